@@ -4,6 +4,8 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <array>
 #include <fstream>
 #include <iomanip>
 #include <sstream>
@@ -91,9 +93,111 @@ bool BedFile::load(const std::string & bed_filename) {
         m_genomes[reference_name].push_back({bed_line, start, end, strand});
     }
 
+    build_indices();
     return true;
 };
 
+// The index is laid out as in cgranges: intervals are sorted by start and the sorted array is
+// treated as an implicit binary tree, where the node at level k has index (2^k - 1) mod 2^(k+1).
+// Each node stores the maximum end position of its subtree so that subtrees which end before
+// the query starts can be skipped.
+void BedFile::build_indices() {
+    m_indices.clear();
+    for (const auto & [genome, genome_entries] : m_genomes) {
+        auto & index = m_indices[genome];
+        auto & intervals = index.intervals;
+        intervals.reserve(genome_entries.size());
+        for (const auto & entry : genome_entries) {
+            intervals.push_back({entry.start, entry.end, entry.end, entry.strand});
+        }
+        std::stable_sort(intervals.begin(), intervals.end(),
+                         [](const auto & lhs, const auto & rhs) { return lhs.start < rhs.start; });
+
+        const size_t n = intervals.size();
+        if (n == 0) {
+            continue;
+        }
+
+        // Leaves are at the even indices and already have max_end == end.
+        size_t last_i = 0;
+        size_t last = 0;
+        for (size_t i = 0; i < n; i += 2) {
+            last_i = i;
+            last = intervals[i].end;
+        }
+
+        int k = 1;
+        for (; (size_t{1} << k) <= n; ++k) {
+            const size_t x = size_t{1} << (k - 1);
+            const size_t i0 = (x << 1) - 1;
+            const size_t step = x << 2;
+            for (size_t i = i0; i < n; i += step) {
+                const size_t left_max = intervals[i - x].max_end;
+                const size_t right_max = i + x < n ? intervals[i + x].max_end : last;
+                intervals[i].max_end = std::max({intervals[i].end, left_max, right_max});
+            }
+            // Move last_i up to its parent.
+            last_i = ((last_i >> k) & 1) ? last_i - x : last_i + x;
+            if (last_i < n && intervals[last_i].max_end > last) {
+                last = intervals[last_i].max_end;
+            }
+        }
+        index.max_level = k - 1;
+    }
+}
+
+size_t BedFile::num_overlapping_entries(const std::string & genome,
+                                        size_t start,
+                                        size_t end,
+                                        char strand) const {
+    auto it = m_indices.find(genome);
+    if (it == m_indices.end() || it->second.max_level < 0) {
+        return 0;
+    }
+    const auto & intervals = it->second.intervals;
+    const size_t n = intervals.size();
+
+    size_t hits = 0;
+    auto check_hit = [&](const IndexedInterval & interval) {
+        if (start < interval.end && (interval.strand == strand || interval.strand == '.')) {
+            ++hits;
+        }
+    };
+
+    // Subtrees at or below this level are scanned linearly rather than traversed.
+    constexpr int LINEAR_SCAN_LEVEL = 3;
+    struct StackEntry {
+        size_t x;
+        int k;
+        bool left_done;
+    };
+    std::array<StackEntry, 64> stack;
+    size_t t = 0;
+    const int root_level = it->second.max_level;
+    stack[t++] = {(size_t{1} << root_level) - 1, root_level, false};
+    while (t > 0) {
+        const auto z = stack[--t];
+        if (z.k <= LINEAR_SCAN_LEVEL) {
+            const size_t i0 = (z.x >> z.k) << z.k;
+            const size_t i1 = std::min(i0 + (size_t{1} << (z.k + 1)) - 1, n);
+            for (size_t i = i0; i < i1 && intervals[i].start < end; ++i) {
+                check_hit(intervals[i]);
+            }
+        } else if (!z.left_done) {
+            // Revisit this node once the left subtree has been handled.
+            const size_t y = z.x - (size_t{1} << (z.k - 1));
+            stack[t++] = {z.x, z.k, true};
+            if (y >= n || intervals[y].max_end > start) {
+                stack[t++] = {y, z.k - 1, false};
+            }
+        } else if (z.x < n && intervals[z.x].start < end) {
+            check_hit(intervals[z.x]);
+            stack[t++] = {z.x + (size_t{1} << (z.k - 1)), z.k - 1, false};
+        }
+    }
+    return hits;
+}
+
 const BedFile::Entries & BedFile::entries(const std::string & genome) const {
     auto it = m_genomes.find(genome);
     return it != m_genomes.end() ? it->second : NO_ENTRIES;
@@ -18,7 +18,24 @@ public:
     using Entries = std::vector<Entry>;
 
 private:
+    // Implicit interval tree over the entries of a genome, sorted by start position.
+    // Each node is augmented with the maximum end of the intervals in its subtree.
+    struct IndexedInterval {
+        size_t start;
+        size_t end;
+        size_t max_end;
+        char strand;
+    };
+
+    struct IntervalIndex {
+        std::vector<IndexedInterval> intervals;
+        int max_level{-1};
+    };
+
+    void build_indices();
+
     std::map<std::string, Entries> m_genomes;
+    std::map<std::string, IntervalIndex> m_indices;
     std::string m_file_name{};
     static const Entries NO_ENTRIES;
 
@@ -33,6 +50,13 @@ public:
 
     const Entries& entries(const std::string& genome) const;
 
+    // Count the entries for |genome| that overlap [start, end) and are either on |strand|
+    // or unstranded.
+    size_t num_overlapping_entries(const std::string& genome,
+                                   size_t start,
+                                   size_t end,
+                                   char strand) const;
+
     const std::string& filename() const;
 };
 
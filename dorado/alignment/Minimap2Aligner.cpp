@@ -218,6 +218,7 @@ std::vector<BamPtr> Minimap2Aligner::align(bam1_t* irecord, mm_tbuf_t* buf) {
         // Copy over tags from input alignment.
         memcpy(bam_get_aux(record), bam_get_aux(irecord), bam_get_l_aux(irecord));
         record->l_data += bam_get_l_aux(irecord);
+        utils::copy_pipeline_entry_time(irecord, record);
 
         // Add new tags to match minimap2.
         add_tags(record, aln, seq, buf);
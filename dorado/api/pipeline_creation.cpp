@@ -114,6 +114,7 @@ void create_stereo_duplex_pipeline(PipelineDescriptor& pipeline_desc,
                                    uint32_t mean_qscore_start_pos,
                                    int scaler_node_threads,
                                    int splitter_node_threads,
+                                   int stereo_encoder_node_threads,
                                    int modbase_node_threads,
                                    PairingParameters pairing_parameters,
                                    NodeHandle sink_node_handle,
@@ -142,8 +143,8 @@ void create_stereo_duplex_pipeline(PipelineDescriptor& pipeline_desc,
     }
 
     auto simplex_model_stride = runners.front()->model_stride();
-    auto stereo_node = pipeline_desc.add_node<StereoDuplexEncoderNode>({stereo_basecaller_node},
-                                                                       int(simplex_model_stride));
+    auto stereo_node = pipeline_desc.add_node<StereoDuplexEncoderNode>(
+            {stereo_basecaller_node}, int(simplex_model_stride), stereo_encoder_node_threads);
 
     auto pairing_node =
             std::holds_alternative<DuplexPairingParameters>(pairing_parameters)
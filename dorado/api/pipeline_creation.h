@@ -52,6 +52,7 @@ void create_stereo_duplex_pipeline(PipelineDescriptor& pipeline_desc,
                                    uint32_t mean_qscore_start_pos,
                                    int scaler_node_threads,
                                    int splitter_node_threads,
+                                   int stereo_encoder_node_threads,
                                    int modbase_node_threads,
                                    PairingParameters pairing_parameters,
                                    NodeHandle sink_node_handle,
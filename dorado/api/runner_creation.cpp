@@ -1,8 +1,10 @@
 #include "runner_creation.h"
 
+#include "basecall/CPUCaller.h"
 #include "basecall/ModelRunner.h"
 #include "basecall/crf_utils.h"
 #include "modbase/ModBaseModelConfig.h"
+#include "utils/dev_utils.h"
 
 #if DORADO_METAL_BUILD
 #include "basecall/MetalModelRunner.h"
@@ -15,6 +17,7 @@
 #include <cxxpool.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <thread>
 
 namespace dorado::api {
@@ -53,9 +56,17 @@ std::pair<std::vector<basecall::RunnerPtr>, size_t> create_basecall_runners(
         spdlog::debug("- CPU calling: set batch size to {}, num_cpu_runners to {}", batch_size,
                       num_cpu_runners);
 
+        // Each caller runs the model for a group of runners. While one runner's batch is in the
+        // model, the others decode their previous batch and fill their next one.
+        const int pipeline_depth = std::max(utils::get_dev_opt<int>("cpu_pipeline_depth", 2), 1);
+        spdlog::debug("- CPU calling: set pipeline depth to {}", pipeline_depth);
+
         for (size_t i = 0; i < num_cpu_runners; i++) {
-            runners.push_back(std::make_unique<basecall::ModelRunner>(
-                    model_config, device, int(chunk_size), int(batch_size)));
+            auto caller = std::make_shared<basecall::CPUCaller>(model_config, device);
+            for (int j = 0; j < pipeline_depth; j++) {
+                runners.push_back(std::make_unique<basecall::ModelRunner>(caller, int(chunk_size),
+                                                                          int(batch_size)));
+            }
         }
     }
 #if DORADO_METAL_BUILD
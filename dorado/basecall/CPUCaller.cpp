@@ -0,0 +1,131 @@
+#include "CPUCaller.h"
+
+#include "crf_utils.h"
+#include "utils/thread_utils.h"
+
+#include <nvtx3/nvtx3.hpp>
+
+#include <utility>
+
+namespace dorado::basecall {
+
+struct CPUCaller::NNTask {
+    NNTask(at::Tensor input_, int num_chunks_)
+            : input(std::move(input_)), num_chunks(num_chunks_) {}
+    at::Tensor input;
+    int num_chunks;
+    decode::DecodeData out;
+    std::mutex mut;
+    std::condition_variable cv;
+    bool done{false};
+    stats::Timer queue_timer;
+};
+
+CPUCaller::CPUCaller(const CRFModelConfig &model_config, const std::string &device)
+        : m_config(model_config),
+          m_decoder(decode::create_decoder(device, model_config)),
+          m_options(at::TensorOptions().dtype(m_decoder->dtype()).device(device)) {
+    m_decoder_options.q_shift = model_config.qbias;
+    m_decoder_options.q_scale = model_config.qscale;
+
+    at::InferenceMode guard;
+    m_module = load_crf_model(model_config, m_options);
+
+    start_threads();
+}
+
+CPUCaller::~CPUCaller() { terminate(); }
+
+std::vector<decode::DecodedChunk> CPUCaller::call_chunks(const at::Tensor &input, int num_chunks) {
+    NVTX3_FUNC_RANGE();
+    if (num_chunks == 0) {
+        return std::vector<decode::DecodedChunk>();
+    }
+
+    auto task = std::make_shared<NNTask>(input.to(m_options.device()), num_chunks);
+    {
+        std::lock_guard<std::mutex> lock(m_input_lock);
+        m_input_queue.push_front(task);
+    }
+    m_input_cv.notify_one();
+
+    {
+        std::unique_lock lock(task->mut);
+        task->cv.wait(lock, [&task] { return task->done; });
+    }
+
+    // Decode on this thread, leaving the model thread free to start on the next batch.
+    stats::Timer timer;
+    auto decoded_chunks = m_decoder->beam_search_part_2(std::move(task->out));
+    m_decode_ms += timer.GetElapsedMS();
+    return decoded_chunks;
+}
+
+void CPUCaller::terminate() {
+    {
+        std::lock_guard<std::mutex> lock(m_input_lock);
+        m_terminate.store(true);
+    }
+    m_input_cv.notify_one();
+    if (m_model_thread && m_model_thread->joinable()) {
+        m_model_thread->join();
+    }
+    m_model_thread.reset();
+}
+
+void CPUCaller::restart() {
+    // This can be called more than once, via multiple runners.
+    if (m_terminate.load()) {
+        m_terminate.store(false);
+        start_threads();
+    }
+}
+
+void CPUCaller::start_threads() {
+    m_model_thread = std::make_unique<std::thread>(&CPUCaller::model_thread_fn, this);
+}
+
+void CPUCaller::model_thread_fn() {
+    utils::set_thread_name("cpu_caller");
+    at::InferenceMode guard;
+    while (true) {
+        std::unique_lock<std::mutex> input_lock(m_input_lock);
+        m_input_cv.wait(input_lock,
+                        [this] { return !m_input_queue.empty() || m_terminate.load(); });
+
+        if (m_input_queue.empty() && m_terminate.load()) {
+            return;
+        }
+
+        auto task = m_input_queue.back();
+        m_input_queue.pop_back();
+        input_lock.unlock();
+
+        m_queue_wait_ms += task->queue_timer.GetElapsedMS();
+
+        stats::Timer timer;
+        auto scores = m_module->forward(task->input);
+        auto out = m_decoder->beam_search_part_1({scores, task->num_chunks, m_decoder_options});
+        m_model_ms += timer.GetElapsedMS();
+        ++m_num_batches_called;
+
+        std::lock_guard<std::mutex> task_lock(task->mut);
+        task->out = std::move(out);
+        task->done = true;
+        task->cv.notify_one();
+    }
+}
+
+stats::NamedStats CPUCaller::sample_stats() const {
+    stats::NamedStats stats;
+    stats["batches_called"] = double(m_num_batches_called);
+    stats["model_ms"] = double(m_model_ms);
+    stats["decode_ms"] = double(m_decode_ms);
+    stats["queue_wait_ms"] = double(m_queue_wait_ms);
+    for (const auto &[name, value] : m_decoder->sample_stats()) {
+        stats[name] = value;
+    }
+    return stats;
+}
+
+}  // namespace dorado::basecall
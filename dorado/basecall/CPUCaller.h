@@ -0,0 +1,67 @@
+#pragma once
+
+#include "CRFModelConfig.h"
+#include "decode/Decoder.h"
+#include "utils/stats.h"
+
+#include <torch/nn.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dorado::basecall {
+
+// Runs the model forward pass for a set of CPU ModelRunners on a dedicated thread. Decoding
+// happens on the calling runner's thread once its scores are ready, so while one runner decodes
+// its batch and fills its next one, the model can move on to another runner's batch. The number
+// of runners sharing a caller is therefore its pipelining depth.
+class CPUCaller {
+public:
+    CPUCaller(const CRFModelConfig &model_config, const std::string &device);
+    ~CPUCaller();
+
+    // Blocks until the first |num_chunks| chunks of |input| have been run through the model and
+    // decoded. |input| must not be modified until this returns.
+    std::vector<decode::DecodedChunk> call_chunks(const at::Tensor &input, int num_chunks);
+
+    void terminate();
+    void restart();
+
+    at::ScalarType dtype() const { return m_decoder->dtype(); }
+    const CRFModelConfig &config() const { return m_config; }
+
+    std::string get_name() const { return "CPUCaller"; }
+    stats::NamedStats sample_stats() const;
+
+private:
+    struct NNTask;
+
+    void start_threads();
+    void model_thread_fn();
+
+    const CRFModelConfig m_config;
+    std::unique_ptr<decode::Decoder> m_decoder;
+    decode::DecoderOptions m_decoder_options;
+    at::TensorOptions m_options;
+    torch::nn::ModuleHolder<torch::nn::AnyModule> m_module{nullptr};
+
+    std::atomic<bool> m_terminate{false};
+    std::deque<std::shared_ptr<NNTask>> m_input_queue;
+    std::mutex m_input_lock;
+    std::condition_variable m_input_cv;
+    std::unique_ptr<std::thread> m_model_thread;
+
+    // Performance monitoring stats.
+    std::atomic<int64_t> m_num_batches_called{0};
+    std::atomic<int64_t> m_model_ms{0};
+    std::atomic<int64_t> m_decode_ms{0};
+    std::atomic<int64_t> m_queue_wait_ms{0};
+};
+
+}  // namespace dorado::basecall
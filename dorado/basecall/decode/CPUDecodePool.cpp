@@ -0,0 +1,184 @@
+#include "CPUDecodePool.h"
+
+#include "utils/dev_utils.h"
+#include "utils/thread_utils.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <exception>
+#include <string>
+
+namespace dorado::basecall::decode {
+
+struct CPUDecodePool::Batch {
+    const std::function<void(size_t)>& task;
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t num_remaining;
+    std::exception_ptr exception;
+};
+
+CPUDecodePool::CPUDecodePool(size_t num_threads) : m_start_time(std::chrono::steady_clock::now()) {
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    spdlog::debug("Creating CPU decode pool with {} threads", num_threads);
+
+    m_workers.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    // Only start the threads once all of the queues exist, since they can steal from any of them.
+    for (size_t i = 0; i < num_threads; ++i) {
+        m_workers[i]->thread = std::thread([this, i] { worker_thread_fn(i); });
+    }
+}
+
+CPUDecodePool::~CPUDecodePool() {
+    {
+        std::lock_guard lock(m_wake_mutex);
+        m_terminate = true;
+    }
+    m_wake_cv.notify_all();
+    for (auto& worker : m_workers) {
+        worker->thread.join();
+    }
+}
+
+std::shared_ptr<CPUDecodePool> CPUDecodePool::shared_instance() {
+    static std::mutex instance_mutex;
+    static std::weak_ptr<CPUDecodePool> instance;
+
+    std::lock_guard lock(instance_mutex);
+    auto pool = instance.lock();
+    if (!pool) {
+        const int num_threads = utils::get_dev_opt<int>("cpu_decode_threads", 0);
+        pool = std::make_shared<CPUDecodePool>(size_t(std::max(num_threads, 0)));
+        instance = pool;
+    }
+    return pool;
+}
+
+void CPUDecodePool::parallel_for(size_t num_tasks, const std::function<void(size_t)>& task) {
+    if (num_tasks == 0) {
+        return;
+    }
+
+    Batch batch{task, {}, {}, num_tasks, nullptr};
+
+    // Deal the tasks out across the queues, starting from a different queue each time so that
+    // small batches don't all land on the first few threads.
+    const size_t num_workers = m_workers.size();
+    const size_t first_worker = m_next_worker.fetch_add(num_tasks) % num_workers;
+    for (size_t worker_offset = 0; worker_offset < std::min(num_tasks, num_workers);
+         ++worker_offset) {
+        auto& worker = *m_workers[(first_worker + worker_offset) % num_workers];
+        std::lock_guard lock(worker.mutex);
+        for (size_t i = worker_offset; i < num_tasks; i += num_workers) {
+            worker.tasks.push_back({&batch, i});
+        }
+    }
+    {
+        std::lock_guard lock(m_wake_mutex);
+        m_num_queued += int64_t(num_tasks);
+    }
+    m_wake_cv.notify_all();
+
+    std::unique_lock lock(batch.mutex);
+    batch.cv.wait(lock, [&batch] { return batch.num_remaining == 0; });
+    if (batch.exception) {
+        std::rethrow_exception(batch.exception);
+    }
+}
+
+bool CPUDecodePool::try_pop_task(size_t worker_idx, Task& task) {
+    {
+        auto& worker = *m_workers[worker_idx];
+        std::lock_guard lock(worker.mutex);
+        if (!worker.tasks.empty()) {
+            task = worker.tasks.front();
+            worker.tasks.pop_front();
+            --m_num_queued;
+            return true;
+        }
+    }
+
+    // Our own queue is empty, so take the most recently queued task from another thread.
+    const size_t num_workers = m_workers.size();
+    for (size_t offset = 1; offset < num_workers; ++offset) {
+        auto& victim = *m_workers[(worker_idx + offset) % num_workers];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            --m_num_queued;
+            ++m_num_steals;
+            return true;
+        }
+    }
+    return false;
+}
+
+void CPUDecodePool::run_task(Worker& worker, const Task& task) {
+    auto& batch = *task.batch;
+    const auto start = std::chrono::steady_clock::now();
+    std::exception_ptr exception;
+    try {
+        batch.task(task.index);
+    } catch (...) {
+        exception = std::current_exception();
+    }
+    worker.busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+    ++m_num_tasks_completed;
+
+    // The submitter owns the batch and can return as soon as the last task is accounted for, so
+    // the batch must not be touched after the lock is released.
+    std::lock_guard lock(batch.mutex);
+    if (exception && !batch.exception) {
+        batch.exception = exception;
+    }
+    if (--batch.num_remaining == 0) {
+        batch.cv.notify_all();
+    }
+}
+
+void CPUDecodePool::worker_thread_fn(size_t worker_idx) {
+    utils::set_thread_name("cpu_decode_" + std::to_string(worker_idx));
+    auto& worker = *m_workers[worker_idx];
+    while (true) {
+        Task task;
+        if (try_pop_task(worker_idx, task)) {
+            run_task(worker, task);
+            continue;
+        }
+
+        std::unique_lock lock(m_wake_mutex);
+        m_wake_cv.wait(lock, [this] { return m_terminate || m_num_queued > 0; });
+        if (m_terminate && m_num_queued <= 0) {
+            return;
+        }
+    }
+}
+
+stats::NamedStats CPUDecodePool::sample_stats() const {
+    stats::NamedStats stats;
+    stats["decode_pool_threads"] = double(m_workers.size());
+    stats["decode_pool_queue_depth"] = double(std::max<int64_t>(m_num_queued, 0));
+    stats["decode_pool_tasks_completed"] = double(m_num_tasks_completed);
+    stats["decode_pool_steals"] = double(m_num_steals);
+
+    const auto elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::steady_clock::now() - m_start_time)
+                                    .count();
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        const double utilisation =
+                elapsed_ns > 0 ? double(m_workers[i]->busy_ns) / double(elapsed_ns) : 0.0;
+        stats["decode_pool_thread_" + std::to_string(i) + "_utilisation"] = utilisation;
+    }
+    return stats;
+}
+
+}  // namespace dorado::basecall::decode
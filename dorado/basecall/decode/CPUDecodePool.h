@@ -0,0 +1,79 @@
+#pragma once
+
+#include "utils/stats.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dorado::basecall::decode {
+
+// A persistent pool of decode threads, shared between the CPU decoders of all model runners.
+// Each thread has its own task queue, and steals from the back of the other queues when its own
+// runs dry, so that a batch with a mix of short and long chunks doesn't leave threads idle while
+// one of them works through the stragglers.
+class CPUDecodePool {
+public:
+    // A num_threads of 0 uses one thread per hardware thread.
+    explicit CPUDecodePool(size_t num_threads);
+    ~CPUDecodePool();
+    CPUDecodePool(const CPUDecodePool&) = delete;
+    CPUDecodePool& operator=(const CPUDecodePool&) = delete;
+
+    // The pool shared by all CPU decoders, which is created on first use and lives for as long as
+    // any decoder holds on to it. Its size can be set with the "cpu_decode_threads" dev option.
+    static std::shared_ptr<CPUDecodePool> shared_instance();
+
+    // Calls task(i) for each i in [0, num_tasks) on the pool threads, returning once they have all
+    // completed. Tasks from concurrent calls are interleaved. If any of the tasks throws then the
+    // first exception is rethrown here, after the remaining tasks have completed.
+    void parallel_for(size_t num_tasks, const std::function<void(size_t)>& task);
+
+    size_t num_threads() const { return m_workers.size(); }
+
+    stats::NamedStats sample_stats() const;
+
+private:
+    struct Batch;
+    struct Task {
+        Batch* batch;
+        size_t index;
+    };
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::atomic<int64_t> busy_ns{0};
+        std::thread thread;
+    };
+
+    void worker_thread_fn(size_t worker_idx);
+    bool try_pop_task(size_t worker_idx, Task& task);
+    void run_task(Worker& worker, const Task& task);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    const std::chrono::steady_clock::time_point m_start_time;
+
+    // Used to wake idle workers when there are new tasks queued.
+    std::mutex m_wake_mutex;
+    std::condition_variable m_wake_cv;
+    bool m_terminate{false};
+
+    // Tasks queued but not yet started. This can briefly go negative if a task is started before
+    // its submitter has accounted for it.
+    std::atomic<int64_t> m_num_queued{0};
+    std::atomic<size_t> m_next_worker{0};
+
+    // Performance monitoring stats.
+    std::atomic<int64_t> m_num_tasks_completed{0};
+    std::atomic<int64_t> m_num_steals{0};
+};
+
+}  // namespace dorado::basecall::decode
@@ -1,147 +1,56 @@
 #include "CPUDecoder.h"
 
 #include "beam_search.h"
+#include "crf_scan.h"
 
 #include <ATen/ATen.h>
-#include <math.h>
 #include <spdlog/spdlog.h>
 
+#include <utility>
 #include <vector>
 
-namespace {
-
-at::Tensor scan(const at::Tensor& Ms,
-                const float fixed_stay_score,
-                const at::Tensor& idx,
-                const at::Tensor& v0) {
-    const int T = int(Ms.size(0));
-    const int N = int(Ms.size(1));
-    const int C = int(Ms.size(2));
-
-    at::Tensor alpha = Ms.new_full({T + 1, N, C}, -1E38);
-    alpha[0] = v0;
-
-    for (int t = 0; t < T; t++) {
-        auto scored_steps = at::add(alpha.index({t, at::indexing::Slice(), idx}), Ms[t]);
-        auto scored_stay =
-                at::add(alpha.index({t, at::indexing::Slice()}), fixed_stay_score).unsqueeze(-1);
-        auto scored_transitions = at::cat({scored_stay, scored_steps}, -1);
-
-        alpha[t + 1] = at::logsumexp(scored_transitions, -1);
-    }
-
-    return alpha;
-}
-
-at::Tensor forward_scores(const at::Tensor& scores, const float fixed_stay_score) {
-    const int T = int(scores.size(0));  // Signal len
-    const int N = int(scores.size(1));  // Num batches
-    const int C = int(scores.size(2));  // 4^state_len * 4 = 4^(state_len + 1)
-
-    const int n_base = 4;
-    const int state_len = int(std::log(C) / std::log(n_base) - 1);
-
-    // Transition scores reshaped so that the 4 scores for each predecessor state are arranged along the
-    // innermost dimension.
-    const at::Tensor Ms = scores.reshape({T, N, -1, n_base});
-
-    // Number of states per timestep.
-    const int num_states = int(pow(n_base, state_len));
-
-    // Guide values at first timestep.
-    const auto v0 = Ms.new_full({{N, num_states}}, 0.0f);
-
-    // For each state, the indices of the 4 states that could precede it via a step transition.
-    const auto idx =
-            at::arange(num_states).repeat_interleave(n_base).reshape({n_base, -1}).t().contiguous();
-
-    return scan(Ms, fixed_stay_score, idx, v0);
-}
-
-at::Tensor backward_scores(const at::Tensor& scores, const float fixed_stay_score) {
-    const int N = int(scores.size(1));  // Num batches
-    const int C = int(scores.size(2));  // 4^state_len * 4 = 4^(state_len + 1)
-
-    const int n_base = 4;
-
-    const int state_len = int(std::log(C) / std::log(n_base) - 1);
-
-    // Number of states per timestep.
-    const int num_states = int(pow(n_base, state_len));
-
-    // Guide values at last timestep.
-    const at::Tensor vT = scores.new_full({N, num_states}, 0.0f);
-
-    const auto idx =
-            at::arange(num_states).repeat_interleave(n_base).reshape({n_base, -1}).t().contiguous();
-    auto idx_T = idx.flatten().argsort().reshape(idx.sizes());
-
-    const auto Ms_T = scores.index({at::indexing::Slice(), at::indexing::Slice(), idx_T});
-
-    // For each state, the indices of the 4 states that could succeed it via a step transition.
-    idx_T = at::bitwise_right_shift(idx_T, 2);
-
-    return scan(Ms_T.flip(0), fixed_stay_score, idx_T.to(at::kLong), vT).flip(0);
-}
-
-}  // namespace
-
 namespace dorado::basecall::decode {
 
+CPUDecoder::CPUDecoder(std::shared_ptr<CPUDecodePool> decode_pool)
+        : m_decode_pool(std::move(decode_pool)) {}
+
 DecodeData CPUDecoder::beam_search_part_1(DecodeData data) const { return data; }
 
 std::vector<DecodedChunk> CPUDecoder::beam_search_part_2(DecodeData data) const {
     const auto scores_cpu = data.data.to(at::kCPU);
     const auto num_chunks = data.num_chunks;
     const auto& options = data.options;
-    int num_threads = std::min(num_chunks, 4);
-    int chunks_per_thread = num_chunks / num_threads;
-    int num_threads_with_one_more_chunk = num_chunks % num_threads;
 
     std::vector<DecodedChunk> chunk_results(num_chunks);
 
-    std::vector<std::thread> threads;
-    threads.reserve(num_threads);
-    for (int i = 0; i < num_threads; ++i) {
-        threads.emplace_back([&, i]() {
-            at::InferenceMode inference_mode_guard;
-
-            int t_first_chunk =
-                    i * chunks_per_thread + std::min(i, num_threads_with_one_more_chunk);
-            int t_num_chunks = chunks_per_thread + int(i < num_threads_with_one_more_chunk);
-
-            using Slice = at::indexing::Slice;
-            auto t_scores =
-                    scores_cpu.index({Slice(), Slice(t_first_chunk, t_first_chunk + t_num_chunks)});
-
-            at::Tensor fwd = forward_scores(t_scores, options.blank_score);
-            at::Tensor bwd = backward_scores(t_scores, options.blank_score);
-
-            at::Tensor posts = at::softmax(fwd + bwd, -1);
-
-            t_scores = t_scores.transpose(0, 1);
-            bwd = bwd.transpose(0, 1).contiguous();
-            posts = posts.transpose(0, 1).contiguous();
-
-            for (int chunk_idx = 0; chunk_idx < t_num_chunks; chunk_idx++) {
-                auto decode_result = beam_search_decode(t_scores[chunk_idx], bwd[chunk_idx],
-                                                        posts[chunk_idx], options.beam_width,
-                                                        options.beam_cut, options.blank_score,
-                                                        options.q_shift, options.q_scale, 1.0f);
-                chunk_results[t_first_chunk + chunk_idx] = DecodedChunk{
-                        std::get<0>(decode_result),
-                        std::get<1>(decode_result),
-                        std::get<2>(decode_result),
-                };
-            }
-        });
-    }
-
-    for (auto& thread : threads) {
-        thread.join();
-    }
+    // Each chunk is decoded as a separate task, so that the pool can balance chunks of differing
+    // difficulty across its threads.
+    m_decode_pool->parallel_for(size_t(num_chunks), [&](size_t chunk_idx) {
+        at::InferenceMode inference_mode_guard;
+
+        using Slice = at::indexing::Slice;
+        const int64_t chunk = int64_t(chunk_idx);
+        const auto chunk_scores = scores_cpu.index({Slice(), Slice(chunk, chunk + 1)});
+
+        at::Tensor fwd = forward_scores(chunk_scores, options.blank_score);
+        at::Tensor bwd = backward_scores(chunk_scores, options.blank_score);
+
+        at::Tensor posts = at::softmax(fwd + bwd, -1);
+
+        auto decode_result = beam_search_decode(
+                chunk_scores.select(1, 0), bwd.select(1, 0), posts.select(1, 0),
+                options.beam_width, options.beam_cut, options.blank_score, options.q_shift,
+                options.q_scale, 1.0f);
+        chunk_results[chunk_idx] = DecodedChunk{
+                std::get<0>(decode_result),
+                std::get<1>(decode_result),
+                std::get<2>(decode_result),
+        };
+    });
 
     return chunk_results;
 }
 
+stats::NamedStats CPUDecoder::sample_stats() const { return m_decode_pool->sample_stats(); }
+
 }  // namespace dorado::basecall::decode
@@ -1,17 +1,27 @@
 #pragma once
 
+#include "CPUDecodePool.h"
 #include "Decoder.h"
 
 #include <ATen/core/TensorBody.h>
 
+#include <memory>
+
 namespace dorado::basecall::decode {
 
 class CPUDecoder final : public Decoder {
 public:
+    explicit CPUDecoder(std::shared_ptr<CPUDecodePool> decode_pool);
+
     DecodeData beam_search_part_1(DecodeData data) const;
     std::vector<DecodedChunk> beam_search_part_2(DecodeData data) const;
 
     at::ScalarType dtype() const { return at::ScalarType::Float; };
+
+    stats::NamedStats sample_stats() const;
+
+private:
+    std::shared_ptr<CPUDecodePool> m_decode_pool;
 };
 
 }  // namespace dorado::basecall::decode
@@ -20,7 +20,7 @@ std::unique_ptr<Decoder> create_decoder(c10::Device device, const CRFModelConfig
     (void)config;  // unused in other build types
 #endif
     if (device.is_cpu()) {
-        return std::make_unique<decode::CPUDecoder>();
+        return std::make_unique<decode::CPUDecoder>(CPUDecodePool::shared_instance());
     }
 
     throw std::runtime_error("Unsupported device type for decoder creation: " + device.str());
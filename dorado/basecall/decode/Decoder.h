@@ -1,5 +1,7 @@
 #pragma once
 
+#include "utils/stats.h"
+
 #include <ATen/core/TensorBody.h>
 
 #include <cstdint>
@@ -42,6 +44,7 @@ public:
     virtual std::vector<DecodedChunk> beam_search_part_2(DecodeData data) const = 0;
     // Returns the torch::TensorOptions::dtype to use for input data to models that use this decoder
     virtual at::ScalarType dtype() const = 0;
+    virtual stats::NamedStats sample_stats() const { return {}; }
 };
 
 std::unique_ptr<Decoder> create_decoder(c10::Device device, const CRFModelConfig& config);
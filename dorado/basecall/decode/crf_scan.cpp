@@ -0,0 +1,313 @@
+#include "crf_scan.h"
+
+#include "utils/simd.h"
+
+#include <ATen/ATen.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+constexpr int kNumBases = 4;
+
+// The CRF has 4^state_len states, and 4 step transitions into each state. For the forward scan,
+// state s can be reached by staying in s, or by a step from state (k * num_states / 4 + s / 4)
+// for k in [0, 4), with the score for the k'th step at scores[s * 4 + k]. Equivalently for the
+// backward scan, the states that can be reached by a step from state (k * num_states / 4 + q) are
+// (4 * q + m) for m in [0, 4), with the score for each step at scores[(4 * q + m) * 4 + k].
+
+// Matches at::logsumexp.
+inline float logsumexp5(const float (&x)[5]) {
+    float max_x = x[0];
+    for (int i = 1; i < 5; ++i) {
+        max_x = std::max(max_x, x[i]);
+    }
+    if (std::isinf(max_x)) {
+        max_x = 0.f;
+    }
+    float sum = 0.f;
+    for (const float v : x) {
+        sum += std::exp(v - max_x);
+    }
+    return std::log(sum) + max_x;
+}
+
+void forward_step_scalar(const float* const prev,
+                         const float* const scores,
+                         const float stay_score,
+                         const int num_states,
+                         const int first_state,
+                         float* const out) {
+    const int pred_stride = num_states / kNumBases;
+    for (int s = first_state; s < num_states; ++s) {
+        const int pred = s / kNumBases;
+        const float* const step_scores = scores + s * kNumBases;
+        const float x[5] = {prev[s] + stay_score, prev[pred] + step_scores[0],
+                            prev[pred_stride + pred] + step_scores[1],
+                            prev[2 * pred_stride + pred] + step_scores[2],
+                            prev[3 * pred_stride + pred] + step_scores[3]};
+        out[s] = logsumexp5(x);
+    }
+}
+
+void backward_step_scalar(const float* const next,
+                          const float* const scores,
+                          const float stay_score,
+                          const int num_states,
+                          const int first_state,
+                          float* const out) {
+    const int pred_stride = num_states / kNumBases;
+    for (int s = first_state; s < num_states; ++s) {
+        const int k = s / pred_stride;
+        const int succ = (s % pred_stride) * kNumBases;
+        const float* const step_scores = scores + succ * kNumBases + k;
+        const float x[5] = {next[s] + stay_score, next[succ] + step_scores[0],
+                            next[succ + 1] + step_scores[4], next[succ + 2] + step_scores[8],
+                            next[succ + 3] + step_scores[12]};
+        out[s] = logsumexp5(x);
+    }
+}
+
+#if ENABLE_AVX2_IMPL
+__attribute__((target("default")))
+#endif
+void forward_step(const float* const prev,
+                  const float* const scores,
+                  const float stay_score,
+                  const int num_states,
+                  float* const out) {
+    forward_step_scalar(prev, scores, stay_score, num_states, 0, out);
+}
+
+#if ENABLE_AVX2_IMPL
+__attribute__((target("default")))
+#endif
+void backward_step(const float* const next,
+                   const float* const scores,
+                   const float stay_score,
+                   const int num_states,
+                   float* const out) {
+    backward_step_scalar(next, scores, stay_score, num_states, 0, out);
+}
+
+#if ENABLE_AVX2_IMPL
+// Cephes based exp, accurate to a couple of ulp. Inputs are clamped so that the result is never
+// denormal, which is irrelevant here since the largest term in each sum is 1.
+__attribute__((target("avx2"))) inline __m256 exp_ps(__m256 x) {
+    x = _mm256_max_ps(x, _mm256_set1_ps(-87.3365448f));
+
+    // Express exp(x) as exp(g) * 2^n, with n = round(x / ln(2)).
+    __m256 fx = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)),
+                              _mm256_set1_ps(0.5f));
+    fx = _mm256_floor_ps(fx);
+    x = _mm256_sub_ps(x, _mm256_mul_ps(fx, _mm256_set1_ps(0.693359375f)));
+    x = _mm256_sub_ps(x, _mm256_mul_ps(fx, _mm256_set1_ps(-2.12194440e-4f)));
+
+    const __m256 z = _mm256_mul_ps(x, x);
+    __m256 y = _mm256_set1_ps(1.9875691500E-4f);
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.3981999507E-3f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(8.3334519073E-3f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(4.1665795894E-2f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.6666665459E-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(5.0000001201E-1f));
+    y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(y, z), x), _mm256_set1_ps(1.f));
+
+    // Build 2^n.
+    __m256i n = _mm256_add_epi32(_mm256_cvttps_epi32(fx), _mm256_set1_epi32(0x7f));
+    n = _mm256_slli_epi32(n, 23);
+    return _mm256_mul_ps(y, _mm256_castsi256_ps(n));
+}
+
+// Cephes based log, accurate to a couple of ulp. Inputs must be positive and finite.
+__attribute__((target("avx2"))) inline __m256 log_ps(__m256 x) {
+    // Split x into mantissa in [0.5, 1) and exponent.
+    __m256i exponent = _mm256_srli_epi32(_mm256_castps_si256(x), 23);
+    x = _mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(~0x7f800000)));
+    x = _mm256_or_ps(x, _mm256_set1_ps(0.5f));
+    exponent = _mm256_sub_epi32(exponent, _mm256_set1_epi32(0x7f));
+    __m256 e = _mm256_add_ps(_mm256_cvtepi32_ps(exponent), _mm256_set1_ps(1.f));
+
+    // Move the mantissa into [sqrt(0.5), sqrt(2)), and subtract 1.
+    const __m256 mask = _mm256_cmp_ps(x, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OS);
+    const __m256 tmp = _mm256_and_ps(x, mask);
+    x = _mm256_sub_ps(x, _mm256_set1_ps(1.f));
+    e = _mm256_sub_ps(e, _mm256_and_ps(_mm256_set1_ps(1.f), mask));
+    x = _mm256_add_ps(x, tmp);
+
+    const __m256 z = _mm256_mul_ps(x, x);
+    __m256 y = _mm256_set1_ps(7.0376836292E-2f);
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-1.1514610310E-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.1676998740E-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-1.2420140846E-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.4249322787E-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-1.6668057665E-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(2.0000714765E-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-2.4999993993E-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(3.3333331174E-1f));
+    y = _mm256_mul_ps(_mm256_mul_ps(y, x), z);
+
+    y = _mm256_add_ps(y, _mm256_mul_ps(e, _mm256_set1_ps(-2.12194440e-4f)));
+    y = _mm256_sub_ps(y, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+    x = _mm256_add_ps(x, y);
+    return _mm256_add_ps(x, _mm256_mul_ps(e, _mm256_set1_ps(0.693359375f)));
+}
+
+__attribute__((target("avx2"))) inline __m256 logsumexp5_ps(const __m256 (&x)[5]) {
+    const __m256 max_x = _mm256_max_ps(_mm256_max_ps(_mm256_max_ps(x[0], x[1]), x[2]),
+                                       _mm256_max_ps(x[3], x[4]));
+    __m256 sum = exp_ps(_mm256_sub_ps(x[0], max_x));
+    for (int i = 1; i < 5; ++i) {
+        sum = _mm256_add_ps(sum, exp_ps(_mm256_sub_ps(x[i], max_x)));
+    }
+    return _mm256_add_ps(log_ps(sum), max_x);
+}
+
+// Loads 8 consecutive groups of 4 floats, returning the m'th element of each group in cols[m].
+__attribute__((target("avx2"))) inline void load_transposed_8x4(const float* const p,
+                                                                 __m256 (&cols)[4]) {
+    const __m256 a = _mm256_loadu_ps(p);
+    const __m256 b = _mm256_loadu_ps(p + 8);
+    const __m256 c = _mm256_loadu_ps(p + 16);
+    const __m256 d = _mm256_loadu_ps(p + 24);
+    const __m256 t0 = _mm256_unpacklo_ps(a, b);
+    const __m256 t1 = _mm256_unpackhi_ps(a, b);
+    const __m256 t2 = _mm256_unpacklo_ps(c, d);
+    const __m256 t3 = _mm256_unpackhi_ps(c, d);
+    // Transposing within each 128 bit lane leaves the groups in the order 0 2 4 6 1 3 5 7.
+    const __m256i kGroupOrder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    cols[0] = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)),
+                                       kGroupOrder);
+    cols[1] = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)),
+                                       kGroupOrder);
+    cols[2] = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)),
+                                       kGroupOrder);
+    cols[3] = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2)),
+                                       kGroupOrder);
+}
+
+__attribute__((target("avx2"))) void forward_step(const float* const prev,
+                                                  const float* const scores,
+                                                  const float stay_score,
+                                                  const int num_states,
+                                                  float* const out) {
+    // Each block of 8 states has 2 distinct predecessors for each k.
+    constexpr int kBlockSize = 8;
+    const int pred_stride = num_states / kNumBases;
+    const int num_vector_states = num_states % kBlockSize == 0 ? num_states : 0;
+    const __m256 stay_scores = _mm256_set1_ps(stay_score);
+    for (int s = 0; s < num_vector_states; s += kBlockSize) {
+        __m256 step_scores[4];
+        load_transposed_8x4(scores + s * kNumBases, step_scores);
+
+        __m256 x[5];
+        x[0] = _mm256_add_ps(_mm256_loadu_ps(prev + s), stay_scores);
+        for (int k = 0; k < kNumBases; ++k) {
+            const float* const pred = prev + k * pred_stride + s / kNumBases;
+            const __m256 preds = _mm256_set_m128(_mm_set1_ps(pred[1]), _mm_set1_ps(pred[0]));
+            x[k + 1] = _mm256_add_ps(preds, step_scores[k]);
+        }
+        _mm256_storeu_ps(out + s, logsumexp5_ps(x));
+    }
+    forward_step_scalar(prev, scores, stay_score, num_states, num_vector_states, out);
+}
+
+__attribute__((target("avx2"))) void backward_step(const float* const next,
+                                                   const float* const scores,
+                                                   const float stay_score,
+                                                   const int num_states,
+                                                   float* const out) {
+    // Each block of 8 states has the same k, so needs num_states / 4 to be a multiple of 8.
+    constexpr int kBlockSize = 8;
+    const int pred_stride = num_states / kNumBases;
+    const int num_vector_states = pred_stride % kBlockSize == 0 ? num_states : 0;
+    const __m256 stay_scores = _mm256_set1_ps(stay_score);
+    // The scores for the steps from each of the 8 states are 16 floats apart.
+    const __m256i kScoreOffsets = _mm256_setr_epi32(0, 16, 32, 48, 64, 80, 96, 112);
+    for (int s = 0; s < num_vector_states; s += kBlockSize) {
+        const int k = s / pred_stride;
+        const int succ = (s % pred_stride) * kNumBases;
+
+        __m256 next_guides[4];
+        load_transposed_8x4(next + succ, next_guides);
+
+        __m256 x[5];
+        x[0] = _mm256_add_ps(_mm256_loadu_ps(next + s), stay_scores);
+        for (int m = 0; m < kNumBases; ++m) {
+            const __m256 step_scores = _mm256_i32gather_ps(
+                    scores + (succ + m) * kNumBases + k, kScoreOffsets, sizeof(float));
+            x[m + 1] = _mm256_add_ps(next_guides[m], step_scores);
+        }
+        _mm256_storeu_ps(out + s, logsumexp5_ps(x));
+    }
+    backward_step_scalar(next, scores, stay_score, num_states, num_vector_states, out);
+}
+#endif
+
+struct ScanShape {
+    int T;
+    int N;
+    int num_states;
+};
+
+ScanShape get_scan_shape(const at::Tensor& scores) {
+    if (scores.dim() != 3 || scores.scalar_type() != at::ScalarType::Float) {
+        throw std::runtime_error("CRF scan: expected 3D float scores");
+    }
+    const int C = int(scores.size(2));
+    if (C < kNumBases * kNumBases || (C & (C - 1)) != 0) {
+        throw std::runtime_error("CRF scan: unexpected number of transition scores " +
+                                 std::to_string(C));
+    }
+    return {int(scores.size(0)), int(scores.size(1)), C / kNumBases};
+}
+
+}  // namespace
+
+namespace dorado::basecall::decode {
+
+at::Tensor forward_scores(const at::Tensor& scores, const float fixed_stay_score) {
+    const auto [T, N, num_states] = get_scan_shape(scores);
+    const auto scores_contig = scores.contiguous();
+    const float* const scores_ptr = scores_contig.data_ptr<float>();
+    const int C = num_states * kNumBases;
+
+    // Guide values at first timestep are 0.
+    at::Tensor alpha = at::empty({T + 1, N, num_states}, scores.options());
+    alpha[0].zero_();
+    float* const alpha_ptr = alpha.data_ptr<float>();
+
+    for (int t = 0; t < T; ++t) {
+        for (int n = 0; n < N; ++n) {
+            forward_step(alpha_ptr + (size_t(t) * N + n) * num_states,
+                         scores_ptr + (size_t(t) * N + n) * C, fixed_stay_score, num_states,
+                         alpha_ptr + (size_t(t + 1) * N + n) * num_states);
+        }
+    }
+    return alpha;
+}
+
+at::Tensor backward_scores(const at::Tensor& scores, const float fixed_stay_score) {
+    const auto [T, N, num_states] = get_scan_shape(scores);
+    const auto scores_contig = scores.contiguous();
+    const float* const scores_ptr = scores_contig.data_ptr<float>();
+    const int C = num_states * kNumBases;
+
+    // Guide values at last timestep are 0.
+    at::Tensor beta = at::empty({T + 1, N, num_states}, scores.options());
+    beta[T].zero_();
+    float* const beta_ptr = beta.data_ptr<float>();
+
+    for (int t = T - 1; t >= 0; --t) {
+        for (int n = 0; n < N; ++n) {
+            backward_step(beta_ptr + (size_t(t + 1) * N + n) * num_states,
+                          scores_ptr + (size_t(t) * N + n) * C, fixed_stay_score, num_states,
+                          beta_ptr + (size_t(t) * N + n) * num_states);
+        }
+    }
+    return beta;
+}
+
+}  // namespace dorado::basecall::decode
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <ATen/core/TensorBody.h>
+
+namespace dorado::basecall::decode {
+
+// Forward and backward guide values for a CRF with 4^state_len states, where |scores| are the
+// transition scores with shape [T, N, 4^(state_len + 1)]. Both return float tensors with shape
+// [T + 1, N, 4^state_len]: the forward guides start from 0 at the first timestep and the backward
+// guides end with 0 at the last.
+at::Tensor forward_scores(const at::Tensor& scores, float fixed_stay_score);
+at::Tensor backward_scores(const at::Tensor& scores, float fixed_stay_score);
+
+}  // namespace dorado::basecall::decode
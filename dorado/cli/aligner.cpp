@@ -10,6 +10,8 @@
 #include "summary/summary.h"
 #include "utils/PostCondition.h"
 #include "utils/bam_utils.h"
+#include "utils/dev_utils.h"
+#include "utils/hts_file.h"
 #include "utils/log_utils.h"
 #include "utils/stats.h"
 
@@ -17,10 +19,14 @@
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <exception>
 #include <filesystem>
 #include <fstream>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <unordered_set>
@@ -70,6 +76,53 @@ bool create_output_folder(const std::filesystem::path& output_folder) {
     return true;
 }
 
+// Combines the reads written by each of the input files currently being aligned, since
+// ReadOutputProgressStats expects a single count covering all collectors in flight.
+class ConcurrentFileStats {
+public:
+    explicit ConcurrentFileStats(dorado::ReadOutputProgressStats& progress_stats)
+            : m_progress_stats(progress_stats) {}
+
+    void update_stats(size_t file_index, const dorado::stats::NamedStats& stats) {
+        std::lock_guard lock(m_mutex);
+        m_reads_written[file_index] = reads_written(stats);
+        m_progress_stats.update_stats(combined_stats());
+    }
+
+    void notify_file_completed(size_t file_index,
+                               size_t num_reads_in_file,
+                               const dorado::stats::NamedStats& final_stats) {
+        std::lock_guard lock(m_mutex);
+        // Bring the combined count up to date first, so that it includes all of this file's
+        // reads when they are moved into the completed total.
+        m_reads_written[file_index] = reads_written(final_stats);
+        m_progress_stats.update_stats(combined_stats());
+        m_reads_written.erase(file_index);
+        m_progress_stats.update_reads_per_file_estimate(num_reads_in_file);
+        m_progress_stats.notify_stats_collector_completed(final_stats);
+    }
+
+private:
+    static constexpr auto READS_WRITTEN_STAT = "HtsWriter.unique_simplex_reads_written";
+
+    static double reads_written(const dorado::stats::NamedStats& stats) {
+        auto it = stats.find(READS_WRITTEN_STAT);
+        return it != stats.end() ? it->second : 0.;
+    }
+
+    dorado::stats::NamedStats combined_stats() const {
+        double total = 0.;
+        for (const auto& [file_index, count] : m_reads_written) {
+            total += count;
+        }
+        return {{READS_WRITTEN_STAT, total}};
+    }
+
+    dorado::ReadOutputProgressStats& m_progress_stats;
+    std::mutex m_mutex;
+    std::map<size_t, double> m_reads_written;
+};
+
 }  // namespace
 
 namespace dorado {
@@ -201,18 +254,45 @@ int aligner(int argc, char* argv[]) {
 
     auto index_file_access = load_index(index, options, aligner_threads);
 
+    // Create all the output folders up front, so that a failure is reported before any files
+    // have been processed.
+    for (const auto& file_info : all_files) {
+        if (file_info.output != "-" &&
+            !create_output_folder(std::filesystem::path(file_info.output).parent_path())) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Several files are aligned at once against the shared index, so that the header handling,
+    // pipeline teardown and sorting of each file overlap with the alignment of the others.
+    // Output to stdout has to be written one file at a time.
+    const bool output_to_stdout =
+            std::any_of(all_files.begin(), all_files.end(),
+                        [](const auto& file_info) { return file_info.output == "-"; });
+    const size_t max_concurrent_files =
+            output_to_stdout ? 1
+                             : static_cast<size_t>(std::max(
+                                       1, utils::get_dev_opt<int>("aligner_concurrent_files", 4)));
+    const size_t num_concurrent_files =
+            std::max(size_t{1}, std::min(all_files.size(), max_concurrent_files));
+    // Split the threads and sort memory budget between the files in flight.
+    const int file_aligner_threads = std::max(1, aligner_threads / int(num_concurrent_files));
+    const int file_writer_threads = std::max(1, writer_threads / int(num_concurrent_files));
+    const size_t sort_buffer_size = utils::HtsFile::DEFAULT_SORT_BUFFER_SIZE / num_concurrent_files;
+    spdlog::debug("> concurrent files {}, aligner threads {}, writer threads per file {}",
+                  num_concurrent_files, file_aligner_threads, file_writer_threads);
+
     ReadOutputProgressStats progress_stats(
             std::chrono::seconds{progress_stats_frequency}, all_files.size(),
             ReadOutputProgressStats::StatsCollectionMode::collector_per_input_file);
     progress_stats.set_post_processing_percentage(0.5f);
     progress_stats.start();
-    for (const auto& file_info : all_files) {
+    ConcurrentFileStats file_stats(progress_stats);
+
+    auto align_file = [&](size_t file_index) {
+        const auto& file_info = all_files[file_index];
         spdlog::info("processing {} -> {}", file_info.input, file_info.output);
         auto reader = std::make_unique<HtsReader>(file_info.input, std::nullopt);
-        if (file_info.output != "-" &&
-            !create_output_folder(std::filesystem::path(file_info.output).parent_path())) {
-            return EXIT_FAILURE;
-        }
 
         spdlog::debug("> input fmt: {} aligned: {}", reader->format, reader->is_aligned);
         auto header = sam_hdr_dup(reader->header);
@@ -220,12 +300,13 @@ int aligner(int argc, char* argv[]) {
 
         add_pg_hdr(header);
 
-        utils::HtsFile hts_file(file_info.output, file_info.output_mode, writer_threads);
+        utils::HtsFile hts_file(file_info.output, file_info.output_mode, file_writer_threads, true);
+        hts_file.set_sort_buffer_size(sort_buffer_size);
 
         PipelineDescriptor pipeline_desc;
         auto hts_writer = pipeline_desc.add_node<HtsWriter>({}, hts_file, "");
         auto aligner = pipeline_desc.add_node<AlignerNode>({hts_writer}, index_file_access, index,
-                                                           bed_file, options, aligner_threads);
+                                                           bed_file, options, file_aligner_threads);
 
         // Create the Pipeline from our description.
         std::vector<dorado::stats::StatsReporter> stats_reporters;
@@ -242,9 +323,11 @@ int aligner(int argc, char* argv[]) {
         auto& hts_writer_ref = dynamic_cast<HtsWriter&>(pipeline->get_node_ref(hts_writer));
         hts_file.set_and_write_header(header);
 
-        // All progress reporting is in the post-processing part.
+        // All progress reporting is in the post-processing part.  The progress bars of files
+        // aligned at the same time would overwrite each other, so they're only shown when files
+        // are aligned one at a time.
         ProgressTracker tracker(0, false, 1.f);
-        if (progress_stats_frequency > 0) {
+        if (progress_stats_frequency > 0 || num_concurrent_files > 1) {
             tracker.disable_progress_reporting();
         }
         tracker.set_description("Aligning");
@@ -253,8 +336,8 @@ int aligner(int argc, char* argv[]) {
         std::vector<dorado::stats::StatsCallable> stats_callables;
         stats_callables.push_back(
                 [&tracker](const stats::NamedStats& stats) { tracker.update_progress_bar(stats); });
-        stats_callables.push_back([&progress_stats](const stats::NamedStats& stats) {
-            progress_stats.update_stats(stats);
+        stats_callables.push_back([&file_stats, file_index](const stats::NamedStats& stats) {
+            file_stats.update_stats(file_index, stats);
         });
         constexpr auto kStatsPeriod = 100ms;
         auto stats_sampler = std::make_unique<dorado::stats::StatsSampler>(
@@ -270,23 +353,53 @@ int aligner(int argc, char* argv[]) {
         // Stop the stats sampler thread before tearing down any pipeline objects.
         stats_sampler->terminate();
         tracker.update_progress_bar(final_stats);
-        progress_stats.update_reads_per_file_estimate(num_reads_in_file);
-        progress_stats.notify_stats_collector_completed(final_stats);
+        file_stats.notify_file_completed(file_index, num_reads_in_file, final_stats);
 
         // Report progress during output file finalisation.
         tracker.set_description("Sorting output files");
         hts_file.finalise(
                 [&](size_t progress) {
                     tracker.update_post_processing_progress(static_cast<float>(progress));
-                    progress_stats.update_post_processing_progress(static_cast<float>(progress));
+                    progress_stats.update_post_processing_progress(file_index,
+                                                                   static_cast<float>(progress));
                 },
-                writer_threads, true);
-        progress_stats.notify_post_processing_completed();
+                file_writer_threads);
+        progress_stats.notify_post_processing_completed(file_index);
         tracker.summarize();
 
-        spdlog::info("> finished alignment");
+        spdlog::info("> finished alignment {}", file_info.input);
         spdlog::info("> total/primary/unmapped {}/{}/{}", hts_writer_ref.get_total(),
                      hts_writer_ref.get_primary(), hts_writer_ref.get_unmapped());
+    };
+
+    // Each worker takes the next file to be aligned until none are left, or a file fails.
+    std::atomic<size_t> next_file_index{0};
+    std::atomic<bool> failed{false};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto worker = [&] {
+        size_t file_index;
+        while (!failed && (file_index = next_file_index++) < all_files.size()) {
+            try {
+                align_file(file_index);
+            } catch (...) {
+                std::lock_guard lock(error_mutex);
+                if (!failed.exchange(true)) {
+                    error = std::current_exception();
+                }
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < num_concurrent_files; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& worker_thread : workers) {
+        worker_thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
     }
 
     progress_stats.report_final_stats();
@@ -199,7 +199,7 @@ void setup(std::vector<std::string> args,
         utils::add_rg_headers(hdr.get(), read_groups);
     }
 
-    utils::HtsFile hts_file("-", output_mode, thread_allocations.writer_threads);
+    utils::HtsFile hts_file("-", output_mode, thread_allocations.writer_threads, true);
 
     PipelineDescriptor pipeline_desc;
     std::string gpu_names{};
@@ -260,13 +260,17 @@ void setup(std::vector<std::string> args,
     // At present, header output file header writing relies on direct node method calls
     // rather than the pipeline framework.
     auto& hts_writer_ref = dynamic_cast<HtsWriter&>(pipeline->get_node_ref(hts_writer));
+
+    // Share the cores between the CPU bound nodes, according to where reads are backing up.
+    auto worker_slot_pool = cli::create_worker_slot_pool(*pipeline);
+    stats_reporters.push_back(stats::make_stats_reporter(*worker_slot_pool));
     if (enable_aligner) {
         const auto& aligner_ref = dynamic_cast<AlignerNode&>(pipeline->get_node_ref(aligner));
         utils::add_sq_hdr(hdr.get(), aligner_ref.get_sequence_records_for_header());
     }
     hts_file.set_and_write_header(hdr.get());
 
-    std::unordered_set<std::string> reads_already_processed;
+    utils::ReadIdSet reads_already_processed;
     if (!resume_from_file.empty()) {
         spdlog::info("> Inspecting resume file...");
         // Turn off warning logging as header info is fetched.
@@ -341,7 +345,7 @@ void setup(std::vector<std::string> args,
             [&](size_t progress) {
                 tracker.update_post_processing_progress(static_cast<float>(progress));
             },
-            thread_allocations.writer_threads, true);
+            thread_allocations.writer_threads);
 
     // Give the user a nice summary.
     tracker.summarize();
@@ -5,6 +5,7 @@
 #include <argparse.hpp>
 
 #include <chrono>
+#include <cstdint>
 #include <iostream>
 
 namespace dorado {
@@ -65,6 +66,51 @@ int benchmark(int argc, char* argv[]) {
                   << std::endl;
     }
 
+    // Signal normalisation as done by ScalerNode, averaged over a number of reads.
+    const int64_t read_samples = 500000;
+    const int num_reads = 20;
+    std::cerr << "normalisation samples : " << read_samples << std::endl;
+
+    auto signal = at::randint(0, 2047, read_samples).to(at::ScalarType::Short);
+    constexpr float factor = 1.4826f;
+    constexpr float eps = 1e-9f;
+
+    // Median/MAD and conversion through float32 temporaries.
+    at::Tensor normalised;
+    float med = 0.f;
+    float mad = 0.f;
+    auto start = std::chrono::system_clock::now();
+    for (int i = 0; i < num_reads; ++i) {
+        auto med_t = signal.median();
+        auto mad_t = at::median(at::abs(signal - med_t)) * factor + eps;
+        med = med_t.item<float>();
+        mad = mad_t.item<float>();
+        normalised = ((signal.to(at::kFloat) - med) / mad).to(at::ScalarType::Half);
+    }
+    auto end = std::chrono::system_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+    std::cerr << "torch:median "
+              << " med=" << med << " mad=" << mad << " " << duration / num_reads << "us"
+              << std::endl;
+
+    // Counting median/MAD and fused int16 -> float16 conversion.
+    auto fused = at::empty({read_samples}, at::ScalarType::Half);
+    start = std::chrono::system_clock::now();
+    for (int i = 0; i < num_reads; ++i) {
+        auto [med_i, mad_i] = utils::median_mad_counting(signal);
+        med = static_cast<float>(med_i);
+        mad = static_cast<float>(mad_i) * factor + eps;
+        utils::convert_i16_to_f16_normalised(fused.data_ptr<c10::Half>(),
+                                             signal.data_ptr<int16_t>(), read_samples, med, mad);
+    }
+    end = std::chrono::system_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+    std::cerr << "fused        "
+              << " med=" << med << " mad=" << mad << " " << duration / num_reads << "us"
+              << (at::equal(normalised, fused) ? "" : " (mismatch)") << std::endl;
+
     return 0;
 }
 
@@ -3,6 +3,8 @@
 
 #include "dorado_version.h"
 #include "models/kits.h"
+#include "read_pipeline/ReadPipeline.h"
+#include "read_pipeline/WorkerSlotPool.h"
 #include "utils/dev_utils.h"
 
 #include <optional>
@@ -29,10 +31,14 @@
 
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <cmath>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -62,6 +68,22 @@ inline std::pair<int, int> worker_vs_writer_thread_allocation(int available_thre
     return std::make_pair(aligner_threads, writer_threads);
 }
 
+// Creates a pool sharing the available cores between the CPU bound nodes of pipeline, so that
+// their combined input threads don't oversubscribe the machine.  The pool must be destroyed
+// before the pipeline.
+inline std::unique_ptr<WorkerSlotPool> create_worker_slot_pool(Pipeline& pipeline) {
+    const std::unordered_set<std::string> cpu_bound_nodes{
+            "ScalerNode",          "ReadSplitNode",         "AlignerNode",
+            "ReadToBamType",       "PolyACalculator",       "AdapterDetectorNode",
+            "ReadFilterNode",      "BarcodeClassifierNode", "StereoDuplexEncoderNode",
+            "ModBaseCallerNode"};
+    const int max_threads = utils::get_dev_opt<int>(
+            "max_worker_threads", static_cast<int>(std::thread::hardware_concurrency()));
+    auto pool = std::make_unique<WorkerSlotPool>(max_threads, std::chrono::milliseconds(100));
+    pool->add_nodes(pipeline, cpu_bound_nodes, 1);
+    return pool;
+}
+
 inline void add_pg_hdr(sam_hdr_t* hdr, const std::vector<std::string>& args, std::string device) {
     sam_hdr_add_lines(hdr, "@HD\tVN:1.6\tSO:unknown", 0);
 
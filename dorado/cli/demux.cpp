@@ -115,7 +115,9 @@ int demuxer(int argc, char* argv[]) {
             .implicit_value(true);
     parser.visible.add_argument("--sort-bam")
             .help("Sort any BAM output files that contain mapped reads. Using this option "
-                  "requires that the --no-trim option is also set.")
+                  "requires that the --no-trim option is also set. Up to 1 GB of memory is "
+                  "shared between the files for sorting, beyond which records are written to "
+                  "temporary files next to the output.")
             .default_value(false)
             .implicit_value(true);
     parser.visible.add_argument("--barcode-arrangement")
@@ -230,7 +232,7 @@ int demuxer(int argc, char* argv[]) {
     PipelineDescriptor pipeline_desc;
     auto demux_writer = pipeline_desc.add_node<BarcodeDemuxerNode>(
             {}, output_dir, demux_writer_threads, parser.visible.get<bool>("--emit-fastq"),
-            std::move(sample_sheet));
+            std::move(sample_sheet), sort_bam);
 
     if (parser.visible.is_used("--kit-name") || parser.visible.is_used("--barcode-arrangement")) {
         std::vector<std::string> kit_names;
@@ -312,8 +314,7 @@ int demuxer(int argc, char* argv[]) {
             [&](size_t progress) {
                 tracker.update_post_processing_progress(static_cast<float>(progress));
                 progress_stats.update_post_processing_progress(static_cast<float>(progress));
-            },
-            sort_bam);
+            });
 
     tracker.summarize();
     progress_stats.report_final_stats();
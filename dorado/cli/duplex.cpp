@@ -363,7 +363,7 @@ int duplex(int argc, char* argv[]) {
         cli::add_pg_hdr(hdr.get(), args, device);
 
         constexpr int WRITER_THREADS = 4;
-        utils::HtsFile hts_file("-", output_mode, WRITER_THREADS);
+        utils::HtsFile hts_file("-", output_mode, WRITER_THREADS, true);
 
         PipelineDescriptor pipeline_desc;
         auto hts_writer = PipelineDescriptor::InvalidNodeHandle;
@@ -395,6 +395,7 @@ int duplex(int argc, char* argv[]) {
                 read_ids_to_filter, 5);
 
         std::unique_ptr<dorado::Pipeline> pipeline;
+        std::unique_ptr<WorkerSlotPool> worker_slot_pool;
         ProgressTracker tracker(int(num_reads), duplex, hts_file.finalise_is_noop() ? 0.f : 0.5f);
         tracker.set_description("Running duplex");
         std::vector<dorado::stats::StatsCallable> stats_callables;
@@ -520,7 +521,7 @@ int duplex(int argc, char* argv[]) {
             api::create_stereo_duplex_pipeline(
                     pipeline_desc, std::move(runners), std::move(stereo_runners),
                     std::move(mod_base_runners), overlap, mean_qscore_start_pos,
-                    int(num_devices * 2), int(num_devices),
+                    int(num_devices * 2), int(num_devices), int(num_devices * 4),
                     int(default_parameters.remora_threads * num_devices),
                     std::move(pairing_parameters), read_filter_node,
                     PipelineDescriptor::InvalidNodeHandle);
@@ -540,6 +541,9 @@ int duplex(int argc, char* argv[]) {
             }
             hts_file.set_and_write_header(hdr.get());
 
+            worker_slot_pool = cli::create_worker_slot_pool(*pipeline);
+            stats_reporters.push_back(stats::make_stats_reporter(*worker_slot_pool));
+
             DataLoader loader(*pipeline, "cpu", num_devices, 0, std::move(read_list), {});
 
             stats_sampler = std::make_unique<dorado::stats::StatsSampler>(
@@ -566,7 +570,7 @@ int duplex(int argc, char* argv[]) {
                 [&](size_t progress) {
                     tracker.update_post_processing_progress(static_cast<float>(progress));
                 },
-                WRITER_THREADS, true);
+                WRITER_THREADS);
 
         tracker.summarize();
         if (!dump_stats_file.empty()) {
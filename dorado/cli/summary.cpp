@@ -21,6 +21,11 @@ int summary(int argc, char *argv[]) {
     argparse::ArgumentParser parser("dorado", DORADO_VERSION, argparse::default_arguments::help);
     parser.add_argument("reads").help("SAM/BAM file produced by dorado basecaller.");
     parser.add_argument("-s", "--separator").default_value(std::string("\t"));
+    parser.add_argument("-t", "--threads")
+            .help("Combined number of threads for decompression and output formatting. Default "
+                  "uses all available threads.")
+            .default_value(0)
+            .scan<'i', int>();
     int verbosity = 0;
     parser.add_argument("-v", "--verbose")
             .default_value(false)
@@ -44,9 +49,11 @@ int summary(int argc, char *argv[]) {
 
     auto reads(parser.get<std::string>("reads"));
     auto separator(parser.get<std::string>("separator"));
+    auto threads(parser.get<int>("threads"));
 
     SummaryData summary;
     summary.set_separator(separator[0]);
+    summary.set_threads(threads);
     summary.process_file(reads, std::cout);
 
     return 0;
@@ -141,7 +141,7 @@ int trim(int argc, char* argv[]) {
         custom_primer_file = parser.get<std::string>("--primer-sequences");
     }
 
-    utils::HtsFile hts_file("-", output_mode, trim_writer_threads);
+    utils::HtsFile hts_file("-", output_mode, trim_writer_threads, false);
     hts_file.set_and_write_header(header.get());
 
     PipelineDescriptor pipeline_desc;
@@ -185,7 +185,7 @@ int trim(int argc, char* argv[]) {
             [&](size_t progress) {
                 tracker.update_post_processing_progress(static_cast<float>(progress));
             },
-            trim_writer_threads, false);
+            trim_writer_threads);
     tracker.summarize();
 
     spdlog::info("> finished adapter/primer trimming");
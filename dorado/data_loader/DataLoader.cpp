@@ -18,17 +18,32 @@
 
 #include <algorithm>
 #include <cctype>
+#include <chrono>
+#include <cstring>
 #include <ctime>
 #include <filesystem>
 #include <mutex>
+#include <numeric>
 #include <optional>
 #include <stdexcept>
+#include <tuple>
 #include <vector>
 
 namespace dorado {
 
 namespace {
 
+// The maximum number of POD5 reads that can be queued for decoding at once.
+// POD5 files are typically written with 1000 reads per batch.
+constexpr size_t MAX_PENDING_POD5_READS = 2000;
+
+// When loading by channel, the reads of a group of channels are fetched together so that each file
+// is only opened once per group. A group holds at most this many reads, unless it's a single
+// channel with more.
+constexpr size_t MAX_POD5_CHANNEL_GROUP_READS = MAX_PENDING_POD5_READS;
+// Queued reads keep their file open, so limit how many files they can hold on to at once.
+constexpr size_t MAX_OPEN_POD5_READERS = 128;
+
 /**
  * @brief Fetches directory entries from a specified path.
  *
@@ -161,13 +176,10 @@ models::ChemistryKey get_chemistry_key(const RunInfoDictData_t* const run_info_d
     return key;
 }
 
-SimplexReadPtr process_pod5_read(
-        size_t row,
-        Pod5ReadRecordBatch* batch,
-        Pod5FileReader* file,
-        const std::string& path,
-        const std::unordered_map<int, std::vector<DataLoader::ReadSortInfo>>& reads_by_channel,
-        const std::unordered_map<std::string, size_t>& read_id_to_index) {
+SimplexReadPtr process_pod5_read(size_t row,
+                                 Pod5ReadRecordBatch* batch,
+                                 Pod5FileReader* file,
+                                 const std::string& path) {
     uint16_t read_table_version = 0;
     ReadBatchRowInfo_t read_data;
     if (pod5_get_read_batch_row_info_data(batch, row, READ_BATCH_ROW_INFO_VERSION, &read_data,
@@ -198,6 +210,7 @@ SimplexReadPtr process_pod5_read(
     }
 
     auto new_read = std::make_unique<SimplexRead>();
+    new_read->read_common.pipeline_entry_time = std::chrono::steady_clock::now();
     new_read->read_common.raw_data = samples;
     new_read->read_common.sample_rate = run_sample_rate;
 
@@ -246,32 +259,26 @@ SimplexReadPtr process_pod5_read(
         new_read->read_common.attributes.is_end_reason_mux_change = true;
     }
 
-    // Determine the time sorted predecessor of the read
-    // if that information is available (primarily used for offline
-    // duplex runs).
-    if (reads_by_channel.find(read_data.channel) != reads_by_channel.end()) {
-        auto& read_id = new_read->read_common.read_id;
-        const auto& v = reads_by_channel.at(read_data.channel);
-        auto read_id_iter = v.begin() + read_id_to_index.at(read_id);
-
-        if (read_id_iter != v.begin()) {
-            new_read->prev_read = std::prev(read_id_iter)->read_id;
-        }
-        if (std::next(read_id_iter) != v.end()) {
-            new_read->next_read = std::next(read_id_iter)->read_id;
-        }
-    }
-
     if (pod5_free_run_info(run_info_data) != POD5_OK) {
         spdlog::error("Failed to free run info");
     }
     return new_read;
 }
 
+// ReadId is either the string form of a read id, or the UUID bytes of one.
+template <typename ReadId>
+bool can_process_read_id(const ReadId& read_id,
+                         const std::optional<utils::ReadIdSet>& allowed_read_ids,
+                         const utils::ReadIdSet& ignored_read_ids) {
+    bool read_in_ignore_list = ignored_read_ids.contains(read_id);
+    bool read_in_read_list = !allowed_read_ids || allowed_read_ids->contains(read_id);
+    return !read_in_ignore_list && read_in_read_list;
+}
+
 bool can_process_pod5_row(Pod5ReadRecordBatch_t* batch,
                           int row,
-                          const std::optional<std::unordered_set<std::string>>& allowed_read_ids,
-                          const std::unordered_set<std::string>& ignored_read_ids) {
+                          const std::optional<utils::ReadIdSet>& allowed_read_ids,
+                          const utils::ReadIdSet& ignored_read_ids) {
     uint16_t read_table_version = 0;
     ReadBatchRowInfo_t read_data;
     if (pod5_get_read_batch_row_info_data(batch, row, READ_BATCH_ROW_INFO_VERSION, &read_data,
@@ -280,19 +287,31 @@ bool can_process_pod5_row(Pod5ReadRecordBatch_t* batch,
         return false;
     }
 
-    char read_id_tmp[POD5_READ_ID_LEN];
-    if (pod5_format_read_id(read_data.read_id, read_id_tmp) != POD5_OK) {
-        spdlog::error("Failed to format read id");
-    }
+    // The sets hold read ids as their UUID bytes, so there's no need to format the id.
+    utils::ReadIdSet::Uuid read_id;
+    static_assert(sizeof(read_data.read_id) == sizeof(read_id));
+    std::memcpy(read_id.data(), read_data.read_id, read_id.size());
+    return can_process_read_id(read_id, allowed_read_ids, ignored_read_ids);
+}
 
-    std::string read_id_str(read_id_tmp);
-    bool read_in_ignore_list = ignored_read_ids.find(read_id_str) != ignored_read_ids.end();
-    bool read_in_read_list =
-            !allowed_read_ids || (allowed_read_ids->find(read_id_str) != allowed_read_ids->end());
-    if (!read_in_ignore_list && read_in_read_list) {
-        return true;
+std::shared_ptr<Pod5FileReader_t> open_pod5_file(const std::string& path) {
+    Pod5FileReader_t* file = pod5_open_file(path.c_str());
+    if (!file) {
+        spdlog::error("Failed to open file {}: {}", path, pod5_get_error_string());
+        return nullptr;
     }
-    return false;
+    return std::shared_ptr<Pod5FileReader_t>(file, Pod5Destructor());
+}
+
+// The batch holds on to its file so that the reader isn't closed while the batch is in use.
+std::shared_ptr<Pod5ReadRecordBatch_t> make_shared_batch(Pod5ReadRecordBatch_t* batch,
+                                                         std::shared_ptr<Pod5FileReader_t> file) {
+    return std::shared_ptr<Pod5ReadRecordBatch_t>(
+            batch, [file = std::move(file)](Pod5ReadRecordBatch_t* b) {
+                if (pod5_free_read_batch(b) != POD5_OK) {
+                    spdlog::error("Failed to release batch");
+                }
+            });
 }
 
 }  // namespace
@@ -310,61 +329,48 @@ void DataLoader::load_reads(const std::filesystem::path& path,
     auto iterate_directory = [&](const auto& iterator) {
         switch (traversal_order) {
         case ReadOrder::BY_CHANNEL:
+            for (const auto& entry : iterator) {
+                auto entry_path = std::filesystem::path(entry);
+                std::string ext = entry_path.extension().string();
+                std::transform(ext.begin(), ext.end(), ext.begin(),
+                               [](unsigned char c) { return std::tolower(c); });
+                if (ext == ".fast5") {
+                    throw std::runtime_error(
+                            "Traversing reads by channel is only available for POD5. "
+                            "Encountered FAST5 at " +
+                            entry_path.string());
+                }
+            }
             // If traversal in channel order is required, the following algorithm
             // is used -
             // 1. iterate through all the read metadata to collect channel information
-            // across all pod5 files
-            // 2. store the read list sorted by channel number
+            // across all pod5 files, along with where each read is stored
             spdlog::info("> Reading read channel info");
             load_read_channels(path, recursive_file_loading);
             spdlog::info("> Processed read channel info");
-            // 3. for each channel, iterate through all files and in each iteration
-            // only load the reads that correspond to that channel.
-            for (int channel = 0; channel <= m_max_channel; channel++) {
-                if (m_reads_by_channel.find(channel) != m_reads_by_channel.end()) {
-                    // Sort the read ids within a channel by its mux
-                    // and start time.
-                    spdlog::debug("Sort channel {}", channel);
-                    auto& reads = m_reads_by_channel.at(channel);
-                    std::sort(reads.begin(), reads.end(), [](ReadSortInfo& a, ReadSortInfo& b) {
-                        if (a.mux != b.mux) {
-                            return a.mux < b.mux;
-                        } else {
-                            return a.read_number < b.read_number;
-                        }
-                    });
-                    // Once sorted, create a hash table from read id
-                    // to index in the sorted list to quickly fetch the
-                    // read location and its neighbors.
-                    for (size_t i = 0; i < reads.size(); i++) {
-                        m_read_id_to_index[reads[i].read_id] = i;
-                    }
-                    spdlog::debug("Sorted channel {}", channel);
+            // 2. split the channels into groups of consecutive channels, and load each group's
+            // reads directly from their batches. The readers are opened afresh for each group,
+            // since they accumulate memory as they're used.
+            for (int channel = 0; channel <= m_max_channel;) {
+                if (m_loaded_read_count == m_max_reads) {
+                    break;
                 }
-                for (const auto& entry : iterator) {
-                    if (m_loaded_read_count == m_max_reads) {
-                        break;
+                std::vector<int> channel_group;
+                size_t num_group_reads = 0;
+                for (; channel <= m_max_channel; channel++) {
+                    auto reads_it = m_reads_by_channel.find(channel);
+                    if (reads_it == m_reads_by_channel.end()) {
+                        continue;
                     }
-                    auto entry_path = std::filesystem::path(entry);
-                    std::string ext = entry_path.extension().string();
-                    std::transform(ext.begin(), ext.end(), ext.begin(),
-                                   [](unsigned char c) { return std::tolower(c); });
-                    if (ext == ".fast5") {
-                        throw std::runtime_error(
-                                "Traversing reads by channel is only available for POD5. "
-                                "Encountered FAST5 at " +
-                                entry_path.string());
-                    } else if (ext == ".pod5") {
-                        auto& channel_to_read_ids =
-                                m_file_channel_read_order_map.at(entry_path.string());
-                        auto& read_ids = channel_to_read_ids[channel];
-                        if (!read_ids.empty()) {
-                            load_pod5_reads_from_file_by_read_ids(entry_path.string(), read_ids);
-                        }
+                    const size_t num_channel_reads = reads_it->second.size();
+                    if (!channel_group.empty() &&
+                        num_group_reads + num_channel_reads > MAX_POD5_CHANNEL_GROUP_READS) {
+                        break;
                     }
+                    channel_group.push_back(channel);
+                    num_group_reads += num_channel_reads;
                 }
-                // Erase sorted list as it's not needed anymore.
-                m_reads_by_channel.erase(channel);
+                load_pod5_reads_by_channel_group(channel_group);
             }
             break;
         case ReadOrder::UNRESTRICTED:
@@ -392,11 +398,14 @@ void DataLoader::load_reads(const std::filesystem::path& path,
     auto filtered_entries =
             filter_fast5_for_mixed_datasets(fetch_directory_entries(path, recursive_file_loading));
     iterate_directory(filtered_entries);
+
+    // Make sure that every read has made it into the pipeline before returning.
+    wait_for_pending_reads(0);
 }
 
 int DataLoader::get_num_reads(std::filesystem::path data_path,
-                              std::optional<std::unordered_set<std::string>> read_list,
-                              const std::unordered_set<std::string>& ignore_read_list,
+                              std::optional<utils::ReadIdSet> read_list,
+                              const utils::ReadIdSet& ignore_read_list,
                               bool recursive_file_loading) {
     size_t num_reads = 0;
 
@@ -436,13 +445,9 @@ int DataLoader::get_num_reads(std::filesystem::path data_path,
     num_reads -= ignore_read_list.size();
 
     if (read_list) {
-        // Get the unique read ids in the read list, since everything in the ignore
-        // list will be skipped over.
-        std::vector<std::string> final_read_list;
-        std::set_difference(read_list->begin(), read_list->end(), ignore_read_list.begin(),
-                            ignore_read_list.end(),
-                            std::inserter(final_read_list, final_read_list.begin()));
-        num_reads = std::min(num_reads, final_read_list.size());
+        // Count the read ids in the read list which aren't in the ignore list, since
+        // everything in the ignore list will be skipped over.
+        num_reads = std::min(num_reads, read_list->count_not_in(ignore_read_list));
     }
 
     return int(num_reads);
@@ -460,10 +465,6 @@ void DataLoader::load_read_channels(std::filesystem::path data_path, bool recurs
             }
             pod5_init();
 
-            // Use a std::map to store by sorted channel order.
-            m_file_channel_read_order_map.emplace(file_path.string(), channel_to_read_id_t());
-            auto& channel_to_read_id = m_file_channel_read_order_map[file_path.string()];
-
             // Open the file ready for walking:
             Pod5FileReader_t* file = pod5_open_file(file_path.string().c_str());
 
@@ -472,6 +473,8 @@ void DataLoader::load_read_channels(std::filesystem::path data_path, bool recurs
                               pod5_get_error_string());
                 continue;
             }
+            const auto file_index = static_cast<uint32_t>(m_pod5_files.size());
+            m_pod5_files.push_back(file_path.string());
             std::size_t batch_count = 0;
             if (pod5_get_read_batch_count(&batch_count, file) != POD5_OK) {
                 spdlog::error("Failed to query batch count: {}", pod5_get_error_string());
@@ -505,18 +508,14 @@ void DataLoader::load_read_channels(std::filesystem::path data_path, bool recurs
                     // Update maximum number of channels encountered.
                     m_max_channel = std::max(m_max_channel, channel);
 
-                    // Store the read_id in the channel's list.
-                    ReadID read_id;
-                    std::memcpy(read_id.data(), read_data.read_id, POD5_READ_ID_SIZE);
-                    channel_to_read_id[channel].push_back(std::move(read_id));
-
                     char read_id_tmp[POD5_READ_ID_LEN];
                     if (pod5_format_read_id(read_data.read_id, read_id_tmp) != POD5_OK) {
                         spdlog::error("Failed to format read id");
                     }
-                    std::string rid(read_id_tmp);
+                    // Store the read in the channel's list, along with where to find it.
                     m_reads_by_channel[channel].push_back(
-                            {rid, read_data.well, read_data.read_number});
+                            {read_id_tmp, read_data.well, read_data.read_number, file_index,
+                             static_cast<uint32_t>(batch_index), static_cast<uint32_t>(row)});
                 }
 
                 if (pod5_free_read_batch(batch) != POD5_OK) {
@@ -775,96 +774,159 @@ std::set<models::ChemistryKey> DataLoader::get_sequencing_chemistry(std::filesys
     return chemistries;
 }
 
-void DataLoader::load_pod5_reads_from_file_by_read_ids(const std::string& path,
-                                                       const std::vector<ReadID>& read_ids) {
-    pod5_init();
-
-    // Open the file ready for walking:
-    // TODO: The earlier implementation was caching the pod5 readers into a
-    // map and re-using it during each iteration. However, we found a leak
-    // in the pod5 traversal API which persists unless the reader is opened
-    // and closed everytime. So the caching logic was reverted until the
-    // leak is fixed in pod5 API.
-    Pod5FileReader_t* file = pod5_open_file(path.c_str());
-
-    if (!file) {
-        spdlog::error("Failed to open file {}: {}", path, pod5_get_error_string());
-        return;
-    }
-
-    auto free_pod5 = [&]() {
-        if (pod5_close_and_free_reader(file) != POD5_OK) {
-            spdlog::error("Failed to close and free POD5 reader for file {}", path.c_str());
-        }
+void DataLoader::load_pod5_reads_by_channel_group(const std::vector<int>& channels) {
+    // The reads to load, in the order they're pushed to the pipeline.
+    struct GroupRead {
+        const ReadSortInfo* info;
+        std::string prev_read;
+        std::string next_read;
     };
+    std::vector<GroupRead> group_reads;
+    for (int channel : channels) {
+        auto& reads = m_reads_by_channel.at(channel);
+
+        // Sort the read ids within a channel by its mux and start time, so that each read's
+        // neighbours can be found.
+        spdlog::debug("Sort channel {}", channel);
+        std::sort(reads.begin(), reads.end(), [](const ReadSortInfo& a, const ReadSortInfo& b) {
+            if (a.mux != b.mux) {
+                return a.mux < b.mux;
+            } else {
+                return a.read_number < b.read_number;
+            }
+        });
+        spdlog::debug("Sorted channel {}", channel);
+
+        // Each channel's reads are pushed in the order that they're stored.
+        std::vector<size_t> channel_order(reads.size());
+        std::iota(channel_order.begin(), channel_order.end(), size_t(0));
+        std::sort(channel_order.begin(), channel_order.end(), [&reads](size_t a, size_t b) {
+            return std::tie(reads[a].file_index, reads[a].batch_index, reads[a].row) <
+                   std::tie(reads[b].file_index, reads[b].batch_index, reads[b].row);
+        });
+
+        for (size_t read_idx : channel_order) {
+            if (m_max_reads - m_loaded_read_count == group_reads.size()) {
+                break;
+            }
+            const auto& read_info = reads[read_idx];
+            if (!can_process_read_id(read_info.read_id, m_allowed_read_ids, m_ignored_read_ids)) {
+                continue;
+            }
 
-    auto post = utils::PostCondition(free_pod5);
-
-    std::vector<uint8_t> read_id_array(POD5_READ_ID_SIZE * read_ids.size());
-    for (size_t i = 0; i < read_ids.size(); i++) {
-        std::memcpy(read_id_array.data() + POD5_READ_ID_SIZE * i, read_ids[i].data(),
-                    POD5_READ_ID_SIZE);
-    }
-
-    std::size_t batch_count = 0;
-    if (pod5_get_read_batch_count(&batch_count, file) != POD5_OK) {
-        spdlog::error("Failed to query batch count: {}", pod5_get_error_string());
-    }
-
-    std::vector<std::uint32_t> traversal_batch_counts(batch_count);
-    std::vector<std::uint32_t> traversal_batch_rows(read_ids.size());
-    size_t find_success_count;
-    pod5_error_t err = pod5_plan_traversal(file, read_id_array.data(), read_ids.size(),
-                                           traversal_batch_counts.data(),
-                                           traversal_batch_rows.data(), &find_success_count);
-    if (err != POD5_OK) {
-        spdlog::error("Couldn't create plan for {} with reads {}", path, read_ids.size());
-        return;
+            // Determine the time sorted predecessor and successor of the read
+            // (primarily used for offline duplex runs).
+            std::string prev_read = read_idx > 0 ? reads[read_idx - 1].read_id : std::string();
+            std::string next_read =
+                    read_idx + 1 < reads.size() ? reads[read_idx + 1].read_id : std::string();
+            group_reads.push_back({&read_info, std::move(prev_read), std::move(next_read)});
+        }
     }
 
-    if (find_success_count != read_ids.size()) {
-        spdlog::error("Reads found by plan {}, reads in input {}", find_success_count,
-                      read_ids.size());
-        throw std::runtime_error("Plan traveral didn't yield correct number of reads");
+    // Fetch the reads of the whole group in the order that they're stored, so that each file is
+    // only opened once per group, and each batch fetched once.
+    std::vector<size_t> load_order(group_reads.size());
+    std::iota(load_order.begin(), load_order.end(), size_t(0));
+    std::sort(load_order.begin(), load_order.end(), [&group_reads](size_t a, size_t b) {
+        const auto& info_a = *group_reads[a].info;
+        const auto& info_b = *group_reads[b].info;
+        return std::tie(info_a.file_index, info_a.batch_index, info_a.row) <
+               std::tie(info_b.file_index, info_b.batch_index, info_b.row);
+    });
+
+    // The reads of a single channel are already in load order, so they can be queued to be pushed
+    // as they're fetched. Otherwise they're held until the whole group has been fetched, and then
+    // queued channel by channel so that the output stays channel ordered. Such a group holds no
+    // more than MAX_POD5_CHANNEL_GROUP_READS reads, so make room for them up front.
+    const bool queue_in_load_order = channels.size() == 1;
+    std::vector<std::future<SimplexReadPtr>> group_futures(group_reads.size());
+    if (!queue_in_load_order) {
+        wait_for_pending_reads(MAX_PENDING_POD5_READS -
+                               std::min(group_reads.size(), MAX_PENDING_POD5_READS));
     }
+    auto wait_for_queued_reads = [&] {
+        if (queue_in_load_order) {
+            wait_for_pending_reads(0);
+        } else {
+            for (auto& future : group_futures) {
+                if (future.valid()) {
+                    future.wait();
+                }
+            }
+        }
+    };
 
-    // Create static threadpool so it is reused across calls to this function.
-    static cxxpool::thread_pool pool{m_num_worker_threads};
-
-    uint32_t row_offset = 0;
-    for (std::size_t batch_index = 0; batch_index < batch_count; ++batch_index) {
-        if (m_loaded_read_count == m_max_reads) {
-            break;
+    std::shared_ptr<Pod5FileReader_t> file;
+    std::shared_ptr<Pod5ReadRecordBatch_t> batch;
+    std::optional<uint32_t> file_index;
+    std::optional<std::pair<uint32_t, uint32_t>> batch_location;
+    size_t num_files_opened = 0;
+    for (size_t read_idx : load_order) {
+        const auto& read_info = *group_reads[read_idx].info;
+        if (read_info.file_index != file_index) {
+            file_index = read_info.file_index;
+            batch_location.reset();
+            batch.reset();
+            file.reset();
+            if (num_files_opened > 0 && num_files_opened % MAX_OPEN_POD5_READERS == 0) {
+                // Don't run out of file handles if there are a lot of files.
+                wait_for_queued_reads();
+            }
+            file = open_pod5_file(m_pod5_files.at(read_info.file_index));
+            ++num_files_opened;
+            ++m_num_pod5_files_opened;
         }
-        Pod5ReadRecordBatch_t* batch = nullptr;
-        if (pod5_get_read_batch(&batch, file, batch_index) != POD5_OK) {
-            spdlog::error("Failed to get batch: {}", pod5_get_error_string());
+        if (!file) {
             continue;
         }
 
-        std::vector<std::future<SimplexReadPtr>> futures;
-        for (std::size_t row_idx = 0; row_idx < traversal_batch_counts[batch_index]; row_idx++) {
-            uint32_t row = traversal_batch_rows[row_idx + row_offset];
-
-            if (can_process_pod5_row(batch, row, m_allowed_read_ids, m_ignored_read_ids)) {
-                futures.push_back(pool.push(process_pod5_read, row, batch, file, std::cref(path),
-                                            std::cref(m_reads_by_channel),
-                                            std::cref(m_read_id_to_index)));
+        const auto location = std::make_pair(read_info.file_index, read_info.batch_index);
+        if (location != batch_location) {
+            batch_location = location;
+            batch.reset();
+            Pod5ReadRecordBatch_t* batch_ptr = nullptr;
+            if (pod5_get_read_batch(&batch_ptr, file.get(), read_info.batch_index) != POD5_OK) {
+                spdlog::error("Failed to get batch: {}", pod5_get_error_string());
+                continue;
             }
+            batch = make_shared_batch(batch_ptr, file);
+        }
+        if (!batch) {
+            continue;
         }
 
-        for (auto& v : futures) {
-            auto read = v.get();
-            check_read(read);
-            m_pipeline.push_message(std::move(read));
-            m_loaded_read_count++;
+        if (queue_in_load_order) {
+            wait_for_pending_reads(MAX_PENDING_POD5_READS - 1);
         }
 
-        if (pod5_free_read_batch(batch) != POD5_OK) {
-            spdlog::error("Failed to release batch");
+        // The decoded reads are returned to be pushed in order.
+        const std::string* path = &m_pod5_files[read_info.file_index];
+        auto future = m_thread_pool->push(
+                [row = read_info.row, batch, file, path,
+                 prev_read = std::move(group_reads[read_idx].prev_read),
+                 next_read = std::move(group_reads[read_idx].next_read)]() mutable {
+                    auto read = process_pod5_read(row, batch.get(), file.get(), *path);
+                    read->prev_read = std::move(prev_read);
+                    read->next_read = std::move(next_read);
+                    return read;
+                });
+        if (queue_in_load_order) {
+            m_pending_reads.push_back(std::move(future));
+        } else {
+            group_futures[read_idx] = std::move(future);
         }
+        m_loaded_read_count++;
+    }
 
-        row_offset += traversal_batch_counts[batch_index];
+    for (auto& future : group_futures) {
+        if (future.valid()) {
+            m_pending_reads.push_back(std::move(future));
+        }
+    }
+
+    // Erase the sorted lists as they're not needed anymore.
+    for (int channel : channels) {
+        m_reads_by_channel.erase(channel);
     }
 }
 
@@ -872,60 +934,73 @@ void DataLoader::load_pod5_reads_from_file(const std::string& path) {
     pod5_init();
 
     // Open the file ready for walking:
-    Pod5FileReader_t* file = pod5_open_file(path.c_str());
-
+    // The reader is shared with the batches, and through them the reads that are still being
+    // decoded, so it stays open until the last of them is done with it.
+    auto file = open_pod5_file(path);
+    ++m_num_pod5_files_opened;
     if (!file) {
-        spdlog::error("Failed to open file {}: {}", path, pod5_get_error_string());
+        return;
     }
 
     std::size_t batch_count = 0;
-    if (pod5_get_read_batch_count(&batch_count, file) != POD5_OK) {
+    if (pod5_get_read_batch_count(&batch_count, file.get()) != POD5_OK) {
         spdlog::error("Failed to query batch count: {}", pod5_get_error_string());
     }
 
-    cxxpool::thread_pool pool{m_num_worker_threads};
+    auto shared_path = std::make_shared<const std::string>(path);
 
     for (std::size_t batch_index = 0; batch_index < batch_count; ++batch_index) {
         if (m_loaded_read_count == m_max_reads) {
             break;
         }
-        Pod5ReadRecordBatch_t* batch = nullptr;
-        if (pod5_get_read_batch(&batch, file, batch_index) != POD5_OK) {
+        Pod5ReadRecordBatch_t* batch_ptr = nullptr;
+        if (pod5_get_read_batch(&batch_ptr, file.get(), batch_index) != POD5_OK) {
             spdlog::error("Failed to get batch: {}", pod5_get_error_string());
+            continue;
         }
+        auto batch = make_shared_batch(batch_ptr, file);
 
         std::size_t batch_row_count = 0;
-        if (pod5_get_read_batch_row_count(&batch_row_count, batch) != POD5_OK) {
+        if (pod5_get_read_batch_row_count(&batch_row_count, batch.get()) != POD5_OK) {
             spdlog::error("Failed to get batch row count");
         }
-        batch_row_count = std::min(batch_row_count, m_max_reads - m_loaded_read_count);
 
-        std::vector<std::future<SimplexReadPtr>> futures;
-
-        for (std::size_t row = 0; row < batch_row_count; ++row) {
-            // TODO - check the read ID here, for each one, only send the row if it is in the list of ones we care about
-
-            if (can_process_pod5_row(batch, int(row), m_allowed_read_ids, m_ignored_read_ids)) {
-                futures.push_back(pool.push(process_pod5_read, row, batch, file, std::cref(path),
-                                            std::cref(m_reads_by_channel),
-                                            std::cref(m_read_id_to_index)));
+        for (std::size_t row = 0; row < batch_row_count && m_loaded_read_count < m_max_reads;
+             ++row) {
+            if (!can_process_pod5_row(batch.get(), int(row), m_allowed_read_ids,
+                                      m_ignored_read_ids)) {
+                continue;
             }
-        }
 
-        for (auto& v : futures) {
-            auto read = v.get();
-            check_read(read);
-            m_pipeline.push_message(std::move(read));
+            // Don't let the loader get too far ahead of the decoding. This still leaves enough
+            // rows queued that the next batch (or file) is fetched while this one is decoded.
+            wait_for_pending_reads(MAX_PENDING_POD5_READS - 1);
+
+            // Each read is pushed to the pipeline as soon as it's decoded, rather than waiting
+            // for the rest of its batch.
+            m_pending_reads.push_back(m_thread_pool->push([this, row, batch, file, shared_path] {
+                auto read = process_pod5_read(row, batch.get(), file.get(), *shared_path);
+                check_read(read);
+                m_pipeline.push_message(std::move(read));
+                return SimplexReadPtr();
+            }));
+            // Reads are counted as they're queued so that the max reads limit can be applied
+            // without waiting for them to be decoded.
             m_loaded_read_count++;
         }
+    }
+}
 
-        if (pod5_free_read_batch(batch) != POD5_OK) {
-            spdlog::error("Failed to release batch");
+void DataLoader::wait_for_pending_reads(size_t max_pending_reads) {
+    while (m_pending_reads.size() > max_pending_reads) {
+        // get() rethrows any exception from decoding the read.
+        auto read = m_pending_reads.front().get();
+        m_pending_reads.pop_front();
+        if (read) {
+            check_read(read);
+            m_pipeline.push_message(std::move(read));
         }
     }
-    if (pod5_close_and_free_reader(file) != POD5_OK) {
-        spdlog::error("Failed to close and free POD5 reader");
-    }
 }
 
 void DataLoader::load_fast5_reads_from_file(const std::string& path) {
@@ -1001,6 +1076,7 @@ void DataLoader::load_fast5_reads_from_file(const std::string& path) {
                                                  static_cast<uint32_t>(start_time / sampling_rate));
 
         auto new_read = std::make_unique<SimplexRead>();
+        new_read->read_common.pipeline_entry_time = std::chrono::steady_clock::now();
         new_read->read_common.sample_rate = uint64_t(sampling_rate);
         new_read->read_common.raw_data = samples;
         new_read->digitisation = digitisation;
@@ -1019,8 +1095,7 @@ void DataLoader::load_fast5_reads_from_file(const std::string& path) {
         new_read->read_common.experiment_id = group_protocol_id;
         new_read->read_common.is_duplex = false;
 
-        if (!m_allowed_read_ids || (m_allowed_read_ids->find(new_read->read_common.read_id) !=
-                                    m_allowed_read_ids->end())) {
+        if (!m_allowed_read_ids || m_allowed_read_ids->contains(new_read->read_common.read_id)) {
             m_pipeline.push_message(std::move(new_read));
             m_loaded_read_count++;
         }
@@ -1040,20 +1115,26 @@ DataLoader::DataLoader(Pipeline& pipeline,
                        const std::string& device,
                        size_t num_worker_threads,
                        size_t max_reads,
-                       std::optional<std::unordered_set<std::string>> read_list,
-                       std::unordered_set<std::string> read_ignore_list)
+                       std::optional<utils::ReadIdSet> read_list,
+                       utils::ReadIdSet read_ignore_list)
         : m_pipeline(pipeline),
           m_device(device),
           m_num_worker_threads(num_worker_threads),
           m_allowed_read_ids(std::move(read_list)),
-          m_ignored_read_ids(std::move(read_ignore_list)) {
+          m_ignored_read_ids(std::move(read_ignore_list)),
+          m_thread_pool(std::make_unique<cxxpool::thread_pool>(num_worker_threads)) {
     m_max_reads = max_reads == 0 ? std::numeric_limits<decltype(m_max_reads)>::max() : max_reads;
     assert(m_num_worker_threads > 0);
     static std::once_flag vbz_init_flag;
     std::call_once(vbz_init_flag, vbz_register);
 }
 
+DataLoader::~DataLoader() = default;
+
 stats::NamedStats DataLoader::sample_stats() const {
-    return stats::NamedStats{{"loaded_read_count", static_cast<double>(m_loaded_read_count)}};
+    return stats::NamedStats{
+            {"loaded_read_count", static_cast<double>(m_loaded_read_count)},
+            {"pod5_files_opened", static_cast<double>(m_num_pod5_files_opened)},
+    };
 }
 }  // namespace dorado
@@ -1,21 +1,26 @@
 #pragma once
 #include "models/models.h"
 #include "read_pipeline/messages.h"
+#include "utils/ReadIdSet.h"
 #include "utils/stats.h"
 #include "utils/types.h"
 
 #include <array>
+#include <deque>
 #include <filesystem>
-#include <map>
+#include <future>
 #include <memory>
 #include <optional>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 struct Pod5FileReader;
 
+namespace cxxpool {
+class thread_pool;
+}
+
 namespace dorado {
 
 class Pipeline;
@@ -23,7 +28,6 @@ struct ReadGroup;
 
 constexpr size_t POD5_READ_ID_SIZE = 16;
 using ReadID = std::array<uint8_t, POD5_READ_ID_SIZE>;
-typedef std::map<int, std::vector<ReadID>> channel_to_read_id_t;
 
 struct Pod5Destructor {
     void operator()(Pod5FileReader*);
@@ -36,9 +40,9 @@ public:
                const std::string& device,
                size_t num_worker_threads,
                size_t max_reads,
-               std::optional<std::unordered_set<std::string>> read_list,
-               std::unordered_set<std::string> read_ignore_list);
-    ~DataLoader() = default;
+               std::optional<utils::ReadIdSet> read_list,
+               utils::ReadIdSet read_ignore_list);
+    ~DataLoader();
     void load_reads(const std::filesystem::path& path,
                     bool recursive_file_loading,
                     ReadOrder traversal_order);
@@ -50,8 +54,8 @@ public:
             bool recursive_file_loading);
 
     static int get_num_reads(std::filesystem::path data_path,
-                             std::optional<std::unordered_set<std::string>> read_list,
-                             const std::unordered_set<std::string>& ignore_read_list,
+                             std::optional<utils::ReadIdSet> read_list,
+                             const utils::ReadIdSet& ignore_read_list,
                              bool recursive_file_loading);
 
     static bool is_read_data_present(std::filesystem::path data_path, bool recursive_file_loading);
@@ -68,32 +72,47 @@ public:
         std::string read_id;
         int32_t mux;
         uint32_t read_number;
+        // Where the read lives in the POD5 files.
+        uint32_t file_index;
+        uint32_t batch_index;
+        uint32_t row;
     };
 
 private:
     void load_fast5_reads_from_file(const std::string& path);
     void load_pod5_reads_from_file(const std::string& path);
-    void load_pod5_reads_from_file_by_read_ids(const std::string& path,
-                                               const std::vector<ReadID>& read_ids);
+    // Loads the reads of a group of channels, pushing them in channel order.
+    void load_pod5_reads_by_channel_group(const std::vector<int>& channels);
     void load_read_channels(std::filesystem::path data_path, bool recursive_file_loading);
 
+    // Wait until at most |max_pending_reads| POD5 reads are still waiting to be decoded.
+    void wait_for_pending_reads(size_t max_pending_reads);
+
     Pipeline& m_pipeline;  // Where should the loaded reads go?
     std::atomic<size_t> m_loaded_read_count{0};
     std::string m_device;
     size_t m_num_worker_threads{1};
     size_t m_max_reads{0};
-    std::optional<std::unordered_set<std::string>> m_allowed_read_ids;
-    std::unordered_set<std::string> m_ignored_read_ids;
+    std::optional<utils::ReadIdSet> m_allowed_read_ids;
+    utils::ReadIdSet m_ignored_read_ids;
 
-    std::unordered_map<std::string, channel_to_read_id_t> m_file_channel_read_order_map;
+    // Members for loading reads in channel order.
+    std::vector<std::string> m_pod5_files;
     std::unordered_map<int, std::vector<ReadSortInfo>> m_reads_by_channel;
-    std::unordered_map<std::string, size_t> m_read_id_to_index;
     int m_max_channel{0};
+    std::atomic<size_t> m_num_pod5_files_opened{0};
 
     // Issue warnings if read is potentially problematic
     inline void check_read(const SimplexReadPtr& read);
     // A flag to warn only once if the data chemsitry is known
     std::atomic<bool> m_log_unknown_chemistry{true};
+
+    // Reads which have been handed to the thread pool to be decoded. Tasks that return a read
+    // leave it to be pushed to the pipeline in order, others push their read themselves.
+    std::deque<std::future<SimplexReadPtr>> m_pending_reads;
+    // Shared across all files so that decoding one file can overlap with loading the next.
+    // Declared last so that the workers are joined before anything they use is destroyed.
+    std::unique_ptr<cxxpool::thread_pool> m_thread_pool;
 };
 
 }  // namespace dorado
@@ -6,7 +6,6 @@
 #include "utils/sequence_utils.h"
 #include "utils/types.h"
 
-#include <edlib.h>
 #include <htslib/sam.h>
 #include <spdlog/spdlog.h>
 
@@ -23,18 +22,9 @@ namespace {
 const int ADAPTER_TRIM_LENGTH = 75;
 const int PRIMER_TRIM_LENGTH = 150;
 
-// Create edlib configuration for detecting adapters and primers.
-EdlibAlignConfig init_edlib_config_for_adapters() {
-    EdlibAlignConfig placement_config = edlibDefaultAlignConfig();
-    placement_config.mode = EDLIB_MODE_HW;
-    placement_config.task = EDLIB_TASK_PATH;
-    // Currently none of our adapters or primers have Ns, but we should support them.
-    static const EdlibEqualityPair additionalEqualities[4] = {
-            {'N', 'A'}, {'N', 'T'}, {'N', 'C'}, {'N', 'G'}};
-    placement_config.additionalEqualities = additionalEqualities;
-    placement_config.additionalEqualitiesLength = 4;
-    return placement_config;
-}
+// Currently none of our adapters or primers have Ns, but we should support them.
+const std::vector<std::pair<char, char>> ADAPTER_EQUALITIES = {
+        {'N', 'A'}, {'N', 'T'}, {'N', 'C'}, {'N', 'G'}};
 
 // For adapters, we there are specific sequences we look for at the front of the read. We don't look for exactly
 // the reverse complement at the rear of the read, though, because it will generally be truncated. So we list here
@@ -87,6 +77,8 @@ AdapterDetector::AdapterDetector(const std::optional<std::string>& custom_primer
             m_primer_sequences[i].sequence_rev = utils::reverse_complement(primers[i].sequence);
         }
     }
+    m_adapter_banks = make_query_banks(m_adapter_sequences, ADAPTER);
+    m_primer_banks = make_query_banks(m_primer_sequences, PRIMER);
 }
 
 AdapterDetector::~AdapterDetector() = default;
@@ -104,11 +96,11 @@ void AdapterDetector::parse_custom_sequence_file(const std::string& filename) {
 }
 
 AdapterScoreResult AdapterDetector::find_adapters(const std::string& seq) const {
-    return detect(seq, m_adapter_sequences, ADAPTER);
+    return detect(seq, m_adapter_banks, ADAPTER);
 }
 
 AdapterScoreResult AdapterDetector::find_primers(const std::string& seq) const {
-    return detect(seq, m_primer_sequences, PRIMER);
+    return detect(seq, m_primer_banks, PRIMER);
 }
 
 const std::vector<AdapterDetector::Query>& AdapterDetector::get_adapter_sequences() const {
@@ -119,18 +111,48 @@ const std::vector<AdapterDetector::Query>& AdapterDetector::get_primer_sequences
     return m_primer_sequences;
 }
 
-static SingleEndResult copy_results(const EdlibAlignResult& source,
-                                    const std::string& name,
-                                    size_t length) {
-    SingleEndResult dest;
-    dest.name = name;
-    dest.score = 1.0f - float(source.editDistance) / length;
-    dest.position = {source.startLocations[0], source.endLocations[0]};
-    return dest;
+AdapterDetector::QueryBanks AdapterDetector::make_query_banks(const std::vector<Query>& queries,
+                                                              QueryType query_type) {
+    std::vector<std::string> front_sequences, rear_sequences;
+    QueryBanks banks;
+    for (const auto& query : queries) {
+        banks.front_names.push_back(query.name + "_FWD");
+        front_sequences.push_back(query.sequence);
+        if (query_type == PRIMER) {
+            // For primers we look for both the forward and reverse sequence at both ends.
+            banks.front_names.push_back(query.name + "_REV");
+            front_sequences.push_back(query.sequence_rev);
+        }
+
+        banks.rear_names.push_back(query.name + "_REV");
+        rear_sequences.push_back(query.sequence_rev);
+        if (query_type == PRIMER) {
+            banks.rear_names.push_back(query.name + "_FWD");
+            rear_sequences.push_back(query.sequence);
+        }
+    }
+    banks.front = PatternBank(front_sequences, ADAPTER_EQUALITIES);
+    banks.rear = PatternBank(rear_sequences, ADAPTER_EQUALITIES);
+    return banks;
+}
+
+static std::vector<SingleEndResult> copy_results(const std::vector<PatternBank::InfixMatch>& source,
+                                                 const std::vector<std::string>& names,
+                                                 const PatternBank& bank,
+                                                 int offset) {
+    std::vector<SingleEndResult> results(source.size());
+    for (size_t i = 0; i < source.size(); ++i) {
+        auto& dest = results[i];
+        dest.name = names[i];
+        dest.score = 1.0f - float(source[i].edit_distance) / bank.pattern(i).length();
+        dest.position = {offset + source[i].start, offset + source[i].end};
+        spdlog::trace("Checking adapter/primer {} score {}", dest.name, dest.score);
+    }
+    return results;
 }
 
 AdapterScoreResult AdapterDetector::detect(const std::string& seq,
-                                           const std::vector<Query>& queries,
+                                           const QueryBanks& banks,
                                            AdapterDetector::QueryType query_type) const {
     const std::string_view seq_view(seq);
     const auto TRIM_LENGTH = (query_type == ADAPTER ? ADAPTER_TRIM_LENGTH : PRIMER_TRIM_LENGTH);
@@ -139,46 +161,11 @@ AdapterScoreResult AdapterDetector::detect(const std::string& seq,
     const std::string_view read_rear = seq_view.substr(rear_start, TRIM_LENGTH);
 
     // Try to find the location of the queries in the front and rear windows.
-    EdlibAlignConfig placement_config = init_edlib_config_for_adapters();
-
-    std::vector<SingleEndResult> front_results, rear_results;
-    for (size_t i = 0; i < queries.size(); i++) {
-        const auto& name = queries[i].name;
-        const auto& query_seq = queries[i].sequence;
-        const auto& query_seq_rev = queries[i].sequence_rev;
-        spdlog::trace("Checking adapter/primer {}", name);
+    auto front_results = copy_results(banks.front.infix_matches(read_front), banks.front_names,
+                                      banks.front, 0);
+    auto rear_results = copy_results(banks.rear.infix_matches(read_rear), banks.rear_names,
+                                     banks.rear, rear_start);
 
-        auto front_result = edlibAlign(query_seq.data(), int(query_seq.length()), read_front.data(),
-                                       int(read_front.length()), placement_config);
-        front_results.emplace_back(copy_results(front_result, name + "_FWD", query_seq.length()));
-        edlibFreeAlignResult(front_result);
-        if (query_type == PRIMER) {
-            // For primers we look for both the forward and reverse sequence at both ends.
-            auto front_result_rev =
-                    edlibAlign(query_seq_rev.data(), int(query_seq_rev.length()), read_front.data(),
-                               int(read_front.length()), placement_config);
-            front_results.emplace_back(
-                    copy_results(front_result_rev, name + "_REV", query_seq_rev.length()));
-            edlibFreeAlignResult(front_result_rev);
-        }
-
-        auto rear_result = edlibAlign(query_seq_rev.data(), int(query_seq_rev.length()),
-                                      read_rear.data(), int(read_rear.length()), placement_config);
-        rear_results.emplace_back(copy_results(rear_result, name + "_REV", query_seq_rev.length()));
-        rear_results.back().position.first += rear_start;
-        rear_results.back().position.second += rear_start;
-        edlibFreeAlignResult(rear_result);
-        if (query_type == PRIMER) {
-            auto rear_result_fwd =
-                    edlibAlign(query_seq.data(), int(query_seq.length()), read_rear.data(),
-                               int(read_rear.length()), placement_config);
-            rear_results.emplace_back(
-                    copy_results(rear_result_fwd, name + "_FWD", query_seq.length()));
-            rear_results.back().position.first += rear_start;
-            rear_results.back().position.second += rear_start;
-            edlibFreeAlignResult(rear_result_fwd);
-        }
-    }
     int best_front = -1, best_rear = -1;
     float best_front_score = -1.0f, best_rear_score = -1.0f;
     const float EPSILON = 0.1f;
@@ -1,4 +1,5 @@
 #pragma once
+#include "PatternBank.h"
 #include "read_pipeline/messages.h"
 #include "utils/stats.h"
 #include "utils/types.h"
@@ -35,10 +36,22 @@ public:
 private:
     enum QueryType { ADAPTER, PRIMER };
 
+    // The sequences to look for at each end of the read, compiled so that
+    // they can all be scored against the same window in a single pass.
+    struct QueryBanks {
+        std::vector<std::string> front_names;
+        PatternBank front;
+        std::vector<std::string> rear_names;
+        PatternBank rear;
+    };
+
     std::vector<Query> m_adapter_sequences;
     std::vector<Query> m_primer_sequences;
+    QueryBanks m_adapter_banks;
+    QueryBanks m_primer_banks;
+    static QueryBanks make_query_banks(const std::vector<Query>& queries, QueryType query_type);
     AdapterScoreResult detect(const std::string& seq,
-                              const std::vector<Query>& queries,
+                              const QueryBanks& banks,
                               QueryType query_type) const;
     void parse_custom_sequence_file(const std::string& custom_sequence_file);
 };
@@ -1,5 +1,6 @@
 #include "BarcodeClassifier.h"
 
+#include "PatternBank.h"
 #include "parse_custom_sequences.h"
 #include "utils/alignment_utils.h"
 #include "utils/barcode_kits.h"
@@ -36,16 +37,6 @@ EdlibAlignConfig init_edlib_config_for_flanks() {
     return placement_config;
 }
 
-// Create edlib configuration for aligning each barcode against
-// the detected region.
-EdlibAlignConfig init_edlib_config_for_mask() {
-    EdlibAlignConfig mask_config = edlibDefaultAlignConfig();
-    mask_config.mode = EDLIB_MODE_NW;
-    mask_config.task =
-            (spdlog::get_level() == spdlog::level::trace) ? EDLIB_TASK_PATH : EDLIB_TASK_LOC;
-    return mask_config;
-}
-
 // Extract the position of the barcode mask in the read based
 // on the local alignment result from edlib.
 int extract_mask_location(EdlibAlignResult aln, std::string_view query) {
@@ -93,28 +84,31 @@ std::tuple<EdlibAlignResult, float, int> extract_flank_fit(std::string_view stra
     return {result, score, bc_loc};
 }
 
-// Helper function to globally align a barcode to a region
-// within the read.
-int extract_barcode_penalty(std::string_view barcode,
-                            std::string_view read,
-                            const EdlibAlignConfig& config,
-                            const char* debug_prefix) {
+// Helper to log the penalty of a barcode against a region within the read,
+// along with their global alignment when tracing.
+void trace_barcode_penalty(std::string_view barcode,
+                           std::string_view read,
+                           int penalty,
+                           const char* debug_prefix) {
+    spdlog::trace("{} {}", debug_prefix, penalty);
+    if (spdlog::get_level() != spdlog::level::trace) {
+        return;
+    }
+    EdlibAlignConfig config = edlibDefaultAlignConfig();
+    config.mode = EDLIB_MODE_NW;
+    config.task = EDLIB_TASK_PATH;
     auto result = edlibAlign(barcode.data(), int(barcode.length()), read.data(), int(read.length()),
                              config);
-    auto penalty = result.editDistance;
-    spdlog::trace("{} {}", debug_prefix, penalty);
     spdlog::trace("\n{}", utils::alignment_to_str(barcode.data(), read.data(), result));
     edlibFreeAlignResult(result);
-    return penalty;
 }
 
 bool barcode_is_permitted(const BarcodingInfo::FilterSet& allowed_barcodes,
-                          const std::string& barcode_name) {
+                          const std::string& normalized_barcode_name) {
     if (!allowed_barcodes.has_value()) {
         return true;
     }
 
-    auto normalized_barcode_name = barcode_kits::normalize_barcode_name(barcode_name);
     return allowed_barcodes->count(normalized_barcode_name) != 0;
 }
 
@@ -166,6 +160,19 @@ std::string extract_right_buffer(const std::string& flank, int buffer) {
     return flank.substr(0, buffer);
 }
 
+// Helper to compile the barcodes, padded with the buffers either side
+// of them, for aligning against the mask region of a read.
+demux::PatternBank make_padded_barcodes(const std::vector<std::string>& barcodes,
+                                        const std::string& left_buffer,
+                                        const std::string& right_buffer) {
+    std::vector<std::string> padded;
+    padded.reserve(barcodes.size());
+    for (const auto& barcode : barcodes) {
+        padded.push_back(left_buffer + barcode + right_buffer);
+    }
+    return demux::PatternBank(padded);
+}
+
 // Helper to pick the top or bottom window in a barcode. The one
 // with lower penalty and higher flank score is preferred. If both
 // are not satisfied by one of the windows, then just decide based
@@ -208,7 +215,15 @@ struct BarcodeClassifier::BarcodeCandidateKit {
     std::string bottom_context_rev;
     std::string bottom_context_rev_left_buffer;
     std::string bottom_context_rev_right_buffer;
+    // Each of the barcodes, padded with the buffers of a context, for scoring
+    // all of them against the mask region of that context at once.
+    PatternBank top_barcodes;
+    PatternBank top_barcodes_rev;
+    PatternBank bottom_barcodes;
+    PatternBank bottom_barcodes_rev;
     std::vector<std::string> barcode_names;
+    // The barcode names as they appear in the allowed barcodes filter.
+    std::vector<std::string> normalized_barcode_names;
     // This is the specific barcode kit product name
     // that is selected by the user, such as SQK-RBK114-96
     // or EXP-PBC096
@@ -216,6 +231,8 @@ struct BarcodeClassifier::BarcodeCandidateKit {
     // This is the barcode ligation group name, such as RAB
     // or 16S, which is shared by multiple product names.
     std::string barcode_kit;
+    bool double_ends{false};
+    bool ends_different{false};
 };
 
 BarcodeClassifier::BarcodeClassifier(const std::vector<std::string>& kit_names,
@@ -309,6 +326,8 @@ std::vector<BarcodeClassifier::BarcodeCandidateKit> BarcodeClassifier::generate_
         BarcodeCandidateKit candidate;
         candidate.kit = kit_name;
         candidate.barcode_kit = kit_info.name;
+        candidate.double_ends = kit_info.double_ends;
+        candidate.ends_different = kit_info.ends_different;
         const auto& ref_bc_name = kit_info.barcodes[0];
         const auto& ref_bc = get_barcode_sequence(ref_bc_name);
 
@@ -392,8 +411,23 @@ std::vector<BarcodeClassifier::BarcodeCandidateKit> BarcodeClassifier::generate_
             }
 
             candidate.barcode_names.push_back(bc_name);
+            candidate.normalized_barcode_names.push_back(
+                    barcode_kits::normalize_barcode_name(bc_name));
         }
 
+        candidate.top_barcodes =
+                make_padded_barcodes(candidate.barcodes1, candidate.top_context_left_buffer,
+                                     candidate.top_context_right_buffer);
+        candidate.top_barcodes_rev =
+                make_padded_barcodes(candidate.barcodes1_rev, candidate.top_context_rev_left_buffer,
+                                     candidate.top_context_rev_right_buffer);
+        candidate.bottom_barcodes =
+                make_padded_barcodes(candidate.barcodes2, candidate.bottom_context_left_buffer,
+                                     candidate.bottom_context_right_buffer);
+        candidate.bottom_barcodes_rev = make_padded_barcodes(
+                candidate.barcodes2_rev, candidate.bottom_context_rev_left_buffer,
+                candidate.bottom_context_rev_right_buffer);
+
         candidates_list.push_back(std::move(candidate));
     }
     spdlog::debug("> Kits to evaluate: {}", candidates_list.size());
@@ -427,8 +461,6 @@ std::vector<BarcodeScoreResult> BarcodeClassifier::calculate_barcode_score_diffe
     // Try to find the location of the barcode + flanks in the top and bottom windows.
     EdlibAlignConfig placement_config = init_edlib_config_for_flanks();
 
-    EdlibAlignConfig mask_config = init_edlib_config_for_mask();
-
     std::string_view top_context_v1 = candidate.top_context;
     const auto& top_context_v1_left_buffer = candidate.top_context_left_buffer;
     const auto& top_context_v1_right_buffer = candidate.top_context_right_buffer;
@@ -491,63 +523,59 @@ std::vector<BarcodeScoreResult> BarcodeClassifier::calculate_barcode_score_diffe
     spdlog::trace("total v1 edit dist {}, total v2 edit dis {}", total_v1_penalty,
                   total_v2_penalty);
 
+    // Globally align every barcode to each mask region, in a single pass over the region.
+    const auto& barcodes1 = candidate.top_barcodes;
+    const auto& barcodes1_rev = candidate.top_barcodes_rev;
+    const auto& barcodes2 = candidate.bottom_barcodes;
+    const auto& barcodes2_rev = candidate.bottom_barcodes_rev;
+    const auto top_penalties_v1 = barcodes1.global_distances(top_mask_v1);
+    const auto bottom_penalties_v1 = barcodes2_rev.global_distances(bottom_mask_v1);
+    const auto top_penalties_v2 = barcodes2.global_distances(top_mask_v2);
+    const auto bottom_penalties_v2 = barcodes1_rev.global_distances(bottom_mask_v2);
+
     std::vector<BarcodeScoreResult> results;
     for (size_t i = 0; i < candidate.barcodes1.size(); i++) {
-        const auto barcode1 =
-                top_context_v1_left_buffer + candidate.barcodes1[i] + top_context_v1_right_buffer;
-        const auto barcode1_rev = bottom_context_v2_left_buffer + candidate.barcodes1_rev[i] +
-                                  bottom_context_v2_right_buffer;
-        const auto barcode2 =
-                top_context_v2_left_buffer + candidate.barcodes2[i] + top_context_v2_right_buffer;
-        const auto barcode2_rev = bottom_context_v1_left_buffer + candidate.barcodes2_rev[i] +
-                                  bottom_context_v1_right_buffer;
         auto& barcode_name = candidate.barcode_names[i];
 
-        if (!barcode_is_permitted(allowed_barcodes, barcode_name)) {
+        if (!barcode_is_permitted(allowed_barcodes, candidate.normalized_barcode_names[i])) {
             continue;
         }
 
         spdlog::trace("Checking barcode {}", barcode_name);
 
-        // Calculate barcode penalties for v1.
-        auto top_mask_result_penalty_v1 =
-                extract_barcode_penalty(barcode1, top_mask_v1, mask_config, "top window v1");
-
-        auto bottom_mask_result_penalty_v1 = extract_barcode_penalty(
-                barcode2_rev, bottom_mask_v1, mask_config, "bottom window v1");
-
         BarcodeScoreResult v1;
-        v1.top_penalty = top_mask_result_penalty_v1;
-        v1.bottom_penalty = bottom_mask_result_penalty_v1;
+        v1.top_penalty = top_penalties_v1[i];
+        v1.bottom_penalty = bottom_penalties_v1[i];
+        trace_barcode_penalty(barcodes1.pattern(i), top_mask_v1, v1.top_penalty, "top window v1");
+        trace_barcode_penalty(barcodes2_rev.pattern(i), bottom_mask_v1, v1.bottom_penalty,
+                              "bottom window v1");
         v1.top_flank_score = top_flank_score_v1;
         v1.bottom_flank_score = bottom_flank_score_v1;
         std::tie(v1.use_top, v1.penalty, v1.flank_score) = pick_top_or_bottom(
                 v1.top_penalty, v1.top_flank_score, v1.bottom_penalty, v1.bottom_flank_score);
-        v1.top_barcode_score = (1.f - static_cast<float>(v1.top_penalty) / barcode1.length());
+        v1.top_barcode_score =
+                (1.f - static_cast<float>(v1.top_penalty) / barcodes1.pattern(i).length());
         v1.bottom_barcode_score =
-                (1.f - static_cast<float>(v1.bottom_penalty) / barcode2_rev.length());
+                (1.f - static_cast<float>(v1.bottom_penalty) / barcodes2_rev.pattern(i).length());
         v1.barcode_score = v1.use_top ? v1.top_barcode_score : v1.bottom_barcode_score;
         v1.top_barcode_pos = {top_result_v1.startLocations[0], top_result_v1.endLocations[0]};
         v1.bottom_barcode_pos = {bottom_start + bottom_result_v1.startLocations[0],
                                  bottom_start + bottom_result_v1.endLocations[0]};
 
-        // Calculate barcode penalties for v2.
-        auto top_mask_result_penalty_v2 =
-                extract_barcode_penalty(barcode2, top_mask_v2, mask_config, "top window v2");
-
-        auto bottom_mask_result_penalty_v2 = extract_barcode_penalty(
-                barcode1_rev, bottom_mask_v2, mask_config, "bottom window v2");
-
         BarcodeScoreResult v2;
-        v2.top_penalty = top_mask_result_penalty_v2;
-        v2.bottom_penalty = bottom_mask_result_penalty_v2;
+        v2.top_penalty = top_penalties_v2[i];
+        v2.bottom_penalty = bottom_penalties_v2[i];
+        trace_barcode_penalty(barcodes2.pattern(i), top_mask_v2, v2.top_penalty, "top window v2");
+        trace_barcode_penalty(barcodes1_rev.pattern(i), bottom_mask_v2, v2.bottom_penalty,
+                              "bottom window v2");
         v2.top_flank_score = top_flank_score_v2;
         v2.bottom_flank_score = bottom_flank_score_v2;
         std::tie(v2.use_top, v2.penalty, v2.flank_score) = pick_top_or_bottom(
                 v2.top_penalty, v2.top_flank_score, v2.bottom_penalty, v2.bottom_flank_score);
-        v2.top_barcode_score = (1.f - static_cast<float>(v2.top_penalty) / barcode2.length());
+        v2.top_barcode_score =
+                (1.f - static_cast<float>(v2.top_penalty) / barcodes2.pattern(i).length());
         v2.bottom_barcode_score =
-                (1.f - static_cast<float>(v2.bottom_penalty) / barcode1_rev.length());
+                (1.f - static_cast<float>(v2.bottom_penalty) / barcodes1_rev.pattern(i).length());
         v2.barcode_score = v2.use_top ? v2.top_barcode_score : v2.bottom_barcode_score;
         v2.top_barcode_pos = {top_result_v2.startLocations[0], top_result_v2.endLocations[0]};
         v2.bottom_barcode_pos = {bottom_start + bottom_result_v2.startLocations[0],
@@ -606,8 +634,6 @@ std::vector<BarcodeScoreResult> BarcodeClassifier::calculate_barcode_score_doubl
     // Try to find the location of the barcode + flanks in the top and bottom windows.
     EdlibAlignConfig placement_config = init_edlib_config_for_flanks();
 
-    EdlibAlignConfig mask_config = init_edlib_config_for_mask();
-
     std::string_view top_context = candidate.top_context;
     const auto& top_left_buffer = candidate.top_context_left_buffer;
     const auto& top_right_buffer = candidate.top_context_right_buffer;
@@ -633,36 +659,37 @@ std::vector<BarcodeScoreResult> BarcodeClassifier::calculate_barcode_score_doubl
     std::string_view bottom_mask =
             read_bottom.substr(bottom_start_idx, bottom_end_idx - bottom_start_idx);
 
+    const auto& barcodes = candidate.top_barcodes;
+    const auto& barcodes_rev = candidate.top_barcodes_rev;
+    const auto top_penalties = barcodes.global_distances(top_mask);
+    const auto bottom_penalties = barcodes_rev.global_distances(bottom_mask);
+
     std::vector<BarcodeScoreResult> results;
     for (size_t i = 0; i < candidate.barcodes1.size(); i++) {
-        auto barcode = top_left_buffer + candidate.barcodes1[i] + top_right_buffer;
-        auto barcode_rev = bottom_left_buffer + candidate.barcodes1_rev[i] + bottom_right_buffer;
         auto& barcode_name = candidate.barcode_names[i];
 
-        if (!barcode_is_permitted(allowed_barcodes, barcode_name)) {
+        if (!barcode_is_permitted(allowed_barcodes, candidate.normalized_barcode_names[i])) {
             continue;
         }
         spdlog::trace("Checking barcode {}", barcode_name);
 
-        auto top_mask_penalty =
-                extract_barcode_penalty(barcode, top_mask, mask_config, "top window");
-
-        auto bottom_mask_penalty =
-                extract_barcode_penalty(barcode_rev, bottom_mask, mask_config, "bottom window");
-
         BarcodeScoreResult res;
         res.barcode_name = barcode_name;
         res.kit = candidate.kit;
         res.barcode_kit = candidate.barcode_kit;
-        res.top_penalty = top_mask_penalty;
-        res.bottom_penalty = bottom_mask_penalty;
+        res.top_penalty = top_penalties[i];
+        res.bottom_penalty = bottom_penalties[i];
+        trace_barcode_penalty(barcodes.pattern(i), top_mask, res.top_penalty, "top window");
+        trace_barcode_penalty(barcodes_rev.pattern(i), bottom_mask, res.bottom_penalty,
+                              "bottom window");
         res.top_flank_score = top_flank_score;
         res.bottom_flank_score = bottom_flank_score;
         std::tie(res.use_top, res.penalty, res.flank_score) = pick_top_or_bottom(
                 res.top_penalty, res.top_flank_score, res.bottom_penalty, res.bottom_flank_score);
-        res.top_barcode_score = (1.f - static_cast<float>(res.top_penalty) / barcode.length());
+        res.top_barcode_score =
+                (1.f - static_cast<float>(res.top_penalty) / barcodes.pattern(i).length());
         res.bottom_barcode_score =
-                (1.f - static_cast<float>(res.bottom_penalty) / barcode_rev.length());
+                (1.f - static_cast<float>(res.bottom_penalty) / barcodes_rev.pattern(i).length());
         res.barcode_score = res.use_top ? res.top_barcode_score : res.bottom_barcode_score;
         res.top_barcode_pos = {top_result.startLocations[0], top_result.endLocations[0]};
         res.bottom_barcode_pos = {bottom_start + bottom_result.startLocations[0],
@@ -691,8 +718,6 @@ std::vector<BarcodeScoreResult> BarcodeClassifier::calculate_barcode_score(
     // Try to find the location of the barcode + flanks in the top and bottom windows.
     EdlibAlignConfig placement_config = init_edlib_config_for_flanks();
 
-    EdlibAlignConfig mask_config = init_edlib_config_for_mask();
-
     std::string_view top_context = candidate.top_context;
     int barcode_len = int(candidate.barcodes1[0].length());
     const auto& top_left_buffer = candidate.top_context_left_buffer;
@@ -707,20 +732,18 @@ std::vector<BarcodeScoreResult> BarcodeClassifier::calculate_barcode_score(
 
     spdlog::trace("BC location {}", top_bc_loc);
 
+    const auto& barcodes = candidate.top_barcodes;
+    const auto top_penalties = barcodes.global_distances(top_mask);
+
     std::vector<BarcodeScoreResult> results;
     for (size_t i = 0; i < candidate.barcodes1.size(); i++) {
-        const auto barcode = candidate.top_context_left_buffer + candidate.barcodes1[i] +
-                             candidate.top_context_right_buffer;
         auto& barcode_name = candidate.barcode_names[i];
 
-        if (!barcode_is_permitted(allowed_barcodes, barcode_name)) {
+        if (!barcode_is_permitted(allowed_barcodes, candidate.normalized_barcode_names[i])) {
             continue;
         }
         spdlog::trace("Checking barcode {}", barcode_name);
 
-        auto top_mask_penalty =
-                extract_barcode_penalty(barcode, top_mask, mask_config, "top window");
-
         BarcodeScoreResult res;
         res.barcode_name = barcode_name;
         res.kit = candidate.kit;
@@ -728,11 +751,13 @@ std::vector<BarcodeScoreResult> BarcodeClassifier::calculate_barcode_score(
         res.top_flank_score = top_flank_score;
         res.bottom_flank_score = -1.f;
         res.flank_score = std::max(res.top_flank_score, res.bottom_flank_score);
-        res.top_penalty = top_mask_penalty;
+        res.top_penalty = top_penalties[i];
         res.bottom_penalty = -1;
+        trace_barcode_penalty(barcodes.pattern(i), top_mask, res.top_penalty, "top window");
         res.penalty = res.top_penalty;
         res.use_top = true;
-        res.top_barcode_score = 1.f - static_cast<float>(res.top_penalty) / barcode.length();
+        res.top_barcode_score =
+                1.f - static_cast<float>(res.top_penalty) / barcodes.pattern(i).length();
         res.barcode_score = res.top_barcode_score;
         res.top_barcode_pos = {top_result.startLocations[0], top_result.endLocations[0]};
 
@@ -766,9 +791,8 @@ BarcodeScoreResult BarcodeClassifier::find_best_barcode(
 
     // Then find the best barcode hit within that kit.
     std::vector<BarcodeScoreResult> results;
-    const auto& kit = get_kit_info(candidate->kit);
-    if (kit.double_ends) {
-        if (kit.ends_different) {
+    if (candidate->double_ends) {
+        if (candidate->ends_different) {
             auto out = calculate_barcode_score_different_double_ends(fwd, *candidate,
                                                                      allowed_barcodes);
             results.insert(results.end(), out.begin(), out.end());
@@ -786,7 +810,7 @@ BarcodeScoreResult BarcodeClassifier::find_best_barcode(
         return UNCLASSIFIED;
     }
 
-    if (kit.double_ends) {
+    if (candidate->double_ends) {
         // For a double ended barcode, ensure that the best barcode according
         // to the top window and the best barcode according to the bottom window
         // are the same. If they suggest different barcodes confidently, then
@@ -812,11 +836,13 @@ BarcodeScoreResult BarcodeClassifier::find_best_barcode(
     std::sort(results.begin(), results.end(),
               [](const auto& l, const auto& r) { return l.penalty < r.penalty; });
 
-    std::stringstream d;
-    for (auto& s : results) {
-        d << s.barcode_name << " " << s.penalty << ", ";
+    if (spdlog::get_level() == spdlog::level::trace) {
+        std::stringstream d;
+        for (auto& s : results) {
+            d << s.barcode_name << " " << s.penalty << ", ";
+        }
+        spdlog::trace("Scores: {}", d.str());
     }
-    spdlog::trace("Scores: {}", d.str());
     auto best_result = results.begin();
     auto are_penalties_acceptable = [this](const auto& proposal) {
         // If barcode penalty is 0, it's a perfect match. Consider it a pass.
@@ -843,7 +869,7 @@ BarcodeScoreResult BarcodeClassifier::find_best_barcode(
         }
     }
 
-    if (barcode_both_ends && kit.double_ends) {
+    if (barcode_both_ends && candidate->double_ends) {
         // For more stringent classification, ensure that both ends of a read
         // have a high score for the same barcode. If not then consider it
         // unclassified.
@@ -0,0 +1,245 @@
+#include "PatternBank.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t WORD_BITS = 64;
+// The lanes are padded out to a multiple of this, and processed in groups of this size so that
+// each group can be kept in vector registers.
+constexpr size_t LANE_MULTIPLE = 4;
+
+// 1 if x is non-zero, else 0, without a comparison.
+uint64_t is_nonzero(uint64_t x) { return (x | (0 - x)) >> (WORD_BITS - 1); }
+
+}  // namespace
+
+namespace dorado::demux {
+
+struct PatternBank::State {
+    // The vertical delta bit vectors, laid out as [block][lane].
+    std::vector<uint64_t> pv;
+    std::vector<uint64_t> mv;
+    // The score of the last row of each pattern, for the current column.
+    std::vector<int64_t> score;
+};
+
+PatternBank::PatternBank(const std::vector<std::string>& patterns,
+                         const std::vector<std::pair<char, char>>& equalities) {
+    size_t max_length = 0;
+    m_offsets.push_back(0);
+    for (const auto& pattern : patterns) {
+        if (pattern.empty()) {
+            throw std::runtime_error("PatternBank: patterns must not be empty");
+        }
+        max_length = std::max(max_length, pattern.length());
+        m_sequences += pattern;
+        m_offsets.push_back(m_sequences.length());
+    }
+    m_num_blocks = (max_length + WORD_BITS - 1) / WORD_BITS;
+    m_num_lanes = (patterns.size() + LANE_MULTIPLE - 1) / LANE_MULTIPLE * LANE_MULTIPLE;
+
+    // Every character of a pattern, and every character equal to one, gets its own match masks.
+    // Anything else in the text matches nothing, and shares index 0.
+    auto add_to_alphabet = [this](char c) {
+        auto& index = m_alphabet[uint8_t(c)];
+        if (index == 0) {
+            index = uint16_t(m_alphabet_size++);
+        }
+    };
+    for (char c : m_sequences) {
+        add_to_alphabet(c);
+    }
+    for (const auto& [a, b] : equalities) {
+        add_to_alphabet(a);
+        add_to_alphabet(b);
+    }
+
+    std::vector<std::string> reversed_patterns;
+    for (const auto& pattern : patterns) {
+        reversed_patterns.emplace_back(pattern.rbegin(), pattern.rend());
+    }
+    m_forward = compile(patterns, equalities);
+    m_reversed = compile(reversed_patterns, equalities);
+}
+
+PatternBank::CompiledPatterns PatternBank::compile(
+        const std::vector<std::string>& patterns,
+        const std::vector<std::pair<char, char>>& equalities) const {
+    auto is_equal = [&equalities](char a, char b) {
+        return a == b || std::any_of(equalities.begin(), equalities.end(), [a, b](const auto& eq) {
+                   return (eq.first == a && eq.second == b) || (eq.first == b && eq.second == a);
+               });
+    };
+
+    CompiledPatterns compiled;
+    const size_t stride = m_num_blocks * m_num_lanes;
+    compiled.peq.assign(m_alphabet_size * stride, 0);
+    compiled.last_row.assign(stride, 0);
+    for (size_t c = 0; c < m_alphabet.size(); ++c) {
+        const size_t index = m_alphabet[c];
+        if (index == 0) {
+            continue;
+        }
+        for (size_t lane = 0; lane < patterns.size(); ++lane) {
+            const auto& pattern = patterns[lane];
+            for (size_t i = 0; i < pattern.length(); ++i) {
+                if (is_equal(pattern[i], char(c))) {
+                    const size_t offset = (i / WORD_BITS) * m_num_lanes + lane;
+                    compiled.peq[index * stride + offset] |= uint64_t(1) << (i % WORD_BITS);
+                }
+            }
+        }
+    }
+    for (size_t lane = 0; lane < patterns.size(); ++lane) {
+        const size_t last = patterns[lane].length() - 1;
+        compiled.last_row[(last / WORD_BITS) * m_num_lanes + lane] = uint64_t(1)
+                                                                      << (last % WORD_BITS);
+    }
+    return compiled;
+}
+
+void PatternBank::reset(State& state, size_t lane_begin, size_t lane_end) const {
+    state.pv.resize(m_num_blocks * m_num_lanes);
+    state.mv.resize(m_num_blocks * m_num_lanes);
+    state.score.resize(m_num_lanes);
+    for (size_t block = 0; block < m_num_blocks; ++block) {
+        for (size_t lane = lane_begin; lane < lane_end; ++lane) {
+            state.pv[block * m_num_lanes + lane] = ~uint64_t(0);
+            state.mv[block * m_num_lanes + lane] = 0;
+        }
+    }
+    // Before any of the text, the last row scores the length of the pattern.
+    for (size_t lane = lane_begin; lane < lane_end; ++lane) {
+        state.score[lane] = lane < size() ? int64_t(pattern(lane).length()) : 0;
+    }
+}
+
+// Advances lanes [lane_begin, lane_end), which are whole groups of LANE_MULTIPLE lanes, by one
+// character of the text.  top_hin is the horizontal delta into the first row: 1 if a gap before
+// the pattern is penalised, and 0 if it's free.
+// This is the block calculation of Myers' algorithm as edlib does it, run across the lanes.
+void PatternBank::advance(const CompiledPatterns& patterns,
+                          char c,
+                          int64_t top_hin,
+                          State& state,
+                          size_t lane_begin,
+                          size_t lane_end) const {
+    const size_t stride = m_num_blocks * m_num_lanes;
+    const uint64_t* const peq = &patterns.peq[m_alphabet[uint8_t(c)] * stride];
+    const uint64_t* const last_row = patterns.last_row.data();
+    uint64_t* const pv = state.pv.data();
+    uint64_t* const mv = state.mv.data();
+    int64_t* const score = state.score.data();
+
+    // Each group of lanes is copied into fixed size local arrays, which the compiler can keep in
+    // vector registers.  Everything here is kept to operations which SSE2 can do on 64 bit lanes.
+    for (size_t group = lane_begin; group < lane_end; group += LANE_MULTIPLE) {
+        uint64_t hin_neg[LANE_MULTIPLE];
+        uint64_t hin_pos[LANE_MULTIPLE];
+        int64_t score_delta[LANE_MULTIPLE];
+        for (size_t i = 0; i < LANE_MULTIPLE; ++i) {
+            hin_neg[i] = uint64_t(top_hin < 0);
+            hin_pos[i] = uint64_t(top_hin > 0);
+            score_delta[i] = 0;
+        }
+        for (size_t block = 0; block < m_num_blocks; ++block) {
+            const size_t offset = block * m_num_lanes + group;
+            uint64_t eq_in[LANE_MULTIPLE];
+            uint64_t pv_in[LANE_MULTIPLE];
+            uint64_t mv_in[LANE_MULTIPLE];
+            uint64_t last_row_in[LANE_MULTIPLE];
+            std::copy_n(peq + offset, LANE_MULTIPLE, eq_in);
+            std::copy_n(pv + offset, LANE_MULTIPLE, pv_in);
+            std::copy_n(mv + offset, LANE_MULTIPLE, mv_in);
+            std::copy_n(last_row + offset, LANE_MULTIPLE, last_row_in);
+
+            uint64_t pv_out[LANE_MULTIPLE];
+            uint64_t mv_out[LANE_MULTIPLE];
+            for (size_t i = 0; i < LANE_MULTIPLE; ++i) {
+                const uint64_t eq = eq_in[i] | hin_neg[i];
+                const uint64_t xv = eq_in[i] | mv_in[i];
+                const uint64_t xh = (((eq & pv_in[i]) + pv_in[i]) ^ pv_in[i]) | eq;
+                uint64_t ph = mv_in[i] | ~(xh | pv_in[i]);
+                uint64_t mh = pv_in[i] & xh;
+                score_delta[i] += int64_t(is_nonzero(ph & last_row_in[i])) -
+                                  int64_t(is_nonzero(mh & last_row_in[i]));
+                const uint64_t hout_pos = ph >> (WORD_BITS - 1);
+                const uint64_t hout_neg = mh >> (WORD_BITS - 1);
+                ph = (ph << 1) | hin_pos[i];
+                mh = (mh << 1) | hin_neg[i];
+                pv_out[i] = mh | ~(xv | ph);
+                mv_out[i] = ph & xv;
+                // A lane never has both, as ph and mh don't share any bits.
+                hin_pos[i] = hout_pos;
+                hin_neg[i] = hout_neg;
+            }
+            std::copy_n(pv_out, LANE_MULTIPLE, pv + offset);
+            std::copy_n(mv_out, LANE_MULTIPLE, mv + offset);
+        }
+        for (size_t i = 0; i < LANE_MULTIPLE; ++i) {
+            score[group + i] += score_delta[i];
+        }
+    }
+}
+
+std::vector<int> PatternBank::global_distances(std::string_view text) const {
+    State state;
+    reset(state, 0, m_num_lanes);
+    for (char c : text) {
+        advance(m_forward, c, 1, state, 0, m_num_lanes);
+    }
+    return std::vector<int>(state.score.begin(), state.score.begin() + size());
+}
+
+std::vector<PatternBank::InfixMatch> PatternBank::infix_matches(std::string_view text) const {
+    State state;
+    reset(state, 0, m_num_lanes);
+
+    // edlib also reports a match ending before the text when the whole pattern is inserted, unless
+    // the pattern fills its blocks exactly.  Only a strictly better score replaces the first end.
+    std::vector<InfixMatch> matches(size());
+    for (size_t lane = 0; lane < size(); ++lane) {
+        const size_t length = pattern(lane).length();
+        matches[lane] = {int(length % WORD_BITS == 0 ? length + 1 : length), 0, -1};
+    }
+    for (size_t pos = 0; pos < text.size(); ++pos) {
+        advance(m_forward, text[pos], 0, state, 0, m_num_lanes);
+        for (size_t lane = 0; lane < size(); ++lane) {
+            if (state.score[lane] < matches[lane].edit_distance) {
+                matches[lane].edit_distance = int(state.score[lane]);
+                matches[lane].end = int(pos);
+            }
+        }
+    }
+
+    // As edlib does, the start is found by aligning the reversed pattern backwards from the end,
+    // taking the longest alignment with the best score.
+    for (size_t lane = 0; lane < size(); ++lane) {
+        auto& match = matches[lane];
+        if (match.end < 0) {
+            match.edit_distance = int(pattern(lane).length());
+            match.start = 0;
+            continue;
+        }
+        // Lanes are advanced a group at a time, but only this one is used.
+        const size_t group = lane / LANE_MULTIPLE * LANE_MULTIPLE;
+        reset(state, group, group + LANE_MULTIPLE);
+        // An alignment using more of the text than the pattern length plus the edit distance
+        // can't score as well, so there's no need to look any further back.
+        const int last_pos =
+                std::min(match.end, int(pattern(lane).length()) + match.edit_distance - 1);
+        int longest = 0;
+        for (int pos = 0; pos <= last_pos; ++pos) {
+            advance(m_reversed, text[match.end - pos], 1, state, group, group + LANE_MULTIPLE);
+            if (state.score[lane] <= match.edit_distance) {
+                longest = pos;
+            }
+        }
+        match.start = match.end - longest;
+    }
+    return matches;
+}
+
+}  // namespace dorado::demux
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace dorado::demux {
+
+/** A set of patterns compiled for scoring against the same text in a single pass.
+ *
+ *  Each pattern is scored with Myers' bit-parallel edit distance algorithm.  The bit vectors of
+ *  all the patterns are laid out side by side, so the update for each character of the text
+ *  runs as one loop across the patterns, which the compiler vectorises.  Patterns may be any
+ *  length, and the results are the same as edlib gives when aligning each pattern on its own.
+ */
+class PatternBank {
+public:
+    PatternBank() = default;
+
+    /** @param patterns The patterns, which must not be empty.
+     *  @param equalities Pairs of characters which match each other, as for
+     *         EdlibAlignConfig::additionalEqualities.
+     */
+    explicit PatternBank(const std::vector<std::string>& patterns,
+                         const std::vector<std::pair<char, char>>& equalities = {});
+
+    size_t size() const { return m_offsets.empty() ? 0 : m_offsets.size() - 1; }
+    std::string_view pattern(size_t index) const {
+        return std::string_view(m_sequences).substr(m_offsets[index],
+                                                    m_offsets[index + 1] - m_offsets[index]);
+    }
+
+    /// Global (EDLIB_MODE_NW) edit distance of each pattern against the whole text.
+    std::vector<int> global_distances(std::string_view text) const;
+
+    struct InfixMatch {
+        int edit_distance;
+        // Inclusive positions in the text, as edlib's first start and end locations.
+        int start;
+        int end;
+    };
+
+    /// Best infix (EDLIB_MODE_HW) match of each pattern within the text.
+    std::vector<InfixMatch> infix_matches(std::string_view text) const;
+
+private:
+    // Match masks for each character, laid out as [character][block][lane].
+    struct CompiledPatterns {
+        std::vector<uint64_t> peq;
+        // The bit of the last row of each pattern, in its final block, laid out as [block][lane].
+        std::vector<uint64_t> last_row;
+    };
+
+    struct State;
+
+    CompiledPatterns compile(const std::vector<std::string>& patterns,
+                             const std::vector<std::pair<char, char>>& equalities) const;
+    void reset(State& state, size_t lane_begin, size_t lane_end) const;
+    void advance(const CompiledPatterns& patterns,
+                 char c,
+                 int64_t top_hin,
+                 State& state,
+                 size_t lane_begin,
+                 size_t lane_end) const;
+
+    // The patterns are stored end to end, with pattern i at [m_offsets[i], m_offsets[i + 1]).
+    std::string m_sequences;
+    std::vector<size_t> m_offsets;
+    size_t m_num_blocks{0};
+    size_t m_num_lanes{0};
+    // Index of each character in the alphabet of the patterns, or 0 if it matches nothing.
+    std::array<uint16_t, 256> m_alphabet{};
+    size_t m_alphabet_size{1};
+    CompiledPatterns m_forward;
+    // The reversed patterns, used to find where each infix match starts.
+    CompiledPatterns m_reversed;
+};
+
+}  // namespace dorado::demux
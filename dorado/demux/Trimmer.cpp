@@ -170,6 +170,7 @@ BamPtr Trimmer::trim_sequence(BamPtr input, std::pair<int, int> trim_interval) {
              bam_get_l_aux(input_record));
     memcpy(bam_get_aux(out_record), bam_get_aux(input_record), bam_get_l_aux(input_record));
     out_record->l_data += bam_get_l_aux(input_record);
+    utils::copy_pipeline_entry_time(input_record, out_record);
 
     // Insert the new tags and delete the old ones.
     if (!trimmed_moves.empty()) {
@@ -0,0 +1,22 @@
+#include "KmerIndex.h"
+
+#include <nvtx3/nvtx3.hpp>
+
+namespace dorado::modbase {
+
+KmerIndex::KmerIndex(const std::vector<int>& seq_ints)
+        : m_size(seq_ints.size()),
+          m_codes(seq_ints.size()),
+          m_one_hot(seq_ints.size() + 2 * MAX_KMER_LEN, 0) {
+    NVTX3_FUNC_RANGE();
+    // Roll backwards along the sequence, so each base is only looked at once.
+    uint64_t code = 0;
+    for (size_t i = m_size; i-- > 0;) {
+        const auto base = static_cast<uint64_t>(seq_ints[i] & 0b11);
+        code = (code >> 2) | (base << (2 * MAX_KMER_LEN - 2));
+        m_codes[i] = code;
+        m_one_hot[i + MAX_KMER_LEN] = uint32_t{1} << (base << 3);
+    }
+}
+
+}  // namespace dorado::modbase
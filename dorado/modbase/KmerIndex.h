@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dorado::modbase {
+
+/// Per-base kmer codes for a sequence, computed once per read and shared by the scalers and
+/// encoders of every modbase caller.
+class KmerIndex {
+public:
+    /// The longest kmer that can be looked up.
+    static constexpr size_t MAX_KMER_LEN = 32;
+
+    /** Build the index for a sequence.
+     *  @param seq_ints The sequence encoded as integers (A=0, C=1, G=2, T=3)
+     */
+    explicit KmerIndex(const std::vector<int>& seq_ints);
+
+    size_t size() const { return m_size; }
+
+    /** Get the 2 bit code of a kmer, with its first base in the most significant bits.
+     *  @param pos The position of the first base of the kmer.
+     *  @param kmer_len The length of the kmer, which must end within the sequence.
+     */
+    uint64_t kmer(size_t pos, size_t kmer_len) const {
+        return m_codes[pos] >> (2 * (MAX_KMER_LEN - kmer_len));
+    }
+
+    /** Get the one-hot encodings of the bases from pos onwards, one uint32 per base with a single
+     *  byte set to 1 for A, C, G or T respectively.  Positions within MAX_KMER_LEN of either end
+     *  of the sequence may be read, and are encoded as 0.
+     */
+    const uint32_t* one_hot(std::ptrdiff_t pos) const {
+        return &m_one_hot[static_cast<size_t>(pos + std::ptrdiff_t(MAX_KMER_LEN))];
+    }
+
+private:
+    size_t m_size;
+    // m_codes[i] holds bases i to i + 31, with those past the end of the sequence set to 0.
+    std::vector<uint64_t> m_codes;
+    // Padded by MAX_KMER_LEN at each end.
+    std::vector<uint32_t> m_one_hot;
+};
+
+}  // namespace dorado::modbase
@@ -1,5 +1,6 @@
 #include "ModBaseRunner.h"
 
+#include "KmerIndex.h"
 #include "ModBaseCaller.h"
 #include "ModBaseModelConfig.h"
 #include "ModbaseScaler.h"
@@ -12,6 +13,9 @@
 
 #include <torch/torch.h>
 
+#include <cassert>
+#include <cstring>
+
 namespace {
 #if DORADO_CUDA_BUILD
 std::vector<c10::optional<c10::Stream>> get_streams_from_caller(
@@ -44,8 +48,9 @@ ModBaseRunner::ModBaseRunner(std::shared_ptr<ModBaseCaller> caller)
 
 void ModBaseRunner::accept_chunk(int model_id,
                                  int chunk_idx,
-                                 const at::Tensor& signal,
-                                 const std::vector<int8_t>& kmers) {
+                                 const at::Tensor& signals,
+                                 size_t signal_offset,
+                                 const int8_t* kmers) {
     // As usual, avoid torch indexing because it is glacially slow.
     // GPU base calling uses float16 signals and input tensors.
     // CPU base calling uses float16 signals, float32 input tensors.
@@ -53,10 +58,10 @@ void ModBaseRunner::accept_chunk(int model_id,
 
     auto& input_sigs = m_input_sigs[model_id];
     auto& input_seqs = m_input_seqs[model_id];
-    assert(signal.size(0) == input_sigs.size(2));
-
-    const auto sig_len = signal.size(0);
-    dorado::utils::copy_tensor_elems(input_sigs, chunk_idx * sig_len, signal, 0, sig_len);
+    const auto sig_len = input_sigs.size(2);
+    assert(signal_offset + sig_len <= size_t(signals.numel()));
+    dorado::utils::copy_tensor_elems(input_sigs, chunk_idx * sig_len, signals, signal_offset,
+                                     sig_len);
 
     const auto kmer_elem_count = input_seqs.size(1) * input_seqs.size(2);
     if (input_seqs.dtype() != torch::kInt8) {
@@ -64,7 +69,7 @@ void ModBaseRunner::accept_chunk(int model_id,
     }
     using SeqInputType = int8_t;
     SeqInputType* const input_seqs_ptr = input_seqs.data_ptr<SeqInputType>();
-    std::memcpy(&input_seqs_ptr[chunk_idx * kmer_elem_count], kmers.data(),
+    std::memcpy(&input_seqs_ptr[chunk_idx * kmer_elem_count], kmers,
                 kmer_elem_count * sizeof(SeqInputType));
 }
 
@@ -78,11 +83,11 @@ at::Tensor ModBaseRunner::call_chunks(int model_id, int num_chunks) {
 
 at::Tensor ModBaseRunner::scale_signal(size_t caller_id,
                                        at::Tensor signal,
-                                       const std::vector<int>& seq_ints,
+                                       const KmerIndex& kmers,
                                        const std::vector<uint64_t>& seq_to_sig_map) const {
     auto& scaler = m_caller->caller_data(caller_id)->scaler;
     if (scaler) {
-        return scaler->scale_signal(signal, seq_ints, seq_to_sig_map);
+        return scaler->scale_signal(signal, kmers, seq_to_sig_map);
     }
     return signal;
 }
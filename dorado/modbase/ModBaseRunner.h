@@ -15,18 +15,22 @@ namespace dorado::modbase {
 
 struct ModBaseModelConfig;
 class ModBaseCaller;
+class KmerIndex;
 
 class ModBaseRunner {
 public:
     explicit ModBaseRunner(std::shared_ptr<ModBaseCaller> caller);
+    // Copies the chunk starting at signal_offset in signals, with its encoded kmers, into
+    // slot chunk_idx of the model's input batch.
     void accept_chunk(int model_id,
                       int chunk_idx,
-                      const at::Tensor& signal,
-                      const std::vector<int8_t>& kmers);
+                      const at::Tensor& signals,
+                      size_t signal_offset,
+                      const int8_t* kmers);
     at::Tensor call_chunks(int model_id, int num_chunks);
     at::Tensor scale_signal(size_t caller_id,
                             at::Tensor signal,
-                            const std::vector<int>& seq_ints,
+                            const KmerIndex& kmers,
                             const std::vector<uint64_t>& seq_to_sig_map) const;
     std::vector<size_t> get_motif_hits(size_t caller_id, const std::string& seq) const;
     const ModBaseModelConfig& caller_params(size_t caller_id) const;
@@ -0,0 +1,208 @@
+#include "ModBaseTagEncoder.h"
+
+#include "ModBaseContext.h"
+#include "MotifMatcher.h"
+#include "utils/bam_utils.h"
+#include "utils/sequence_utils.h"
+#include "utils/types.h"
+
+#include <nvtx3/nvtx3.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+
+namespace {
+
+const std::string CARDINAL_BASES = "ACGT";
+
+// Reverse complements a motif, which may contain IUPAC codes.
+std::string reverse_complement_motif(const std::string& motif) {
+    std::string rc_motif(motif.rbegin(), motif.rend());
+    for (auto& base : rc_motif) {
+        switch (base) {
+        case 'A':
+            base = 'T';
+            break;
+        case 'T':
+        case 'U':
+            base = 'A';
+            break;
+        case 'C':
+            base = 'G';
+            break;
+        case 'G':
+            base = 'C';
+            break;
+        case 'R':
+            base = 'Y';
+            break;
+        case 'Y':
+            base = 'R';
+            break;
+        case 'K':
+            base = 'M';
+            break;
+        case 'M':
+            base = 'K';
+            break;
+        case 'B':
+            base = 'V';
+            break;
+        case 'V':
+            base = 'B';
+            break;
+        case 'D':
+            base = 'H';
+            break;
+        case 'H':
+            base = 'D';
+            break;
+        default:
+            // S, W and N are their own complements.
+            break;
+        }
+    }
+    return rc_motif;
+}
+
+}  // namespace
+
+namespace dorado::modbase {
+
+ModBaseTagEncoder::ModBaseTagEncoder(const ModBaseInfo& info)
+        : m_num_channels(info.alphabet.size()) {
+    std::array<bool, 4> has_motif{};
+    std::array<bool, 4> has_context{};
+    if (!info.context.empty()) {
+        ModBaseContext context_handler;
+        if (!context_handler.decode(info.context)) {
+            throw std::runtime_error("Invalid base modification context string.");
+        }
+        for (size_t i = 0; i < CARDINAL_BASES.size(); ++i) {
+            const auto& motif = context_handler.motif(CARDINAL_BASES[i]);
+            if (motif.empty()) {
+                continue;
+            }
+            // A motif of just the single base flags every instance of it, but is reported as
+            // having no context.
+            const auto offset = context_handler.motif_offset(CARDINAL_BASES[i]);
+            has_motif[i] = true;
+            has_context[i] = motif.size() > 1;
+            m_forward_matchers[i] = std::make_unique<MotifMatcher>(motif, offset);
+            m_reverse_matchers[i] = std::make_unique<MotifMatcher>(reverse_complement_motif(motif),
+                                                                   motif.size() - 1 - offset);
+        }
+    }
+
+    char current_cardinal = 0;
+    for (size_t channel_idx = 0; channel_idx < m_num_channels; ++channel_idx) {
+        const auto& name = info.alphabet[channel_idx];
+        if (CARDINAL_BASES.find(name) != std::string::npos) {
+            current_cardinal = name[0];
+            continue;
+        }
+        if (!utils::validate_bam_tag_code(name)) {
+            m_valid_codes = false;
+        }
+        const int base_id = utils::BaseInfo::BASE_IDS[uint8_t(current_cardinal)];
+        const bool cardinal_has_context = base_id >= 0 && has_context[base_id];
+        const std::string suffix = name + (cardinal_has_context ? "?" : ".");
+        const char complement = utils::complement_table[uint8_t(current_cardinal)];
+        m_mod_channels.push_back({channel_idx, current_cardinal,
+                                  std::string(1, current_cardinal) + "+" + suffix,
+                                  std::string(1, complement) + "-" + suffix,
+                                  has_motif[utils::base_to_int(current_cardinal)]});
+    }
+}
+
+ModBaseTagEncoder::~ModBaseTagEncoder() = default;
+
+bool ModBaseTagEncoder::encode(const std::string& seq,
+                               const std::vector<uint8_t>& base_mod_probs,
+                               bool is_duplex,
+                               uint8_t threshold) {
+    NVTX3_FUNC_RANGE();
+    m_mm.clear();
+    m_ml.clear();
+    if (!m_valid_codes) {
+        return false;
+    }
+
+    m_mask.assign(seq.size(), 0);
+    update_mask(seq, base_mod_probs, false, threshold);
+    if (is_duplex) {
+        update_mask(seq, base_mod_probs, true, threshold);
+    }
+
+    for (const auto& channel : m_mod_channels) {
+        append_channel(seq, base_mod_probs, channel.cardinal, channel.index,
+                       channel.forward_prefix);
+    }
+    if (is_duplex) {
+        for (const auto& channel : m_mod_channels) {
+            append_channel(seq, base_mod_probs, utils::complement_table[uint8_t(channel.cardinal)],
+                           channel.index, channel.reverse_prefix);
+        }
+    }
+    return true;
+}
+
+void ModBaseTagEncoder::update_mask(const std::string& seq,
+                                    const std::vector<uint8_t>& base_mod_probs,
+                                    bool reverse_strand,
+                                    uint8_t threshold) {
+    // The reverse strand is matched against the reverse complement of each motif, so the hits
+    // are already in forward strand coordinates.
+    const auto& matchers = reverse_strand ? m_reverse_matchers : m_forward_matchers;
+    for (const auto& matcher : matchers) {
+        if (matcher) {
+            for (auto hit : matcher->get_motif_hits(seq)) {
+                m_mask[hit] = 1;
+            }
+        }
+    }
+
+    // Bases without a motif are flagged wherever a modification passes the threshold.  On the
+    // reverse strand these are the bases whose complement is the cardinal base.
+    for (const auto& channel : m_mod_channels) {
+        if (channel.has_motif) {
+            continue;
+        }
+        for (size_t base_idx = 0; base_idx < seq.size(); ++base_idx) {
+            const char base = reverse_strand ? utils::complement_table[uint8_t(seq[base_idx])]
+                                             : seq[base_idx];
+            if (base == channel.cardinal &&
+                base_mod_probs[base_idx * m_num_channels + channel.index] >= threshold) {
+                m_mask[base_idx] = 1;
+            }
+        }
+    }
+}
+
+void ModBaseTagEncoder::append_channel(const std::string& seq,
+                                       const std::vector<uint8_t>& base_mod_probs,
+                                       char base,
+                                       size_t channel_index,
+                                       const std::string& prefix) {
+    m_mm += prefix;
+    int skipped_bases = 0;
+    char number[16];
+    for (size_t base_idx = 0; base_idx < seq.size(); ++base_idx) {
+        if (seq[base_idx] != base) {
+            continue;
+        }
+        if (!m_mask[base_idx]) {
+            ++skipped_bases;
+            continue;
+        }
+        const auto result = std::to_chars(std::begin(number), std::end(number), skipped_bases);
+        m_mm += ',';
+        m_mm.append(number, result.ptr);
+        skipped_bases = 0;
+        m_ml.push_back(base_mod_probs[base_idx * m_num_channels + channel_index]);
+    }
+    m_mm += ';';
+}
+
+}  // namespace dorado::modbase
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dorado {
+
+struct ModBaseInfo;
+
+namespace modbase {
+
+class MotifMatcher;
+
+/** Builds the MM and ML tag values describing a read's modified base calls.
+ *
+ *  Everything that only depends on the ModBaseInfo, such as the decoded context and the tag
+ *  codes of each channel, is worked out on construction, so a single encoder should be reused
+ *  for every read sharing that info.  The tag values are built in buffers which are also reused
+ *  from one read to the next.
+ */
+class ModBaseTagEncoder {
+public:
+    /** @param info The modbase alphabet and context of the reads to be encoded.
+     *  @throws std::runtime_error if the context string is invalid.
+     */
+    explicit ModBaseTagEncoder(const ModBaseInfo& info);
+    ~ModBaseTagEncoder();
+
+    /** Build the tag values for a read.
+     *  @param seq The basecall sequence.
+     *  @param base_mod_probs The modbase probabilities, seq.size() rows of one per channel.
+     *  @param is_duplex Whether to also encode the modifications of the complement strand.
+     *  @param threshold The probability at or above which bases without a context are reported.
+     *  @return false if the alphabet has a modification code that can't be written to a BAM tag,
+     *  in which case no tags should be written.
+     */
+    bool encode(const std::string& seq,
+                const std::vector<uint8_t>& base_mod_probs,
+                bool is_duplex,
+                uint8_t threshold);
+
+    /// The MM tag value built by the last call to encode.
+    const std::string& mm() const { return m_mm; }
+    /// The ML tag value built by the last call to encode.
+    const std::vector<uint8_t>& ml() const { return m_ml; }
+
+private:
+    // A modification channel, i.e. any channel that isn't a canonical base.
+    struct ModChannel {
+        size_t index;
+        char cardinal;
+        // The tag prefix for each strand, e.g. "C+m?".
+        std::string forward_prefix;
+        std::string reverse_prefix;
+        // Whether the cardinal base has a motif, in which case the threshold doesn't apply.
+        bool has_motif;
+    };
+
+    // Flags bases of seq, on the forward or reverse strand, which are to be reported.
+    void update_mask(const std::string& seq,
+                     const std::vector<uint8_t>& base_mod_probs,
+                     bool reverse_strand,
+                     uint8_t threshold);
+    // Appends the entries for bases of seq matching base, and flagged in the mask.
+    void append_channel(const std::string& seq,
+                        const std::vector<uint8_t>& base_mod_probs,
+                        char base,
+                        size_t channel_index,
+                        const std::string& prefix);
+
+    size_t m_num_channels;
+    bool m_valid_codes{true};
+    std::vector<ModChannel> m_mod_channels;
+    // Indexed by canonical base.  Bases with a motif are flagged wherever it matches and the
+    // others wherever a modification is called at or above the threshold.
+    std::array<std::unique_ptr<MotifMatcher>, 4> m_forward_matchers;
+    std::array<std::unique_ptr<MotifMatcher>, 4> m_reverse_matchers;
+
+    std::vector<uint8_t> m_mask;
+    std::string m_mm;
+    std::vector<uint8_t> m_ml;
+};
+
+}  // namespace modbase
+}  // namespace dorado
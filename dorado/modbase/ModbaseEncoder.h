@@ -1,11 +1,14 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace dorado::modbase {
 
+class KmerIndex;
+
 class ModBaseEncoder {
 private:
     int m_bases_before;
@@ -16,14 +19,11 @@ private:
 
     int m_seq_len;
     int m_signal_len;
-    std::vector<int> m_sequence_ints;
+    std::shared_ptr<const KmerIndex> m_kmers;
     std::vector<int> m_sample_offsets;
 
     int compute_sample_pos(int base_pos) const;
 
-    std::vector<int8_t> encode_kmer(const std::vector<int>& seq,
-                                    const std::vector<int>& seq_mappings) const;
-
 public:
     /** Encoder for Remora-style modified base detection.
      *  @param block_stride The number of samples corresponding to a single entry in the movement vector.
@@ -40,6 +40,12 @@ public:
      */
     void init(const std::vector<int>& sequence_ints, const std::vector<uint64_t>& seq_to_sig_map);
 
+    /** As above, but sharing a kmer index already built for the sequence, e.g. by another caller.
+     *  @param kmers The kmer index of the basecall sequence.
+     *  @param seq_to_sig_map As above.
+     */
+    void init(std::shared_ptr<const KmerIndex> kmers, const std::vector<uint64_t>& seq_to_sig_map);
+
     /// Helper structure for specifying the context and returning the corresponding encoded data.
     struct Context {
         std::vector<int8_t> data;  ///< Encoded data slice
@@ -59,6 +65,16 @@ public:
      *  The data is arranged in Feature-Time order i.e each column corresponds to the kmer at a given sample.
      */
     Context get_context(size_t seq_pos) const;
+
+    /** As above, but writes the encoded data to output rather than allocating it.
+     *  @param seq_pos The position of the base to center the encoded data on.
+     *  @param output Destination for the encoded data, with room for encoded_size() entries.
+     *  @return The context, with an empty data member.
+     */
+    Context get_context(size_t seq_pos, int8_t* output) const;
+
+    /// The number of entries in the encoded data of a context.
+    size_t encoded_size() const;
 };
 
 }  // namespace dorado::modbase
@@ -1,5 +1,6 @@
 #include "ModbaseScaler.h"
 
+#include "KmerIndex.h"
 #include "utils/math_utils.h"
 
 #include <ATen/ATen.h>
@@ -16,21 +17,14 @@ ModBaseScaler::ModBaseScaler(const std::vector<float>& kmer_levels,
         : m_kmer_levels(kmer_levels), m_kmer_len(kmer_len), m_centre_index(centre_index) {
     // ensure that the levels were the length we expected
     assert(m_kmer_levels.size() == static_cast<size_t>(1ull << (2 * m_kmer_len)));
-}
-
-size_t ModBaseScaler::index_from_int_kmer(const int* int_kmer_start, size_t kmer_len) {
-    size_t index = 0;
-    for (int kmer_pos = 0; kmer_pos < static_cast<int>(kmer_len); ++kmer_pos) {
-        index += *(int_kmer_start + kmer_len - kmer_pos - 1) * (1 << (2 * kmer_pos));
-    }
-    return index;
+    assert(m_kmer_len <= KmerIndex::MAX_KMER_LEN);
 }
 
 at::Tensor ModBaseScaler::scale_signal(const at::Tensor& signal,
-                                       const std::vector<int>& seq_ints,
+                                       const KmerIndex& kmers,
                                        const std::vector<uint64_t>& seq_to_sig_map) const {
     NVTX3_FUNC_RANGE();
-    auto levels = extract_levels(seq_ints);
+    auto levels = extract_levels(kmers);
 
     // generate the signal values at the centre of each base, create the nx5% quantiles (sorted)
     // and perform a linear regression against the expected kmer levels to generate a new shift and scale
@@ -39,17 +33,15 @@ at::Tensor ModBaseScaler::scale_signal(const at::Tensor& signal,
     return scaled_signal;
 }
 
-std::vector<float> ModBaseScaler::extract_levels(const std::vector<int>& int_seq) const {
-    std::vector<float> levels(int_seq.size(), 0.f);
-    if (int_seq.size() < m_kmer_len) {
+std::vector<float> ModBaseScaler::extract_levels(const KmerIndex& kmers) const {
+    std::vector<float> levels(kmers.size(), 0.f);
+    if (kmers.size() < m_kmer_len) {
         return levels;
     }
 
-    auto int_kmer_start_ptr = int_seq.data();
     auto levels_ptr = levels.data() + m_centre_index;
-    for (size_t pos = 0; pos < int_seq.size() - m_kmer_len;
-         ++pos, ++int_kmer_start_ptr, ++levels_ptr) {
-        *(levels_ptr) = m_kmer_levels[index_from_int_kmer(int_kmer_start_ptr, m_kmer_len)];
+    for (size_t pos = 0; pos < kmers.size() - m_kmer_len; ++pos, ++levels_ptr) {
+        *(levels_ptr) = m_kmer_levels[kmers.kmer(pos, m_kmer_len)];
     }
     return levels;
 }
@@ -9,6 +9,8 @@
 
 namespace dorado::modbase {
 
+class KmerIndex;
+
 /// Calculates new scaling values for improved modified base detection
 class ModBaseScaler {
 private:
@@ -16,18 +18,11 @@ private:
     const size_t m_kmer_len;
     const size_t m_centre_index;
 
-    /** Get the index in the model kmer_levels corresponding to the input kmer
-     *  @param int_kmer_start Pointer to the start of the kmer in the sequence
-     *  @param kmer_len The length of the kmer
-     *  @return The index of the kmer
-     */
-    static inline size_t index_from_int_kmer(const int* int_kmer_start, size_t kmer_len);
-
     /** Get the expected normalized daq levels for in the input basecall sequence.
-     *  @param int_seq The basecall sequence, encoded as integers with A=0, C=1, G=2, T=3
+     *  @param kmers The kmer index of the basecall sequence
      *  @return A vector of the expected normalized daq level for each base
      */
-    std::vector<float> extract_levels(const std::vector<int>& int_seq) const;
+    std::vector<float> extract_levels(const KmerIndex& kmers) const;
 
     /** Calculate the new offset and scale 
      *  @param samples The normalized samples for the basecalled sequence
@@ -48,12 +43,12 @@ public:
     /**
      * Scale the input signal based on the expected kmer levels of the input basecalled sequence
      * @param signal The signal for the basecalled sequence
-     * @param seq_ints The basecall sequence, encoded as integers with A=0, C=1, G=2, T=3
+     * @param kmers The kmer index of the basecall sequence
      * @param seq_to_sig_map The indices of the samples corresponding to moves in the move table
      * @return The rescaled input signal
     */
     at::Tensor scale_signal(const at::Tensor& signal,
-                            const std::vector<int>& seq_ints,
+                            const KmerIndex& kmers,
                             const std::vector<uint64_t>& seq_to_sig_map) const;
 
     /** Scale calculator for v1 Remora-style modified base detection.
@@ -1,43 +1,174 @@
 #include "MotifMatcher.h"
 
 #include "ModBaseModelConfig.h"
+#include "utils/simd.h"
 
 #include <nvtx3/nvtx3.hpp>
 
-#include <iterator>
-#include <regex>
+#include <array>
 #include <unordered_map>
 
 namespace {
-const std::unordered_map<char, std::string> IUPAC_CODES = {
+
+constexpr uint8_t A_MASK = 1 << 0;
+constexpr uint8_t C_MASK = 1 << 1;
+constexpr uint8_t G_MASK = 1 << 2;
+constexpr uint8_t T_MASK = 1 << 3;
+
+const std::unordered_map<char, uint8_t> IUPAC_CODES = {
         // clang-format off
-        {'A', "A"},
-        {'C', "C"},
-        {'G', "G"},
-        {'T', "T"},
-        {'U', "T"},  // basecalls will have "T"s instead of "U"s
-        {'R', "[AG]"},
-        {'Y', "[CT]"}, 
-        {'S', "[GC]"}, 
-        {'W', "[AT]"},
-        {'K', "[GT]"}, 
-        {'M', "[AC]"}, 
-        {'B', "[CGT]"},
-        {'D', "[AGT]"},
-        {'H', "[ACT]"},
-        {'V', "[ACG]"},
-        {'N', "[ACGT]"},
+        {'A', A_MASK},
+        {'C', C_MASK},
+        {'G', G_MASK},
+        {'T', T_MASK},
+        {'U', T_MASK},  // basecalls will have "T"s instead of "U"s
+        {'R', A_MASK | G_MASK},
+        {'Y', C_MASK | T_MASK},
+        {'S', G_MASK | C_MASK},
+        {'W', A_MASK | T_MASK},
+        {'K', G_MASK | T_MASK},
+        {'M', A_MASK | C_MASK},
+        {'B', C_MASK | G_MASK | T_MASK},
+        {'D', A_MASK | G_MASK | T_MASK},
+        {'H', A_MASK | C_MASK | T_MASK},
+        {'V', A_MASK | C_MASK | G_MASK},
+        {'N', A_MASK | C_MASK | G_MASK | T_MASK},
         // clang-format on
 };
 
-std::string expand_motif_regex(const std::string& motif) {
-    std::string motif_regex = "(";
+// Maps a sequence character to its base mask. Anything other than an upper case
+// canonical base maps to 0, and so can't be matched by any motif.
+const std::array<uint8_t, 256> BASE_MASKS = [] {
+    std::array<uint8_t, 256> masks{};
+    masks['A'] = A_MASK;
+    masks['C'] = C_MASK;
+    masks['G'] = G_MASK;
+    masks['T'] = T_MASK;
+    return masks;
+}();
+
+std::vector<uint8_t> compile_motif(const std::string& motif) {
+    std::vector<uint8_t> motif_masks;
+    motif_masks.reserve(motif.size());
     for (auto base : motif) {
-        motif_regex += IUPAC_CODES.at(base);
+        motif_masks.push_back(IUPAC_CODES.at(base));
+    }
+    return motif_masks;
+}
+
+// Append hits for every match starting at or after |start_pos|.
+void append_motif_hits_scalar(std::string_view seq,
+                              size_t start_pos,
+                              const std::vector<uint8_t>& motif_masks,
+                              size_t motif_offset,
+                              std::vector<size_t>& hits) {
+    const size_t motif_len = motif_masks.size();
+    if (seq.size() < start_pos + motif_len) {
+        return;
     }
-    motif_regex += ")";
-    return motif_regex;
+
+    if (motif_len > 64) {
+        // Too long for the shift-and state to fit in a register, so check each position in turn.
+        for (size_t pos = start_pos; pos + motif_len <= seq.size(); ++pos) {
+            size_t i = 0;
+            while (i < motif_len && (BASE_MASKS[uint8_t(seq[pos + i])] & motif_masks[i])) {
+                ++i;
+            }
+            if (i == motif_len) {
+                hits.push_back(pos + motif_offset);
+            }
+        }
+        return;
+    }
+
+    // Shift-and: bit i of the state is set if the last i + 1 bases match the first i + 1 motif
+    // positions, so a full match has been seen when bit motif_len - 1 is set.
+    std::array<uint64_t, T_MASK + 1> base_transitions{};
+    for (size_t i = 0; i < motif_len; ++i) {
+        for (uint8_t base_mask : {A_MASK, C_MASK, G_MASK, T_MASK}) {
+            if (motif_masks[i] & base_mask) {
+                base_transitions[base_mask] |= uint64_t{1} << i;
+            }
+        }
+    }
+
+    const uint64_t match_bit = uint64_t{1} << (motif_len - 1);
+    uint64_t state = 0;
+    for (size_t pos = start_pos; pos < seq.size(); ++pos) {
+        state = ((state << 1) | 1) & base_transitions[BASE_MASKS[uint8_t(seq[pos])]];
+        if (state & match_bit) {
+            hits.push_back(pos + 1 - motif_len + motif_offset);
+        }
+    }
+}
+
+#if ENABLE_AVX2_IMPL
+__attribute__((target("default")))
+#endif
+std::vector<size_t>
+get_motif_hits_impl(std::string_view seq,
+                    const std::vector<uint8_t>& motif_masks,
+                    size_t motif_offset) {
+    std::vector<size_t> hits;
+    append_motif_hits_scalar(seq, 0, motif_masks, motif_offset, hits);
+    return hits;
+}
+
+#if ENABLE_AVX2_IMPL
+// AVX2 implementation that tests 32 candidate start positions at once. For each motif position
+// the sequence is loaded at that offset and converted to base masks with PSHUFB lookups, and
+// positions where the base isn't allowed by the motif are cleared from the set of candidates.
+// Short motifs such as CG and DRACH only need a handful of loads per 32 bases.
+__attribute__((target("avx2"))) std::vector<size_t> get_motif_hits_impl(
+        std::string_view seq,
+        const std::vector<uint8_t>& motif_masks,
+        size_t motif_offset) {
+    std::vector<size_t> hits;
+    const size_t motif_len = motif_masks.size();
+
+    // The low 4 bits of A, C, G and T in ASCII are unique (1, 3, 7 and 4), so we can look up the
+    // base masks by the low nibble. Since other characters share those nibbles we also look up
+    // the character that should have produced them and discard any mismatches.
+    const __m256i kBaseMaskTable = _mm256_setr_epi8(
+            0, A_MASK, 0, C_MASK, T_MASK, 0, 0, G_MASK, 0, 0, 0, 0, 0, 0, 0, 0, 0, A_MASK, 0,
+            C_MASK, T_MASK, 0, 0, G_MASK, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i kBaseCharTable =
+            _mm256_setr_epi8(0, 'A', 0, 'C', 'T', 0, 0, 'G', 0, 0, 0, 0, 0, 0, 0, 0, 0, 'A', 0,
+                             'C', 'T', 0, 0, 'G', 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i kLowNibbleMask = _mm256_set1_epi8(0x0f);
+    const __m256i kZero = _mm256_setzero_si256();
+
+    static constexpr size_t kUnroll = 32;
+    size_t pos = 0;
+    if (motif_len > 0) {
+        for (; pos + kUnroll + motif_len - 1 <= seq.size(); pos += kUnroll) {
+            __m256i candidates = _mm256_set1_epi8(-1);
+            for (size_t i = 0; i < motif_len; ++i) {
+                const __m256i bases =
+                        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&seq[pos + i]));
+                const __m256i low_nibbles = _mm256_and_si256(bases, kLowNibbleMask);
+                const __m256i valid_bases =
+                        _mm256_cmpeq_epi8(_mm256_shuffle_epi8(kBaseCharTable, low_nibbles), bases);
+                const __m256i base_masks = _mm256_and_si256(
+                        _mm256_shuffle_epi8(kBaseMaskTable, low_nibbles), valid_bases);
+                const __m256i allowed =
+                        _mm256_and_si256(base_masks, _mm256_set1_epi8(char(motif_masks[i])));
+                candidates = _mm256_andnot_si256(_mm256_cmpeq_epi8(allowed, kZero), candidates);
+            }
+
+            auto matches = static_cast<uint32_t>(_mm256_movemask_epi8(candidates));
+            while (matches) {
+                hits.push_back(pos + __builtin_ctz(matches) + motif_offset);
+                matches &= matches - 1;
+            }
+        }
+    }
+
+    // Handle whatever didn't fill a full register.
+    append_motif_hits_scalar(seq, pos, motif_masks, motif_offset, hits);
+    return hits;
 }
+#endif
 
 }  // namespace
 
@@ -47,25 +178,14 @@ MotifMatcher::MotifMatcher(const ModBaseModelConfig& model_config)
         : MotifMatcher(model_config.motif, model_config.motif_offset) {}
 
 MotifMatcher::MotifMatcher(const std::string& motif, size_t offset)
-        : m_motif(expand_motif_regex(motif)), m_motif_offset(offset) {}
+        : m_motif_masks(compile_motif(motif)), m_motif_offset(offset) {}
 
 std::vector<size_t> MotifMatcher::get_motif_hits(std::string_view seq) const {
     NVTX3_FUNC_RANGE();
-    std::vector<size_t> context_hits;
-
-    std::regex regex(m_motif);
-    auto start = std::cbegin(seq);
-    auto end = std::cend(seq);
-    auto pos = start;
-    // string_view on linux uses `const_iterator=const char*`,
-    // but on Windows it's a `std::_String_view_iterator<_Traits>`
-    std::match_results<decltype(pos)> motif_match;
-    while (std::regex_search(pos, end, motif_match, regex)) {
-        auto hit = std::distance(start, pos) + motif_match.position(0) + m_motif_offset;
-        context_hits.push_back(hit);
-        pos += motif_match.position(0) + 1;
+    if (m_motif_masks.empty()) {
+        return {};
     }
-    return context_hits;
+    return get_motif_hits_impl(seq, m_motif_masks, m_motif_offset);
 }
 
 }  // namespace dorado::modbase
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -15,7 +16,8 @@ public:
     std::vector<size_t> get_motif_hits(std::string_view seq) const;
 
 private:
-    const std::string m_motif;
+    // The set of bases allowed at each position of the motif, as a bitmask with one bit per base.
+    const std::vector<uint8_t> m_motif_masks;
     const size_t m_motif_offset;
 };
 
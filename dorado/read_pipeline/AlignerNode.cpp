@@ -106,33 +106,37 @@ void AlignerNode::align_read_common(ReadCommon& read_common, mm_tbuf_t* tbuf) {
 }
 
 void AlignerNode::input_thread_fn() {
-    Message message;
+    std::vector<Message> messages;
+    std::vector<Message> messages_to_send;
     mm_tbuf_t* tbuf = mm_tbuf_init();
-    auto align_read = [this, tbuf](auto&& read) {
+    auto align_read = [this, tbuf, &messages_to_send](auto&& read) {
         align_read_common(read->read_common, tbuf);
-        send_message_to_sink(std::move(read));
+        messages_to_send.push_back(std::move(read));
     };
-    while (get_input_message(message)) {
-        if (std::holds_alternative<BamPtr>(message)) {
-            auto read = std::get<BamPtr>(std::move(message));
-            auto records =
-                    alignment::Minimap2Aligner(m_index_for_bam_messages).align(read.get(), tbuf);
-            for (auto& record : records) {
-                if (!m_bed_file_for_bam_messages.filename().empty() &&
-                    !(record->core.flag & BAM_FUNMAP)) {
-                    auto ref_id = record->core.tid;
-                    add_bed_hits_to_record(m_header_sequences_for_bam_messages.at(ref_id), record);
+    while (get_input_messages(messages, kMaxInputBatchSize)) {
+        for (auto& message : messages) {
+            if (std::holds_alternative<BamPtr>(message)) {
+                auto read = std::get<BamPtr>(std::move(message));
+                auto records = alignment::Minimap2Aligner(m_index_for_bam_messages)
+                                       .align(read.get(), tbuf);
+                for (auto& record : records) {
+                    if (!m_bed_file_for_bam_messages.filename().empty() &&
+                        !(record->core.flag & BAM_FUNMAP)) {
+                        auto ref_id = record->core.tid;
+                        add_bed_hits_to_record(m_header_sequences_for_bam_messages.at(ref_id),
+                                               record);
+                    }
+                    messages_to_send.push_back(std::move(record));
                 }
-                send_message_to_sink(std::move(record));
+            } else if (std::holds_alternative<SimplexReadPtr>(message)) {
+                align_read(std::get<SimplexReadPtr>(std::move(message)));
+            } else if (std::holds_alternative<DuplexReadPtr>(message)) {
+                align_read(std::get<DuplexReadPtr>(std::move(message)));
+            } else {
+                messages_to_send.push_back(std::move(message));
             }
-        } else if (std::holds_alternative<SimplexReadPtr>(message)) {
-            align_read(std::get<SimplexReadPtr>(std::move(message)));
-        } else if (std::holds_alternative<DuplexReadPtr>(message)) {
-            align_read(std::get<DuplexReadPtr>(std::move(message)));
-        } else {
-            send_message_to_sink(std::move(message));
-            continue;
         }
+        send_messages_to_sink(std::move(messages_to_send));
     }
     mm_tbuf_destroy(tbuf);
 }
@@ -143,13 +147,8 @@ void AlignerNode::add_bed_hits_to_record(const std::string& genome, BamPtr& reco
     size_t genome_start = record->core.pos;
     size_t genome_end = bam_endpos(record.get());
     char direction = (bam_is_rev(record.get())) ? '-' : '+';
-    int bed_hits = 0;
-    for (const auto& interval : m_bed_file_for_bam_messages.entries(genome)) {
-        if (!(interval.start >= genome_end || interval.end <= genome_start) &&
-            (interval.strand == direction || interval.strand == '.')) {
-            bed_hits++;
-        }
-    }
+    int bed_hits = int(m_bed_file_for_bam_messages.num_overlapping_entries(
+            genome, genome_start, genome_end, direction));
     // update the record.
     bam_aux_append(record.get(), "bh", 'i', sizeof(bed_hits), (uint8_t*)&bed_hits);
 }
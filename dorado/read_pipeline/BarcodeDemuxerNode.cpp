@@ -7,6 +7,7 @@
 #include <htslib/bgzf.h>
 #include <htslib/sam.h>
 
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
 #include <string>
@@ -16,12 +17,14 @@ namespace dorado {
 BarcodeDemuxerNode::BarcodeDemuxerNode(const std::string& output_dir,
                                        size_t htslib_threads,
                                        bool write_fastq,
-                                       std::unique_ptr<const utils::SampleSheet> sample_sheet)
+                                       std::unique_ptr<const utils::SampleSheet> sample_sheet,
+                                       bool sort_bam)
         : MessageSink(10000, 1),
           m_output_dir(output_dir),
           m_htslib_threads(int(htslib_threads)),
           m_write_fastq(write_fastq),
-          m_sample_sheet(std::move(sample_sheet)) {
+          m_sample_sheet(std::move(sample_sheet)),
+          m_sort_bam(sort_bam) {
     std::filesystem::create_directories(m_output_dir);
     start_input_processing(&BarcodeDemuxerNode::input_thread_fn, this);
 }
@@ -67,11 +70,17 @@ int BarcodeDemuxerNode::write(bam1_t* const record) {
         file = std::make_unique<utils::HtsFile>(
                 filepath_str,
                 m_write_fastq ? utils::HtsFile::OutputMode::FASTQ : utils::HtsFile::OutputMode::BAM,
-                m_htslib_threads);
+                m_htslib_threads, m_sort_bam);
+        // The files share the sort budget, and it's managed here rather than by each file. See
+        // reserve_sort_buffer_memory().
+        file->set_sort_buffer_size(m_sort_buffer_size);
         file->set_and_write_header(m_header.get());
     }
 
+    reserve_sort_buffer_memory(utils::HtsFile::sort_buffer_memory_for(record));
+    const size_t memory_before = file->sort_buffer_memory();
     auto hts_res = file->write(record);
+    m_sort_buffer_memory = m_sort_buffer_memory + file->sort_buffer_memory() - memory_before;
     if (hts_res < 0) {
         throw std::runtime_error("Failed to write SAM record, error code " +
                                  std::to_string(hts_res));
@@ -81,6 +90,20 @@ int BarcodeDemuxerNode::write(bam1_t* const record) {
     return hts_res;
 }
 
+// There's a file per barcode, so rather than giving each of them its own budget for sorting, the
+// records buffered by all of the files are kept within half of a single budget. Whenever another
+// record wouldn't fit, the largest buffer is written out to a run on disk. Each file is given the
+// whole budget, so none of them ever fills up and spills its buffer by itself.
+void BarcodeDemuxerNode::reserve_sort_buffer_memory(size_t memory) {
+    while (m_sort_buffer_memory > 0 && m_sort_buffer_memory + memory > m_sort_buffer_size / 2) {
+        auto largest = std::max_element(m_files.begin(), m_files.end(), [](auto& lhs, auto& rhs) {
+            return lhs.second->sort_buffer_memory() < rhs.second->sort_buffer_memory();
+        });
+        m_sort_buffer_memory -= largest->second->sort_buffer_memory();
+        largest->second->flush_sort_buffer();
+    }
+}
+
 void BarcodeDemuxerNode::set_header(const sam_hdr_t* const header) {
     if (header) {
         m_header.reset(sam_hdr_dup(header));
@@ -88,8 +111,7 @@ void BarcodeDemuxerNode::set_header(const sam_hdr_t* const header) {
 }
 
 void BarcodeDemuxerNode::finalise_hts_files(
-        const utils::HtsFile::ProgressCallback& progress_callback,
-        bool sort_if_mapped) {
+        const utils::HtsFile::ProgressCallback& progress_callback) {
     const size_t num_files = m_files.size();
     size_t current_file_idx = 0;
     for (auto& [bc, hts_file] : m_files) {
@@ -99,7 +121,7 @@ void BarcodeDemuxerNode::finalise_hts_files(
                     const size_t total_progress = (current_file_idx * 100 + progress) / num_files;
                     progress_callback(total_progress);
                 },
-                m_htslib_threads, sort_if_mapped);
+                m_htslib_threads);
         ++current_file_idx;
     }
 
@@ -26,7 +26,8 @@ public:
     BarcodeDemuxerNode(const std::string& output_dir,
                        size_t htslib_threads,
                        bool write_fastq,
-                       std::unique_ptr<const utils::SampleSheet> sample_sheet);
+                       std::unique_ptr<const utils::SampleSheet> sample_sheet,
+                       bool sort_bam);
     ~BarcodeDemuxerNode();
     std::string get_name() const override { return "BarcodeDemuxerNode"; }
     stats::NamedStats sample_stats() const override;
@@ -35,10 +36,13 @@ public:
 
     void set_header(const sam_hdr_t* header);
 
+    // Set the total amount of memory that all of the output files can use to buffer records for
+    // sorting. Must be called before any records are written.
+    void set_sort_buffer_size(size_t buffer_size) { m_sort_buffer_size = buffer_size; }
+
     // Finalisation must occur before destruction of this node.
     // Note that this isn't safe to call until after this node has been terminated.
-    void finalise_hts_files(const utils::HtsFile::ProgressCallback& progress_callback,
-                            bool sort_bam);
+    void finalise_hts_files(const utils::HtsFile::ProgressCallback& progress_callback);
 
 private:
     std::filesystem::path m_output_dir;
@@ -50,8 +54,13 @@ private:
     std::unique_ptr<std::thread> m_worker;
     void input_thread_fn();
     int write(bam1_t* record);
+    void reserve_sort_buffer_memory(size_t memory);
     bool m_write_fastq{false};
     std::unique_ptr<const utils::SampleSheet> m_sample_sheet;
+    bool m_sort_bam;
+    size_t m_sort_buffer_size{utils::HtsFile::DEFAULT_SORT_BUFFER_SIZE};
+    // The memory used by the sort buffers of all of the files.
+    size_t m_sort_buffer_memory{0};
 };
 
 }  // namespace dorado
@@ -16,7 +16,7 @@
 namespace dorado {
 
 HtsReader::HtsReader(const std::string& filename,
-                     std::optional<std::unordered_set<std::string>> read_list)
+                     std::optional<utils::ReadIdSet> read_list)
         : m_read_list(std::move(read_list)) {
     m_file = hts_open(filename.c_str(), "r");
     if (!m_file) {
@@ -42,6 +42,12 @@ HtsReader::~HtsReader() {
 
 bool HtsReader::read() { return sam_read1(m_file, header, record.get()) >= 0; }
 
+void HtsReader::set_decompression_threads(int threads) {
+    if (hts_set_threads(m_file, threads) < 0) {
+        throw std::runtime_error("Could not set decompression threads for HTS file");
+    }
+}
+
 bool HtsReader::has_tag(std::string tagname) {
     uint8_t* tag = bam_aux_get(record.get(), tagname.c_str());
     return static_cast<bool>(tag);
@@ -50,11 +56,8 @@ bool HtsReader::has_tag(std::string tagname) {
 std::size_t HtsReader::read(Pipeline& pipeline, std::size_t max_reads) {
     std::size_t num_reads = 0;
     while (this->read()) {
-        if (m_read_list) {
-            std::string read_id = bam_get_qname(record.get());
-            if (m_read_list->find(read_id) == m_read_list->end()) {
-                continue;
-            }
+        if (m_read_list && !m_read_list->contains(bam_get_qname(record.get()))) {
+            continue;
         }
         pipeline.push_message(BamPtr(bam_dup1(record.get())));
         ++num_reads;
@@ -104,7 +107,7 @@ ReadMap read_bam(const std::string& filename, const std::unordered_set<std::stri
     return reads;
 }
 
-std::unordered_set<std::string> fetch_read_ids(const std::string& filename) {
+utils::ReadIdSet fetch_read_ids(const std::string& filename) {
     if (filename.empty()) {
         return {};
     }
@@ -115,12 +118,11 @@ std::unordered_set<std::string> fetch_read_ids(const std::string& filename) {
     auto initial_hts_log_level = hts_get_log_level();
     hts_set_log_level(HTS_LOG_OFF);
 
-    std::unordered_set<std::string> read_ids;
+    utils::ReadIdSet read_ids;
     HtsReader reader(filename, std::nullopt);
     try {
         while (reader.read()) {
-            std::string read_id = bam_get_qname(reader.record);
-            read_ids.insert(read_id);
+            read_ids.insert(bam_get_qname(reader.record));
         }
     } catch (std::exception&) {
         // Do nothing.
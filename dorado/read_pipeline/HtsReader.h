@@ -1,6 +1,7 @@
 #pragma once
 
 #include "read_pipeline/ReadPipeline.h"
+#include "utils/ReadIdSet.h"
 #include "utils/stats.h"
 #include "utils/types.h"
 
@@ -22,13 +23,15 @@ class Pipeline;
 class HtsReader {
 public:
     HtsReader(const std::string& filename,
-              std::optional<std::unordered_set<std::string>> read_list);
+              std::optional<utils::ReadIdSet> read_list);
     ~HtsReader();
     bool read();
     std::size_t read(Pipeline& pipeline, std::size_t max_reads);
     template <typename T>
     T get_tag(std::string tagname);
     bool has_tag(std::string tagname);
+    // Decompress BGZF blocks on a pool of threads while reading, which htslib disables by default.
+    void set_decompression_threads(int threads);
 
     char* format{nullptr};
     bool is_aligned{false};
@@ -38,7 +41,7 @@ public:
 private:
     htsFile* m_file{nullptr};
 
-    std::optional<std::unordered_set<std::string>> m_read_list;
+    std::optional<utils::ReadIdSet> m_read_list;
 };
 
 template <typename T>
@@ -85,8 +88,8 @@ ReadMap read_bam(const std::string& filename, const std::unordered_set<std::stri
  * and all read ids seen so far are returned.
  *
  * @param filename The path to the input HTS file.
- * @return An unordered set with read ids.
+ * @return A set with read ids.
  */
-std::unordered_set<std::string> fetch_read_ids(const std::string& filename);
+utils::ReadIdSet fetch_read_ids(const std::string& filename);
 
 }  // namespace dorado
@@ -1,6 +1,7 @@
 #include "HtsWriter.h"
 
 #include "read_pipeline/ReadPipeline.h"
+#include "utils/bam_utils.h"
 #include "utils/sequence_utils.h"
 
 #include <htslib/bgzf.h>
@@ -10,6 +11,7 @@
 #include <spdlog/spdlog.h>
 
 #include <cassert>
+#include <chrono>
 #include <filesystem>
 #include <stdexcept>
 
@@ -18,7 +20,9 @@ namespace dorado {
 using OutputMode = dorado::utils::HtsFile::OutputMode;
 
 HtsWriter::HtsWriter(utils::HtsFile& file, std::string gpu_names)
-        : MessageSink(10000, 1), m_file(file), m_gpu_names(std::move(gpu_names)) {
+        : MessageSink(10000, 1, utils::AsyncQueueType::LockFree),
+          m_file(file),
+          m_gpu_names(std::move(gpu_names)) {
     if (!m_gpu_names.empty()) {
         m_gpu_names = "gpu:" + m_gpu_names;
     }
@@ -61,6 +65,13 @@ void HtsWriter::input_thread_fn() {
                                      std::to_string(res));
         }
 
+        // Secondary and supplementary records are written along with the primary one, so only
+        // count each read once.
+        const auto entry_time = utils::get_pipeline_entry_time(aln.get());
+        if (entry_time && !(aln->core.flag & (BAM_FSECONDARY | BAM_FSUPPLEMENTARY))) {
+            m_read_latencies.record(std::chrono::steady_clock::now() - *entry_time);
+        }
+
         // For the purpose of estimating write count, we ignore duplex reads
         int64_t dx_tag = 0;
         auto tag_str = bam_aux_get(aln.get(), "dx");
@@ -74,20 +85,20 @@ void HtsWriter::input_thread_fn() {
             // Read is a duplex read.
             m_duplex_reads_written++;
         } else {
-            std::string read_id;
+            const char* read_id;
 
             // If read is a split read, use the parent read id
             // to track write count since we don't know a priori
             // how many split reads will be generated.
             auto pid_tag = bam_aux_get(aln.get(), "pi");
             if (pid_tag) {
-                read_id = std::string(bam_aux2Z(pid_tag));
+                read_id = bam_aux2Z(pid_tag);
                 m_split_reads_written++;
             } else {
                 read_id = bam_get_qname(aln.get());
             }
 
-            m_processed_read_ids.add(std::move(read_id));
+            m_processed_read_ids.add(read_id);
         }
     }
 }
@@ -121,6 +132,7 @@ stats::NamedStats HtsWriter::sample_stats() const {
     stats["unique_simplex_reads_written"] = static_cast<double>(m_processed_read_ids.size());
     stats["duplex_reads_written"] = static_cast<double>(m_duplex_reads_written.load());
     stats["split_reads_written"] = static_cast<double>(m_split_reads_written.load());
+    m_read_latencies.add_to_stats(stats, "read_latency");
     return stats;
 }
 
@@ -128,8 +140,8 @@ void HtsWriter::terminate(const FlushOptions&) { stop_input_processing(); }
 
 std::size_t HtsWriter::ProcessedReadIds::size() const { return m_threadsafe_count_of_reads; }
 
-void HtsWriter::ProcessedReadIds::add(std::string read_id) {
-    read_ids.insert(std::move(read_id));
+void HtsWriter::ProcessedReadIds::add(std::string_view read_id) {
+    read_ids.insert(read_id);
     m_threadsafe_count_of_reads = read_ids.size();
 }
 
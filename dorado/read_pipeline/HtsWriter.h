@@ -1,5 +1,6 @@
 #pragma once
 #include "read_pipeline/ReadPipeline.h"
+#include "utils/ReadIdSet.h"
 #include "utils/hts_file.h"
 #include "utils/stats.h"
 
@@ -8,8 +9,8 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <string_view>
 #include <thread>
-#include <unordered_set>
 
 struct bam1_t;
 
@@ -45,12 +46,14 @@ private:
     void input_thread_fn();
     std::atomic<int> m_duplex_reads_written{0};
     std::atomic<int> m_split_reads_written{0};
+    // Time from reads being loaded to being written.
+    stats::LatencyHistogram m_read_latencies;
 
     // Expected usage:
     //  single writer thread calling add()
     //  many threads may concurrently call size().
     class ProcessedReadIds {
-        std::unordered_set<std::string> read_ids;
+        utils::ReadIdSet read_ids;
         std::atomic<std::size_t> m_threadsafe_count_of_reads{};
 
     public:
@@ -58,7 +61,7 @@ private:
         std::size_t size() const;
 
         // Not thread safe for concurrent calls.
-        void add(std::string read_id);
+        void add(std::string_view read_id);
     } m_processed_read_ids;
 };
 
@@ -1,11 +1,33 @@
 #include "MessageSink.h"
 
+#include "WorkerSlotPool.h"
+
 #include <cassert>
 
 namespace dorado {
 
-MessageSink::MessageSink(size_t max_messages, int num_input_threads)
-        : m_work_queue(max_messages), m_num_input_threads(num_input_threads) {}
+namespace {
+
+// State of the calling thread's most recent pop from an input queue.  Input threads only serve
+// one sink, so the time until the thread next pops, less time spent pushing to sinks, is the
+// time spent processing the popped messages.
+struct InputThreadTiming {
+    const MessageSink *sink{nullptr};
+    std::chrono::steady_clock::time_point pop_time{};
+    std::chrono::steady_clock::duration push_time{};
+    size_t num_messages{0};
+    // The worker slot held while processing the popped messages, if the sink has slots.
+    std::shared_ptr<NodeWorkerSlots> held_slots;
+};
+
+thread_local InputThreadTiming t_input_thread_timing;
+
+}  // namespace
+
+MessageSink::MessageSink(size_t max_messages,
+                         int num_input_threads,
+                         utils::AsyncQueueType queue_type)
+        : m_work_queue(max_messages, queue_type), m_num_input_threads(num_input_threads) {}
 
 void MessageSink::push_message_internal(Message &&message) {
 #ifndef NDEBUG
@@ -17,17 +39,120 @@ void MessageSink::push_message_internal(Message &&message) {
     assert(status == utils::AsyncQueueStatus::Success);
 }
 
+void MessageSink::push_messages(std::vector<Message> &&messages) {
+#ifndef NDEBUG
+    const auto status =
+#endif
+            m_work_queue.try_push_n(std::move(messages));
+    // As with push_message_internal, we do not expect to be pushing to a terminated sink.
+    assert(status == utils::AsyncQueueStatus::Success);
+}
+
+bool MessageSink::get_input_message(Message &message) {
+    const auto wait_start = start_input_wait();
+    const auto status = m_work_queue.try_pop(message);
+    const bool success = status == utils::AsyncQueueStatus::Success;
+    finish_input_wait(wait_start, success ? 1 : 0);
+    return success;
+}
+
+bool MessageSink::get_input_messages(std::vector<Message> &messages, size_t max_count) {
+    messages.clear();
+    const auto wait_start = start_input_wait();
+    const auto status = m_work_queue.process_and_pop_n(
+            [&messages](Message &&message) { messages.push_back(std::move(message)); },
+            max_count);
+    const bool success = status == utils::AsyncQueueStatus::Success;
+    finish_input_wait(wait_start, success ? messages.size() : 0);
+    return success;
+}
+
+MessageSink::TimePoint MessageSink::start_input_wait() {
+    const auto now = std::chrono::steady_clock::now();
+    auto &timing = t_input_thread_timing;
+    if (timing.sink == this && timing.num_messages > 0) {
+        const auto num_messages = int64_t(timing.num_messages);
+        const auto processing_time = now - timing.pop_time - timing.push_time;
+        m_processing_times.record(processing_time / num_messages, num_messages);
+    }
+    // Don't hold on to a worker slot while waiting for input.
+    if (timing.held_slots) {
+        timing.held_slots->release();
+        timing.held_slots.reset();
+    }
+    return now;
+}
+
+void MessageSink::finish_input_wait(TimePoint wait_start, size_t num_messages_popped) {
+    auto &timing = t_input_thread_timing;
+    if (num_messages_popped == 0) {
+        // We're terminating, so there's nothing further to time.
+        timing = InputThreadTiming{};
+        return;
+    }
+    auto slots = std::atomic_load(&m_worker_slots);
+    if (slots) {
+        slots->acquire();
+    }
+    const auto now = std::chrono::steady_clock::now();
+    m_input_wait_times.record(now - wait_start);
+    timing = InputThreadTiming{this, now, {}, num_messages_popped, std::move(slots)};
+}
+
+void MessageSink::record_push_time(stats::LatencyHistogram::Duration push_time) {
+    m_push_times.record(push_time);
+    auto &timing = t_input_thread_timing;
+    if (timing.sink == this) {
+        timing.push_time += push_time;
+    }
+}
+
+double MessageSink::input_queue_occupancy() const {
+    const auto capacity = m_work_queue.capacity();
+    return capacity > 0 ? double(m_work_queue.size()) / double(capacity) : 0.0;
+}
+
+void MessageSink::set_worker_slots(std::shared_ptr<NodeWorkerSlots> slots) {
+    std::atomic_store(&m_worker_slots, std::move(slots));
+}
+
+bool MessageSink::add_input_threads(int num_threads) {
+    std::lock_guard lock(m_input_threads_mutex);
+    if (m_input_threads.empty()) {
+        // Not running, or being stopped.
+        return false;
+    }
+    for (int i = 0; i < num_threads; ++i) {
+        m_input_threads.push_back(std::thread(m_input_thread_fn));
+    }
+    m_num_input_threads += num_threads;
+    return true;
+}
+
+stats::NamedStats MessageSink::sample_stats_with_timings() const {
+    auto stats = sample_stats();
+    m_input_wait_times.add_to_stats(stats, "input_wait");
+    m_processing_times.add_to_stats(stats, "processing");
+    m_push_times.add_to_stats(stats, "push_wait");
+    return stats;
+}
+
 void MessageSink::add_sink(MessageSink &sink) { m_sinks.push_back(std::ref(sink)); }
 
 // Mark the input queue as terminating, and stop input processing threads.
 void MessageSink::stop_input_processing() {
     terminate_input_queue();
-    for (auto &t : m_input_threads) {
+    // Join outside of the lock, so that add_input_threads isn't held up by the threads finishing.
+    std::vector<std::thread> input_threads;
+    {
+        std::lock_guard lock(m_input_threads_mutex);
+        input_threads.swap(m_input_threads);
+    }
+    for (auto &t : input_threads) {
         if (t.joinable()) {
             t.join();
         }
     }
-    m_input_threads.clear();
 }
 
 }  // namespace dorado
\ No newline at end of file
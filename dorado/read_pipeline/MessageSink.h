@@ -6,7 +6,10 @@
 #include "utils/stats.h"
 
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <thread>
@@ -17,12 +20,18 @@
 
 namespace dorado {
 
+class NodeWorkerSlots;
+
 // Base class for an object which consumes messages as part of the processing pipeline.
 // Destructors of derived classes must call terminate() in order to shut down
 // waits on the input queue before attempting to join input worker threads.
 class MessageSink {
 public:
-    MessageSink(size_t max_messages, int num_input_threads);
+    // queue_type selects the input queue implementation.  AsyncQueueType::LockFree suits nodes
+    // whose input queue sees heavy traffic from many threads.
+    MessageSink(size_t max_messages,
+                int num_input_threads,
+                utils::AsyncQueueType queue_type = utils::AsyncQueueType::Locked);
 
     virtual ~MessageSink() = default;
 
@@ -32,6 +41,10 @@ public:
         return std::unordered_map<std::string, double>();
     }
 
+    // sample_stats, plus percentiles of the time the node's input threads spend waiting for
+    // input, processing each message, and blocked pushing messages to sinks.
+    stats::NamedStats sample_stats_with_timings() const;
+
     // Adds a message to the input queue.  This can block if the sink's queue is full.
     template <typename Msg>
     void push_message(Msg&& msg) {
@@ -40,6 +53,24 @@ public:
         push_message_internal(Message(std::move(msg)));
     }
 
+    // Adds a batch of messages to the input queue in one queue operation.  This can block if
+    // the sink's queue is full.  On return messages is empty.
+    void push_messages(std::vector<Message>&& messages);
+
+    // Fraction of the input queue's capacity currently in use.
+    double input_queue_occupancy() const;
+
+    int num_input_threads() const { return m_num_input_threads.load(); }
+
+    // Starts num_threads more input threads while the node is running, returning false if it
+    // isn't.  The extra threads are kept if the node is restarted.
+    bool add_input_threads(int num_threads);
+
+    // If slots is non-null, input threads must take one of its slots before processing the
+    // messages they pop, which limits how many of them work at once.  Can be called while the
+    // node is running.
+    void set_worker_slots(std::shared_ptr<NodeWorkerSlots> slots);
+
     // Waits until work is finished and shuts down worker threads.
     // No work can be done by the node after this returns until
     // restart is subsequently called.
@@ -59,7 +90,9 @@ protected:
     // Sends message to the designated sink.
     template <typename Msg>
     void send_message_to_sink(int sink_index, Msg&& message) {
+        const auto push_start = std::chrono::steady_clock::now();
         m_sinks.at(sink_index).get().push_message(std::forward<Msg>(message));
+        record_push_time(std::chrono::steady_clock::now() - push_start);
     }
 
     // Version for nodes with a single sink that is implicit.
@@ -71,12 +104,34 @@ protected:
         send_message_to_sink(0, std::forward<Msg>(message));
     }
 
+    // Sends a batch of messages to the designated sink in one queue operation.
+    void send_messages_to_sink(int sink_index, std::vector<Message>&& messages) {
+        if (!messages.empty()) {
+            const auto push_start = std::chrono::steady_clock::now();
+            m_sinks.at(sink_index).get().push_messages(std::move(messages));
+            record_push_time(std::chrono::steady_clock::now() - push_start);
+        }
+    }
+
+    // Version for nodes with a single sink that is implicit.
+    void send_messages_to_sink(std::vector<Message>&& messages) {
+        if (m_sinks.size() != 1) {
+            throw std::runtime_error("Invalid m_sinks size");
+        }
+        send_messages_to_sink(0, std::move(messages));
+    }
+
     // Pops the next input message, returning true on success.
     // If terminating, returns false.
-    bool get_input_message(Message& message) {
-        auto status = m_work_queue.try_pop(message);
-        return status == utils::AsyncQueueStatus::Success;
-    }
+    bool get_input_message(Message& message);
+
+    // Replaces the contents of messages with the next input message plus up to max_count - 1
+    // more that are already queued, returning true on success.
+    // If terminating, returns false.
+    bool get_input_messages(std::vector<Message>& messages, size_t max_count);
+
+    // Default number of messages nodes consuming batches pop from their input queue at once.
+    static constexpr size_t kMaxInputBatchSize = 32;
 
     // Queue of work items for this node.
     utils::AsyncQueue<Message> m_work_queue;
@@ -94,16 +149,20 @@ protected:
                     "Attempting to start input processing with invalid thread count");
         }
 
+        std::lock_guard lock(m_input_threads_mutex);
         // Should only be called at construction time, or after stop_input_processing.
         if (!m_input_threads.empty()) {
             throw std::runtime_error("Input threads already started");
         }
 
+        // Kept so that more input threads can be started by add_input_threads.
+        m_input_thread_fn = [input_thread_fn...] { std::invoke(input_thread_fn...); };
+
         // The queue must be in started state before we attempt to pop an item,
         // otherwise the pop will fail and the thread will terminate.
         start_input_queue();
         for (int i = 0; i < m_num_input_threads; ++i) {
-            m_input_threads.push_back(std::thread(input_thread_fn...));
+            m_input_threads.push_back(std::thread(m_input_thread_fn));
         }
     }
 
@@ -119,9 +178,25 @@ private:
 
     void push_message_internal(Message&& message);
 
+    // Timing of the calling input thread's use of the input queue, which tracks how long it
+    // spends processing the messages it pops.
+    using TimePoint = std::chrono::steady_clock::time_point;
+    TimePoint start_input_wait();
+    void finish_input_wait(TimePoint wait_start, size_t num_messages_popped);
+    void record_push_time(stats::LatencyHistogram::Duration push_time);
+
+    // Accessed via std::atomic_load/atomic_store, since it can be changed while running.
+    std::shared_ptr<NodeWorkerSlots> m_worker_slots;
+
+    stats::LatencyHistogram m_input_wait_times;
+    stats::LatencyHistogram m_processing_times;
+    stats::LatencyHistogram m_push_times;
+
     // Input processing threads.
-    const int m_num_input_threads;
+    std::atomic<int> m_num_input_threads;
+    std::mutex m_input_threads_mutex;
     std::vector<std::thread> m_input_threads;
+    std::function<void()> m_input_thread_fn;
 };
 
 }  // namespace dorado
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "ModBaseCallerNode.h"
 
+#include "modbase/KmerIndex.h"
 #include "modbase/ModBaseContext.h"
 #include "modbase/ModBaseModelConfig.h"
 #include "modbase/ModBaseRunner.h"
@@ -13,7 +14,9 @@
 #include <nvtx3/nvtx3.hpp>
 #include <spdlog/spdlog.h>
 
+#include <cassert>
 #include <chrono>
+#include <cstddef>
 #include <cstring>
 #include <iostream>
 
@@ -23,24 +26,83 @@ namespace dorado {
 
 constexpr auto FORCE_TIMEOUT = 100ms;
 
-struct ModBaseCallerNode::RemoraChunk {
-    RemoraChunk(std::shared_ptr<WorkingRead> read,
-                at::Tensor input_signal,
-                std::vector<int8_t> kmer_data,
-                size_t position,
-                bool template_direction)
-            : working_read(std::move(read)),
-              signal(std::move(input_signal)),
-              encoded_kmers(std::move(kmer_data)),
-              context_hit(position),
-              is_template_direction(template_direction) {}
-
-    std::shared_ptr<WorkingRead> working_read;
-    at::Tensor signal;
-    std::vector<int8_t> encoded_kmers;
-    size_t context_hit;
+// Upper bound on the arenas kept for reuse, since each can hold tens of MB for a long read.
+constexpr size_t MAX_FREE_CHUNK_ARENAS = 16;
+
+namespace {
+
+// Resizes buffer, returning 1 if that needed an allocation.
+template <typename T>
+int resize_buffer(std::vector<T>& buffer, size_t size) {
+    const auto capacity = buffer.capacity();
+    buffer.resize(size);
+    return buffer.capacity() != capacity ? 1 : 0;
+}
+
+}  // namespace
+
+// Holds the signal, encoded kmers and scores of every chunk of a read for one caller, so that
+// making a chunk means writing a row rather than allocating.  Arenas are recycled once their
+// read has been called, so in the steady state chunk generation doesn't allocate at all.
+struct ModBaseCallerNode::ChunkArena {
+    // Sizes the arena for num_chunks_ chunks with the same dtype as signal, reusing the existing
+    // buffers if they are big enough.  Returns the number of buffers allocated.
+    int reset(size_t num_chunks_,
+              size_t signal_len_,
+              size_t kmers_len_,
+              size_t num_scores_,
+              const at::Tensor& signal) {
+        num_chunks = num_chunks_;
+        signal_len = signal_len_;
+        kmers_len = kmers_len_;
+        num_scores = num_scores_;
+
+        int num_allocations = 0;
+        const auto num_signal_elems = static_cast<int64_t>(num_chunks * signal_len);
+        if (!signals.defined() || signals.scalar_type() != signal.scalar_type() ||
+            signals.numel() < num_signal_elems) {
+            signals = at::empty({num_signal_elems}, signal.options());
+            ++num_allocations;
+        }
+        num_allocations += resize_buffer(kmers, num_chunks * kmers_len);
+        num_allocations += resize_buffer(scores, num_chunks * num_scores);
+        return num_allocations;
+    }
+
+    // Writes the signal and encoded kmers of the context centred on context_hit into row.
+    // signal must be contiguous.
+    void write_chunk(size_t row,
+                     const at::Tensor& signal,
+                     const modbase::ModBaseEncoder& encoder,
+                     size_t context_hit) {
+        const auto context = encoder.get_context(context_hit, kmers_row(row));
+        assert(context.lead_samples_needed + context.num_samples + context.tail_samples_needed ==
+               signal_len);
+
+        // Zero pad where the context runs off either end of the signal.
+        auto* const signals_ptr = static_cast<std::byte*>(signals.data_ptr());
+        const size_t elem_size = signals.element_size();
+        const size_t row_start = row * signal_len;
+        const size_t tail_start = row_start + context.lead_samples_needed + context.num_samples;
+        std::memset(&signals_ptr[row_start * elem_size], 0,
+                    context.lead_samples_needed * elem_size);
+        utils::copy_tensor_elems(signals, row_start + context.lead_samples_needed, signal,
+                                 context.first_sample, context.num_samples);
+        std::memset(&signals_ptr[tail_start * elem_size], 0,
+                    context.tail_samples_needed * elem_size);
+    }
+
+    int8_t* kmers_row(size_t row) { return &kmers[row * kmers_len]; }
+    float* scores_row(size_t row) { return &scores[row * num_scores]; }
+
+    // Flat, num_chunks * signal_len elements are in use.
+    at::Tensor signals;
+    std::vector<int8_t> kmers;
     std::vector<float> scores;
-    bool is_template_direction;
+    size_t num_chunks{0};
+    size_t signal_len{0};
+    size_t kmers_len{0};
+    size_t num_scores{0};
 };
 
 struct ModBaseCallerNode::WorkingRead {
@@ -48,6 +110,7 @@ struct ModBaseCallerNode::WorkingRead {
     size_t num_modbase_chunks;
     std::atomic_size_t
             num_modbase_chunks_called;  // Number of modbase chunks which have been scored
+    std::vector<std::unique_ptr<ChunkArena>> chunk_arenas;  // Storage for the read's chunks.
 };
 
 ModBaseCallerNode::ModBaseCallerNode(std::vector<modbase::RunnerPtr> model_runners,
@@ -63,8 +126,7 @@ ModBaseCallerNode::ModBaseCallerNode(std::vector<modbase::RunnerPtr> model_runne
     init_modbase_info();
     for (size_t i = 0; i < m_runners[0]->num_callers(); i++) {
         m_chunk_queues.emplace_back(
-                std::make_unique<utils::AsyncQueue<std::unique_ptr<RemoraChunk>>>(m_batch_size *
-                                                                                  5));
+                std::make_unique<utils::AsyncQueue<RemoraChunk>>(m_batch_size * 5));
     }
 
     // Spin up the processing threads:
@@ -142,6 +204,29 @@ void ModBaseCallerNode::init_modbase_info() {
     m_base_prob_offsets[3] = m_base_prob_offsets[2] + result.base_counts[2];
 }
 
+std::unique_ptr<ModBaseCallerNode::ChunkArena> ModBaseCallerNode::acquire_chunk_arena() {
+    {
+        std::lock_guard<std::mutex> lock(m_free_chunk_arenas_mutex);
+        if (!m_free_chunk_arenas.empty()) {
+            auto arena = std::move(m_free_chunk_arenas.back());
+            m_free_chunk_arenas.pop_back();
+            return arena;
+        }
+    }
+    return std::make_unique<ChunkArena>();
+}
+
+void ModBaseCallerNode::release_chunk_arenas(std::vector<std::unique_ptr<ChunkArena>>&& arenas) {
+    std::lock_guard<std::mutex> lock(m_free_chunk_arenas_mutex);
+    for (auto& arena : arenas) {
+        if (m_free_chunk_arenas.size() >= MAX_FREE_CHUNK_ARENAS) {
+            break;
+        }
+        m_free_chunk_arenas.push_back(std::move(arena));
+    }
+    arenas.clear();
+}
+
 void ModBaseCallerNode::duplex_mod_call(Message&& message) {
     // Let's do this only for the template strand for now.
 
@@ -171,8 +256,7 @@ void ModBaseCallerNode::duplex_mod_call(Message&& message) {
 
         // all runners have the same set of callers, so we only need to use the first one
         auto& runner = m_runners[0];
-        std::vector<std::vector<std::unique_ptr<RemoraChunk>>> chunks_to_enqueue_by_caller(
-                runner->num_callers());
+        std::vector<std::vector<RemoraChunk>> chunks_to_enqueue_by_caller(runner->num_callers());
 
         std::vector<unsigned long> all_context_hits;
 
@@ -209,7 +293,9 @@ void ModBaseCallerNode::duplex_mod_call(Message&& message) {
             auto signal_len = new_move_table.size() * m_block_stride;
             auto num_moves = std::accumulate(new_move_table.begin(), new_move_table.end(), 0);
             auto new_seq = duplex_seq.substr(target_start, num_moves);
-            std::vector<int> sequence_ints = utils::sequence_to_ints(new_seq);
+            // Shared by the scalers and encoders of every caller.
+            const auto kmers =
+                    std::make_shared<const modbase::KmerIndex>(utils::sequence_to_ints(new_seq));
 
             // no reverse_signal in duplex, so we can do this once for all callers
             std::vector<uint64_t> seq_to_sig_map =
@@ -224,30 +310,32 @@ void ModBaseCallerNode::duplex_mod_call(Message&& message) {
 
                 // scale signal based on model parameters
                 auto scaled_signal =
-                        runner->scale_signal(caller_id, signal, sequence_ints, seq_to_sig_map);
+                        runner->scale_signal(caller_id, signal, *kmers, seq_to_sig_map)
+                                .contiguous();
 
                 auto context_samples = (params.context_before + params.context_after);
 
                 // One-hot encodes the kmer at each signal step for input into the network
                 modbase::ModBaseEncoder encoder(m_block_stride, context_samples,
                                                 params.bases_before, params.bases_after);
-                encoder.init(sequence_ints, seq_to_sig_map);
+                encoder.init(kmers, seq_to_sig_map);
 
                 auto context_hits = runner->get_motif_hits(caller_id, new_seq);
                 m_num_context_hits += static_cast<int64_t>(context_hits.size());
-                chunks_to_enqueue.reserve(context_hits.size());
+                if (context_hits.empty()) {
+                    continue;
+                }
+                chunks_to_enqueue.reserve(chunks_to_enqueue.size() + context_hits.size());
 
-                for (auto context_hit : context_hits) {
+                auto arena = acquire_chunk_arena();
+                m_num_chunk_buffer_allocations +=
+                        arena->reset(context_hits.size(), context_samples, encoder.encoded_size(),
+                                     params.base_mod_count + 1, scaled_signal);
+
+                for (size_t row = 0; row < context_hits.size(); ++row) {
                     nvtx3::scoped_range range_create_chunk{"create_chunk"};
-                    auto slice = encoder.get_context(context_hit);
-                    // signal
-                    auto input_signal = scaled_signal.index({at::indexing::Slice(
-                            slice.first_sample, slice.first_sample + slice.num_samples)});
-                    if (slice.lead_samples_needed != 0 || slice.tail_samples_needed != 0) {
-                        input_signal = at::constant_pad_nd(input_signal,
-                                                           {(int64_t)slice.lead_samples_needed,
-                                                            (int64_t)slice.tail_samples_needed});
-                    }
+                    const auto context_hit = context_hits[row];
+                    arena->write_chunk(row, scaled_signal, encoder, context_hit);
 
                     // Update the context hit into the duplex reference context
                     unsigned long context_hit_in_duplex_space;
@@ -259,13 +347,14 @@ void ModBaseCallerNode::duplex_mod_call(Message&& message) {
                                 read->read_common.seq.size() - (context_hit + target_start + 1));
                     }
 
-                    chunks_to_enqueue.push_back(std::make_unique<RemoraChunk>(
-                            working_read, input_signal, std::move(slice.data),
-                            context_hit_in_duplex_space, is_template_direction));
+                    chunks_to_enqueue.push_back({working_read, arena.get(), row,
+                                                 context_hit_in_duplex_space,
+                                                 is_template_direction});
 
                     all_context_hits.push_back(context_hit_in_duplex_space);
                     ++working_read->num_modbase_chunks;
                 }
+                working_read->chunk_arenas.push_back(std::move(arena));
             }
         }
 
@@ -286,11 +375,8 @@ void ModBaseCallerNode::duplex_mod_call(Message&& message) {
             // needs to be done after working_read->read is set as chunks could be processed
             // before we set that value otherwise
             for (size_t caller_id = 0; caller_id < runner->num_callers(); ++caller_id) {
-                auto& chunk_queue = m_chunk_queues.at(caller_id);
-                auto& chunks_to_enqueue = chunks_to_enqueue_by_caller.at(caller_id);
-                for (auto& chunk : chunks_to_enqueue) {
-                    chunk_queue->try_push(std::move(chunk));
-                }
+                m_chunk_queues.at(caller_id)->try_push_n(
+                        std::move(chunks_to_enqueue_by_caller.at(caller_id)));
             }
         } else {
             // No modbases to call, pass directly to next node
@@ -324,12 +410,13 @@ void ModBaseCallerNode::simplex_mod_call(Message&& message) {
     working_read->num_modbase_chunks = 0;
     working_read->num_modbase_chunks_called = 0;
 
-    std::vector<int> sequence_ints = utils::sequence_to_ints(read->read_common.seq);
+    // Shared by the scalers and encoders of every caller.
+    const auto kmers = std::make_shared<const modbase::KmerIndex>(
+            utils::sequence_to_ints(read->read_common.seq));
 
     // all runners have the same set of callers, so we only need to use the first one
     auto& runner = m_runners[0];
-    std::vector<std::vector<std::unique_ptr<RemoraChunk>>> chunks_to_enqueue_by_caller(
-            runner->num_callers());
+    std::vector<std::vector<RemoraChunk>> chunks_to_enqueue_by_caller(runner->num_callers());
     for (size_t caller_id = 0; caller_id < runner->num_callers(); ++caller_id) {
         nvtx3::scoped_range range{"generate_chunks"};
 
@@ -350,34 +437,35 @@ void ModBaseCallerNode::simplex_mod_call(Message&& message) {
         }
 
         // scale signal based on model parameters
-        auto scaled_signal = runner->scale_signal(caller_id, signal, sequence_ints, seq_to_sig_map);
+        auto scaled_signal =
+                runner->scale_signal(caller_id, signal, *kmers, seq_to_sig_map).contiguous();
 
         auto context_samples = (params.context_before + params.context_after);
 
         // One-hot encodes the kmer at each signal step for input into the network
         modbase::ModBaseEncoder encoder(m_block_stride, context_samples, params.bases_before,
                                         params.bases_after);
-        encoder.init(sequence_ints, seq_to_sig_map);
+        encoder.init(kmers, seq_to_sig_map);
 
         auto context_hits = runner->get_motif_hits(caller_id, read->read_common.seq);
         m_num_context_hits += static_cast<int64_t>(context_hits.size());
+        if (context_hits.empty()) {
+            continue;
+        }
         chunks_to_enqueue.reserve(context_hits.size());
-        for (auto context_hit : context_hits) {
+
+        auto arena = acquire_chunk_arena();
+        m_num_chunk_buffer_allocations +=
+                arena->reset(context_hits.size(), context_samples, encoder.encoded_size(),
+                             params.base_mod_count + 1, scaled_signal);
+        for (size_t row = 0; row < context_hits.size(); ++row) {
             nvtx3::scoped_range nvtxrange{"create_chunk"};
-            auto slice = encoder.get_context(context_hit);
-            // signal
-            auto input_signal = scaled_signal.index({at::indexing::Slice(
-                    slice.first_sample, slice.first_sample + slice.num_samples)});
-            if (slice.lead_samples_needed != 0 || slice.tail_samples_needed != 0) {
-                input_signal = at::constant_pad_nd(
-                        input_signal,
-                        {(int64_t)slice.lead_samples_needed, (int64_t)slice.tail_samples_needed});
-            }
-            chunks_to_enqueue.push_back(std::make_unique<RemoraChunk>(
-                    working_read, input_signal, std::move(slice.data), context_hit, true));
+            arena->write_chunk(row, scaled_signal, encoder, context_hits[row]);
+            chunks_to_enqueue.push_back({working_read, arena.get(), row, context_hits[row], true});
 
             ++working_read->num_modbase_chunks;
         }
+        working_read->chunk_arenas.push_back(std::move(arena));
     }
     m_chunk_generation_ms += timer.GetElapsedMS();
 
@@ -396,11 +484,8 @@ void ModBaseCallerNode::simplex_mod_call(Message&& message) {
         // needs to be done after working_read->read is set as chunks could be processed
         // before we set that value otherwise
         for (size_t caller_id = 0; caller_id < runner->num_callers(); ++caller_id) {
-            auto& chunk_queue = m_chunk_queues.at(caller_id);
-            auto& chunks_to_enqueue = chunks_to_enqueue_by_caller.at(caller_id);
-            for (auto& chunk : chunks_to_enqueue) {
-                chunk_queue->try_push(std::move(chunk));
-            }
+            m_chunk_queues.at(caller_id)->try_push_n(
+                    std::move(chunks_to_enqueue_by_caller.at(caller_id)));
         }
     } else {
         // No modbases to call, pass directly to next node
@@ -431,7 +516,7 @@ void ModBaseCallerNode::modbasecall_worker_thread(size_t worker_id, size_t calle
     auto& runner = m_runners[worker_id];
     auto& chunk_queue = m_chunk_queues[caller_id];
 
-    std::vector<std::unique_ptr<RemoraChunk>> batched_chunks;
+    std::vector<RemoraChunk> batched_chunks;
     auto last_chunk_reserve_time = std::chrono::system_clock::now();
 
     size_t previous_chunk_count = 0;
@@ -439,7 +524,7 @@ void ModBaseCallerNode::modbasecall_worker_thread(size_t worker_id, size_t calle
         nvtx3::scoped_range range{"modbasecall_worker_thread"};
         // Repeatedly attempt to complete the current batch with one acquisition of the
         // chunk queue mutex.
-        auto grab_chunk = [&batched_chunks](std::unique_ptr<RemoraChunk> chunk) {
+        auto grab_chunk = [&batched_chunks](RemoraChunk chunk) {
             batched_chunks.push_back(std::move(chunk));
         };
         const auto status = chunk_queue->process_and_pop_n_with_timeout(
@@ -459,8 +544,9 @@ void ModBaseCallerNode::modbasecall_worker_thread(size_t worker_id, size_t calle
              ++chunk_idx) {
             assert(chunk_idx < m_batch_size);
             const auto& chunk = batched_chunks[chunk_idx];
-            runner->accept_chunk(int(caller_id), int(chunk_idx), chunk->signal,
-                                 chunk->encoded_kmers);
+            runner->accept_chunk(int(caller_id), int(chunk_idx), chunk.arena->signals,
+                                 chunk.arena_row * chunk.arena->signal_len,
+                                 chunk.arena->kmers_row(chunk.arena_row));
         }
 
         // If we have a complete batch, or we have a partial batch and timed out,
@@ -490,7 +576,7 @@ void ModBaseCallerNode::modbasecall_worker_thread(size_t worker_id, size_t calle
 void ModBaseCallerNode::call_current_batch(
         size_t worker_id,
         size_t caller_id,
-        std::vector<std::unique_ptr<RemoraChunk>>& batched_chunks) {
+        std::vector<RemoraChunk>& batched_chunks) {
     nvtx3::scoped_range loop{"call_current_batch"};
 
     dorado::stats::Timer timer;
@@ -503,15 +589,19 @@ void ModBaseCallerNode::call_current_batch(
     assert(results_f32.is_contiguous());
     const auto* const results_f32_ptr = results_f32.data_ptr<float>();
 
-    auto row_size = results.size(1);
+    const auto row_size = static_cast<size_t>(results.size(1));
 
-    // Put results into chunk
+    // Put results into the chunks' arenas
     for (size_t i = 0; i < batched_chunks.size(); ++i) {
         auto& chunk = batched_chunks[i];
-        chunk->scores.resize(row_size);
-        std::memcpy(chunk->scores.data(), &results_f32_ptr[i * row_size], row_size * sizeof(float));
-        m_processed_chunks.try_push(std::move(chunk));
+        if (chunk.arena->num_scores != row_size) {
+            throw std::runtime_error("Unexpected number of modbase scores: " +
+                                     std::to_string(row_size));
+        }
+        std::memcpy(chunk.arena->scores_row(chunk.arena_row), &results_f32_ptr[i * row_size],
+                    row_size * sizeof(float));
     }
+    m_processed_chunks.try_push_n(std::move(batched_chunks));
 
     batched_chunks.clear();
     ++m_num_batches_called;
@@ -522,8 +612,8 @@ void ModBaseCallerNode::output_worker_thread() {
 
     // The m_processed_chunks lock is sufficiently contended that it's worth taking all
     // chunks available once we obtain it.
-    std::vector<std::unique_ptr<RemoraChunk>> processed_chunks;
-    auto grab_chunk = [&processed_chunks](std::unique_ptr<RemoraChunk> chunk) {
+    std::vector<RemoraChunk> processed_chunks;
+    auto grab_chunk = [&processed_chunks](RemoraChunk chunk) {
         processed_chunks.push_back(std::move(chunk));
     };
     while (m_processed_chunks.process_and_pop_n(grab_chunk, m_processed_chunks.capacity()) ==
@@ -533,29 +623,32 @@ void ModBaseCallerNode::output_worker_thread() {
         std::vector<std::shared_ptr<WorkingRead>> completed_reads;
 
         for (const auto& chunk : processed_chunks) {
-            auto working_read = chunk->working_read;
+            auto working_read = chunk.working_read;
             auto& source_read = working_read->read;
             auto& source_read_common = get_read_common_data(source_read);
 
-            int64_t result_pos = chunk->context_hit;
+            int64_t result_pos = chunk.context_hit;
 
             int64_t offset;
             const auto& baseIds = utils::BaseInfo::BASE_IDS;
             const auto& seq = source_read_common.seq[result_pos];
 
-            offset = chunk->is_template_direction
+            offset = chunk.is_template_direction
                              ? m_base_prob_offsets[baseIds[seq]]
                              : m_base_prob_offsets[baseIds[dorado::utils::complement_table[seq]]];
 
-            auto num_chunk_scores = chunk->scores.size();
+            const auto num_chunk_scores = chunk.arena->num_scores;
+            const auto* const chunk_scores = chunk.arena->scores_row(chunk.arena_row);
             for (size_t i = 0; i < num_chunk_scores; ++i) {
                 source_read_common.base_mod_probs[m_num_states * result_pos + offset + i] =
-                        static_cast<uint8_t>(std::min(std::floor(chunk->scores[i] * 256), 255.0f));
+                        static_cast<uint8_t>(std::min(std::floor(chunk_scores[i] * 256), 255.0f));
             }
             // If all chunks for the read associated with this chunk have now been called,
             // add it to the completed_reads vector for subsequent sending on to the sink.
             auto num_chunks_called = ++working_read->num_modbase_chunks_called;
             if (num_chunks_called == working_read->num_modbase_chunks) {
+                // Every chunk of the read has been called, so its arenas can be reused.
+                release_chunk_arenas(std::move(working_read->chunk_arenas));
                 completed_reads.push_back(std::move(working_read));
             }
         }
@@ -599,6 +692,7 @@ std::unordered_map<std::string, double> ModBaseCallerNode::sample_stats() const
     stats["mod_base_reads_pushed"] = double(m_num_mod_base_reads_pushed);
     stats["non_mod_base_reads_pushed"] = double(m_num_non_mod_base_reads_pushed);
     stats["chunk_generation_ms"] = double(m_chunk_generation_ms);
+    stats["chunk_buffer_allocations"] = double(m_num_chunk_buffer_allocations);
     stats["working_reads_items"] = double(m_working_reads_size);
     return stats;
 }
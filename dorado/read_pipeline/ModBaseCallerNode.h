@@ -22,9 +22,19 @@ using RunnerPtr = std::unique_ptr<ModBaseRunner>;
 }  // namespace modbase
 
 class ModBaseCallerNode : public MessageSink {
-    struct RemoraChunk;
+    struct ChunkArena;
     struct WorkingRead;
 
+    // A single context to be modbase called.  Its signal, encoded kmers and scores live in a
+    // row of an arena shared with the other chunks of the read.
+    struct RemoraChunk {
+        std::shared_ptr<WorkingRead> working_read;
+        ChunkArena* arena;
+        size_t arena_row;
+        size_t context_hit;
+        bool is_template_direction;
+    };
+
 public:
     ModBaseCallerNode(std::vector<modbase::RunnerPtr> model_runners,
                       size_t remora_threads,
@@ -45,6 +55,11 @@ private:
     // Determine the modbase alphabet from all callers and calculate offset positions for the results
     void init_modbase_info();
 
+    // Takes an arena from the free list, or makes a new one if it's empty.
+    std::unique_ptr<ChunkArena> acquire_chunk_arena();
+    // Returns the arenas of a completed read to the free list.
+    void release_chunk_arenas(std::vector<std::unique_ptr<ChunkArena>>&& arenas);
+
     // Worker threads, scales and chunks reads for runners and enqueues them
     void input_thread_fn();
 
@@ -54,7 +69,7 @@ private:
     // Called by modbasecall_worker_thread, calls the model and enqueues the results
     void call_current_batch(size_t worker_id,
                             size_t caller_id,
-                            std::vector<std::unique_ptr<RemoraChunk>>& batched_chunks);
+                            std::vector<RemoraChunk>& batched_chunks);
 
     // Worker thread, processes chunk results back into the reads
     void output_worker_thread();
@@ -66,8 +81,12 @@ private:
     std::unique_ptr<std::thread> m_output_worker;
     std::vector<std::unique_ptr<std::thread>> m_runner_workers;
 
-    utils::AsyncQueue<std::unique_ptr<RemoraChunk>> m_processed_chunks;
-    std::vector<std::unique_ptr<utils::AsyncQueue<std::unique_ptr<RemoraChunk>>>> m_chunk_queues;
+    utils::AsyncQueue<RemoraChunk> m_processed_chunks;
+    std::vector<std::unique_ptr<utils::AsyncQueue<RemoraChunk>>> m_chunk_queues;
+
+    std::mutex m_free_chunk_arenas_mutex;
+    // Arenas of completed reads, kept so their buffers can be reused by later reads.
+    std::vector<std::unique_ptr<ChunkArena>> m_free_chunk_arenas;
 
     std::mutex m_working_reads_mutex;
     // Reads removed from input queue and being modbasecalled.
@@ -89,6 +108,7 @@ private:
     std::atomic<int64_t> m_num_mod_base_reads_pushed = 0;
     std::atomic<int64_t> m_num_non_mod_base_reads_pushed = 0;
     std::atomic<int64_t> m_chunk_generation_ms = 0;
+    std::atomic<int64_t> m_num_chunk_buffer_allocations = 0;
     std::atomic<int64_t> m_working_reads_size = 0;
 };
 
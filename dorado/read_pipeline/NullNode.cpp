@@ -1,11 +1,13 @@
 #include "NullNode.h"
 
+#include <vector>
+
 namespace dorado {
 
 void NullNode::input_thread_fn() {
-    Message message;
-    while (get_input_message(message)) {
-        // Do nothing with the popped message.
+    std::vector<Message> messages;
+    while (get_input_messages(messages, kMaxInputBatchSize)) {
+        // Do nothing with the popped messages.
     }
 }
 
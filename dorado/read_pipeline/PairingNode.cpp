@@ -2,12 +2,12 @@
 
 #include "ClientInfo.h"
 
-#include <minimap.h>
 #include <nvtx3/nvtx3.hpp>
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
 #include <cstdint>
+#include <functional>
 #include <limits>
 
 namespace {
@@ -112,44 +112,18 @@ PairingNode::PairingResult PairingNode::is_within_alignment_criteria(
     const std::string nvtx_id = "pairing_map_" + std::to_string(tid);
     nvtx3::scoped_range loop{nvtx_id};
     // Add mm2 based overlap check.
-    mm_idxopt_t m_idx_opt;
-    mm_mapopt_t m_map_opt;
-    mm_set_opt(0, &m_idx_opt, &m_map_opt);
-    mm_set_opt("map-hifi", &m_idx_opt, &m_map_opt);
+    const auto overlap =
+            m_overlappers[tid]->overlap(temp.read_common.seq, temp.read_common.read_id,
+                                        comp.read_common.seq, comp.read_common.read_id);
+    const int hits = overlap.num_hits;
 
-    std::vector<const char*> seqs = {temp.read_common.seq.c_str()};
-    std::vector<const char*> names = {temp.read_common.read_id.c_str()};
-    mm_idx_t* m_index = mm_idx_str(m_idx_opt.w, m_idx_opt.k, 0, m_idx_opt.bucket_bits, 1,
-                                   seqs.data(), names.data());
-    mm_mapopt_update(&m_map_opt, m_index);
-
-    mm_tbuf_t* tbuf = m_tbufs[tid].get();
-
-    int hits = 0;
-    mm_reg1_t* reg =
-            mm_map(m_index, int(comp.read_common.seq.length()), comp.read_common.seq.c_str(), &hits,
-                   tbuf, &m_map_opt, comp.read_common.read_id.c_str());
-
-    mm_idx_destroy(m_index);
-
-    // When there are multiple hits, pick the primary alignment.
     if (hits > 0) {
-        uint8_t mapq = 0;
-        int32_t temp_start = 0;
-        int32_t temp_end = 0;
-        int32_t comp_start = 0;
-        int32_t comp_end = 0;
-        bool rev = false;
-
-        auto best_map = std::max_element(
-                reg, reg + hits,
-                [](const mm_reg1_t& l, const mm_reg1_t& r) { return l.mapq < r.mapq; });
-        mapq = best_map->mapq;
-        temp_start = best_map->rs;
-        temp_end = best_map->re;
-        comp_start = best_map->qs;
-        comp_end = best_map->qe;
-        rev = best_map->rev;
+        const uint8_t mapq = overlap.mapq;
+        const int32_t temp_start = overlap.ref_start;
+        const int32_t temp_end = overlap.ref_end;
+        const int32_t comp_start = overlap.query_start;
+        const int32_t comp_end = overlap.query_end;
+        const bool rev = overlap.rev;
 
         const int kMinMapQ = 50;
         const float kMinOverlapFraction = 0.8f;
@@ -184,11 +158,6 @@ PairingNode::PairingResult PairingNode::is_within_alignment_criteria(
         }
     }
 
-    for (int i = 0; i < hits; ++i) {
-        free(reg[i].p);
-    }
-    free(reg);
-
     return pair_result;
 }
 
@@ -277,6 +246,85 @@ void PairingNode::pair_list_worker_thread(int tid) {
     --m_num_active_worker_threads;
 }
 
+PairingNode::ReadCacheShard& PairingNode::get_read_cache_shard(int channel) {
+    return m_read_cache_shards[std::hash<int>{}(channel) % NUM_READ_CACHE_SHARDS];
+}
+
+std::unique_lock<std::mutex> PairingNode::lock_read_cache_shard(ReadCacheShard& shard) {
+    std::unique_lock<std::mutex> lock(shard.mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        ++shard.contended_lock_acquisitions;
+        lock.lock();
+    }
+    ++shard.lock_acquisitions;
+    return lock;
+}
+
+void PairingNode::add_working_channel_key(int32_t client_id, const UniquePoreIdentifierKey& key) {
+    if (m_max_num_keys == std::numeric_limits<size_t>::max()) {
+        // Pores are never evicted, so there's no need to track them.
+        return;
+    }
+
+    UniquePoreIdentifierKey oldest_key;
+    {
+        std::lock_guard<std::mutex> lock(m_working_channel_keys_mutex);
+        auto& working_channel_keys = m_working_channel_keys[client_id];
+        working_channel_keys.push_back(key);
+        if (working_channel_keys.size() <= m_max_num_keys) {
+            return;
+        }
+        // Remove the oldest key (front of the list)
+        oldest_key = std::move(working_channel_keys.front());
+        working_channel_keys.pop_front();
+    }
+
+    auto& shard = get_read_cache_shard(std::get<0>(oldest_key));
+    auto lock = lock_read_cache_shard(shard);
+    auto read_map_it = shard.channel_read_maps.find(client_id);
+    if (read_map_it == shard.channel_read_maps.end()) {
+        // The client's cache has already been flushed.
+        return;
+    }
+    auto& channel_read_map = read_map_it->second;
+    auto oldest_key_it = channel_read_map.find(oldest_key);
+    if (oldest_key_it == channel_read_map.end()) {
+        return;
+    }
+
+    // Remove the oldest key from the map
+    for (auto& read_ptr : oldest_key_it->second) {
+        shard.signal_bytes -= read_signal_bytes(*read_ptr);
+        shard.reads_to_clear.insert(std::move(read_ptr));
+    }
+    channel_read_map.erase(oldest_key_it);
+    clear_evicted_reads(shard);
+}
+
+void PairingNode::clear_evicted_reads(ReadCacheShard& shard) {
+    // Check if any of the in-flight reads need to be purged from the cache.
+    for (auto to_clear_itr = shard.reads_to_clear.begin();
+         to_clear_itr != shard.reads_to_clear.end();) {
+        auto in_flight_itr = shard.reads_in_flight_ctr.find(to_clear_itr->get());
+        bool ok_to_clear = false;
+        // If a read to clear is not in-flight (not in the in-flight list
+        // or in-flight counter is 0), then clear it
+        // from the cache.
+        if (in_flight_itr == shard.reads_in_flight_ctr.end()) {
+            ok_to_clear = true;
+        } else if (in_flight_itr->second == 0) {
+            shard.reads_in_flight_ctr.erase(in_flight_itr);
+            ok_to_clear = true;
+        }
+        if (ok_to_clear) {
+            auto read_handle = shard.reads_to_clear.extract(*to_clear_itr++);
+            send_message_to_sink(std::move(read_handle.value()));
+        } else {
+            ++to_clear_itr;
+        }
+    }
+}
+
 void PairingNode::pair_generating_worker_thread(int tid) {
     at::InferenceMode inference_mode_guard;
 
@@ -287,18 +335,25 @@ void PairingNode::pair_generating_worker_thread(int tid) {
     Message message;
     while (get_input_message(message)) {
         if (std::holds_alternative<CacheFlushMessage>(message)) {
-            std::unique_lock<std::mutex> lock(m_pairing_mtx);
             auto flush_message = std::get<CacheFlushMessage>(message);
-            auto& read_cache = m_read_caches[flush_message.client_id];
-            for (auto& [key, reads_list] : read_cache.channel_read_map) {
-                // kv is a std::pair<UniquePoreIdentifierKey, std::list<std::shared_ptr<Read>>>
-                for (auto& read_ptr : reads_list) {
-                    // Push each read message
-                    m_cache_signal_bytes -= read_signal_bytes(*read_ptr);
-                    send_message_to_sink(std::move(read_ptr));
+            for (auto& shard : m_read_cache_shards) {
+                auto lock = lock_read_cache_shard(shard);
+                auto read_map_it = shard.channel_read_maps.find(flush_message.client_id);
+                if (read_map_it == shard.channel_read_maps.end()) {
+                    continue;
                 }
+                for (auto& [key, reads_list] : read_map_it->second) {
+                    // kv is a std::pair<UniquePoreIdentifierKey, std::list<std::shared_ptr<Read>>>
+                    for (auto& read_ptr : reads_list) {
+                        // Push each read message
+                        shard.signal_bytes -= read_signal_bytes(*read_ptr);
+                        send_message_to_sink(std::move(read_ptr));
+                    }
+                }
+                shard.channel_read_maps.erase(read_map_it);
             }
-            m_read_caches.erase(flush_message.client_id);
+            std::lock_guard<std::mutex> lock(m_working_channel_keys_mutex);
+            m_working_channel_keys.erase(flush_message.client_id);
             continue;
         }
 
@@ -318,43 +373,28 @@ void PairingNode::pair_generating_worker_thread(int tid) {
         std::string flowcell_id = read->read_common.flowcell_id;
         int32_t client_id = read->read_common.client_info->client_id();
 
-        std::unique_lock<std::mutex> lock(m_pairing_mtx);
+        auto& shard = get_read_cache_shard(channel);
+        auto lock = lock_read_cache_shard(shard);
 
-        auto& read_cache = m_read_caches[client_id];
+        auto& channel_read_map = shard.channel_read_maps[client_id];
         UniquePoreIdentifierKey key = std::make_tuple(channel, run_id, flowcell_id);
-        auto read_list_iter = read_cache.channel_read_map.find(key);
+        auto read_list_iter = channel_read_map.find(key);
         // Check if the key is already in the list
-        if (read_list_iter == read_cache.channel_read_map.end()) {
-            // Key is not in the dequeue
-            // Add the new key to the end of the list
-            {
-                read_cache.working_channel_keys.push_back(key);
-                std::list<SimplexReadPtr> reads;
-                m_cache_signal_bytes += read_signal_bytes(*read);
-                reads.push_back(std::move(read));
-                read_cache.channel_read_map.emplace(key, std::move(reads));
-            }
-
-            if (read_cache.working_channel_keys.size() > m_max_num_keys) {
-                // Remove the oldest key (front of the list)
-                auto oldest_key = read_cache.working_channel_keys.front();
-                read_cache.working_channel_keys.pop_front();
-
-                auto oldest_key_it = read_cache.channel_read_map.find(oldest_key);
-
-                // Remove the oldest key from the map
-                for (auto& read_ptr : oldest_key_it->second) {
-                    m_cache_signal_bytes -= read_signal_bytes(*read_ptr);
-                    m_reads_to_clear.insert(std::move(read_ptr));
-                }
-                read_cache.channel_read_map.erase(oldest_key);
-                assert(read_cache.channel_read_map.size() ==
-                       read_cache.working_channel_keys.size());
-            }
+        if (read_list_iter == channel_read_map.end()) {
+            // Key is not in the cache, so add it.
+            std::list<SimplexReadPtr> reads;
+            shard.signal_bytes += read_signal_bytes(*read);
+            reads.push_back(std::move(read));
+            channel_read_map.emplace(key, std::move(reads));
+
+            // Eviction may need to lock another shard, so don't hold on to this one.
+            lock.unlock();
+            add_working_channel_key(client_id, key);
+            lock.lock();
         } else {
             auto& cached_read_list = read_list_iter->second;
             // It's safe to take raw pointers of these reads since their ownership isn't released from this
-            // node until their counter in |m_reads_in_flight_ctr| hits 0.
+            // node until their counter in |reads_in_flight_ctr| hits 0.
             SimplexRead* later_read = nullptr;
             SimplexRead* earlier_read = nullptr;
 
@@ -362,24 +402,24 @@ void PairingNode::pair_generating_worker_thread(int tid) {
                     cached_read_list.begin(), cached_read_list.end(), read, compare_reads_by_time);
             if (later_read_iter != cached_read_list.end()) {
                 later_read = later_read_iter->get();
-                m_reads_in_flight_ctr[later_read]++;
+                shard.reads_in_flight_ctr[later_read]++;
             }
 
             if (later_read_iter != cached_read_list.begin()) {
                 earlier_read = std::prev(later_read_iter)->get();
-                m_reads_in_flight_ctr[earlier_read]++;
+                shard.reads_in_flight_ctr[earlier_read]++;
             }
 
             SimplexRead* const read_ptr = read.get();
-            m_cache_signal_bytes += read_signal_bytes(*read);
+            shard.signal_bytes += read_signal_bytes(*read);
             cached_read_list.insert(later_read_iter, std::move(read));
-            m_reads_in_flight_ctr[read_ptr]++;
+            shard.reads_in_flight_ctr[read_ptr]++;
 
             while (cached_read_list.size() > m_max_num_reads) {
-                m_cache_signal_bytes -= read_signal_bytes(*cached_read_list.front());
+                shard.signal_bytes -= read_signal_bytes(*cached_read_list.front());
                 auto cached_read = std::move(cached_read_list.front());
                 cached_read_list.pop_front();
-                m_reads_to_clear.insert(std::move(cached_read));
+                shard.reads_to_clear.insert(std::move(cached_read));
             }
 
             // Release mutex around read cache to run pair evaluations.
@@ -419,59 +459,48 @@ void PairingNode::pair_generating_worker_thread(int tid) {
             lock.lock();
 
             // Decrement in-flight counter for each read.
-            m_reads_in_flight_ctr[read_ptr]--;
+            shard.reads_in_flight_ctr[read_ptr]--;
             if (earlier_read) {
-                m_reads_in_flight_ctr[earlier_read]--;
+                shard.reads_in_flight_ctr[earlier_read]--;
             }
             if (later_read) {
-                m_reads_in_flight_ctr[later_read]--;
+                shard.reads_in_flight_ctr[later_read]--;
             }
         }
 
         // Once pairs have been evaluated, check if any of the in-flight reads
         // need to be purged from the cache.
-        for (auto to_clear_itr = m_reads_to_clear.begin();
-             to_clear_itr != m_reads_to_clear.end();) {
-            auto in_flight_itr = m_reads_in_flight_ctr.find(to_clear_itr->get());
-            bool ok_to_clear = false;
-            // If a read to clear is not in-flight (not in the in-flight list
-            // or in-flight counter is 0), then clear it
-            // from the cache.
-            if (in_flight_itr == m_reads_in_flight_ctr.end()) {
-                ok_to_clear = true;
-            } else if (in_flight_itr->second.load() == 0) {
-                m_reads_in_flight_ctr.erase(in_flight_itr);
-                ok_to_clear = true;
-            }
-            if (ok_to_clear) {
-                auto read_handle = m_reads_to_clear.extract(*to_clear_itr++);
-                send_message_to_sink(std::move(read_handle.value()));
-            } else {
-                ++to_clear_itr;
-            }
-        }
+        clear_evicted_reads(shard);
     }
 
     if (--m_num_active_worker_threads == 0) {
-        if (!m_preserve_cache_during_flush) {
-            std::unique_lock<std::mutex> lock(m_pairing_mtx);
-            // There are still reads in channel_read_map. Push them to the sink.
-            // Last thread alive is responsible for cleaning up the cache.
-            for (auto& [client_id, read_cache] : m_read_caches) {
-                for (auto& kv : read_cache.channel_read_map) {
-                    // kv is a std::pair<UniquePoreIdentifierKey, std::list<std::shared_ptr<Read>>>
-                    auto& reads_list = kv.second;
-
-                    for (auto& read_ptr : reads_list) {
-                        m_cache_signal_bytes -= read_signal_bytes(*read_ptr);
-                        // Push each read message
-                        send_message_to_sink(std::move(read_ptr));
+        // Last thread alive is responsible for cleaning up the cache.
+        for (auto& shard : m_read_cache_shards) {
+            auto lock = lock_read_cache_shard(shard);
+            if (!m_preserve_cache_during_flush) {
+                // There are still reads in the channel read maps. Push them to the sink.
+                for (auto& [client_id, channel_read_map] : shard.channel_read_maps) {
+                    for (auto& kv : channel_read_map) {
+                        // kv is a std::pair<UniquePoreIdentifierKey, std::list<std::shared_ptr<Read>>>
+                        auto& reads_list = kv.second;
+
+                        for (auto& read_ptr : reads_list) {
+                            shard.signal_bytes -= read_signal_bytes(*read_ptr);
+                            // Push each read message
+                            send_message_to_sink(std::move(read_ptr));
+                        }
                     }
                 }
+                shard.channel_read_maps.clear();
             }
-            m_read_caches.clear();
+            shard.reads_in_flight_ctr.clear();
+            // Nothing is in flight any more, so any evicted reads can be pushed.
+            clear_evicted_reads(shard);
+        }
+        if (!m_preserve_cache_during_flush) {
+            std::lock_guard<std::mutex> lock(m_working_channel_keys_mutex);
+            m_working_channel_keys.clear();
         }
-        m_reads_in_flight_ctr.clear();
     }
 }
 
@@ -515,9 +544,9 @@ PairingNode::PairingNode(DuplexPairingParameters pairing_params,
 }
 
 void PairingNode::start_threads() {
-    m_tbufs.reserve(m_num_worker_threads);
+    m_overlappers.reserve(m_num_worker_threads);
     for (int i = 0; i < m_num_worker_threads; i++) {
-        m_tbufs.push_back(MmTbufPtr(mm_tbuf_init()));
+        m_overlappers.push_back(std::make_unique<utils::PairwiseOverlapper>());
         m_workers.push_back(std::make_unique<std::thread>(std::thread(m_pairing_func, this, i)));
         ++m_num_active_worker_threads;
     }
@@ -538,7 +567,7 @@ void PairingNode::terminate_impl() {
     }
     m_workers.clear();
 
-    m_tbufs.clear();
+    m_overlappers.clear();
 }
 
 void PairingNode::restart() {
@@ -550,8 +579,21 @@ stats::NamedStats PairingNode::sample_stats() const {
     stats::NamedStats stats = m_work_queue.sample_stats();
     stats["early_accepted_pairs"] = m_early_accepted_pairs.load();
     stats["overlap_accepted_pairs"] = m_overlap_accepted_pairs.load();
+    size_t cache_signal_bytes = 0;
+    size_t lock_acquisitions = 0;
+    size_t contended_lock_acquisitions = 0;
+    for (size_t i = 0; i < m_read_cache_shards.size(); ++i) {
+        const auto& shard = m_read_cache_shards[i];
+        cache_signal_bytes += shard.signal_bytes.load();
+        lock_acquisitions += shard.lock_acquisitions.load();
+        contended_lock_acquisitions += shard.contended_lock_acquisitions.load();
+        stats["cache_shard_" + std::to_string(i) + "_contended_locks"] =
+                static_cast<double>(shard.contended_lock_acquisitions.load());
+    }
     stats["cached_signal_mb"] =
-            static_cast<double>(m_cache_signal_bytes) / static_cast<double>(1024 * 1024);
+            static_cast<double>(cache_signal_bytes) / static_cast<double>(1024 * 1024);
+    stats["cache_lock_acquisitions"] = static_cast<double>(lock_acquisitions);
+    stats["cache_contended_locks"] = static_cast<double>(contended_lock_acquisitions);
     return stats;
 }
 
@@ -1,9 +1,11 @@
 #pragma once
 
 #include "ReadPipeline.h"
+#include "utils/PairwiseOverlapper.h"
 #include "utils/stats.h"
 #include "utils/types.h"
 
+#include <array>
 #include <atomic>
 #include <cstdint>
 #include <deque>
@@ -15,6 +17,7 @@
 #include <thread>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace dorado {
@@ -23,11 +26,27 @@ class PairingNode : public MessageSink {
     // A key for a unique Pore, Duplex reads must have the same UniquePoreIdentifierKey
     // The values are channel, run_id, flowcell_id
     using UniquePoreIdentifierKey = std::tuple<int, std::string, std::string>;
+    using ChannelReadMap = std::map<UniquePoreIdentifierKey, std::list<SimplexReadPtr>>;
 
-    struct ReadCache {
-        std::map<UniquePoreIdentifierKey, std::list<SimplexReadPtr>> channel_read_map;
-        std::deque<UniquePoreIdentifierKey> working_channel_keys;
+    // The read cache is sharded by channel so that workers handling reads from different
+    // pores don't contend on a single lock. Reads from the same pore always go to the same shard.
+    struct ReadCacheShard {
+        std::mutex mutex;
+
+        // individual read caches per client, keyed by client_id
+        std::unordered_map<int32_t, ChannelReadMap> channel_read_maps;
+
+        // Track reads which need to be emptied from the cache but are still being
+        // evaluated for pairs by other threads.
+        std::unordered_map<const SimplexRead*, int> reads_in_flight_ctr;
+        std::unordered_set<SimplexReadPtr> reads_to_clear;
+
+        // Stats tracking for the shard.
+        std::atomic<size_t> signal_bytes{0};
+        std::atomic<size_t> lock_acquisitions{0};
+        std::atomic<size_t> contended_lock_acquisitions{0};
     };
+    static constexpr size_t NUM_READ_CACHE_SHARDS = 16;
 
 public:
     // Template-complement map: uses the pair_list pairing method
@@ -64,6 +83,17 @@ private:
      */
     void pair_generating_worker_thread(int tid);
 
+    ReadCacheShard& get_read_cache_shard(int channel);
+    std::unique_lock<std::mutex> lock_read_cache_shard(ReadCacheShard& shard);
+
+    // Record that a new pore has been seen, evicting the reads of the oldest pore for the client if
+    // there are now more than m_max_num_keys of them.
+    void add_working_channel_key(int32_t client_id, const UniquePoreIdentifierKey& key);
+
+    // Push any evicted reads that are no longer being evaluated.
+    // Must be called with the shard locked.
+    void clear_evicted_reads(ReadCacheShard& shard);
+
     std::vector<std::unique_ptr<std::thread>> m_workers;
     int m_num_worker_threads = 0;
     std::atomic<int> m_num_active_worker_threads = 0;
@@ -84,10 +114,12 @@ private:
 
     // Members for pair_generating method
 
-    std::mutex m_pairing_mtx;
+    std::array<ReadCacheShard, NUM_READ_CACHE_SHARDS> m_read_cache_shards;
 
-    // individual read caches per client, keyed by client_id
-    std::unordered_map<int32_t, ReadCache> m_read_caches;
+    // The order in which pores were first seen for each client, keyed by client_id. This is only
+    // touched when a new pore is seen, so it's guarded by its own lock rather than a shard's.
+    std::mutex m_working_channel_keys_mutex;
+    std::unordered_map<int32_t, std::deque<UniquePoreIdentifierKey>> m_working_channel_keys;
 
     /**
      * The maximum number of different channels (pores) to keep in memory concurrently. 
@@ -116,18 +148,12 @@ private:
                                                bool allow_rejection,
                                                int tid);
 
-    // Store the minimap2 buffers used for mapping. One buffer per thread.
-    std::vector<MmTbufPtr> m_tbufs;
-
-    // Track reads which need to be emptied from the cache but are still being
-    // evaluated for pairs by other threads.
-    std::unordered_map<const SimplexRead*, std::atomic<int>> m_reads_in_flight_ctr;
-    std::unordered_set<SimplexReadPtr> m_reads_to_clear;
+    // Overlap engines used for mapping, which reuse minimap2 state between pairs. One per thread.
+    std::vector<std::unique_ptr<utils::PairwiseOverlapper>> m_overlappers;
 
     // Stats tracking for pairing node.
     std::atomic<int> m_early_accepted_pairs{0};
     std::atomic<int> m_overlap_accepted_pairs{0};
-    std::atomic<size_t> m_cache_signal_bytes{0};
 };
 
 }  // namespace dorado
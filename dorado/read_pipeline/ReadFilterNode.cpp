@@ -2,39 +2,45 @@
 
 #include <spdlog/spdlog.h>
 
+#include <vector>
+
 namespace dorado {
 
 void ReadFilterNode::input_thread_fn() {
     at::InferenceMode inference_mode_guard;
 
-    Message message;
-    while (get_input_message(message)) {
-        // If this message isn't a read, just forward it to the sink.
-        if (!is_read_message(message)) {
-            send_message_to_sink(std::move(message));
-            continue;
-        }
+    std::vector<Message> messages;
+    std::vector<Message> messages_to_send;
+    while (get_input_messages(messages, kMaxInputBatchSize)) {
+        for (auto& message : messages) {
+            // If this message isn't a read, just forward it to the sink.
+            if (!is_read_message(message)) {
+                messages_to_send.push_back(std::move(message));
+                continue;
+            }
+
+            const auto& read_common = get_read_common_data(message);
 
-        const auto& read_common = get_read_common_data(message);
+            auto log_filtering = [&]() {
+                if (read_common.is_duplex) {
+                    ++m_num_duplex_reads_filtered;
+                    m_num_duplex_bases_filtered += read_common.seq.length();
+                } else {
+                    ++m_num_simplex_reads_filtered;
+                    m_num_simplex_bases_filtered += read_common.seq.length();
+                }
+            };
 
-        auto log_filtering = [&]() {
-            if (read_common.is_duplex) {
-                ++m_num_duplex_reads_filtered;
-                m_num_duplex_bases_filtered += read_common.seq.length();
+            // Filter based on qscore.
+            if ((read_common.calculate_mean_qscore() < m_min_qscore) ||
+                read_common.seq.size() < m_min_read_length ||
+                (m_read_ids_to_filter.find(read_common.read_id) != m_read_ids_to_filter.end())) {
+                log_filtering();
             } else {
-                ++m_num_simplex_reads_filtered;
-                m_num_simplex_bases_filtered += read_common.seq.length();
+                messages_to_send.push_back(std::move(message));
             }
-        };
-
-        // Filter based on qscore.
-        if ((read_common.calculate_mean_qscore() < m_min_qscore) ||
-            read_common.seq.size() < m_min_read_length ||
-            (m_read_ids_to_filter.find(read_common.read_id) != m_read_ids_to_filter.end())) {
-            log_filtering();
-        } else {
-            send_message_to_sink(std::move(message));
         }
+        send_messages_to_sink(std::move(messages_to_send));
     }
 }
 
@@ -42,7 +48,7 @@ ReadFilterNode::ReadFilterNode(size_t min_qscore,
                                size_t min_read_length,
                                std::unordered_set<std::string> read_ids_to_filter,
                                size_t num_worker_threads)
-        : MessageSink(1000, static_cast<int>(num_worker_threads)),
+        : MessageSink(1000, static_cast<int>(num_worker_threads), utils::AsyncQueueType::LockFree),
           m_min_qscore(min_qscore),
           m_min_read_length(min_read_length),
           m_read_ids_to_filter(std::move(read_ids_to_filter)),
@@ -1,8 +1,9 @@
 #include "ReadPipeline.h"
 
 #include "DefaultClientInfo.h"
-#include "modbase/ModBaseContext.h"
+#include "modbase/ModBaseTagEncoder.h"
 #include "stereo_features.h"
+#include "utils/BamRecordBuilder.h"
 #include "utils/bam_utils.h"
 #include "utils/sequence_utils.h"
 
@@ -18,7 +19,7 @@
 #include <stack>
 #include <stdexcept>
 #include <string_view>
-#include <unordered_map>
+#include <tuple>
 
 using namespace std::chrono_literals;
 
@@ -42,249 +43,125 @@ std::string ReadCommon::generate_read_group() const {
     return read_group;
 }
 
-void ReadCommon::generate_read_tags(bam1_t *aln, bool emit_moves, bool is_duplex_parent) const {
+void ReadCommon::generate_read_tags(utils::BamRecordBuilder &builder,
+                                    bool emit_moves,
+                                    bool is_duplex_parent) const {
     int qs = static_cast<int>(std::round(calculate_mean_qscore()));
-    bam_aux_append(aln, "qs", 'i', sizeof(qs), (uint8_t *)&qs);
+    builder.add_int("qs", qs);
 
     float du = (float)(get_raw_data_samples() + num_trimmed_samples) / (float)sample_rate;
-    bam_aux_append(aln, "du", 'f', sizeof(du), (uint8_t *)&du);
+    builder.add_float("du", du);
 
     int ns = int(get_raw_data_samples() + num_trimmed_samples);
-    bam_aux_append(aln, "ns", 'i', sizeof(ns), (uint8_t *)&ns);
+    builder.add_int("ns", ns);
 
     int ts = int(num_trimmed_samples);
-    bam_aux_append(aln, "ts", 'i', sizeof(ts), (uint8_t *)&ts);
+    builder.add_int("ts", ts);
 
     int mx = attributes.mux;
-    bam_aux_append(aln, "mx", 'i', sizeof(mx), (uint8_t *)&mx);
+    builder.add_int("mx", mx);
 
     int ch = attributes.channel_number;
-    bam_aux_append(aln, "ch", 'i', sizeof(ch), (uint8_t *)&ch);
+    builder.add_int("ch", ch);
 
-    bam_aux_append(aln, "st", 'Z', int(attributes.start_time.length() + 1),
-                   (uint8_t *)attributes.start_time.c_str());
+    builder.add_string("st", attributes.start_time);
 
     // For reads which are the result of read splitting, the read number will be set to -1
     int rn = attributes.read_number;
-    bam_aux_append(aln, "rn", 'i', sizeof(rn), (uint8_t *)&rn);
+    builder.add_int("rn", rn);
 
-    bam_aux_append(aln, "fn", 'Z', int(attributes.fast5_filename.length() + 1),
-                   (uint8_t *)attributes.fast5_filename.c_str());
+    builder.add_string("fn", attributes.fast5_filename);
 
-    float sm = shift;
-    bam_aux_append(aln, "sm", 'f', sizeof(sm), (uint8_t *)&sm);
+    builder.add_float("sm", shift);
+    builder.add_float("sd", scale);
 
-    float sd = scale;
-    bam_aux_append(aln, "sd", 'f', sizeof(sd), (uint8_t *)&sd);
-
-    bam_aux_append(aln, "sv", 'Z', int(scaling_method.size() + 1),
-                   (uint8_t *)scaling_method.c_str());
+    builder.add_string("sv", scaling_method);
 
     int32_t dx = (is_duplex_parent ? -1 : 0);
-    bam_aux_append(aln, "dx", 'i', sizeof(dx), (uint8_t *)&dx);
+    builder.add_int("dx", dx);
 
     auto rg = generate_read_group();
     if (!rg.empty()) {
-        bam_aux_append(aln, "RG", 'Z', int(rg.length() + 1), (uint8_t *)rg.c_str());
+        builder.add_string("RG", rg);
     }
 
     if (!parent_read_id.empty()) {
-        bam_aux_append(aln, "pi", 'Z', int(parent_read_id.size() + 1),
-                       (uint8_t *)parent_read_id.c_str());
+        builder.add_string("pi", parent_read_id);
         // For split reads, also store the start coordinate of the new read
         // in the original signal.
-        bam_aux_append(aln, "sp", 'i', sizeof(split_point), (uint8_t *)&split_point);
+        builder.add_int("sp", int32_t(split_point));
     }
 
     if (emit_moves) {
-        std::vector<uint8_t> m(moves.size() + 1, 0);
+        auto *m = builder.add_byte_array("mv", 'c', moves.size() + 1);
         m[0] = uint8_t(model_stride);
 
         for (size_t idx = 0; idx < moves.size(); idx++) {
             m[idx + 1] = static_cast<uint8_t>(moves[idx]);
         }
-
-        bam_aux_update_array(aln, "mv", 'c', int(m.size()), (uint8_t *)m.data());
     }
 
     if (rna_poly_tail_length >= 0) {
-        bam_aux_append(aln, "pt", 'i', sizeof(rna_poly_tail_length),
-                       (uint8_t *)&rna_poly_tail_length);
+        builder.add_int("pt", rna_poly_tail_length);
     }
 }
 
-void ReadCommon::generate_duplex_read_tags(bam1_t *aln) const {
+void ReadCommon::generate_duplex_read_tags(utils::BamRecordBuilder &builder) const {
     int qs = static_cast<int>(std::round(calculate_mean_qscore()));
-    bam_aux_append(aln, "qs", 'i', sizeof(qs), (uint8_t *)&qs);
-    uint32_t duplex = 1;
-    bam_aux_append(aln, "dx", 'i', sizeof(duplex), (uint8_t *)&duplex);
+    builder.add_int("qs", qs);
+    builder.add_int("dx", 1);
 
     int mx = attributes.mux;
-    bam_aux_append(aln, "mx", 'i', sizeof(mx), (uint8_t *)&mx);
+    builder.add_int("mx", mx);
 
     int ch = attributes.channel_number;
-    bam_aux_append(aln, "ch", 'i', sizeof(ch), (uint8_t *)&ch);
+    builder.add_int("ch", ch);
 
-    bam_aux_append(aln, "st", 'Z', int(attributes.start_time.length() + 1),
-                   (uint8_t *)attributes.start_time.c_str());
+    builder.add_string("st", attributes.start_time);
 
     auto rg = generate_read_group();
     if (!rg.empty()) {
-        bam_aux_append(aln, "RG", 'Z', int(rg.length() + 1), (uint8_t *)rg.c_str());
+        builder.add_string("RG", rg);
     }
 
     if (!parent_read_id.empty()) {
-        bam_aux_append(aln, "pi", 'Z', int(parent_read_id.size() + 1),
-                       (uint8_t *)parent_read_id.c_str());
+        builder.add_string("pi", parent_read_id);
     }
 }
 
-void ReadCommon::generate_modbase_tags(bam1_t *aln, uint8_t threshold) const {
+void ReadCommon::generate_modbase_tags(utils::BamRecordBuilder &builder,
+                                       uint8_t threshold) const {
     if (!mod_base_info) {
         return;
     }
 
     const size_t num_channels = mod_base_info->alphabet.size();
-    const std::string cardinal_bases = "ACGT";
-    char current_cardinal = 0;
     if (seq.length() * num_channels != base_mod_probs.size()) {
         throw std::runtime_error(
                 "Mismatch between base_mod_probs size and sequence length * num channels in "
                 "modbase_alphabet!");
     }
 
-    std::string modbase_string = "";
-    std::vector<uint8_t> modbase_prob;
-
-    // Create a mask indicating which bases are modified.
-    std::unordered_map<char, bool> base_has_context = {
-            {'A', false}, {'C', false}, {'G', false}, {'T', false}};
-    modbase::ModBaseContext context_handler;
-    if (!mod_base_info->context.empty()) {
-        if (!context_handler.decode(mod_base_info->context)) {
-            throw std::runtime_error("Invalid base modification context string.");
-        }
-        for (auto base : cardinal_bases) {
-            if (context_handler.motif(base).size() > 1) {
-                // If the context is just the single base, then this is equivalent to no context.
-                base_has_context[base] = true;
-            }
-        }
+    // Every read from a modbase model shares its info, so the decoded context and tag buffers
+    // are kept between reads, per thread as reads are written from several threads at once.
+    // Holding the info also stops its address being reused by a different info.
+    thread_local std::shared_ptr<const ModBaseInfo> t_tag_encoder_info;
+    thread_local std::unique_ptr<modbase::ModBaseTagEncoder> t_tag_encoder;
+    if (t_tag_encoder_info != mod_base_info) {
+        t_tag_encoder = std::make_unique<modbase::ModBaseTagEncoder>(*mod_base_info);
+        t_tag_encoder_info = mod_base_info;
     }
-    auto modbase_mask = context_handler.get_sequence_mask(seq);
-    context_handler.update_mask(modbase_mask, seq, mod_base_info->alphabet, base_mod_probs,
-                                threshold);
 
-    if (is_duplex) {
-        // If this is a duplex read, we need to compute the reverse complement mask and combine it
-        auto reverse_complemented_seq = utils::reverse_complement(seq);
-
-        // Compute the reverse complement mask
-        auto modbase_mask_rc = context_handler.get_sequence_mask(reverse_complemented_seq);
-
-        auto reverseMatrix = [](const std::vector<uint8_t> &matrix, int m_num_states) {
-            int numRows = static_cast<int>(matrix.size()) / static_cast<int>(m_num_states);
-            std::vector<uint8_t> reversedMatrix(matrix.size());
-
-            for (int i = 0; i < numRows; ++i) {
-                for (int j = 0; j < m_num_states; ++j) {
-                    reversedMatrix[i * m_num_states + j] =
-                            matrix[(numRows - 1 - i) * m_num_states + j];
-                }
-            }
-
-            return reversedMatrix;
-        };
-
-        int num_states = static_cast<int>(base_mod_probs.size()) / static_cast<int>(seq.size());
-        // Update the context mask using the reversed sequence
-        context_handler.update_mask(modbase_mask_rc, reverse_complemented_seq,
-                                    mod_base_info->alphabet,
-                                    reverseMatrix(base_mod_probs, num_states), threshold);
-
-        // Reverse the mask in-place
-        std::reverse(modbase_mask_rc.begin(), modbase_mask_rc.end());
-
-        // Combine the original and reverse complement masks
-        // Using std::transform for better readability and potential efficiency
-        std::transform(modbase_mask.begin(), modbase_mask.end(), modbase_mask_rc.begin(),
-                       modbase_mask.begin(), std::plus<>());
-    }
-
-    // Iterate over the provided alphabet and find all the channels we need to write out
-    for (size_t channel_idx = 0; channel_idx < num_channels; channel_idx++) {
-        if (cardinal_bases.find(mod_base_info->alphabet[channel_idx]) != std::string::npos) {
-            // A cardinal base
-            current_cardinal = mod_base_info->alphabet[channel_idx][0];
-        } else {
-            // A modification on the previous cardinal base
-            std::string bam_name = mod_base_info->alphabet[channel_idx];
-            if (!utils::validate_bam_tag_code(bam_name)) {
-                return;
-            }
-
-            // Write out the results we found
-            modbase_string += std::string(1, current_cardinal) + "+" + bam_name;
-            modbase_string += base_has_context[current_cardinal] ? "?" : ".";
-            int skipped_bases = 0;
-            for (size_t base_idx = 0; base_idx < seq.size(); base_idx++) {
-                if (seq[base_idx] == current_cardinal) {
-                    if (modbase_mask[base_idx]) {
-                        modbase_string += "," + std::to_string(skipped_bases);
-                        skipped_bases = 0;
-                        modbase_prob.push_back(
-                                base_mod_probs[base_idx * num_channels + channel_idx]);
-                    } else {
-                        // Skip this base
-                        skipped_bases++;
-                    }
-                }
-            }
-            modbase_string += ";";
-        }
-    }
-
-    if (is_duplex) {
-        // Having done the strand in the forward direction, if the read is duplex we need to also process its complement
-        // There is some code repetition here, but it makes it more readable.
-        for (size_t channel_idx = 0; channel_idx < num_channels; channel_idx++) {
-            if (cardinal_bases.find(mod_base_info->alphabet[channel_idx]) != std::string::npos) {
-                // A cardinal base
-                current_cardinal = mod_base_info->alphabet[channel_idx][0];
-            } else {
-                auto cardinal_complement = utils::complement_table[current_cardinal];
-                // A modification on the previous cardinal base
-                std::string bam_name = mod_base_info->alphabet[channel_idx];
-                if (!utils::validate_bam_tag_code(bam_name)) {
-                    return;
-                }
-
-                modbase_string += std::string(1, cardinal_complement) + "-" + bam_name;
-                modbase_string += base_has_context[current_cardinal] ? "?" : ".";
-                int skipped_bases = 0;
-                for (size_t base_idx = 0; base_idx < seq.size(); base_idx++) {
-                    if (seq[base_idx] == cardinal_complement) {  // complement
-                        if (modbase_mask[base_idx]) {            // Not sure this one is right
-                            modbase_string += "," + std::to_string(skipped_bases);
-                            skipped_bases = 0;
-                            modbase_prob.push_back(
-                                    base_mod_probs[base_idx * num_channels + channel_idx]);
-                        } else {
-                            // Skip this base
-                            skipped_bases++;
-                        }
-                    }
-                }
-                modbase_string += ";";
-            }
-        }
+    auto &encoder = *t_tag_encoder;
+    if (!encoder.encode(seq, base_mod_probs, is_duplex, threshold)) {
+        return;
     }
 
-    int seq_len = int(seq.length());
-    bam_aux_append(aln, "MN", 'i', sizeof(seq_len), (uint8_t *)&seq_len);
-    bam_aux_append(aln, "MM", 'Z', int(modbase_string.length() + 1),
-                   (uint8_t *)modbase_string.c_str());
-    bam_aux_update_array(aln, "ML", 'C', int(modbase_prob.size()), (uint8_t *)modbase_prob.data());
+    builder.add_int("MN", int(seq.length()));
+    builder.add_string("MM", encoder.mm());
+    const auto &modbase_prob = encoder.ml();
+    std::copy(modbase_prob.begin(), modbase_prob.end(),
+              builder.add_byte_array("ML", 'C', modbase_prob.size()));
 }
 
 float ReadCommon::calculate_mean_qscore() const {
@@ -320,37 +197,24 @@ std::vector<BamPtr> ReadCommon::extract_sam_lines(bool emit_moves,
         throw std::runtime_error("Empty sequence and qstring provided for read id " + read_id);
     }
 
-    std::vector<BamPtr> alns;
-
-    bam1_t *aln = bam_init1();
-    uint32_t flags = 4;              // 4 = UNMAPPED
-    std::string ref_seq = "*";       // UNMAPPED
-    int leftmost_pos = -1;           // UNMAPPED - will be written as 0
-    int map_q = 0;                   // UNMAPPED
-    std::string cigar_string = "*";  // UNMAPPED
-    std::string r_next = "*";
-    int next_pos = -1;  // UNMAPPED - will be written as 0
-
-    // Convert string qscore to phred vector.
-    std::vector<uint8_t> qscore;
-    std::transform(qstring.begin(), qstring.end(), std::back_inserter(qscore),
-                   [](char c) { return (uint8_t)(c)-33; });
-
-    bam_set1(aln, read_id.length(), read_id.c_str(), uint16_t(flags), -1, leftmost_pos,
-             uint8_t(map_q), 0, nullptr, -1, next_pos, 0, seq.length(), seq.c_str(),
-             (char *)qscore.data(), 0);
+    // The tags are staged per thread, so the record itself is the only allocation.
+    thread_local utils::BamRecordBuilder builder;
+    builder.clear();
 
     if (!barcode.empty() && barcode != "unclassified") {
-        bam_aux_append(aln, "BC", 'Z', int(barcode.length() + 1), (uint8_t *)barcode.c_str());
+        builder.add_string("BC", barcode);
     }
 
     if (is_duplex) {
-        generate_duplex_read_tags(aln);
+        generate_duplex_read_tags(builder);
     } else {
-        generate_read_tags(aln, emit_moves, is_duplex_parent);
+        generate_read_tags(builder, emit_moves, is_duplex_parent);
     }
-    generate_modbase_tags(aln, modbase_threshold);
-    alns.push_back(BamPtr(aln));
+    generate_modbase_tags(builder, modbase_threshold);
+
+    std::vector<BamPtr> alns;
+    alns.push_back(builder.build_unmapped(read_id, seq, qstring));
+    utils::set_pipeline_entry_time(alns.back().get(), pipeline_entry_time);
 
     return alns;
 }
@@ -461,7 +325,9 @@ Pipeline::Pipeline(PipelineDescriptor &&descriptor,
     for (auto &[desc_node, _] : descriptor.m_node_descriptors) {
         m_nodes.push_back(std::move(desc_node));
         if (stats_reporters) {
-            stats_reporters->push_back(stats::make_stats_reporter(*m_nodes.back()));
+            stats_reporters->push_back([&node = *m_nodes.back()]() {
+                return std::make_tuple(node.get_name(), node.sample_stats_with_timings());
+            });
         }
     }
 
@@ -480,6 +346,12 @@ void Pipeline::push_message(Message &&message) {
     dynamic_cast<MessageSink &>(*m_nodes.at(source_node_index)).push_message(std::move(message));
 }
 
+void Pipeline::push_messages(std::vector<Message> &&messages) {
+    assert(!m_nodes.empty());
+    const auto source_node_index = m_source_to_sink_order.front();
+    dynamic_cast<MessageSink &>(*m_nodes.at(source_node_index)).push_messages(std::move(messages));
+}
+
 stats::NamedStats Pipeline::terminate(const FlushOptions &flush_options) {
     stats::NamedStats final_stats;
     // Nodes must be terminated in source to sink order to ensure all in flight
@@ -488,7 +360,7 @@ stats::NamedStats Pipeline::terminate(const FlushOptions &flush_options) {
     for (auto handle : m_source_to_sink_order) {
         auto &node = m_nodes.at(handle);
         node->terminate(flush_options);
-        auto node_stats = node->sample_stats();
+        auto node_stats = node->sample_stats_with_timings();
         const auto node_name = node->get_name();
         for (const auto &[name, value] : node_stats) {
             final_stats[node_name + "." + name] = value;
@@ -84,6 +84,9 @@ public:
     // Routes the given message to the pipeline source node.
     void push_message(Message&& message);
 
+    // Routes the given batch of messages to the pipeline source node.
+    void push_messages(std::vector<Message>&& messages);
+
     // Stops all pipeline nodes in source to sink order.
     // Returns stats from nodes' final states.
     // After this is called the pipeline will do no further work processing subsequent inputs,
@@ -97,6 +100,9 @@ public:
     // Exists to accommodate situations where client code avoids using the pipeline framework.
     MessageSink& get_node_ref(NodeHandle node_handle) { return *m_nodes.at(node_handle); }
 
+    // Number of nodes in the pipeline.  Node handles run from 0 to num_nodes() - 1.
+    size_t num_nodes() const { return m_nodes.size(); }
+
 private:
     // Constructor is private to ensure instances of this class are created
     // through the create function.
@@ -5,42 +5,47 @@
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
+#include <vector>
 
 namespace dorado {
 
 void ReadToBamTypeNode::input_thread_fn() {
     at::InferenceMode inference_mode_guard;
 
-    Message message;
-    while (get_input_message(message)) {
-        // If this message isn't a read, just forward it to the sink.
-        if (!is_read_message(message)) {
-            send_message_to_sink(std::move(message));
-            continue;
-        }
+    std::vector<Message> messages;
+    std::vector<Message> messages_to_send;
+    while (get_input_messages(messages, kMaxInputBatchSize)) {
+        for (auto& message : messages) {
+            // If this message isn't a read, just forward it to the sink.
+            if (!is_read_message(message)) {
+                messages_to_send.push_back(std::move(message));
+                continue;
+            }
 
-        auto& read_common_data = get_read_common_data(message);
+            auto& read_common_data = get_read_common_data(message);
 
-        bool is_duplex_parent = false;
-        if (!read_common_data.is_duplex) {
-            is_duplex_parent = std::get<SimplexReadPtr>(message)->is_duplex_parent;
-        }
+            bool is_duplex_parent = false;
+            if (!read_common_data.is_duplex) {
+                is_duplex_parent = std::get<SimplexReadPtr>(message)->is_duplex_parent;
+            }
 
-        // alias barcode if present
-        if (m_sample_sheet && !read_common_data.barcode.empty()) {
-            auto alias = m_sample_sheet->get_alias(
-                    read_common_data.flowcell_id, read_common_data.position_id,
-                    read_common_data.experiment_id, read_common_data.barcode);
-            if (!alias.empty()) {
-                read_common_data.barcode = alias;
+            // alias barcode if present
+            if (m_sample_sheet && !read_common_data.barcode.empty()) {
+                auto alias = m_sample_sheet->get_alias(
+                        read_common_data.flowcell_id, read_common_data.position_id,
+                        read_common_data.experiment_id, read_common_data.barcode);
+                if (!alias.empty()) {
+                    read_common_data.barcode = alias;
+                }
             }
-        }
 
-        auto alns = read_common_data.extract_sam_lines(m_emit_moves, m_modbase_threshold,
-                                                       is_duplex_parent);
-        for (auto& aln : alns) {
-            send_message_to_sink(std::move(aln));
+            auto alns = read_common_data.extract_sam_lines(m_emit_moves, m_modbase_threshold,
+                                                           is_duplex_parent);
+            for (auto& aln : alns) {
+                messages_to_send.push_back(std::move(aln));
+            }
         }
+        send_messages_to_sink(std::move(messages_to_send));
     }
 }
 
@@ -49,7 +54,9 @@ ReadToBamTypeNode::ReadToBamTypeNode(bool emit_moves,
                                      float modbase_threshold_frac,
                                      std::unique_ptr<const utils::SampleSheet> sample_sheet,
                                      size_t max_reads)
-        : MessageSink(max_reads, static_cast<int>(num_worker_threads)),
+        : MessageSink(max_reads,
+                      static_cast<int>(num_worker_threads),
+                      utils::AsyncQueueType::LockFree),
           m_emit_moves(emit_moves),
           m_modbase_threshold(
                   static_cast<uint8_t>(std::min(modbase_threshold_frac * 256.0f, 255.0f))),
@@ -30,9 +30,8 @@ std::pair<float, float> med_mad(const at::Tensor& x) {
     //  (specifically the "Relation to standard deviation" section)
     constexpr float factor = 1.4826f;
     //Calculate signal median and median absolute deviation
-    auto med = x.median();
-    auto mad = at::median(at::abs(x - med)) * factor + EPS;
-    return {med.item<float>(), mad.item<float>()};
+    auto [med, mad] = dorado::utils::median_mad_counting(x);
+    return {static_cast<float>(med), static_cast<float>(mad) * factor + EPS};
 }
 
 std::pair<float, float> normalisation(const dorado::basecall::QuantileScalingParams& params,
@@ -191,9 +190,13 @@ void ScalerNode::input_thread_fn() {
                 shift = read->offset;
             }
 
-            read->read_common.raw_data =
-                    ((read->read_common.raw_data.to(at::kFloat) + shift) * scale)
-                            .to(at::ScalarType::Half);
+            // Shift and scale in float32 form while converting to float16, in a single pass.
+            const auto raw_data = read->read_common.raw_data.contiguous();
+            auto scaled_data = at::empty(raw_data.sizes(), raw_data.options().dtype(at::kHalf));
+            utils::convert_i16_to_f16_scaled(scaled_data.data_ptr<c10::Half>(),
+                                             raw_data.data_ptr<int16_t>(), raw_data.numel(), shift,
+                                             scale);
+            read->read_common.raw_data = std::move(scaled_data);
 
             read->read_common.scale = scale;
             read->read_common.shift = shift;
@@ -204,10 +207,13 @@ void ScalerNode::input_thread_fn() {
                             : med_mad(read->read_common.raw_data);
 
             // raw_data comes from DataLoader with dtype int16.  We send it on as float16 after
-            // shifting/scaling in float32 form.
-            read->read_common.raw_data =
-                    ((read->read_common.raw_data.to(at::kFloat) - shift) / scale)
-                            .to(at::ScalarType::Half);
+            // shifting/scaling in float32 form, in a single pass with no temporaries.
+            const auto raw_data = read->read_common.raw_data.contiguous();
+            auto scaled_data = at::empty(raw_data.sizes(), raw_data.options().dtype(at::kHalf));
+            utils::convert_i16_to_f16_normalised(scaled_data.data_ptr<c10::Half>(),
+                                                 raw_data.data_ptr<int16_t>(), raw_data.numel(),
+                                                 shift, scale);
+            read->read_common.raw_data = std::move(scaled_data);
             // move the shift and scale into pA.
             read->read_common.scale = read->scaling * scale;
             read->read_common.shift = read->scaling * (shift + read->offset);
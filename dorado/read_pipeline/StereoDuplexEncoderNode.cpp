@@ -6,6 +6,7 @@
 #include <ATen/ATen.h>
 #include <edlib.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstring>
@@ -76,6 +77,10 @@ DuplexReadPtr StereoDuplexEncoderNode::stereo_encode(const ReadPair& read_pair)
             template_read.read_common.attributes.channel_number;
     read->read_common.attributes.start_time = template_read.read_common.attributes.start_time;
     read->read_common.start_time_ms = template_read.read_common.start_time_ms;
+    // The duplex read can't be produced until both of its parents have been loaded.
+    read->read_common.pipeline_entry_time =
+            std::max(template_read.read_common.pipeline_entry_time,
+                     complement_read.read_common.pipeline_entry_time);
 
     read->read_common.read_tag = template_read.read_common.read_tag;
     read->read_common.client_info = template_read.read_common.client_info;
@@ -108,8 +113,8 @@ void StereoDuplexEncoderNode::input_thread_fn() {
     }
 }
 
-StereoDuplexEncoderNode::StereoDuplexEncoderNode(int input_signal_stride)
-        : MessageSink(1000, std::thread::hardware_concurrency()),
+StereoDuplexEncoderNode::StereoDuplexEncoderNode(int input_signal_stride, int num_worker_threads)
+        : MessageSink(1000, num_worker_threads),
           m_input_signal_stride(input_signal_stride) {
     start_input_processing(&StereoDuplexEncoderNode::input_thread_fn, this);
 }
@@ -10,7 +10,7 @@ namespace dorado {
 
 class StereoDuplexEncoderNode : public MessageSink {
 public:
-    StereoDuplexEncoderNode(int input_signal_stride);
+    StereoDuplexEncoderNode(int input_signal_stride, int num_worker_threads);
 
     DuplexReadPtr stereo_encode(const ReadPair& pair);
 
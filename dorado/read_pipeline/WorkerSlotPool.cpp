@@ -0,0 +1,178 @@
+#include "WorkerSlotPool.h"
+
+#include "ReadPipeline.h"
+#include "utils/thread_utils.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+namespace dorado {
+
+void NodeWorkerSlots::acquire() {
+    std::unique_lock lock(m_mutex);
+    m_cv.wait(lock, [this] { return m_num_active < m_num_slots; });
+    ++m_num_active;
+}
+
+void NodeWorkerSlots::release() {
+    {
+        std::lock_guard lock(m_mutex);
+        --m_num_active;
+    }
+    m_cv.notify_one();
+}
+
+void NodeWorkerSlots::set_num_slots(int num_slots) {
+    {
+        std::lock_guard lock(m_mutex);
+        m_num_slots = num_slots;
+    }
+    // Threads that were over the old limit may now be allowed to run.  If the limit went down,
+    // threads already active finish what they're doing before the new limit takes effect.
+    m_cv.notify_all();
+}
+
+int NodeWorkerSlots::num_slots() const {
+    std::lock_guard lock(m_mutex);
+    return m_num_slots;
+}
+
+WorkerSlotPool::WorkerSlotPool(int max_active_threads, std::chrono::milliseconds rebalance_period)
+        : m_max_active_threads(std::max(max_active_threads, 1)),
+          m_rebalance_period(rebalance_period),
+          m_controller_thread(&WorkerSlotPool::controller_thread_fn, this) {}
+
+WorkerSlotPool::~WorkerSlotPool() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_terminate = true;
+    }
+    m_cv.notify_one();
+    m_controller_thread.join();
+
+    // Let the nodes run unrestricted again.
+    for (auto& managed_node : m_nodes) {
+        managed_node.node->set_worker_slots(nullptr);
+    }
+}
+
+void WorkerSlotPool::add_node(MessageSink& node, int min_threads) {
+    const int num_threads = node.num_input_threads();
+    if (num_threads <= 0) {
+        spdlog::debug("WorkerSlotPool: {} has no input threads to manage", node.get_name());
+        return;
+    }
+    min_threads = std::clamp(min_threads, 1, num_threads);
+
+    auto slots = std::make_shared<NodeWorkerSlots>(num_threads);
+    {
+        std::lock_guard lock(m_mutex);
+        m_nodes.push_back({&node, slots, min_threads, num_threads > 1});
+    }
+    node.set_worker_slots(std::move(slots));
+    rebalance();
+}
+
+void WorkerSlotPool::add_nodes(Pipeline& pipeline,
+                               const std::unordered_set<std::string>& node_names,
+                               int min_threads) {
+    for (size_t i = 0; i < pipeline.num_nodes(); ++i) {
+        auto& node = pipeline.get_node_ref(NodeHandle(i));
+        if (node_names.count(node.get_name()) != 0) {
+            add_node(node, min_threads);
+        }
+    }
+}
+
+void WorkerSlotPool::rebalance() {
+    // Weight given to every node regardless of its queue, so that spare slots are shared out
+    // when all of the queues are empty.
+    constexpr double kBaseDemand = 0.01;
+    // Weight given to the latest occupancy sample in the smoothed value.
+    constexpr double kSmoothing = 0.5;
+    // Smoothed occupancy above which a node may be given more slots than it has threads.
+    constexpr double kAddThreadsOccupancy = 0.5;
+
+    std::lock_guard lock(m_mutex);
+    if (m_nodes.empty()) {
+        return;
+    }
+
+    std::vector<int> allocations;
+    std::vector<int> max_allocations;
+    allocations.reserve(m_nodes.size());
+    max_allocations.reserve(m_nodes.size());
+    int remaining_slots = m_max_active_threads;
+    for (auto& managed_node : m_nodes) {
+        managed_node.occupancy = kSmoothing * managed_node.node->input_queue_occupancy() +
+                                 (1.0 - kSmoothing) * managed_node.occupancy;
+        allocations.push_back(managed_node.min_threads);
+        remaining_slots -= managed_node.min_threads;
+        const int num_threads = managed_node.node->num_input_threads();
+        const bool starved = managed_node.can_add_threads &&
+                             managed_node.occupancy >= kAddThreadsOccupancy;
+        max_allocations.push_back(starved ? std::max(num_threads, m_max_active_threads)
+                                          : num_threads);
+    }
+
+    // Hand out the remaining slots one at a time, each to the node with the greatest demand per
+    // slot it already has.
+    while (remaining_slots > 0) {
+        int best_index = -1;
+        double best_demand = 0.0;
+        for (size_t i = 0; i < m_nodes.size(); ++i) {
+            if (allocations[i] >= max_allocations[i]) {
+                continue;
+            }
+            const double demand = (m_nodes[i].occupancy + kBaseDemand) / (allocations[i] + 1);
+            if (demand > best_demand) {
+                best_index = int(i);
+                best_demand = demand;
+            }
+        }
+        if (best_index < 0) {
+            // Every node has as many slots as it can use.
+            break;
+        }
+        ++allocations[best_index];
+        --remaining_slots;
+    }
+
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        auto& managed_node = m_nodes[i];
+        const int extra_threads = allocations[i] - managed_node.node->num_input_threads();
+        if (extra_threads > 0 && managed_node.node->add_input_threads(extra_threads)) {
+            spdlog::debug("WorkerSlotPool: added {} input threads to {}", extra_threads,
+                          managed_node.node->get_name());
+        }
+        managed_node.slots->set_num_slots(allocations[i]);
+    }
+    ++m_num_rebalances;
+}
+
+stats::NamedStats WorkerSlotPool::sample_stats() const {
+    stats::NamedStats stats;
+    stats["max_active_threads"] = double(m_max_active_threads);
+    stats["rebalances"] = double(m_num_rebalances.load());
+    std::lock_guard lock(m_mutex);
+    for (const auto& managed_node : m_nodes) {
+        const auto name = managed_node.node->get_name();
+        stats[name + "_slots"] = double(managed_node.slots->num_slots());
+        stats[name + "_threads"] = double(managed_node.node->num_input_threads());
+        stats[name + "_occupancy"] = managed_node.occupancy;
+    }
+    return stats;
+}
+
+void WorkerSlotPool::controller_thread_fn() {
+    utils::set_thread_name("worker_slots");
+    std::unique_lock lock(m_mutex);
+    while (!m_cv.wait_for(lock, m_rebalance_period, [this] { return m_terminate; })) {
+        lock.unlock();
+        rebalance();
+        lock.lock();
+    }
+}
+
+}  // namespace dorado
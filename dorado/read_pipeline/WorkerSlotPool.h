@@ -0,0 +1,90 @@
+#pragma once
+
+#include "utils/stats.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace dorado {
+
+class MessageSink;
+class Pipeline;
+
+// Limits how many of a node's input threads may process messages at once.
+class NodeWorkerSlots {
+public:
+    explicit NodeWorkerSlots(int num_slots) : m_num_slots(num_slots) {}
+
+    // Blocks until a slot is free, then takes it.
+    void acquire();
+    void release();
+
+    void set_num_slots(int num_slots);
+    int num_slots() const;
+
+private:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    int m_num_slots;
+    int m_num_active{0};
+};
+
+// Shares a fixed number of worker slots, i.e. threads that may be processing messages at once,
+// between a set of CPU bound pipeline nodes.  Each node is given its minimum number of slots,
+// then a controller thread periodically hands out the rest in proportion to how full each
+// node's input queue is, so that bottleneck nodes get more of the CPU.  A node is normally
+// given no more slots than it has input threads, but if its queue is backing up then the pool
+// starts more input threads for it, so that slots can move to wherever reads are waiting.  Only
+// nodes created with several input threads are grown, since the others may rely on there being
+// just one.
+class WorkerSlotPool {
+public:
+    WorkerSlotPool(int max_active_threads, std::chrono::milliseconds rebalance_period);
+    ~WorkerSlotPool();
+
+    // Puts the input threads of node under the pool's control.  node must outlive the pool.
+    void add_node(MessageSink& node, int min_threads);
+
+    // Adds those nodes in pipeline whose names are in node_names.
+    void add_nodes(Pipeline& pipeline,
+                   const std::unordered_set<std::string>& node_names,
+                   int min_threads);
+
+    // Redistributes slots according to current queue occupancy.  Called periodically by the
+    // controller thread.
+    void rebalance();
+
+    std::string get_name() const { return "WorkerSlotPool"; }
+    stats::NamedStats sample_stats() const;
+
+private:
+    struct ManagedNode {
+        MessageSink* node;
+        std::shared_ptr<NodeWorkerSlots> slots;
+        int min_threads;
+        bool can_add_threads;
+        // Smoothed input queue occupancy, so that slots don't swing around on momentary spikes.
+        double occupancy{0.0};
+    };
+
+    void controller_thread_fn();
+
+    const int m_max_active_threads;
+    const std::chrono::milliseconds m_rebalance_period;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_terminate{false};
+    std::vector<ManagedNode> m_nodes;
+    std::atomic<int64_t> m_num_rebalances{0};
+    std::thread m_controller_thread;
+};
+
+}  // namespace dorado
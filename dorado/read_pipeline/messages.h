@@ -6,6 +6,7 @@
 #include <ATen/core/TensorBody.h>
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <limits>
 #include <memory>
@@ -33,6 +34,10 @@ struct Attributes {
 
 class ClientInfo;
 
+namespace utils {
+class BamRecordBuilder;
+}
+
 class ReadCommon {
 public:
     ReadCommon();
@@ -56,6 +61,10 @@ public:
 
     uint64_t start_time_ms;
 
+    // When the read was created by the data loader, for tracking its latency through the
+    // pipeline.  Default constructed for reads from other sources.
+    std::chrono::steady_clock::time_point pipeline_entry_time{};
+
     std::shared_ptr<const AdapterInfo> adapter_info;
     std::shared_ptr<const BarcodingInfo> barcoding_info;
     std::shared_ptr<BarcodeScoreResult> barcoding_result;
@@ -126,9 +135,11 @@ public:
     float model_q_scale{0.0f};
 
 private:
-    void generate_duplex_read_tags(bam1_t*) const;
-    void generate_read_tags(bam1_t* aln, bool emit_moves, bool is_duplex_parent) const;
-    void generate_modbase_tags(bam1_t* aln, uint8_t threshold) const;
+    void generate_duplex_read_tags(utils::BamRecordBuilder& builder) const;
+    void generate_read_tags(utils::BamRecordBuilder& builder,
+                            bool emit_moves,
+                            bool is_duplex_parent) const;
+    void generate_modbase_tags(utils::BamRecordBuilder& builder, uint8_t threshold) const;
     std::string generate_read_group() const;
 };
 
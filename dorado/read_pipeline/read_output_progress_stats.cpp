@@ -19,17 +19,7 @@ std::string const PREFIX_PROGRESS_LINE{"[PROG_STAT] "};
 // to estimated total number of reads than assuming half.
 constexpr float ASSUMED_PERCENTAGE_THROUGH_INPUT_FILE{0.75};
 
-struct ReportInfo {
-    float time_elapsed;
-    float time_remaining;
-    std::size_t total_reads_processed;
-    std::size_t total_reads_estimate;
-    float interval_time_elapsed;
-    std::size_t interval_reads_processed;
-    std::size_t estimated_percentage;
-};
-
-void show_report(const ReportInfo& info) {
+void show_report(const ReadOutputProgressStats::ReportInfo& info) {
     std::ostringstream oss;
     // clang-format off
     oss << PREFIX_PROGRESS_LINE 
@@ -148,27 +138,31 @@ void ReadOutputProgressStats::report_final_stats() {
     join_report_thread();
 }
 
-std::pair<float, float> ReadOutputProgressStats::get_current_range() const {
+float ReadOutputProgressStats::get_post_processing_progress() const {
     if (m_stats_collection_mode == StatsCollectionMode::single_collector) {
-        return {0.0f, 1.0f};
+        return m_post_processing_progress;
     }
-    if (m_num_completed_files == m_num_input_files) {
-        return {1.0f, 1.0f};
+    float total_progress = 100.f * m_num_completed_files;
+    for (const auto& [file_index, progress] : m_post_processing_progress_per_file) {
+        total_progress += progress;
     }
-    float interval_per_file = 1.0f / m_num_input_files;
-    float from = m_num_completed_files * interval_per_file;
-    float to = std::min(from + interval_per_file, 1.0f);
-    return {from, to};
+    return total_progress / m_num_input_files;
 }
 
 void ReadOutputProgressStats::report_stats(progress_clock::time_point interval_end) const {
+    show_report(get_report_info(interval_end));
+}
+
+ReadOutputProgressStats::ReportInfo ReadOutputProgressStats::get_report_info(
+        progress_clock::time_point interval_end) const {
     using namespace std::chrono;
     using Seconds = duration<float>;
     ReportInfo info{};
     info.time_elapsed = duration_cast<Seconds>(interval_end - m_monitoring_start_time).count();
     info.interval_time_elapsed = duration_cast<Seconds>(interval_end - m_interval_start).count();
 
-    if (m_post_processing_stats) {
+    // Files still being aligned take precedence over those being post processed.
+    if (m_post_processing_stats && m_current_reads_written_count == 0) {
         info.interval_reads_processed = m_post_processing_stats->interval_reads_processed;
         info.total_reads_processed = m_post_processing_stats->total_reads_processed;
         info.total_reads_estimate = m_post_processing_stats->total_reads_estimate;
@@ -199,19 +193,22 @@ void ReadOutputProgressStats::report_stats(progress_clock::time_point interval_e
         float progress = std::min(100.f, 100.f * static_cast<float>(info.total_reads_processed) /
                                                  info.total_reads_estimate);
         progress = (1 - m_post_processing_percentage) * progress;
-        auto post_processing_progress = m_post_processing_percentage * m_post_processing_progress;
+        auto post_processing_progress =
+                m_post_processing_percentage * get_post_processing_progress();
         progress += post_processing_progress;
 
-        auto [from, to] = get_current_range();
-        progress = from * 100.0f + (to - from) * progress;
-
         info.estimated_percentage = static_cast<std::size_t>(progress);
     } else {
         info.time_remaining = 0.0;
         info.estimated_percentage = 0;
     }
 
-    show_report(info);
+    return info;
+}
+
+ReadOutputProgressStats::ReportInfo ReadOutputProgressStats::get_current_report() {
+    std::lock_guard lock(m_mutex);
+    return get_report_info(progress_clock::now());
 }
 
 void ReadOutputProgressStats::update_stats(const stats::NamedStats& stats) {
@@ -248,18 +245,24 @@ void ReadOutputProgressStats::notify_stats_collector_completed(const stats::Name
     }
 
     m_interval_previous_stat_collectors_total +=
-            stats_reads_written - m_interval_start_count + duplicates_read_ids_this_interval;
-    m_interval_start_count = 0;
+            stats_reads_written + duplicates_read_ids_this_interval;
 
-    m_current_reads_written_count = 0;
+    // In collector_per_input_file mode several files may be in flight at once, in which case
+    // the current count is the sum over all of them, so only this collector's reads are moved
+    // into the previous total.
+    m_current_reads_written_count -= std::min(m_current_reads_written_count, stats_reads_written);
 
     if (m_stats_collection_mode == StatsCollectionMode::collector_per_input_file) {
         // entering post processing so capture read stats
+        ++m_num_files_post_processing;
         m_post_processing_stats = StatsForPostProcessing{};  // make_optional not working with clang
         m_post_processing_stats->interval_reads_processed =
-                m_interval_previous_stat_collectors_total;
-        m_post_processing_stats->total_reads_processed = m_previous_stat_collectors_total;
-        m_post_processing_stats->total_reads_estimate = calc_total_reads_collector_per_file(0);
+                m_interval_previous_stat_collectors_total + m_current_reads_written_count -
+                m_interval_start_count;
+        m_post_processing_stats->total_reads_processed =
+                m_previous_stat_collectors_total + m_current_reads_written_count;
+        m_post_processing_stats->total_reads_estimate =
+                calc_total_reads_collector_per_file(m_current_reads_written_count);
     }
 }
 
@@ -339,15 +342,18 @@ void ReadOutputProgressStats::update_reads_per_file_estimate(std::size_t num_rea
                   m_estimated_num_reads_per_file);
 }
 
-void ReadOutputProgressStats::notify_post_processing_completed() {
+void ReadOutputProgressStats::notify_post_processing_completed(std::size_t file_index) {
     if (m_stats_collection_mode == StatsCollectionMode::single_collector) {
         return;
     }
     std::lock_guard lock(m_mutex);
     assert(m_num_completed_files < m_num_input_files);
     ++m_num_completed_files;
-    m_post_processing_stats = std::nullopt;
-    m_post_processing_progress = 0.0f;
+    m_post_processing_progress_per_file.erase(file_index);
+    // Keep reporting the post processing stats while other files are still being post processed.
+    if (m_num_files_post_processing > 0 && --m_num_files_post_processing == 0) {
+        m_post_processing_stats = std::nullopt;
+    }
 }
 
 bool ReadOutputProgressStats::is_known_total_number_input_reads() const {
@@ -368,4 +374,10 @@ void ReadOutputProgressStats::update_post_processing_progress(float progress) {
     m_post_processing_progress = progress;
 }
 
+void ReadOutputProgressStats::update_post_processing_progress(std::size_t file_index,
+                                                              float progress) {
+    std::lock_guard lock(m_mutex);
+    m_post_processing_progress_per_file[file_index] = progress;
+}
+
 }  // namespace dorado
@@ -4,6 +4,7 @@
 
 #include <chrono>
 #include <condition_variable>
+#include <map>
 #include <mutex>
 #include <optional>
 #include <thread>
@@ -17,6 +18,16 @@ public:
         collector_per_input_file,  // aligner creates a new pipeline for each input file
     };
 
+    struct ReportInfo {
+        float time_elapsed;
+        float time_remaining;
+        std::size_t total_reads_processed;
+        std::size_t total_reads_estimate;
+        float interval_time_elapsed;
+        std::size_t interval_reads_processed;
+        std::size_t estimated_percentage;
+    };
+
 private:
     using progress_clock = std::chrono::steady_clock;
     const std::chrono::seconds m_interval_duration;
@@ -42,10 +53,12 @@ private:
 
     std::size_t m_num_files_where_readcount_known{};
 
-    // incremented in after post processing is completed only relevant if
-    // StatsCollectionMode is collector_per_input_file.
-    // Used to identify the interval range for percentage complete of post processing
+    // Only relevant if StatsCollectionMode is collector_per_input_file, where several files
+    // may be post processed at once. Each file counts for an equal share of post processing,
+    // so that one file completing doesn't affect the progress of the others.
     std::size_t m_num_completed_files{};
+    std::size_t m_num_files_post_processing{};
+    std::map<std::size_t, float> m_post_processing_progress_per_file{};
 
     std::size_t m_total_known_readcount{};
     float m_estimated_num_reads_per_file{};
@@ -58,11 +71,12 @@ private:
     std::thread m_reporting_thread{};
 
     void report_stats(progress_clock::time_point interval_end) const;
+    ReportInfo get_report_info(progress_clock::time_point interval_end) const;
 
     std::size_t calc_total_reads_single_collector(std::size_t current_reads_count) const;
     std::size_t calc_total_reads_collector_per_file(std::size_t current_reads_count) const;
     std::size_t get_adjusted_estimated_total_reads(std::size_t current_reads_count) const;
-    std::pair<float, float> get_current_range() const;
+    float get_post_processing_progress() const;
 
     bool is_known_total_number_input_reads() const;
     bool is_disabled() const;
@@ -77,17 +91,21 @@ public:
 
     void start();
 
+    // In collector_per_input_file mode, if several collectors are in flight at once the stats
+    // should hold the combined number of reads written by all of them.
     void update_stats(const stats::NamedStats& stats);
 
     // Called to indicate the current stats collection has completed.
     // There may be new stats but their counters will be reset to zero.
     // E.g. happens in `dorado aligner` when reading from multiple input files
     // a new pipeline and HtsWriter is created for each input file
+    // If other collectors are still in flight, their reads remain in the current count.
     void notify_stats_collector_completed(const stats::NamedStats& stats);
 
     // Useful for collector_per_input_file mode (aligner), so that further
     // report outputs will be based on read stats instead of post processing
-    void notify_post_processing_completed();
+    // Other input files may still be post processed.
+    void notify_post_processing_completed(std::size_t file_index);
 
     void update_reads_per_file_estimate(std::size_t num_reads_in_file);
 
@@ -95,6 +113,12 @@ public:
 
     void update_post_processing_progress(float progress);
 
+    // For collector_per_input_file mode, where several files may be post processed at once.
+    void update_post_processing_progress(std::size_t file_index, float progress);
+
+    // The figures that would be reported if the interval ended now.
+    ReportInfo get_current_report();
+
     void report_final_stats();
 };
 
@@ -54,6 +54,7 @@ SimplexReadPtr shallow_copy_read(const SimplexRead& read) {
     copy->read_common.is_duplex = read.read_common.is_duplex;
 
     copy->read_common.read_tag = read.read_common.read_tag;
+    copy->read_common.pipeline_entry_time = read.read_common.pipeline_entry_time;
     copy->read_common.client_info = read.read_common.client_info;
     copy->read_common.barcoding_info = read.read_common.barcoding_info;
     copy->read_common.adapter_info = read.read_common.adapter_info;
@@ -5,6 +5,19 @@
 
 #include <algorithm>
 #include <cassert>
+#include <numeric>
+
+namespace {
+
+// The range of a chunk's calls that make it into the stitched read.
+struct TrimmedChunk {
+    int seq_start;
+    int seq_end;
+    int moves_start;
+    int moves_end;
+};
+
+}  // namespace
 
 namespace dorado::utils {
 
@@ -14,12 +27,13 @@ void stitch_chunks(ReadCommon& read_common,
                                               called_chunks[0]->moves.size())) ==
            read_common.model_stride);
 
+    // Work out which part of each chunk to keep before copying anything, so that the outputs can
+    // be allocated once at their final size.
+    std::vector<TrimmedChunk> trimmed_chunks;
+    trimmed_chunks.reserve(called_chunks.size());
+
     int start_pos = 0;
     int mid_point_front = 0;
-    std::vector<uint8_t> moves;
-    std::vector<std::string> sequences;
-    std::vector<std::string> qstrings;
-
     for (int i = 0; i < int(called_chunks.size() - 1); i++) {
         auto& current_chunk = called_chunks[i];
         auto& next_chunk = called_chunks[i + 1];
@@ -35,11 +49,8 @@ void stitch_chunks(ReadCommon& read_common,
 
         int current_chunk_seq_len = int(current_chunk->seq.size());
         int end_pos = current_chunk_seq_len - current_chunk_bases_to_trim;
-        int trimmed_len = end_pos - start_pos;
-        sequences.push_back(current_chunk->seq.substr(start_pos, trimmed_len));
-        qstrings.push_back(current_chunk->qstring.substr(start_pos, trimmed_len));
-        moves.insert(moves.end(), std::next(current_chunk->moves.begin(), mid_point_front),
-                     std::prev(current_chunk->moves.end(), mid_point_rear));
+        trimmed_chunks.push_back({start_pos, std::max(start_pos, end_pos), mid_point_front,
+                                  int(current_chunk->moves.size()) - mid_point_rear});
 
         mid_point_front = overlap_down_sampled - mid_point_rear;
 
@@ -51,27 +62,45 @@ void stitch_chunks(ReadCommon& read_common,
 
     // Append the final chunk
     auto& last_chunk = called_chunks.back();
-    moves.insert(moves.end(), std::next(last_chunk->moves.begin(), mid_point_front),
-                 last_chunk->moves.end());
-
     if (called_chunks.size() == 1) {
         // shorten the sequence, qstring & moves where the read is shorter than chunksize
         int last_index_in_moves_to_keep =
                 int(read_common.get_raw_data_samples() / read_common.model_stride);
-        moves = std::vector<uint8_t>(moves.begin(), moves.begin() + last_index_in_moves_to_keep);
-        int end = std::accumulate(moves.begin(), moves.end(), 0);
-        sequences.push_back(last_chunk->seq.substr(start_pos, end));
-        qstrings.push_back(last_chunk->qstring.substr(start_pos, end));
-
+        int end = std::accumulate(last_chunk->moves.begin(),
+                                  last_chunk->moves.begin() + last_index_in_moves_to_keep, 0);
+        trimmed_chunks.push_back({start_pos, std::min(start_pos + end, int(last_chunk->seq.size())),
+                                  mid_point_front, last_index_in_moves_to_keep});
     } else {
-        sequences.push_back(last_chunk->seq.substr(start_pos));
-        qstrings.push_back(last_chunk->qstring.substr(start_pos));
+        trimmed_chunks.push_back({start_pos, int(last_chunk->seq.size()), mid_point_front,
+                                  int(last_chunk->moves.size())});
     }
 
-    // Set the read seq and qstring
-    read_common.seq = std::accumulate(sequences.begin(), sequences.end(), std::string(""));
-    read_common.qstring = std::accumulate(qstrings.begin(), qstrings.end(), std::string(""));
-    read_common.moves = std::move(moves);
+    size_t seq_len = 0;
+    size_t moves_len = 0;
+    for (const auto& trimmed_chunk : trimmed_chunks) {
+        seq_len += trimmed_chunk.seq_end - trimmed_chunk.seq_start;
+        moves_len += trimmed_chunk.moves_end - trimmed_chunk.moves_start;
+    }
+
+    // Set the read seq, qstring and moves
+    auto& seq = read_common.seq;
+    auto& qstring = read_common.qstring;
+    auto& moves = read_common.moves;
+    seq.clear();
+    qstring.clear();
+    moves.clear();
+    seq.reserve(seq_len);
+    qstring.reserve(seq_len);
+    moves.reserve(moves_len);
+    for (size_t i = 0; i < called_chunks.size(); ++i) {
+        const auto& chunk = *called_chunks[i];
+        const auto& trimmed_chunk = trimmed_chunks[i];
+        const size_t trimmed_len = trimmed_chunk.seq_end - trimmed_chunk.seq_start;
+        seq.append(chunk.seq, trimmed_chunk.seq_start, trimmed_len);
+        qstring.append(chunk.qstring, trimmed_chunk.seq_start, trimmed_len);
+        moves.insert(moves.end(), std::next(chunk.moves.begin(), trimmed_chunk.moves_start),
+                     std::next(chunk.moves.begin(), trimmed_chunk.moves_end));
+    }
 
     // remove partial stride overhang
     if (static_cast<int>(read_common.moves.size()) >
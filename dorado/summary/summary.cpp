@@ -1,15 +1,29 @@
 #include "summary.h"
 
 #include "read_pipeline/HtsReader.h"
+#include "utils/AsyncQueue.h"
 #include "utils/bam_utils.h"
 #include "utils/log_utils.h"
 #include "utils/time_utils.h"
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <charconv>
+#include <chrono>
 #include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
 #include <filesystem>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <type_traits>
 
 namespace {
 
@@ -33,6 +47,266 @@ public:
 
 volatile sig_atomic_t SigIntHandler::interrupt{};
 
+constexpr uint16_t tag_code(char a, char b) { return uint16_t((uint8_t(a) << 8) | uint8_t(b)); }
+
+// The tags used for a row of the summary, found in a single pass over the aux data.  As with
+// bam_aux_get, only the first of any repeated tag is used.
+struct SummaryTags {
+    std::string_view read_group;
+    std::string_view f5_filename;
+    std::string_view filename;
+    std::string_view start_time;
+    std::string_view barcode;
+    int channel{0};
+    int mux{0};
+    int mean_qscore{0};
+    int num_samples{0};
+    int trim_samples{0};
+    int bed_hits{0};
+    float duration{0};
+
+    explicit SummaryTags(bam1_t* record) {
+        uint32_t seen = 0;
+        auto first = [&seen](int field) {
+            const bool is_first = !(seen & (1u << field));
+            seen |= 1u << field;
+            return is_first;
+        };
+        auto as_string = [](const uint8_t* aux) {
+            const char* value = bam_aux2Z(aux);
+            return value ? std::string_view(value) : std::string_view();
+        };
+
+        for (uint8_t* aux = bam_aux_first(record); aux; aux = bam_aux_next(record, aux)) {
+            const char* tag = bam_aux_tag(aux);
+            switch (tag_code(tag[0], tag[1])) {
+            case tag_code('R', 'G'):
+                if (first(0)) {
+                    read_group = as_string(aux);
+                }
+                break;
+            case tag_code('f', '5'):
+                if (first(1)) {
+                    f5_filename = as_string(aux);
+                }
+                break;
+            case tag_code('f', 'n'):
+                if (first(2)) {
+                    filename = as_string(aux);
+                }
+                break;
+            case tag_code('s', 't'):
+                if (first(3)) {
+                    start_time = as_string(aux);
+                }
+                break;
+            case tag_code('B', 'C'):
+                if (first(4)) {
+                    barcode = as_string(aux);
+                }
+                break;
+            case tag_code('c', 'h'):
+                if (first(5)) {
+                    channel = int(bam_aux2i(aux));
+                }
+                break;
+            case tag_code('m', 'x'):
+                if (first(6)) {
+                    mux = int(bam_aux2i(aux));
+                }
+                break;
+            case tag_code('q', 's'):
+                if (first(7)) {
+                    mean_qscore = int(bam_aux2i(aux));
+                }
+                break;
+            case tag_code('n', 's'):
+                if (first(8)) {
+                    num_samples = int(bam_aux2i(aux));
+                }
+                break;
+            case tag_code('t', 's'):
+                if (first(9)) {
+                    trim_samples = int(bam_aux2i(aux));
+                }
+                break;
+            case tag_code('b', 'h'):
+                if (first(10)) {
+                    bed_hits = int(bam_aux2i(aux));
+                }
+                break;
+            case tag_code('d', 'u'):
+                if (first(11)) {
+                    duration = float(bam_aux2f(aux));
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+};
+
+// Appends separated fields to a row, formatting numbers as std::ostream does by default.
+class RowWriter {
+public:
+    RowWriter(std::string& row, char separator) : m_row(row), m_separator(separator) {}
+
+    void end_row() { m_row += '\n'; }
+
+    RowWriter& operator<<(std::string_view value) {
+        separate();
+        m_row.append(value);
+        return *this;
+    }
+
+    template <typename T, std::enable_if_t<std::is_integral_v<T>, bool> = true>
+    RowWriter& operator<<(T value) {
+        separate();
+        char buffer[24];
+        const auto result = std::to_chars(std::begin(buffer), std::end(buffer), value);
+        m_row.append(buffer, result.ptr);
+        return *this;
+    }
+
+    template <typename T, std::enable_if_t<std::is_floating_point_v<T>, bool> = true>
+    RowWriter& operator<<(T value) {
+        separate();
+        char buffer[32];
+        const int length = std::snprintf(buffer, sizeof(buffer), "%g", double(value));
+        m_row.append(buffer, size_t(length));
+        return *this;
+    }
+
+private:
+    void separate() {
+        if (m_first) {
+            m_first = false;
+        } else {
+            m_row += m_separator;
+        }
+    }
+
+    std::string& m_row;
+    const char m_separator;
+    bool m_first{true};
+};
+
+using ExperimentStartTimes = std::map<std::string, std::chrono::microseconds, std::less<>>;
+
+// Appends the summary row for a primary record to rows.
+void format_row(bam1_t* record,
+                const dorado::HtsReader& reader,
+                dorado::SummaryData::FieldFlags field_flags,
+                char separator,
+                const ExperimentStartTimes& exp_start_times,
+                std::string& rows) {
+    using dorado::SummaryData;
+    const SummaryTags tags(record);
+
+    std::string_view run_id = "unknown";
+    if (!tags.read_group.empty()) {
+        run_id = tags.read_group.substr(0, tags.read_group.find('_'));
+    }
+
+    auto filename = tags.f5_filename.empty() ? tags.filename : tags.f5_filename;
+    auto read_id = bam_get_qname(record);
+    auto seqlen = record->core.l_qseq;
+    auto duration = tags.duration;
+    auto barcode = tags.barcode.empty() ? std::string_view("unclassified") : tags.barcode;
+
+    float sample_rate = tags.num_samples / duration;
+    float template_duration = (tags.num_samples - tags.trim_samples) / sample_rate;
+    auto start_time = 0.0;
+    auto exp_start_time_iter = exp_start_times.find(tags.read_group);
+    if (exp_start_time_iter != exp_start_times.end()) {
+        const auto read_start_time = dorado::utils::parse_time_stamp(tags.start_time);
+        start_time = std::chrono::duration<double>(read_start_time - exp_start_time_iter->second)
+                             .count();
+    }
+    auto template_start_time = start_time + (duration - template_duration);
+
+    RowWriter writer(rows, separator);
+    writer << filename << read_id;
+
+    if (field_flags & SummaryData::GENERAL_FIELDS) {
+        writer << run_id << tags.channel << tags.mux << start_time << duration
+               << template_start_time << template_duration << seqlen << tags.mean_qscore;
+    }
+
+    if (field_flags & SummaryData::BARCODING_FIELDS) {
+        writer << barcode;
+    }
+
+    if (field_flags & SummaryData::ALIGNMENT_FIELDS) {
+        std::string_view alignment_genome = "*";
+        int32_t alignment_genome_start = -1;
+        int32_t alignment_genome_end = -1;
+        int32_t alignment_strand_start = -1;
+        int32_t alignment_strand_end = -1;
+        std::string_view alignment_direction = "*";
+        int32_t alignment_length = 0;
+        int32_t alignment_mapq = 0;
+        int alignment_num_aligned = 0;
+        int alignment_num_correct = 0;
+        int alignment_num_insertions = 0;
+        int alignment_num_deletions = 0;
+        int alignment_num_substitutions = 0;
+        float strand_coverage = 0.0;
+        float alignment_identity = 0.0;
+        float alignment_accurary = 0.0;
+        int alignment_bed_hits = 0;
+
+        if (reader.is_aligned && !(record->core.flag & BAM_FUNMAP)) {
+            alignment_mapq = static_cast<int>(record->core.qual);
+            alignment_genome = reader.header->target_name[record->core.tid];
+
+            alignment_genome_start = int32_t(record->core.pos);
+            alignment_genome_end = int32_t(bam_endpos(record));
+            alignment_direction = bam_is_rev(record) ? "-" : "+";
+
+            auto alignment_counts = dorado::utils::get_alignment_op_counts(record);
+            alignment_num_aligned = int(alignment_counts.matches);
+            alignment_num_correct = int(alignment_counts.matches - alignment_counts.substitutions);
+            alignment_num_insertions = int(alignment_counts.insertions);
+            alignment_num_deletions = int(alignment_counts.deletions);
+            alignment_num_substitutions = int(alignment_counts.substitutions);
+            alignment_length = int(alignment_counts.matches + alignment_counts.insertions +
+                                   alignment_counts.deletions);
+            alignment_strand_start = int(alignment_counts.softclip_start);
+            alignment_strand_end = int(seqlen - alignment_counts.softclip_end);
+
+            strand_coverage =
+                    (alignment_strand_end - alignment_strand_start) / static_cast<float>(seqlen);
+            alignment_identity =
+                    alignment_num_correct / static_cast<float>(alignment_counts.matches);
+            alignment_accurary = alignment_num_correct / static_cast<float>(alignment_length);
+            alignment_bed_hits = tags.bed_hits;
+        }
+
+        writer << alignment_genome << alignment_genome_start << alignment_genome_end
+               << alignment_strand_start << alignment_strand_end << alignment_direction
+               << alignment_length << alignment_num_aligned << alignment_num_correct
+               << alignment_num_insertions << alignment_num_deletions
+               << alignment_num_substitutions << alignment_mapq << strand_coverage
+               << alignment_identity << alignment_accurary << alignment_bed_hits;
+    }
+    writer.end_row();
+}
+
+// Records are handed to the formatting threads in batches of this size.
+constexpr size_t RECORD_BATCH_SIZE = 1000;
+
+struct RecordBatch {
+    std::vector<dorado::BamPtr> records;
+    size_t size{0};
+};
+
+struct FormatTask {
+    std::unique_ptr<RecordBatch> batch;
+    std::promise<std::string> rows;
+};
+
 }  // anonymous namespace
 
 namespace dorado {
@@ -65,6 +339,8 @@ SummaryData::SummaryData(FieldFlags flags) { set_fields(flags); }
 
 void SummaryData::set_separator(char s) { m_separator = s; }
 
+void SummaryData::set_threads(int threads) { m_threads = threads; }
+
 void SummaryData::set_fields(FieldFlags flags) {
     if (flags == 0 || flags > (GENERAL_FIELDS | BARCODING_FIELDS | ALIGNMENT_FIELDS)) {
         throw std::runtime_error(
@@ -141,125 +417,113 @@ bool SummaryData::write_rows_from_reader(
         HtsReader& reader,
         std::ostream& writer,
         const std::map<std::string, std::string>& read_group_exp_start_time) {
-    while (reader.read() && !SigIntHandler::interrupt) {
-        if (reader.record->core.flag & (BAM_FSECONDARY | BAM_FSUPPLEMENTARY)) {
-            continue;
-        }
-
-        std::string run_id = "unknown";
-        std::string model = "unknown";
-
-        auto rg_value = reader.get_tag<std::string>("RG");
-        if (rg_value.length() > 0) {
-            auto rg_split = rg_value.find("_");
-            run_id = rg_value.substr(0, rg_split);
-            model = rg_value.substr(rg_split + 1, rg_value.length());
-        }
-
-        auto filename = reader.get_tag<std::string>("f5");
-        if (filename.empty()) {
-            filename = reader.get_tag<std::string>("fn");
-        }
-        auto read_id = bam_get_qname(reader.record);
-        auto channel = reader.get_tag<int>("ch");
-        auto mux = reader.get_tag<int>("mx");
-
-        auto start_time_dt = reader.get_tag<std::string>("st");
-        auto duration = reader.get_tag<float>("du");
-
-        auto seqlen = reader.record->core.l_qseq;
-        auto mean_qscore = reader.get_tag<int>("qs");
-
-        auto num_samples = reader.get_tag<int>("ns");
-        auto trim_samples = reader.get_tag<int>("ts");
-
-        auto barcode = reader.get_tag<std::string>("BC");
-        if (barcode.empty()) {
-            barcode = "unclassified";
-        }
+    ExperimentStartTimes exp_start_times;
+    for (const auto& [read_group, exp_start_dt] : read_group_exp_start_time) {
+        exp_start_times.emplace(read_group, utils::parse_time_stamp(exp_start_dt));
+    }
 
-        float sample_rate = num_samples / duration;
-        float template_duration = (num_samples - trim_samples) / sample_rate;
-        auto start_time = 0.0;
-        auto exp_start_time_iter = read_group_exp_start_time.find(rg_value);
-        if (exp_start_time_iter != read_group_exp_start_time.end()) {
-            auto exp_start_dt = exp_start_time_iter->second;
-            start_time = utils::time_difference_seconds(start_time_dt, exp_start_dt);
-        }
-        auto template_start_time = start_time + (duration - template_duration);
+    // Split the threads between decompressing the file and formatting the rows.
+    const int num_threads =
+            m_threads > 0 ? m_threads : std::max(int(std::thread::hardware_concurrency()), 1);
+    const int num_decompression_threads = num_threads / 2;
+    const int num_format_threads = std::max(num_threads - num_decompression_threads, 1);
+    if (num_decompression_threads > 0) {
+        reader.set_decompression_threads(num_decompression_threads);
+    }
 
-        writer << filename << m_separator << read_id;
+    // Batches are recycled once formatted, so the records read into them are reused, and their
+    // rows are written in the order they were read.
+    const size_t max_batches = 2 * size_t(num_format_threads) + 2;
+    utils::AsyncQueue<std::unique_ptr<RecordBatch>> free_batches(max_batches);
+    for (size_t i = 0; i < max_batches; ++i) {
+        free_batches.try_push(std::make_unique<RecordBatch>());
+    }
+    utils::AsyncQueue<FormatTask> format_tasks(max_batches);
+    utils::AsyncQueue<std::future<std::string>> formatted_rows(max_batches);
+
+    std::vector<std::thread> format_threads;
+    for (int i = 0; i < num_format_threads; ++i) {
+        format_threads.emplace_back([&] {
+            FormatTask task;
+            while (format_tasks.try_pop(task) == utils::AsyncQueueStatus::Success) {
+                try {
+                    std::string rows;
+                    for (size_t j = 0; j < task.batch->size; ++j) {
+                        format_row(task.batch->records[j].get(), reader, m_field_flags,
+                                   m_separator, exp_start_times, rows);
+                    }
+                    task.rows.set_value(std::move(rows));
+                } catch (...) {
+                    task.rows.set_exception(std::current_exception());
+                }
+                free_batches.try_push(std::move(task.batch));
+            }
+        });
+    }
 
-        if (m_field_flags & GENERAL_FIELDS) {
-            writer << m_separator << run_id << m_separator << channel << m_separator << mux
-                   << m_separator << start_time << m_separator << duration << m_separator
-                   << template_start_time << m_separator << template_duration << m_separator
-                   << seqlen << m_separator << mean_qscore;
+    std::exception_ptr error;
+    std::atomic<bool> failed{false};
+    std::thread writer_thread([&] {
+        std::future<std::string> rows;
+        while (formatted_rows.try_pop(rows) == utils::AsyncQueueStatus::Success) {
+            try {
+                const auto text = rows.get();
+                if (!failed) {
+                    writer.write(text.data(), text.size());
+                }
+            } catch (...) {
+                // Keep draining the queue so that the reader isn't left blocked on it.
+                if (!failed.exchange(true)) {
+                    error = std::current_exception();
+                }
+            }
         }
+    });
+
+    std::exception_ptr read_error;
+    try {
+        bool reading = true;
+        while (reading && !failed) {
+            std::unique_ptr<RecordBatch> batch;
+            free_batches.try_pop(batch);
+            batch->size = 0;
+            while (batch->size < RECORD_BATCH_SIZE) {
+                if (!reader.read() || SigIntHandler::interrupt) {
+                    reading = false;
+                    break;
+                }
+                if (reader.record->core.flag & (BAM_FSECONDARY | BAM_FSUPPLEMENTARY)) {
+                    continue;
+                }
+                if (batch->size == batch->records.size()) {
+                    batch->records.emplace_back(bam_init1());
+                }
+                std::swap(batch->records[batch->size++], reader.record);
+            }
+            if (batch->size == 0) {
+                break;
+            }
 
-        if (m_field_flags & BARCODING_FIELDS) {
-            writer << m_separator << barcode;
+            FormatTask task{std::move(batch), {}};
+            formatted_rows.try_push(task.rows.get_future());
+            format_tasks.try_push(std::move(task));
         }
+    } catch (...) {
+        read_error = std::current_exception();
+    }
 
-        if (m_field_flags & ALIGNMENT_FIELDS) {
-            std::string alignment_genome = "*";
-            int32_t alignment_genome_start = -1;
-            int32_t alignment_genome_end = -1;
-            int32_t alignment_strand_start = -1;
-            int32_t alignment_strand_end = -1;
-            std::string alignment_direction = "*";
-            int32_t alignment_length = 0;
-            int32_t alignment_mapq = 0;
-            int alignment_num_aligned = 0;
-            int alignment_num_correct = 0;
-            int alignment_num_insertions = 0;
-            int alignment_num_deletions = 0;
-            int alignment_num_substitutions = 0;
-            float strand_coverage = 0.0;
-            float alignment_identity = 0.0;
-            float alignment_accurary = 0.0;
-            int alignment_bed_hits = 0;
-
-            if (reader.is_aligned && !(reader.record->core.flag & BAM_FUNMAP)) {
-                alignment_mapq = static_cast<int>(reader.record->core.qual);
-                alignment_genome = reader.header->target_name[reader.record->core.tid];
-
-                alignment_genome_start = int32_t(reader.record->core.pos);
-                alignment_genome_end = int32_t(bam_endpos(reader.record.get()));
-                alignment_direction = bam_is_rev(reader.record) ? "-" : "+";
-
-                auto alignment_counts = utils::get_alignment_op_counts(reader.record.get());
-                alignment_num_aligned = int(alignment_counts.matches);
-                alignment_num_correct =
-                        int(alignment_counts.matches - alignment_counts.substitutions);
-                alignment_num_insertions = int(alignment_counts.insertions);
-                alignment_num_deletions = int(alignment_counts.deletions);
-                alignment_num_substitutions = int(alignment_counts.substitutions);
-                alignment_length = int(alignment_counts.matches + alignment_counts.insertions +
-                                       alignment_counts.deletions);
-                alignment_strand_start = int(alignment_counts.softclip_start);
-                alignment_strand_end = int(seqlen - alignment_counts.softclip_end);
-
-                strand_coverage = (alignment_strand_end - alignment_strand_start) /
-                                  static_cast<float>(seqlen);
-                alignment_identity =
-                        alignment_num_correct / static_cast<float>(alignment_counts.matches);
-                alignment_accurary = alignment_num_correct / static_cast<float>(alignment_length);
-                alignment_bed_hits = reader.get_tag<int>("bh");
-            }
+    format_tasks.terminate();
+    for (auto& format_thread : format_threads) {
+        format_thread.join();
+    }
+    formatted_rows.terminate();
+    writer_thread.join();
 
-            writer << m_separator << alignment_genome << m_separator << alignment_genome_start
-                   << m_separator << alignment_genome_end << m_separator << alignment_strand_start
-                   << m_separator << alignment_strand_end << m_separator << alignment_direction
-                   << m_separator << alignment_length << m_separator << alignment_num_aligned
-                   << m_separator << alignment_num_correct << m_separator
-                   << alignment_num_insertions << m_separator << alignment_num_deletions
-                   << m_separator << alignment_num_substitutions << m_separator << alignment_mapq
-                   << m_separator << strand_coverage << m_separator << alignment_identity
-                   << m_separator << alignment_accurary << m_separator << alignment_bed_hits;
-            ;
-        }
-        writer << '\n';
+    if (read_error) {
+        std::rethrow_exception(read_error);
+    }
+    if (error) {
+        std::rethrow_exception(error);
     }
     return true;
 }
@@ -3,17 +3,131 @@
 #include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <queue>
 #include <string>
+#include <tuple>
 #include <unordered_map>
+#include <vector>
 
 namespace dorado::utils {
 
 // Status return by push/pop methods.
 enum class AsyncQueueStatus { Success, Timeout, Terminate };
 
+// Selects how an AsyncQueue stores its items.
+enum class AsyncQueueType {
+    // A std::queue guarded by a mutex.
+    Locked,
+    // A bounded lock-free ring buffer.  The mutex is only taken to block when the queue is
+    // full or empty, which cuts contention on queues carrying many small items.
+    LockFree,
+};
+
+namespace details {
+
+// Bounded multi-producer multi-consumer ring buffer, based on Dmitry Vyukov's design.
+// Each cell has a sequence number which tells producers and consumers whose turn it is to use
+// the cell, so pushes and pops only contend on their own position counter.
+template <class Item>
+class MPMCRingBuffer {
+public:
+    explicit MPMCRingBuffer(size_t capacity)
+            : m_capacity(std::max(capacity, size_t(1))),
+              m_cells(std::make_unique<Cell[]>(m_capacity)) {
+        for (size_t i = 0; i < m_capacity; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Adds item, which is only moved from on success.  Returns false if the buffer is full.
+    bool try_push(Item& item) {
+        size_t pos = m_push_pos.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        while (true) {
+            cell = &m_cells[pos % m_capacity];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+            if (diff == 0) {
+                if (m_push_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_push_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->item.emplace(std::move(item));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Removes the next item and passes it to consume_fn as an rvalue.  Returns false if the
+    // buffer is empty.
+    template <class ConsumeFn>
+    bool try_consume(ConsumeFn& consume_fn) {
+        size_t pos = m_pop_pos.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        while (true) {
+            cell = &m_cells[pos % m_capacity];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence - (pos + 1));
+            if (diff == 0) {
+                if (m_pop_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_pop_pos.load(std::memory_order_relaxed);
+            }
+        }
+        Item item = std::move(*cell->item);
+        cell->item.reset();
+        cell->sequence.store(pos + m_capacity, std::memory_order_release);
+        consume_fn(std::move(item));
+        return true;
+    }
+
+    // Whether the next push/pop could succeed.  Only a hint under concurrent use.
+    bool can_push() const { return can_use(m_push_pos, 0); }
+    bool can_pop() const { return can_use(m_pop_pos, 1); }
+
+    // Approximate number of items in the buffer.
+    size_t size() const {
+        const size_t pop_pos = m_pop_pos.load(std::memory_order_acquire);
+        const size_t push_pos = m_push_pos.load(std::memory_order_acquire);
+        return push_pos > pop_pos ? std::min(push_pos - pop_pos, m_capacity) : 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        std::optional<Item> item;
+    };
+
+    bool can_use(const std::atomic<size_t>& position, size_t offset) const {
+        const size_t pos = position.load(std::memory_order_acquire);
+        const size_t sequence = m_cells[pos % m_capacity].sequence.load(std::memory_order_acquire);
+        return static_cast<std::ptrdiff_t>(sequence - (pos + offset)) >= 0;
+    }
+
+    const size_t m_capacity;
+    std::unique_ptr<Cell[]> m_cells;
+    // Kept on separate cache lines so that producers and consumers don't interfere.
+    alignas(64) std::atomic<size_t> m_push_pos{0};
+    alignas(64) std::atomic<size_t> m_pop_pos{0};
+};
+
+}  // namespace details
+
 // Asynchronous queue for producer/consumer use.
 // Items must be movable.
 template <class Item>
@@ -34,10 +148,18 @@ class AsyncQueue {
     size_t m_capacity = 0;
     // If true, CV waits should terminate regardless of other state.
     // Pending attempts to push or pop items will fail.
-    bool m_terminate = false;
+    // Atomic since the lock-free implementation reads it without holding the mutex.
+    std::atomic<bool> m_terminate{false};
     // Stats for monitoring queue usage.
-    int64_t m_num_pushes = 0;
-    int64_t m_num_pops = 0;
+    std::atomic<int64_t> m_num_pushes{0};
+    std::atomic<int64_t> m_num_pops{0};
+
+    // Holds the items in place of m_items when using AsyncQueueType::LockFree.
+    std::unique_ptr<details::MPMCRingBuffer<Item>> m_ring;
+    // Number of threads blocked in pushes/pops of the ring buffer, so that the other side only
+    // needs to take the mutex to wake them when there's someone to wake.
+    std::atomic<int> m_num_waiting_pushers{0};
+    std::atomic<int> m_num_waiting_poppers{0};
 
     // Sets item to the next element in the queue and
     // notifies a waiting thread that the queue is not full.
@@ -94,9 +216,128 @@ class AsyncQueue {
         return {std::move(lock), wait_status};
     }
 
+    // Wakes threads waiting on cv if waiter_count says there are any.  The seq_cst fence pairs
+    // with the one in wait_for_ring, so that either the waiter sees the change that was just
+    // made to the ring buffer, or we see the waiter.
+    void notify_ring_waiters(const std::atomic<int>& waiter_count,
+                             std::condition_variable& cv,
+                             bool notify_all) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiter_count.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        {
+            // Waiters check their condition with the mutex held, so taking it here ensures that
+            // they are either yet to check or already waiting.
+            std::lock_guard lock(m_mutex);
+        }
+        if (notify_all) {
+            cv.notify_all();
+        } else {
+            cv.notify_one();
+        }
+    }
+
+    // Blocks until ready() returns true, we are asked to terminate, or timeout_time (if non-null)
+    // passes.  Returns false on timeout.
+    template <class Ready, class Clock, class Duration>
+    bool wait_for_ring(std::atomic<int>& waiter_count,
+                       std::condition_variable& cv,
+                       Ready ready,
+                       const std::chrono::time_point<Clock, Duration>* timeout_time) {
+        std::unique_lock lock(m_mutex);
+        ++waiter_count;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto predicate = [this, &ready] { return ready() || m_terminate; };
+        bool wait_status = true;
+        if (timeout_time) {
+            wait_status = cv.wait_until(lock, *timeout_time, predicate);
+        } else {
+            cv.wait(lock, predicate);
+        }
+        --waiter_count;
+        return wait_status;
+    }
+
+    // Pushes the num_items items starting at items, blocking while the queue is full.
+    AsyncQueueStatus ring_push(Item* items, size_t num_items) {
+        size_t num_pushed = 0;
+        while (true) {
+            if (m_terminate) {
+                return AsyncQueueStatus::Terminate;
+            }
+            const size_t prev_num_pushed = num_pushed;
+            while (num_pushed < num_items && m_ring->try_push(items[num_pushed])) {
+                ++num_pushed;
+            }
+            if (num_pushed > prev_num_pushed) {
+                const size_t count = num_pushed - prev_num_pushed;
+                m_num_pushes.fetch_add(int64_t(count), std::memory_order_relaxed);
+                notify_ring_waiters(m_num_waiting_poppers, m_not_empty_cv, count > 1);
+            }
+            if (num_pushed == num_items) {
+                return AsyncQueueStatus::Success;
+            }
+            // The queue is full, so wait for a pop to make space.
+            using Clock = std::chrono::steady_clock;
+            wait_for_ring(
+                    m_num_waiting_pushers, m_not_full_cv, [this] { return m_ring->can_push(); },
+                    static_cast<const Clock::time_point*>(nullptr));
+        }
+    }
+
+    // Pops the next item into consume_fn, blocking while the queue is empty.
+    // Termination takes effect once all items have been popped from the queue.
+    template <class ConsumeFn, class Clock, class Duration>
+    AsyncQueueStatus ring_pop(ConsumeFn& consume_fn,
+                              const std::chrono::time_point<Clock, Duration>* timeout_time) {
+        while (true) {
+            if (m_ring->try_consume(consume_fn)) {
+                m_num_pops.fetch_add(1, std::memory_order_relaxed);
+                return AsyncQueueStatus::Success;
+            }
+            // A push that has claimed a cell but not yet filled it still counts towards the size,
+            // so we don't report termination while it's in flight.
+            if (m_terminate && m_ring->size() == 0) {
+                return AsyncQueueStatus::Terminate;
+            }
+            if (!wait_for_ring(
+                        m_num_waiting_poppers, m_not_empty_cv, [this] { return m_ring->can_pop(); },
+                        timeout_time)) {
+                return AsyncQueueStatus::Timeout;
+            }
+        }
+    }
+
+    // Pops the next item, then up to max_count - 1 more if they're immediately available, and
+    // wakes any pushers waiting for space.
+    template <class ProcessFn, class Clock, class Duration>
+    AsyncQueueStatus ring_process_items(
+            ProcessFn& process_fn,
+            size_t max_count,
+            const std::chrono::time_point<Clock, Duration>* timeout_time) {
+        const auto status = ring_pop(process_fn, timeout_time);
+        if (status != AsyncQueueStatus::Success) {
+            return status;
+        }
+        size_t num_popped = 1;
+        while (num_popped < max_count && m_ring->try_consume(process_fn)) {
+            ++num_popped;
+        }
+        m_num_pops.fetch_add(int64_t(num_popped - 1), std::memory_order_relaxed);
+        // We have in general removed > 1 item, and there can be > 1 thread waiting to push.
+        notify_ring_waiters(m_num_waiting_pushers, m_not_full_cv, num_popped > 1);
+        return AsyncQueueStatus::Success;
+    }
+
 public:
     // Attempts to push items beyond capacity will block.
-    explicit AsyncQueue(size_t capacity) : m_capacity(capacity) {}
+    explicit AsyncQueue(size_t capacity, AsyncQueueType type = AsyncQueueType::Locked)
+            : m_capacity(capacity) {
+        if (type == AsyncQueueType::LockFree) {
+            m_ring = std::make_unique<details::MPMCRingBuffer<Item>>(capacity);
+        }
+    }
 
     ~AsyncQueue() {
         // Ensure CV waits terminate before destruction.
@@ -117,6 +358,10 @@ public:
     // is returned.
     // Items pushed must be rvalues, since we assume sole ownership.
     AsyncQueueStatus try_push(Item&& item) {
+        if (m_ring) {
+            return ring_push(&item, 1);
+        }
+
         std::unique_lock lock(m_mutex);
 
         // Ensure there is space for the new item, given our limit on capacity.
@@ -138,6 +383,44 @@ public:
         return AsyncQueueStatus::Success;
     }
 
+    // Adds all of items to the queue, taking the lock once per batch of items rather than
+    // once per item.  Blocks while the queue is full, adding items as space becomes available.
+    // If terminate() is called before all items have been added, AsyncQueueStatus::Terminate
+    // is returned and the remaining items are not added.
+    // On return items is empty.
+    AsyncQueueStatus try_push_n(std::vector<Item>&& items) {
+        auto status = AsyncQueueStatus::Success;
+        if (m_ring) {
+            status = ring_push(items.data(), items.size());
+            items.clear();
+            return status;
+        }
+
+        size_t num_pushed = 0;
+        while (num_pushed < items.size()) {
+            std::unique_lock lock(m_mutex);
+            m_not_full_cv.wait(lock,
+                               [this] { return m_items.size() < m_capacity || m_terminate; });
+            if (m_terminate) {
+                status = AsyncQueueStatus::Terminate;
+                break;
+            }
+
+            const size_t count = std::min(m_capacity - m_items.size(), items.size() - num_pushed);
+            for (size_t i = 0; i < count; ++i) {
+                m_items.push(std::move(items[num_pushed + i]));
+            }
+            num_pushed += count;
+            m_num_pushes += count;
+
+            // Inform all waiting threads, since in general we have added > 1 item.
+            lock.unlock();
+            m_not_empty_cv.notify_all();
+        }
+        items.clear();
+        return status;
+    }
+
     // Obtains the next item in the queue, potentially timing out.
     // If queue is empty:
     // If timeout is reached, but we are not terminating, returns AsyncQueueStatus::Timeout.
@@ -146,6 +429,11 @@ public:
     template <class Clock, class Duration>
     AsyncQueueStatus try_pop_until(Item& item,
                                    const std::chrono::time_point<Clock, Duration>& timeout_time) {
+        if (m_ring) {
+            auto consume_fn = [&item](Item&& popped) { item = std::move(popped); };
+            return ring_process_items(consume_fn, 1, &timeout_time);
+        }
+
         auto [lock, wait_status] = wait_for_item_or_timeout(timeout_time);
 
         if (wait_status == false) {
@@ -169,6 +457,13 @@ public:
     // Otherwise block until an item is added, upon which AsyncQueueStatus::Success
     // is returned.
     AsyncQueueStatus try_pop(Item& item) {
+        if (m_ring) {
+            using Clock = std::chrono::steady_clock;
+            auto consume_fn = [&item](Item&& popped) { item = std::move(popped); };
+            return ring_process_items(consume_fn, 1,
+                                      static_cast<const Clock::time_point*>(nullptr));
+        }
+
         auto lock = wait_for_item();
 
         // Termination takes effect once all items have been popped from the queue.
@@ -190,6 +485,12 @@ public:
     // is returned.
     template <class ProcessFn>
     AsyncQueueStatus process_and_pop_n(ProcessFn process_fn, size_t max_count) {
+        if (m_ring) {
+            using Clock = std::chrono::steady_clock;
+            return ring_process_items(process_fn, max_count,
+                                      static_cast<const Clock::time_point*>(nullptr));
+        }
+
         auto lock = wait_for_item();
 
         // Termination takes effect once all items have been popped from the queue.
@@ -208,6 +509,10 @@ public:
             ProcessFn process_fn,
             size_t max_count,
             const std::chrono::time_point<Clock, Duration>& timeout_time) {
+        if (m_ring) {
+            return ring_process_items(process_fn, max_count, &timeout_time);
+        }
+
         auto [lock, wait_status] = wait_for_item_or_timeout(timeout_time);
 
         if (wait_status == false) {
@@ -254,6 +559,9 @@ public:
     // Current number of items in the queue.  Only useful for stats sampling and
     // testing.
     size_t size() const {
+        if (m_ring) {
+            return m_ring->size();
+        }
         std::lock_guard lock(m_mutex);
         return m_items.size();
     }
@@ -262,8 +570,7 @@ public:
 
     std::unordered_map<std::string, double> sample_stats() const {
         std::unordered_map<std::string, double> stats;
-        std::lock_guard<std::mutex> lock(m_mutex);
-        stats["items"] = double(m_items.size());
+        stats["items"] = double(size());
         stats["pushes"] = double(m_num_pushes);
         stats["pops"] = double(m_num_pops);
         return stats;
@@ -0,0 +1,74 @@
+#include "BamRecordBuilder.h"
+
+#include <htslib/sam.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace dorado::utils {
+
+uint8_t* BamRecordBuilder::append_tag(const char tag[2], char type, size_t data_size) {
+    const size_t offset = m_aux.size();
+    m_aux.resize(offset + 3 + data_size);
+    auto* entry = m_aux.data() + offset;
+    entry[0] = uint8_t(tag[0]);
+    entry[1] = uint8_t(tag[1]);
+    entry[2] = uint8_t(type);
+    return entry + 3;
+}
+
+void BamRecordBuilder::add_int(const char tag[2], int32_t value) {
+    std::memcpy(append_tag(tag, 'i', sizeof(value)), &value, sizeof(value));
+}
+
+void BamRecordBuilder::add_float(const char tag[2], float value) {
+    std::memcpy(append_tag(tag, 'f', sizeof(value)), &value, sizeof(value));
+}
+
+void BamRecordBuilder::add_string(const char tag[2], std::string_view value) {
+    auto* data = append_tag(tag, 'Z', value.size() + 1);
+    std::memcpy(data, value.data(), value.size());
+    data[value.size()] = 0;
+}
+
+uint8_t* BamRecordBuilder::add_byte_array(const char tag[2], char type, size_t count) {
+    // The element type and a little endian count precede the elements.
+    auto* data = append_tag(tag, 'B', 5 + count);
+    data[0] = uint8_t(type);
+    const auto items = uint32_t(count);
+    for (int i = 0; i < 4; ++i) {
+        data[1 + i] = uint8_t(items >> (8 * i));
+    }
+    return data + 5;
+}
+
+BamPtr BamRecordBuilder::build_unmapped(std::string_view qname,
+                                        std::string_view seq,
+                                        std::string_view qstring) const {
+    if (seq.size() != qstring.size()) {
+        throw std::runtime_error("Sequence and qscore do not match size for read id " +
+                                 std::string(qname));
+    }
+
+    BamPtr record(bam_init1());
+    // bam_set1 reserves space for the aux data, so copying it in doesn't reallocate.  The
+    // quality is written directly rather than converted into a separate buffer first.
+    if (bam_set1(record.get(), qname.size(), qname.data(), BAM_FUNMAP, -1, -1, 0, 0, nullptr, -1,
+                 -1, 0, seq.size(), seq.data(), nullptr, m_aux.size()) < 0) {
+        throw std::runtime_error("Failed to create BAM record for read id " + std::string(qname));
+    }
+
+    auto* qual = bam_get_qual(record.get());
+    for (size_t i = 0; i < qstring.size(); ++i) {
+        qual[i] = uint8_t(qstring[i] - 33);
+    }
+
+    if (!m_aux.empty()) {
+        std::memcpy(record->data + record->l_data, m_aux.data(), m_aux.size());
+        record->l_data += int(m_aux.size());
+    }
+    return record;
+}
+
+}  // namespace dorado::utils
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "types.h"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace dorado::utils {
+
+/** Builds an unmapped BAM record in a single allocation.
+ *
+ *  Aux tags are staged in a buffer which is kept between records, and copied in once the size
+ *  of the whole record is known, rather than reallocating the record as each tag is appended.
+ *  The record is byte-identical to one made with bam_set1 followed by a bam_aux_append or
+ *  bam_aux_update_array call for each tag, in the same order.
+ */
+class BamRecordBuilder {
+public:
+    /// Start a new record, discarding any tags already added.
+    void clear() { m_aux.clear(); }
+
+    /// Add an 'i' tag, stored as 4 bytes whatever its value as bam_aux_append does.
+    void add_int(const char tag[2], int32_t value);
+    /// Add an 'f' tag.
+    void add_float(const char tag[2], float value);
+    /// Add a 'Z' tag.
+    void add_string(const char tag[2], std::string_view value);
+    /** Add a 'B' array tag of count single byte elements.
+     *  @param type The element type, 'c' or 'C'.
+     *  @return The elements, to be filled in by the caller before the next tag is added.
+     */
+    uint8_t* add_byte_array(const char tag[2], char type, size_t count);
+
+    /** Build an unmapped record holding the tags added since the last call to clear.
+     *  @param qname The read name.
+     *  @param seq The sequence.
+     *  @param qstring The phred+33 quality string, which must be the same length as seq.
+     */
+    BamPtr build_unmapped(std::string_view qname,
+                          std::string_view seq,
+                          std::string_view qstring) const;
+
+private:
+    uint8_t* append_tag(const char tag[2], char type, size_t data_size);
+
+    std::vector<uint8_t> m_aux;
+};
+
+}  // namespace dorado::utils
@@ -0,0 +1,75 @@
+#include "PairwiseOverlapper.h"
+
+#include <minimap.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+// The index only ever holds a single read, so there's no need for the 2^14 buckets that the
+// preset asks for. Allocating and walking all of them dominates the cost of building such a
+// small index. Bucketing only partitions the minimizer hash table, so the hits are unaffected.
+constexpr int kIndexBucketBits = 8;
+
+}  // namespace
+
+namespace dorado::utils {
+
+struct PairwiseOverlapper::Options {
+    mm_idxopt_t idx_opt;
+    mm_mapopt_t map_opt;
+};
+
+PairwiseOverlapper::PairwiseOverlapper()
+        : m_options(std::make_unique<Options>()), m_tbuf(mm_tbuf_init()) {
+    mm_set_opt(0, &m_options->idx_opt, &m_options->map_opt);
+    mm_set_opt("map-hifi", &m_options->idx_opt, &m_options->map_opt);
+    m_options->idx_opt.bucket_bits = std::min<short>(m_options->idx_opt.bucket_bits,
+                                                     static_cast<short>(kIndexBucketBits));
+}
+
+PairwiseOverlapper::~PairwiseOverlapper() = default;
+
+PairwiseOverlapper::Overlap PairwiseOverlapper::overlap(const std::string& ref_seq,
+                                                        const std::string& ref_name,
+                                                        const std::string& query_seq,
+                                                        const std::string& query_name) {
+    const auto& idx_opt = m_options->idx_opt;
+    const char* seq = ref_seq.c_str();
+    const char* name = ref_name.c_str();
+    mm_idx_t* index = mm_idx_str(idx_opt.w, idx_opt.k, 0, idx_opt.bucket_bits, 1, &seq, &name);
+
+    // Some of the mapping options depend on the index, so update a copy of them.
+    mm_mapopt_t map_opt = m_options->map_opt;
+    mm_mapopt_update(&map_opt, index);
+
+    int hits = 0;
+    mm_reg1_t* reg = mm_map(index, int(query_seq.length()), query_seq.c_str(), &hits,
+                            m_tbuf.get(), &map_opt, query_name.c_str());
+
+    mm_idx_destroy(index);
+
+    Overlap overlap{hits, 0, false, 0, 0, 0, 0};
+    // When there are multiple hits, pick the primary alignment.
+    if (hits > 0) {
+        auto best_map = std::max_element(
+                reg, reg + hits,
+                [](const mm_reg1_t& l, const mm_reg1_t& r) { return l.mapq < r.mapq; });
+        overlap.mapq = static_cast<uint8_t>(best_map->mapq);
+        overlap.rev = best_map->rev;
+        overlap.ref_start = best_map->rs;
+        overlap.ref_end = best_map->re;
+        overlap.query_start = best_map->qs;
+        overlap.query_end = best_map->qe;
+    }
+
+    for (int i = 0; i < hits; ++i) {
+        free(reg[i].p);
+    }
+    free(reg);
+
+    return overlap;
+}
+
+}  // namespace dorado::utils
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "types.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace dorado::utils {
+
+// Finds the overlap between pairs of sequences with minimap2, using the map-hifi preset.
+// The minimap2 options and thread buffer are set up once and reused for every pair, so a
+// PairwiseOverlapper should be kept around rather than created per pair.
+// An instance is not thread safe: use one per thread.
+class PairwiseOverlapper {
+public:
+    // The primary (highest mapq) hit from mapping a query onto a reference.
+    struct Overlap {
+        int num_hits;
+        uint8_t mapq;
+        bool rev;
+        int32_t ref_start;
+        int32_t ref_end;
+        int32_t query_start;
+        int32_t query_end;
+    };
+
+    PairwiseOverlapper();
+    ~PairwiseOverlapper();
+    PairwiseOverlapper(const PairwiseOverlapper&) = delete;
+    PairwiseOverlapper& operator=(const PairwiseOverlapper&) = delete;
+
+    // Index |ref_seq| and map |query_seq| onto it. Returns an Overlap with num_hits == 0 if the
+    // query doesn't map.
+    Overlap overlap(const std::string& ref_seq,
+                    const std::string& ref_name,
+                    const std::string& query_seq,
+                    const std::string& query_name);
+
+private:
+    struct Options;
+    std::unique_ptr<Options> m_options;
+    MmTbufPtr m_tbuf;
+};
+
+}  // namespace dorado::utils
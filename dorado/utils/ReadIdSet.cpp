@@ -0,0 +1,155 @@
+#include "ReadIdSet.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr size_t UUID_STRING_LENGTH = 36;
+constexpr size_t MIN_CAPACITY = 16;
+
+// The value of each lowercase hex digit, and -1 for every other character.  Uppercase digits
+// aren't accepted, since pod5 formats read ids in lowercase, and a string with uppercase digits
+// wouldn't match one.
+constexpr std::array<int8_t, 256> HEX_VALUES = [] {
+    std::array<int8_t, 256> values{};
+    for (auto& value : values) {
+        value = -1;
+    }
+    for (int i = 0; i < 10; ++i) {
+        values['0' + i] = int8_t(i);
+    }
+    for (int i = 0; i < 6; ++i) {
+        values['a' + i] = int8_t(10 + i);
+    }
+    return values;
+}();
+
+// Where each byte of a UUID starts in its string form.
+constexpr std::array<uint8_t, 16> BYTE_POSITIONS = {0,  2,  4,  6,  9,  11, 14, 16,
+                                                    19, 21, 24, 26, 28, 30, 32, 34};
+
+}  // namespace
+
+namespace dorado::utils {
+
+ReadIdSet::ReadIdSet(std::initializer_list<std::string_view> read_ids) {
+    for (auto read_id : read_ids) {
+        insert(read_id);
+    }
+}
+
+std::optional<ReadIdSet::Uuid> ReadIdSet::parse_uuid(std::string_view read_id) {
+    if (read_id.length() != UUID_STRING_LENGTH) {
+        return std::nullopt;
+    }
+    if (read_id[8] != '-' || read_id[13] != '-' || read_id[18] != '-' || read_id[23] != '-') {
+        return std::nullopt;
+    }
+    // Any character which isn't a hex digit sets the sign bit of invalid.
+    Uuid uuid{};
+    int invalid = 0;
+    for (size_t i = 0; i < uuid.size(); ++i) {
+        const int high = HEX_VALUES[uint8_t(read_id[BYTE_POSITIONS[i]])];
+        const int low = HEX_VALUES[uint8_t(read_id[BYTE_POSITIONS[i] + 1])];
+        invalid |= high | low;
+        uuid[i] = uint8_t((unsigned(high) << 4) | unsigned(low));
+    }
+    if (invalid < 0) {
+        return std::nullopt;
+    }
+    return uuid;
+}
+
+ReadIdSet::Key ReadIdSet::to_key(const Uuid& uuid) {
+    Key key;
+    std::memcpy(&key.hi, uuid.data(), sizeof(key.hi));
+    std::memcpy(&key.lo, uuid.data() + sizeof(key.hi), sizeof(key.lo));
+    return key;
+}
+
+bool ReadIdSet::insert(std::string_view read_id) {
+    if (auto uuid = parse_uuid(read_id)) {
+        return insert(*uuid);
+    }
+    return m_other_ids.emplace(read_id).second;
+}
+
+bool ReadIdSet::insert(const Uuid& uuid) { return insert_key(to_key(uuid)); }
+
+bool ReadIdSet::contains(std::string_view read_id) const {
+    if (auto uuid = parse_uuid(read_id)) {
+        return contains(*uuid);
+    }
+    return m_other_ids.count(std::string(read_id)) != 0;
+}
+
+bool ReadIdSet::contains(const Uuid& uuid) const { return contains_key(to_key(uuid)); }
+
+size_t ReadIdSet::count_not_in(const ReadIdSet& other) const {
+    size_t count = 0;
+    for (const auto& key : m_slots) {
+        if (!key.empty() && !other.contains_key(key)) {
+            ++count;
+        }
+    }
+    if (m_has_zero_uuid && !other.m_has_zero_uuid) {
+        ++count;
+    }
+    for (const auto& read_id : m_other_ids) {
+        if (other.m_other_ids.count(read_id) == 0) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+// Linear probing from the hash of the key, which stops at the key or at the first empty slot.
+size_t ReadIdSet::find_slot(const Key& key) const {
+    // Read ids are mostly random UUIDs, but mix the words so that sequential ids spread out too.
+    const uint64_t hash = (key.hi ^ (key.lo * 0x9e3779b97f4a7c15ull)) * 0xbf58476d1ce4e5b9ull;
+    const size_t mask = m_slots.size() - 1;
+    size_t slot = size_t(hash >> 32) & mask;
+    while (!m_slots[slot].empty() && !(m_slots[slot] == key)) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+bool ReadIdSet::insert_key(const Key& key) {
+    if (key.empty()) {
+        const bool inserted = !m_has_zero_uuid;
+        m_has_zero_uuid = true;
+        return inserted;
+    }
+    // Keep the table at most 3/4 full, so that probes stay short.
+    if ((m_num_uuids + 1) * 4 > m_slots.size() * 3) {
+        grow();
+    }
+    auto& slot = m_slots[find_slot(key)];
+    if (!slot.empty()) {
+        return false;
+    }
+    slot = key;
+    ++m_num_uuids;
+    return true;
+}
+
+bool ReadIdSet::contains_key(const Key& key) const {
+    if (key.empty()) {
+        return m_has_zero_uuid;
+    }
+    return !m_slots.empty() && !m_slots[find_slot(key)].empty();
+}
+
+void ReadIdSet::grow() {
+    const auto old_slots = std::move(m_slots);
+    m_slots.assign(std::max(MIN_CAPACITY, old_slots.size() * 2), Key{0, 0});
+    for (const auto& key : old_slots) {
+        if (!key.empty()) {
+            m_slots[find_slot(key)] = key;
+        }
+    }
+}
+
+}  // namespace dorado::utils
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace dorado::utils {
+
+/** A set of read ids, for tracking the tens of millions of reads in a run.
+ *
+ *  Read ids are UUIDs, so each is held as its 16 bytes in an open addressing hash table, rather
+ *  than as a 36 character string.  Ids which aren't in the canonical lowercase UUID form are
+ *  kept as strings, so that any read id behaves as it would in a set of strings.
+ */
+class ReadIdSet {
+public:
+    /// The bytes of a UUID, in the order they're written in its string form, as POD5 stores them.
+    using Uuid = std::array<uint8_t, 16>;
+
+    ReadIdSet() = default;
+    ReadIdSet(std::initializer_list<std::string_view> read_ids);
+
+    /// Parse a read id of the form "0123abcd-...", or return nothing if it isn't a UUID.
+    static std::optional<Uuid> parse_uuid(std::string_view read_id);
+
+    /// @return true if the read id wasn't already in the set.
+    bool insert(std::string_view read_id);
+    bool insert(const Uuid& uuid);
+
+    bool contains(std::string_view read_id) const;
+    bool contains(const Uuid& uuid) const;
+    size_t count(std::string_view read_id) const { return contains(read_id) ? 1 : 0; }
+
+    size_t size() const { return m_num_uuids + (m_has_zero_uuid ? 1 : 0) + m_other_ids.size(); }
+    bool empty() const { return size() == 0; }
+
+    /// The number of read ids in this set which aren't in other.
+    size_t count_not_in(const ReadIdSet& other) const;
+
+private:
+    // A UUID as two words.  The all zero UUID marks an empty slot, so it's tracked separately.
+    struct Key {
+        uint64_t hi;
+        uint64_t lo;
+        bool operator==(const Key& rhs) const { return hi == rhs.hi && lo == rhs.lo; }
+        bool empty() const { return hi == 0 && lo == 0; }
+    };
+
+    static Key to_key(const Uuid& uuid);
+    size_t find_slot(const Key& key) const;
+    bool insert_key(const Key& key);
+    bool contains_key(const Key& key) const;
+    void grow();
+
+    std::vector<Key> m_slots;
+    size_t m_num_uuids{0};
+    bool m_has_zero_uuid{false};
+    // Read ids which aren't UUIDs.
+    std::unordered_set<std::string> m_other_ids;
+};
+
+}  // namespace dorado::utils
@@ -557,4 +557,20 @@ void remove_alignment_tags_from_record(bam1_t* record) {
     }
 }
 
+void set_pipeline_entry_time(bam1_t* record, std::chrono::steady_clock::time_point entry_time) {
+    const auto ticks = entry_time.time_since_epoch().count();
+    record->id = ticks > 0 ? uint64_t(ticks) : 0;
+}
+
+std::optional<std::chrono::steady_clock::time_point> get_pipeline_entry_time(
+        const bam1_t* record) {
+    if (record->id == 0) {
+        return std::nullopt;
+    }
+    using Duration = std::chrono::steady_clock::duration;
+    return std::chrono::steady_clock::time_point(Duration(Duration::rep(record->id)));
+}
+
+void copy_pipeline_entry_time(const bam1_t* from, bam1_t* to) { to->id = from->id; }
+
 }  // namespace dorado::utils
@@ -2,7 +2,9 @@
 #include "barcode_kits.h"
 #include "types.h"
 
+#include <chrono>
 #include <map>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -201,4 +203,32 @@ kstring_t allocate_kstring();
  */
 void remove_alignment_tags_from_record(bam1_t* record);
 
+/*
+ * Record the time at which the read a BAM record was made from entered the pipeline, so that the
+ * read's end-to-end latency can be measured when the record is written.  The time is kept in
+ * bam1_t::id, which is not written to the output file.
+ *
+ * @param record BAM record.
+ * @param entry_time Pipeline entry time.  A default constructed time_point is not recorded.
+ */
+void set_pipeline_entry_time(bam1_t* record, std::chrono::steady_clock::time_point entry_time);
+
+/*
+ * Get the time set by set_pipeline_entry_time.
+ *
+ * @param record BAM record.
+ * @return The pipeline entry time, or std::nullopt if none was set.
+ */
+std::optional<std::chrono::steady_clock::time_point> get_pipeline_entry_time(
+        const bam1_t* record);
+
+/*
+ * Copy the time set by set_pipeline_entry_time to a record built from another one.  bam_set1()
+ * doesn't keep it, so this must be called by anything that rebuilds a record.
+ *
+ * @param from The original BAM record.
+ * @param to The new BAM record.
+ */
+void copy_pipeline_entry_time(const bam1_t* from, bam1_t* to);
+
 }  // namespace dorado::utils
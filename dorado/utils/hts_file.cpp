@@ -5,102 +5,279 @@
 #include <htslib/bgzf.h>
 #include <htslib/hts.h>
 #include <htslib/sam.h>
+#include <htslib/thread_pool.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <filesystem>
-#include <map>
+#include <functional>
+#include <future>
+#include <queue>
 #include <stdexcept>
 
 namespace {
 
-uint64_t calculate_sorting_key(bam1_t* const record) {
+// The maximum number of sorted runs that are merged at once. If we have more runs than this then
+// they're merged in several passes so that we don't run out of file handles.
+constexpr size_t MAX_MERGE_FAN_IN = 256;
+
+// Records in a sort buffer are aligned so that the cigar data can be read in place.
+constexpr size_t RECORD_ALIGNMENT = alignof(bam1_core_t);
+
+// The space that a record takes up in a sort buffer.
+size_t padded_record_size(const bam1_t* const record) {
+    const size_t record_size = sizeof(bam1_core_t) + record->l_data;
+    return (record_size + RECORD_ALIGNMENT - 1) & ~(RECORD_ALIGNMENT - 1);
+}
+
+uint64_t calculate_sorting_key(const bam1_t* const record) {
     return (static_cast<uint64_t>(record->core.tid) << 32) | record->core.pos;
 }
 
+// Buffers smaller than this are sorted on a single thread.
+constexpr size_t MIN_ENTRIES_PER_SORT_CHUNK = 1000;
+
+// Stable sort of |entries| by their sorting key. The entries are split into chunks that are sorted
+// on up to |threads| threads, then neighbouring chunks are merged in parallel until one is left.
+// A merge keeps the earlier chunk's entries first, so ties stay in the order they were written.
+template <typename Entry>
+void parallel_stable_sort(std::vector<Entry>& entries, int threads) {
+    auto by_key = [](const Entry& lhs, const Entry& rhs) {
+        return lhs.sorting_key < rhs.sorting_key;
+    };
+    const size_t num_chunks = std::clamp(entries.size() / MIN_ENTRIES_PER_SORT_CHUNK, size_t{1},
+                                         size_t(std::max(threads, 1)));
+    if (num_chunks == 1) {
+        std::stable_sort(entries.begin(), entries.end(), by_key);
+        return;
+    }
+
+    std::vector<typename std::vector<Entry>::iterator> bounds;
+    for (size_t chunk = 0; chunk <= num_chunks; ++chunk) {
+        bounds.push_back(entries.begin() + entries.size() * chunk / num_chunks);
+    }
+
+    std::vector<std::future<void>> tasks;
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+        tasks.push_back(std::async(std::launch::async, [&, chunk] {
+            std::stable_sort(bounds[chunk], bounds[chunk + 1], by_key);
+        }));
+    }
+    for (auto& task : tasks) {
+        task.get();
+    }
+
+    for (size_t width = 1; width < num_chunks; width *= 2) {
+        tasks.clear();
+        for (size_t first = 0; first + width < num_chunks; first += 2 * width) {
+            const size_t middle = first + width;
+            const size_t last = std::min(first + 2 * width, num_chunks);
+            tasks.push_back(std::async(std::launch::async, [&, first, middle, last] {
+                std::inplace_merge(bounds[first], bounds[middle], bounds[last], by_key);
+            }));
+        }
+        for (auto& task : tasks) {
+            task.get();
+        }
+    }
+}
+
+struct HtsThreadPoolDestructor {
+    void operator()(hts_tpool* pool) { hts_tpool_destroy(pool); }
+};
+using HtsThreadPoolPtr = std::unique_ptr<hts_tpool, HtsThreadPoolDestructor>;
+
+// Merge the sorted runs in |run_files| into |out_file|. Records with the same sorting key are
+// written in the order of the runs they came from, so that the merge is stable.
+void merge_runs(const std::vector<std::string>& run_files,
+                htsFile* const out_file,
+                const sam_hdr_t* const out_header,
+                int threads,
+                const std::function<void()>& on_record_written) {
+    // Share a single pool between the readers rather than giving each of them its own threads.
+    HtsThreadPoolPtr pool(hts_tpool_init(std::max(threads, 1)));
+    if (!pool) {
+        throw std::runtime_error("Could not create thread pool for merging sorted runs.");
+    }
+    htsThreadPool thread_pool{pool.get(), 0};
+
+    struct RunReader {
+        dorado::HtsFilePtr file;
+        dorado::SamHdrPtr header;
+        dorado::BamPtr record;
+    };
+    std::vector<RunReader> readers(run_files.size());
+
+    auto read_next = [&readers, &run_files](size_t run_idx) {
+        auto& reader = readers[run_idx];
+        const int res = sam_read1(reader.file.get(), reader.header.get(), reader.record.get());
+        if (res < -1) {
+            throw std::runtime_error("Failed to read from sorted run " + run_files[run_idx]);
+        }
+        return res >= 0;
+    };
+
+    // Min-heap of (sorting key, run index), so ties are broken by the run order.
+    using HeapEntry = std::pair<uint64_t, size_t>;
+    std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> heap;
+
+    for (size_t run_idx = 0; run_idx < run_files.size(); ++run_idx) {
+        auto& reader = readers[run_idx];
+        reader.file.reset(hts_open(run_files[run_idx].c_str(), "rb"));
+        if (!reader.file) {
+            throw std::runtime_error("Could not open sorted run " + run_files[run_idx]);
+        }
+        if (hts_set_opt(reader.file.get(), HTS_OPT_THREAD_POOL, &thread_pool) < 0) {
+            throw std::runtime_error("Could not enable multi threading for BAM reading.");
+        }
+        reader.header.reset(sam_hdr_read(reader.file.get()));
+        if (!reader.header) {
+            throw std::runtime_error("Could not read header of sorted run " + run_files[run_idx]);
+        }
+        reader.record.reset(bam_init1());
+        if (read_next(run_idx)) {
+            heap.emplace(calculate_sorting_key(reader.record.get()), run_idx);
+        }
+    }
+
+    while (!heap.empty()) {
+        const auto run_idx = heap.top().second;
+        heap.pop();
+
+        auto& reader = readers[run_idx];
+        if (sam_write1(out_file, out_header, reader.record.get()) < 0) {
+            throw std::runtime_error(std::string("Failed to write to sorted file ") +
+                                     out_file->fn);
+        }
+        on_record_written();
+
+        if (read_next(run_idx)) {
+            heap.emplace(calculate_sorting_key(reader.record.get()), run_idx);
+        }
+    }
+}
+
 }  // namespace
 
 namespace dorado::utils {
 
-HtsFile::HtsFile(const std::string& filename, OutputMode mode, size_t threads) : m_mode(mode) {
-    switch (mode) {
+HtsFile::HtsFile(const std::string& filename, OutputMode mode, size_t threads, bool sort_bam)
+        : m_filename(filename),
+          m_threads(threads),
+          m_sort_bam(sort_bam && mode == OutputMode::BAM && filename != "-"),
+          m_mode(mode) {
+    if (m_sort_bam) {
+        // Records are buffered in memory and sorted as they're written, so we don't need to open
+        // anything until we know that the output is mapped (see set_and_write_header()).
+        m_finalise_is_noop = false;
+        return;
+    }
+    open_unsorted_file();
+}
+
+HtsFile::~HtsFile() {
+    if (!m_finalised) {
+        spdlog::error("finalise() not called on a HtsFile.");
+        // Can't throw in a dtor, and this is a logic_error rather than being data dependent.
+        std::abort();
+    }
+}
+
+void HtsFile::open_unsorted_file() {
+    switch (m_mode) {
     case OutputMode::FASTQ:
-        m_file.reset(hts_open(filename.c_str(), "wf"));
+        m_file.reset(hts_open(m_filename.c_str(), "wf"));
         hts_set_opt(m_file.get(), FASTQ_OPT_AUX, "RG");
         hts_set_opt(m_file.get(), FASTQ_OPT_AUX, "st");
         hts_set_opt(m_file.get(), FASTQ_OPT_AUX, "DS");
         break;
     case OutputMode::BAM: {
-        auto file = filename;
+        auto file = m_filename;
         if (file != "-") {
             file += ".temp";
         }
         m_file.reset(hts_open(file.c_str(), "wb"));
     } break;
     case OutputMode::SAM:
-        m_file.reset(hts_open(filename.c_str(), "w"));
+        m_file.reset(hts_open(m_filename.c_str(), "w"));
         break;
     case OutputMode::UBAM:
-        m_file.reset(hts_open(filename.c_str(), "wb0"));
+        m_file.reset(hts_open(m_filename.c_str(), "wb0"));
         break;
     default:
         throw std::runtime_error("Unknown output mode selected: " +
-                                 std::to_string(static_cast<int>(mode)));
+                                 std::to_string(static_cast<int>(m_mode)));
     }
     if (!m_file) {
-        throw std::runtime_error("Could not open file: " + filename);
+        throw std::runtime_error("Could not open file: " + m_filename);
     }
 
     if (m_file->format.compression == bgzf) {
-        auto res = bgzf_mt(m_file->fp.bgzf, int(threads), 128);
+        auto res = bgzf_mt(m_file->fp.bgzf, int(m_threads), 128);
         if (res < 0) {
             throw std::runtime_error("Could not enable multi threading for BAM generation.");
         }
     }
 
-    m_finalise_is_noop = filename == "-" || m_file->format.compression != bgzf;
+    m_finalise_is_noop = m_filename == "-" || m_file->format.compression != bgzf;
 }
 
-HtsFile::~HtsFile() {
-    if (!m_finalised) {
-        spdlog::error("finalise() not called on a HtsFile.");
-        // Can't throw in a dtor, and this is a logic_error rather than being data dependent.
-        std::abort();
+void HtsFile::set_sort_buffer_size(size_t buffer_size) {
+    assert(m_num_records == 0);
+    m_sort_buffer_size = buffer_size;
+}
+
+size_t HtsFile::sort_buffer_memory() const {
+    return m_sort_buffer.data.size() + m_sort_buffer.entries.size() * sizeof(SortBuffer::Entry);
+}
+
+size_t HtsFile::sort_buffer_memory_for(const bam1_t* const record) {
+    return padded_record_size(record) + sizeof(SortBuffer::Entry);
+}
+
+void HtsFile::flush_sort_buffer() {
+    if (!m_sort_bam || m_sort_buffer.entries.empty()) {
+        return;
     }
+    spill_sort_buffer();
+    wait_for_pending_run();
 }
 
-// When we close the underlying htsFile, then and only then can we correctly read the virtual file offsets of
-// the records (since bgzf_tell doesn't give the correct values in a write-file - see bgzf_flush, etc)
-// in order to generate a map of sort coordinates to virtual file offsets. we can then jump around in the
-// file to write out the records in the sorted order. finally we can delete the unsorted file.
-// in case an error occurs, the unsorted file is left on disk, so users can recover their data.
-void HtsFile::finalise(const ProgressCallback& progress_callback,
-                       int writer_threads,
-                       bool sort_if_mapped) {
+// When sorting, records are accumulated in an in-memory buffer. Once half of the sort buffer
+// budget has been used, the buffer is sorted and written out to a temporary run file on a
+// background thread while the other half of the budget is used to keep accepting records. In
+// finalise() the runs are merged into the output, or if everything fit in memory the buffer is
+// written out directly.
+// If an error occurs the runs are left on disk, so users can recover their data. That includes
+// records which were still in memory, which are written out to a run first.
+void HtsFile::finalise(const ProgressCallback& progress_callback, int writer_threads) {
     assert(progress_callback);
 
-    // Rough divisions of how far through we are at the start of each section.
-    constexpr size_t percent_start_sorting = 5;
-    constexpr size_t percent_start_writing = 20;
-    constexpr size_t percent_start_indexing = 95;
     progress_callback(0);
     auto on_return = utils::PostCondition([&] { progress_callback(100); });
 
-    // Helper so that we don't spam the callback.
-    auto update_progress = [&, last_progress = size_t{0}](size_t from, size_t to, size_t count,
-                                                          size_t max) mutable {
-        const size_t new_progress = from + (to - from) * std::min(count, max) / max;
-        if (new_progress != last_progress) {
-            last_progress = new_progress;
-            progress_callback(new_progress);
-        }
-    };
-
     if (std::exchange(m_finalised, true)) {
         spdlog::error("finalise() called twice on a HtsFile. Ignoring second call.");
         return;
     }
 
+    if (m_sort_bam && !m_header) {
+        // Nothing was ever written, so fall back to the unsorted path to create the (empty) file.
+        m_sort_bam = false;
+        open_unsorted_file();
+    }
+
+    if (m_sort_bam) {
+        if (write_sorted(progress_callback, writer_threads)) {
+            for (const auto& run_file : m_run_files) {
+                std::filesystem::remove(run_file);
+            }
+        }
+        return;
+    }
+
     auto temp_filename = std::string(m_file->fn);
 
     m_header.reset();
@@ -110,90 +287,132 @@ void HtsFile::finalise(const ProgressCallback& progress_callback,
         return;
     }
 
+    // No sorting was required, so just rename the file.
     std::filesystem::path filepath(temp_filename);
     filepath.replace_extension("");
+    std::filesystem::rename(temp_filename, filepath);
+}
 
-    bool file_is_mapped = false;
-    {
-        HtsFilePtr in_file(hts_open(temp_filename.c_str(), "rb"));
-        if (bgzf_mt(in_file->fp.bgzf, writer_threads, 128) < 0) {
-            spdlog::error("Could not enable multi threading for BAM reading.");
-            return;
-        }
-
-        SamHdrPtr in_header(sam_hdr_read(in_file.get()));
-        file_is_mapped = (sam_hdr_nref(in_header.get()) > 0);
-        if (file_is_mapped && sort_if_mapped) {
-            // We only need to sort and index the file if contains mapped reads.
-            HtsFilePtr out_file(hts_open(filepath.string().c_str(), "wb"));
-            if (bgzf_mt(out_file->fp.bgzf, writer_threads, 128) < 0) {
-                spdlog::error("Could not enable multi threading for BAM generation.");
-                return;
-            }
-
-            SamHdrPtr out_header(sam_hdr_dup(in_header.get()));
-            sam_hdr_change_HD(out_header.get(), "SO", "coordinate");
-            if (sam_hdr_write(out_file.get(), out_header.get()) < 0) {
-                spdlog::error("Failed to write header for sorted bam file {}", out_file->fn);
-                return;
-            }
-
-            size_t read_records = 0;
-            progress_callback(percent_start_sorting);
-
-            BamPtr record(bam_init1());
+bool HtsFile::write_sorted(const ProgressCallback& progress_callback, int writer_threads) {
+    // Rough divisions of how far through we are at the start of each section.
+    constexpr size_t percent_start_merging = 5;
+    constexpr size_t percent_start_writing = 20;
+    constexpr size_t percent_start_indexing = 95;
 
-            std::multimap<uint64_t, int64_t> record_map;
-            auto pos = bgzf_tell(in_file->fp.bgzf);
-            while ((sam_read1(in_file.get(), in_header.get(), record.get()) >= 0)) {
-                auto sorting_key = calculate_sorting_key(record.get());
-                record_map.insert({sorting_key, pos});
-                pos = bgzf_tell(in_file->fp.bgzf);
+    // Helper so that we don't spam the callback.
+    size_t processed_records = 0;
+    auto on_record_written = [&, last_progress = size_t{0}]() mutable {
+        ++processed_records;
+        const size_t new_progress =
+                percent_start_writing + (percent_start_indexing - percent_start_writing) *
+                                                std::min(processed_records, m_num_records) /
+                                                std::max(m_num_records, size_t{1});
+        if (new_progress != last_progress) {
+            last_progress = new_progress;
+            progress_callback(new_progress);
+        }
+    };
 
-                ++read_records;
-                update_progress(percent_start_sorting, percent_start_writing, read_records,
-                                m_num_records);
+    try {
+        if (!m_run_files.empty()) {
+            // Flush whatever is left so that everything can be merged from disk.
+            if (!m_sort_buffer.entries.empty()) {
+                spill_sort_buffer();
             }
+            wait_for_pending_run();
+        }
 
-            size_t processed_records = 0;
-            progress_callback(percent_start_writing);
-
-            for (auto [sorting_key, record_offset] : record_map) {
-                if (bgzf_seek(in_file->fp.bgzf, record_offset, SEEK_SET) < 0) {
-                    spdlog::error("Failed to seek in file {}, record offset {}", in_file->fn,
-                                  record_offset);
-                    return;
+        // Merge runs together in batches until there are few enough to merge into the output.
+        progress_callback(percent_start_merging);
+        while (m_run_files.size() > MAX_MERGE_FAN_IN) {
+            std::vector<std::string> merged_runs;
+            for (size_t first = 0; first < m_run_files.size(); first += MAX_MERGE_FAN_IN) {
+                const size_t last = std::min(first + MAX_MERGE_FAN_IN, m_run_files.size());
+                std::vector<std::string> batch(m_run_files.begin() + first,
+                                               m_run_files.begin() + last);
+                if (batch.size() == 1) {
+                    merged_runs.push_back(batch.front());
+                    continue;
                 }
-                if (sam_read1(in_file.get(), in_header.get(), record.get()) < 0) {
-                    spdlog::error("Failed to read from temporary file {}", in_file->fn);
-                    return;
-                }
-                if (sam_write1(out_file.get(), out_header.get(), record.get()) < 0) {
-                    spdlog::error("Failed to write to sorted file {}", out_file->fn);
-                    return;
+
+                auto merged_run = next_run_filename();
+                HtsFilePtr run_file(hts_open(merged_run.c_str(), "wb1"));
+                if (!run_file || bgzf_mt(run_file->fp.bgzf, writer_threads, 128) < 0 ||
+                    sam_hdr_write(run_file.get(), m_header.get()) < 0) {
+                    throw std::runtime_error("Could not create sorted run " + merged_run);
                 }
+                merge_runs(batch, run_file.get(), m_header.get(), writer_threads, [] {});
+                run_file.reset();
 
-                processed_records++;
-                update_progress(percent_start_writing, percent_start_indexing, processed_records,
-                                m_num_records);
+                for (const auto& run : batch) {
+                    std::filesystem::remove(run);
+                }
+                merged_runs.push_back(std::move(merged_run));
             }
+            m_run_files = std::move(merged_runs);
         }
+    } catch (const std::exception& e) {
+        spdlog::error("Failed to sort records for {}: {}", m_filename, e.what());
+        keep_sort_buffer_on_disk();
+        return false;
     }
 
-    if (file_is_mapped && sort_if_mapped) {
-        progress_callback(percent_start_indexing);
-        if (sam_index_build(filepath.string().c_str(), 0) < 0) {
-            spdlog::error("Failed to build index for file {}", filepath.string());
-            return;
+    progress_callback(percent_start_writing);
+    {
+        HtsFilePtr out_file(hts_open(m_filename.c_str(), "wb"));
+        if (!out_file) {
+            spdlog::error("Could not open file: {}", m_filename);
+            keep_sort_buffer_on_disk();
+            return false;
+        }
+        if (bgzf_mt(out_file->fp.bgzf, writer_threads, 128) < 0) {
+            spdlog::error("Could not enable multi threading for BAM generation.");
+            keep_sort_buffer_on_disk();
+            return false;
+        }
+        if (sam_hdr_write(out_file.get(), m_header.get()) < 0) {
+            spdlog::error("Failed to write header for sorted bam file {}", out_file->fn);
+            keep_sort_buffer_on_disk();
+            return false;
+        }
+
+        try {
+            if (m_run_files.empty()) {
+                // Everything fit in memory, so there's no need to go via disk.
+                write_sorted_buffer(m_sort_buffer, out_file.get(), m_header.get(), writer_threads,
+                                    on_record_written);
+            } else {
+                merge_runs(m_run_files, out_file.get(), m_header.get(), writer_threads,
+                           on_record_written);
+            }
+        } catch (const std::exception& e) {
+            spdlog::error("{}", e.what());
+            keep_sort_buffer_on_disk();
+            return false;
         }
-        std::filesystem::remove(temp_filename);
-    } else {
-        // No sorting was required, so just rename the file.
-        std::filesystem::rename(temp_filename, filepath);
     }
+    m_sort_buffer = {};
+    m_header.reset();
+
+    progress_callback(percent_start_indexing);
+    if (sam_index_build(m_filename.c_str(), 0) < 0) {
+        spdlog::error("Failed to build index for file {}", m_filename);
+        return false;
+    }
+    return true;
 }
 
 int HtsFile::set_and_write_header(const sam_hdr_t* const header) {
+    if (m_sort_bam) {
+        if (header && sam_hdr_nref(header) > 0) {
+            // The header is only written out once the records have been sorted.
+            m_header.reset(sam_hdr_dup(header));
+            return sam_hdr_change_HD(m_header.get(), "SO", "coordinate");
+        }
+        // We only need to sort the file if it contains mapped reads.
+        m_sort_bam = false;
+        open_unsorted_file();
+    }
     if (header) {
         m_header.reset(sam_hdr_dup(header));
         return sam_hdr_write(m_file.get(), m_header.get());
@@ -209,7 +428,112 @@ int HtsFile::write(const bam1_t* const record) {
         assert(m_header);
     }
     ++m_num_records;
+    if (m_sort_bam) {
+        try {
+            buffer_record(record);
+        } catch (const std::exception& e) {
+            spdlog::error("Failed to write sorted run for {}: {}", m_filename, e.what());
+            return -1;
+        }
+        return 0;
+    }
     return sam_write1(m_file.get(), m_header.get(), record);
 }
 
+void HtsFile::buffer_record(const bam1_t* const record) {
+    // Store the core followed by the variable length data, padded so the next record is aligned.
+    const size_t padded_size = padded_record_size(record);
+
+    auto& buffer = m_sort_buffer;
+    const size_t offset = buffer.data.size();
+    buffer.data.resize(offset + padded_size);
+    std::memcpy(buffer.data.data() + offset, &record->core, sizeof(bam1_core_t));
+    std::memcpy(buffer.data.data() + offset + sizeof(bam1_core_t), record->data, record->l_data);
+    buffer.entries.push_back(
+            {calculate_sorting_key(record), offset, static_cast<uint32_t>(record->l_data)});
+
+    // Half of the budget is for the buffer being filled, the other half for the run being written.
+    if (buffer.data.size() >= m_sort_buffer_size / 2) {
+        spill_sort_buffer();
+    }
+}
+
+void HtsFile::wait_for_pending_run() {
+    if (m_pending_run.valid()) {
+        // Rethrows any error that happened while writing the run.
+        m_pending_run.get();
+    }
+}
+
+void HtsFile::spill_sort_buffer() {
+    // Only allow a single run to be in flight so that we stay within the memory budget.
+    wait_for_pending_run();
+
+    auto run_filename = next_run_filename();
+    m_run_files.push_back(run_filename);
+
+    auto write_run = [buffer = std::move(m_sort_buffer), header = m_header.get(),
+                      threads = int(m_threads), filename = std::move(run_filename)]() mutable {
+        HtsFilePtr run_file(hts_open(filename.c_str(), "wb1"));
+        if (!run_file) {
+            throw std::runtime_error("Could not open file: " + filename);
+        }
+        if (bgzf_mt(run_file->fp.bgzf, threads, 128) < 0) {
+            throw std::runtime_error("Could not enable multi threading for BAM generation.");
+        }
+        if (sam_hdr_write(run_file.get(), header) < 0) {
+            throw std::runtime_error("Failed to write header for sorted run " + filename);
+        }
+        write_sorted_buffer(buffer, run_file.get(), header, threads, [] {});
+    };
+    m_pending_run = std::async(std::launch::async, std::move(write_run));
+
+    m_sort_buffer.entries.clear();
+    m_sort_buffer.data.clear();
+}
+
+// Called when the sorted output couldn't be written. Records that were only held in memory are
+// written to a run, so that they're left on disk along with any other runs.
+void HtsFile::keep_sort_buffer_on_disk() {
+    try {
+        if (!m_sort_buffer.entries.empty()) {
+            spill_sort_buffer();
+        }
+        wait_for_pending_run();
+    } catch (const std::exception& e) {
+        spdlog::error("Failed to write sorted run for {}: {}", m_filename, e.what());
+        return;
+    }
+    for (const auto& run_file : m_run_files) {
+        spdlog::error("Sorted records for {} have been left in {}", m_filename, run_file);
+    }
+}
+
+std::string HtsFile::next_run_filename() {
+    return m_filename + "." + std::to_string(m_num_runs_created++) + ".tmp";
+}
+
+void HtsFile::write_sorted_buffer(SortBuffer& buffer,
+                                  htsFile* const file,
+                                  const sam_hdr_t* const header,
+                                  int threads,
+                                  const std::function<void()>& on_record_written) {
+    // A stable sort keeps records with the same key in the order they were written.
+    parallel_stable_sort(buffer.entries, threads);
+
+    for (const auto& entry : buffer.entries) {
+        // Point a record at the buffered data rather than copying it out.
+        auto* const record_data = buffer.data.data() + entry.offset;
+        bam1_t record{};
+        std::memcpy(&record.core, record_data, sizeof(bam1_core_t));
+        record.data = record_data + sizeof(bam1_core_t);
+        record.l_data = static_cast<int>(entry.data_size);
+        record.m_data = entry.data_size;
+        if (sam_write1(file, header, &record) < 0) {
+            throw std::runtime_error(std::string("Failed to write to sorted file ") + file->fn);
+        }
+        on_record_written();
+    }
+}
+
 }  // namespace dorado::utils
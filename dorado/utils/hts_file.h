@@ -2,8 +2,11 @@
 
 #include "types.h"
 
+#include <cstdint>
 #include <functional>
+#include <future>
 #include <string>
+#include <vector>
 
 namespace dorado::utils {
 
@@ -18,28 +21,78 @@ public:
 
     using ProgressCallback = std::function<void(size_t percentage)>;
 
-    HtsFile(const std::string& filename, OutputMode mode, size_t threads);
+    // Default amount of memory used to buffer records for sorting before they are spilled to disk.
+    // Commands that write several files at once share this budget between them.
+    static constexpr size_t DEFAULT_SORT_BUFFER_SIZE = 1'000'000'000;
+
+    // If |sort_bam| is set and the output is a mapped BAM file then records are sorted by
+    // coordinate as they are written, and the sorted output is indexed in finalise().
+    HtsFile(const std::string& filename, OutputMode mode, size_t threads, bool sort_bam);
     ~HtsFile();
     HtsFile(const HtsFile&) = delete;
     HtsFile& operator=(const HtsFile&) = delete;
 
+    // Set the total amount of memory that can be used to buffer records for sorting.
+    // Must be called before any records are written.
+    void set_sort_buffer_size(size_t buffer_size);
+
+    // The memory used by the records that are currently buffered for sorting.
+    size_t sort_buffer_memory() const;
+    // The extra memory that buffering |record| for sorting would use.
+    static size_t sort_buffer_memory_for(const bam1_t* record);
+    // Write the records that are buffered for sorting out to a temporary run, releasing their
+    // memory. Lets several files share a single budget, see BarcodeDemuxerNode.
+    void flush_sort_buffer();
+
     int set_and_write_header(const sam_hdr_t* header);
     int write(const bam1_t* record);
 
     bool finalise_is_noop() const { return m_finalise_is_noop; }
-    void finalise(const ProgressCallback& progress_callback,
-                  int writer_threads,
-                  bool sort_if_mapped);
+    void finalise(const ProgressCallback& progress_callback, int writer_threads);
 
     OutputMode get_output_mode() const { return m_mode; }
 
 private:
+    // A sorted run of records, held in memory until it's written out.
+    struct SortBuffer {
+        struct Entry {
+            uint64_t sorting_key;
+            size_t offset;
+            uint32_t data_size;
+        };
+        std::vector<Entry> entries;
+        std::vector<uint8_t> data;
+    };
+
+    void open_unsorted_file();
+    void buffer_record(const bam1_t* record);
+    void wait_for_pending_run();
+    void spill_sort_buffer();
+    void keep_sort_buffer_on_disk();
+    std::string next_run_filename();
+    bool write_sorted(const ProgressCallback& progress_callback, int writer_threads);
+    // Sorts |buffer| on up to |threads| threads and writes it to |file|.
+    static void write_sorted_buffer(SortBuffer& buffer,
+                                    htsFile* file,
+                                    const sam_hdr_t* header,
+                                    int threads,
+                                    const std::function<void()>& on_record_written);
+
+    const std::string m_filename;
+    const size_t m_threads;
     HtsFilePtr m_file;
     SamHdrPtr m_header;
     size_t m_num_records{0};
     bool m_finalised{false};
     bool m_finalise_is_noop;
+    bool m_sort_bam;
     const OutputMode m_mode;
+
+    size_t m_sort_buffer_size{DEFAULT_SORT_BUFFER_SIZE};
+    SortBuffer m_sort_buffer;
+    std::vector<std::string> m_run_files;
+    size_t m_num_runs_created{0};
+    std::future<void> m_pending_run;
 };
 
 }  // namespace dorado::utils
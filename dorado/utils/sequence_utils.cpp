@@ -1,10 +1,10 @@
 #include "sequence_utils.h"
 
+#include "PairwiseOverlapper.h"
 #include "simd.h"
 #include "types.h"
 
 #include <edlib.h>
-#include <minimap.h>
 #include <nvtx3/nvtx3.hpp>
 #include <spdlog/spdlog.h>
 
@@ -262,51 +262,12 @@ std::vector<uint64_t> moves_to_map(const std::vector<uint8_t>& moves,
 }
 
 OverlapResult compute_overlap(const std::string& query_seq, const std::string& target_seq) {
-    OverlapResult overlap_result = {false, 0, 0, 0, 0};
-
-    // Add mm2 based overlap check.
-    mm_idxopt_t m_idx_opt;
-    mm_mapopt_t m_map_opt;
-    mm_set_opt(0, &m_idx_opt, &m_map_opt);
-    mm_set_opt("map-hifi", &m_idx_opt, &m_map_opt);
-
-    std::vector<const char*> seqs = {query_seq.c_str()};
-    std::vector<const char*> names = {"query"};
-    mm_idx_t* m_index = mm_idx_str(m_idx_opt.w, m_idx_opt.k, 0, m_idx_opt.bucket_bits, 1,
-                                   seqs.data(), names.data());
-    mm_mapopt_update(&m_map_opt, m_index);
-
-    MmTbufPtr mbuf = MmTbufPtr(mm_tbuf_init());
-
-    int hits = 0;
-    mm_reg1_t* reg = mm_map(m_index, int(target_seq.length()), target_seq.c_str(), &hits,
-                            mbuf.get(), &m_map_opt, "target");
-
-    mm_idx_destroy(m_index);
-
-    if (hits > 0) {
-        int32_t target_start = 0;
-        int32_t target_end = 0;
-        int32_t query_start = 0;
-        int32_t query_end = 0;
-
-        auto best_map = std::max_element(
-                reg, reg + hits,
-                [](const mm_reg1_t& l, const mm_reg1_t& r) { return l.mapq < r.mapq; });
-        target_start = best_map->rs;
-        target_end = best_map->re;
-        query_start = best_map->qs;
-        query_end = best_map->qe;
-
-        overlap_result = {true, target_start, target_end, query_start, query_end};
+    PairwiseOverlapper overlapper;
+    const auto overlap = overlapper.overlap(query_seq, "query", target_seq, "target");
+    if (overlap.num_hits == 0) {
+        return {false, 0, 0, 0, 0};
     }
-
-    for (int i = 0; i < hits; ++i) {
-        free(reg[i].p);
-    }
-    free(reg);
-
-    return overlap_result;
+    return {true, overlap.ref_start, overlap.ref_end, overlap.query_start, overlap.query_end};
 }
 
 // Query is the read that the moves table is associated with. A new moves table will be generated
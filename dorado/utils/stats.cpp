@@ -1,5 +1,8 @@
 #include "stats.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <ostream>
 #include <set>
 
@@ -105,4 +108,86 @@ void StatsSampler::sampling_thread_fn() {
     }
 }
 
+void LatencyHistogram::record(Duration duration, uint64_t count) {
+    if (count == 0) {
+        return;
+    }
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    const uint64_t value_ns = ns > 0 ? uint64_t(ns) : 0;
+    m_buckets[bucket_index(value_ns)].fetch_add(count, std::memory_order_relaxed);
+    m_count.fetch_add(count, std::memory_order_relaxed);
+    m_total_ns.fetch_add(value_ns * count, std::memory_order_relaxed);
+    uint64_t max_ns = m_max_ns.load(std::memory_order_relaxed);
+    while (value_ns > max_ns &&
+           !m_max_ns.compare_exchange_weak(max_ns, value_ns, std::memory_order_relaxed)) {
+    }
+}
+
+double LatencyHistogram::percentile_ms(double fraction) const {
+    // Snapshot the buckets, since other threads may be recording as we go.
+    std::array<uint64_t, kNumBuckets> counts;
+    uint64_t total_count = 0;
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+        counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+        total_count += counts[i];
+    }
+    if (total_count == 0) {
+        return 0.0;
+    }
+
+    const auto rank = std::max(
+            uint64_t(std::ceil(std::clamp(fraction, 0.0, 1.0) * double(total_count))), uint64_t(1));
+    uint64_t cumulative_count = 0;
+    size_t index = 0;
+    for (; index < kNumBuckets; ++index) {
+        cumulative_count += counts[index];
+        if (cumulative_count >= rank) {
+            break;
+        }
+    }
+    // The bucket's upper bound can exceed anything actually recorded.
+    const auto value_ns = std::min(bucket_upper_bound(index), m_max_ns.load());
+    return double(value_ns) / 1e6;
+}
+
+void LatencyHistogram::add_to_stats(NamedStats& stats, const std::string& prefix) const {
+    const auto num_recorded = count();
+    stats[prefix + "_count"] = double(num_recorded);
+    stats[prefix + "_mean_ms"] =
+            num_recorded > 0 ? double(m_total_ns.load()) / double(num_recorded) / 1e6 : 0.0;
+    stats[prefix + "_p50_ms"] = percentile_ms(0.5);
+    stats[prefix + "_p90_ms"] = percentile_ms(0.9);
+    stats[prefix + "_p99_ms"] = percentile_ms(0.99);
+    stats[prefix + "_max_ms"] = double(m_max_ns.load()) / 1e6;
+}
+
+// Values below kSubBuckets get a bucket each.  Above that, each power of 2 is split into
+// kSubBuckets buckets according to the bits following the most significant bit.
+size_t LatencyHistogram::bucket_index(uint64_t value_ns) {
+    if (value_ns < kSubBuckets) {
+        return size_t(value_ns);
+    }
+    int msb = 0;
+    for (int step = 32; step > 0; step /= 2) {
+        if (value_ns >> (msb + step)) {
+            msb += step;
+        }
+    }
+    const int shift = msb - kSubBucketBits;
+    return size_t(shift + 1) * kSubBuckets + size_t((value_ns >> shift) & (kSubBuckets - 1));
+}
+
+uint64_t LatencyHistogram::bucket_upper_bound(size_t index) {
+    if (index < kSubBuckets) {
+        return uint64_t(index);
+    }
+    const auto shift = int(index / kSubBuckets) - 1;
+    const uint64_t mantissa = kSubBuckets | (index % kSubBuckets);
+    // Saturate rather than overflow for the last bucket.
+    if (shift + kSubBucketBits >= 63 && mantissa == 2 * kSubBuckets - 1) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    return ((mantissa + 1) << shift) - 1;
+}
+
 }  // namespace dorado::stats
\ No newline at end of file
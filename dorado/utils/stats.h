@@ -1,7 +1,9 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <functional>
 #include <iosfwd>
 #include <optional>
@@ -92,5 +94,40 @@ private:
     std::chrono::time_point<std::chrono::system_clock> m_start_time;
 };
 
+// Lock-free histogram of durations, for recording latencies from many threads at once.
+// Buckets are log-spaced, with kSubBuckets buckets per power of 2 nanoseconds, so reported
+// percentiles are accurate to within 1 / kSubBuckets of their value.
+// Recorded values accumulate for the lifetime of the histogram.
+class LatencyHistogram {
+public:
+    using Duration = std::chrono::steady_clock::duration;
+
+    // Records count occurrences of duration.
+    void record(Duration duration, uint64_t count = 1);
+
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+
+    // Returns the duration in ms that fraction (in [0, 1]) of the recorded durations are at or
+    // below, or 0 if nothing has been recorded.
+    double percentile_ms(double fraction) const;
+
+    // Adds <prefix>_count, <prefix>_mean_ms, <prefix>_max_ms and the <prefix>_p50_ms, _p90_ms
+    // and _p99_ms percentiles to stats.
+    void add_to_stats(NamedStats& stats, const std::string& prefix) const;
+
+private:
+    static constexpr int kSubBucketBits = 3;
+    static constexpr uint64_t kSubBuckets = uint64_t(1) << kSubBucketBits;
+    static constexpr size_t kNumBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+    static size_t bucket_index(uint64_t value_ns);
+    static uint64_t bucket_upper_bound(size_t index);
+
+    std::array<std::atomic<uint64_t>, kNumBuckets> m_buckets{};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_total_ns{0};
+    std::atomic<uint64_t> m_max_ns{0};
+};
+
 }  // namespace stats
 }  // namespace dorado
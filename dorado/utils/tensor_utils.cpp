@@ -5,9 +5,13 @@
 #include <torch/csrc/jit/serialization/pickle.h>
 #include <torch/torch.h>
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <stdexcept>
 #include <vector>
 
 namespace {
@@ -64,6 +68,82 @@ __attribute__((target("avx2,f16c"))) void convert_f32_to_f16_impl(c10::Half* con
 }
 #endif
 
+#if ENABLE_AVX2_IMPL
+__attribute__((target("default")))
+#endif
+void convert_i16_to_f16_impl(c10::Half* const dest,
+                             const std::int16_t* const src,
+                             std::size_t count,
+                             float shift,
+                             float scale,
+                             bool divide) {
+    for (size_t i = 0; i < count; ++i) {
+        const float elem = static_cast<float>(src[i]);
+        dest[i] = c10::Half(divide ? (elem - shift) / scale : (elem + shift) * scale);
+    }
+}
+
+#if ENABLE_AVX2_IMPL
+// Shifts and scales 8 int16 elements in float32, converting the results to float16.
+__attribute__((target("avx2,f16c"))) __m128i convert_8_i16_to_f16(const std::int16_t* const src,
+                                                                  __m256 shift,
+                                                                  __m256 scale,
+                                                                  bool divide) {
+    // Matches torch behaviour.
+    const int kRoundNearestEven = 0;
+
+    const __m128i elems_i16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    const __m256 elems_f32 = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(elems_i16));
+    const __m256 result = divide ? _mm256_div_ps(_mm256_sub_ps(elems_f32, shift), scale)
+                                 : _mm256_mul_ps(_mm256_add_ps(elems_f32, shift), scale);
+    return _mm256_cvtps_ph(result, kRoundNearestEven);
+}
+
+__attribute__((target("avx2,f16c"))) void convert_i16_to_f16_impl(c10::Half* const dest,
+                                                                  const std::int16_t* const src,
+                                                                  std::size_t count,
+                                                                  float shift,
+                                                                  float scale,
+                                                                  bool divide) {
+    // Unroll to AVX register size: 8 floats.
+    static constexpr size_t kUnroll = 8;
+
+    const __m256 shift_vec = _mm256_set1_ps(shift);
+    const __m256 scale_vec = _mm256_set1_ps(scale);
+
+    // Main vectorised loop: 8 elements per iteration.
+    const size_t vectorised_count = count - count % kUnroll;
+    for (size_t i = 0; i < vectorised_count; i += kUnroll) {
+        const __m128i elems_f16 = convert_8_i16_to_f16(&src[i], shift_vec, scale_vec, divide);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), elems_f16);
+    }
+
+    // Pad the final 0-7 elements out to a full vector.
+    const size_t remaining_count = count - vectorised_count;
+    if (remaining_count > 0) {
+        std::int16_t src_tail[kUnroll] = {};
+        c10::Half dest_tail[kUnroll];
+        std::memcpy(src_tail, &src[vectorised_count], remaining_count * sizeof(std::int16_t));
+        const __m128i elems_f16 = convert_8_i16_to_f16(src_tail, shift_vec, scale_vec, divide);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest_tail), elems_f16);
+        std::memcpy(&dest[vectorised_count], dest_tail, remaining_count * sizeof(c10::Half));
+    }
+}
+#endif
+
+// Returns the index of the lower median in a histogram of the given number of elements.
+size_t lower_median_bin(const std::vector<size_t>& counts, size_t num_elems) {
+    const size_t median_rank = (num_elems - 1) / 2;
+    size_t total = 0;
+    for (size_t bin = 0; bin < counts.size(); ++bin) {
+        total += counts[bin];
+        if (total > median_rank) {
+            return bin;
+        }
+    }
+    throw std::logic_error("Histogram holds fewer elements than expected");
+}
+
 }  // namespace
 
 namespace dorado::utils {
@@ -137,6 +217,40 @@ at::Tensor quantile_counting(const at::Tensor t, const at::Tensor q) {
     return res;
 }
 
+std::pair<int, int> median_mad_counting(const at::Tensor& t) {
+    assert(t.dtype() == at::ScalarType::Short);
+
+    const auto contiguous = t.contiguous();
+    const auto* const p = contiguous.data_ptr<int16_t>();
+    const size_t size = contiguous.numel();
+    if (size == 0) {
+        throw std::runtime_error("median_mad_counting: tensor is empty");
+    }
+
+    // Finding the values directly, rather than with std::minmax_element, lets this vectorise.
+    int16_t range_min = p[0];
+    int16_t range_max = p[0];
+    for (size_t i = 1; i < size; ++i) {
+        range_min = std::min(range_min, p[i]);
+        range_max = std::max(range_max, p[i]);
+    }
+
+    std::vector<size_t> counts(range_max - range_min + 1, 0);
+    for (size_t i = 0; i < size; ++i) {
+        counts[p[i] - range_min]++;
+    }
+    const int median = range_min + int(lower_median_bin(counts, size));
+
+    // The absolute deviations are counted from the histogram rather than the elements.
+    std::vector<size_t> deviation_counts(std::max(median - range_min, range_max - median) + 1, 0);
+    for (size_t bin = 0; bin < counts.size(); ++bin) {
+        deviation_counts[std::abs(range_min + int(bin) - median)] += counts[bin];
+    }
+    const int mad = int(lower_median_bin(deviation_counts, size));
+
+    return {median, mad};
+}
+
 // Multiversioned function dispatch doesn't work across the dorado_lib linking
 // boundary.  Without this wrapper, AVX machines still only execute the default
 // version.
@@ -144,6 +258,22 @@ void convert_f32_to_f16(c10::Half* const dest, const float* const src, std::size
     return convert_f32_to_f16_impl(dest, src, count);
 }
 
+void convert_i16_to_f16_scaled(c10::Half* const dest,
+                               const std::int16_t* const src,
+                               std::size_t count,
+                               float shift,
+                               float scale) {
+    return convert_i16_to_f16_impl(dest, src, count, shift, scale, false);
+}
+
+void convert_i16_to_f16_normalised(c10::Half* const dest,
+                                   const std::int16_t* const src,
+                                   std::size_t count,
+                                   float shift,
+                                   float scale) {
+    return convert_i16_to_f16_impl(dest, src, count, shift, scale, true);
+}
+
 void copy_tensor_elems(at::Tensor& dest_tensor,
                        std::size_t dest_offset,
                        const at::Tensor& src_tensor,
@@ -3,8 +3,10 @@
 #include <ATen/core/TensorBody.h>
 
 #include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace dorado::utils {
@@ -25,10 +27,30 @@ at::Tensor quantile(const at::Tensor t, const at::Tensor q);
 // Only `interpolation='lower'` is currently implemented.
 at::Tensor quantile_counting(const at::Tensor t, const at::Tensor q);
 
+// Computes the median and median absolute deviation of the int16 tensor `t`
+// using counting sorts, returned as a pair {median, mad}.
+// As with at::median, the lower median is taken for an even number of elements.
+std::pair<int, int> median_mad_counting(const at::Tensor& t);
+
 // Converts count float elements pointed to by src to half precision, with
 // the result pointed to by dest.
 void convert_f32_to_f16(c10::Half* dest, const float* src, std::size_t count);
 
+// Converts count int16 elements pointed to by src to half precision, computing
+// (x + shift) * scale in float32 for each, with the result pointed to by dest.
+void convert_i16_to_f16_scaled(c10::Half* dest,
+                               const std::int16_t* src,
+                               std::size_t count,
+                               float shift,
+                               float scale);
+
+// As convert_i16_to_f16_scaled, but computing (x - shift) / scale.
+void convert_i16_to_f16_normalised(c10::Half* dest,
+                                   const std::int16_t* src,
+                                   std::size_t count,
+                                   float shift,
+                                   float scale);
+
 // Copies count elements from src_offset elements into src to
 // dest_elements into dst.  The tensors must be contiguous.
 void copy_tensor_elems(at::Tensor& dest_tensor,
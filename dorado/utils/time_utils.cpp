@@ -4,7 +4,103 @@
 #include <date/tz.h>
 
 #include <chrono>
+#include <cstdint>
+#include <optional>
 #include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// Days since the epoch of a date in the proleptic Gregorian calendar.
+int64_t days_from_civil(int64_t year, int month, int day) {
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const int64_t year_of_era = year - era * 400;
+    const int64_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int64_t day_of_era =
+            year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+int days_in_month(int year, int month) {
+    static constexpr int DAYS[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    const bool leap_year = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return month == 2 && leap_year ? 29 : DAYS[month - 1];
+}
+
+// Parses the fixed width form of the time stamps written by MinKNOW and dorado, such as
+// "2017-09-12T09:50:12.456+00:00" or "2017-09-12T09:50:12Z", without going through a stream.
+// Anything else gives std::nullopt, and is left to date::parse.
+std::optional<std::chrono::microseconds> parse_fixed_width_time_stamp(std::string_view time_stamp) {
+    auto read_digits = [time_stamp](size_t pos, size_t count, int& value) {
+        if (pos + count > time_stamp.size()) {
+            return false;
+        }
+        value = 0;
+        for (size_t i = pos; i < pos + count; ++i) {
+            const char c = time_stamp[i];
+            if (c < '0' || c > '9') {
+                return false;
+            }
+            value = value * 10 + (c - '0');
+        }
+        return true;
+    };
+    auto is_char = [time_stamp](size_t pos, char c) {
+        return pos < time_stamp.size() && time_stamp[pos] == c;
+    };
+
+    int year, month, day, hours, minutes, seconds;
+    if (!read_digits(0, 4, year) || !is_char(4, '-') || !read_digits(5, 2, month) ||
+        !is_char(7, '-') || !read_digits(8, 2, day) || !is_char(10, 'T') ||
+        !read_digits(11, 2, hours) || !is_char(13, ':') || !read_digits(14, 2, minutes) ||
+        !is_char(16, ':') || !read_digits(17, 2, seconds)) {
+        return std::nullopt;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > days_in_month(year, month) || hours > 23 ||
+        minutes > 59 || seconds > 59) {
+        return std::nullopt;
+    }
+
+    size_t pos = 19;
+    int64_t microseconds = 0;
+    if (is_char(pos, '.')) {
+        size_t num_digits = 0;
+        for (++pos; pos < time_stamp.size() && time_stamp[pos] >= '0' && time_stamp[pos] <= '9';
+             ++pos) {
+            if (++num_digits > 6) {
+                return std::nullopt;
+            }
+            microseconds = microseconds * 10 + (time_stamp[pos] - '0');
+        }
+        if (num_digits == 0) {
+            return std::nullopt;
+        }
+        for (; num_digits < 6; ++num_digits) {
+            microseconds *= 10;
+        }
+    }
+
+    int64_t offset_minutes = 0;
+    if (is_char(pos, '+') || is_char(pos, '-')) {
+        int offset_hours, offset_mins;
+        if (pos + 6 != time_stamp.size() || !read_digits(pos + 1, 2, offset_hours) ||
+            !is_char(pos + 3, ':') || !read_digits(pos + 4, 2, offset_mins) || offset_hours > 23 ||
+            offset_mins > 59) {
+            return std::nullopt;
+        }
+        offset_minutes = (is_char(pos, '-') ? -1 : 1) * (offset_hours * 60 + offset_mins);
+    } else if (!is_char(pos, 'Z') || pos + 1 != time_stamp.size()) {
+        return std::nullopt;
+    }
+
+    const int64_t minutes_since_epoch =
+            (days_from_civil(year, month, day) * 24 + hours) * 60 + minutes - offset_minutes;
+    return std::chrono::microseconds((minutes_since_epoch * 60 + seconds) * 1'000'000 +
+                                     microseconds);
+}
+
+}  // namespace
 
 namespace dorado::utils {
 
@@ -23,19 +119,26 @@ std::string get_string_timestamp_from_unix_time(time_t time_stamp_ms) {
 // Expects the time to be encoded like "2017-09-12T09:50:12.456+00:00" or "2017-09-12T09:50:12Z".
 // Time stamp can be specified up to microseconds
 time_t get_unix_time_from_string_timestamp(const std::string & time_stamp) {
-    std::istringstream ss(time_stamp);
+    auto epoch = parse_time_stamp(time_stamp);
+    auto value = std::chrono::duration_cast<std::chrono::milliseconds>(epoch);
+    return value.count();
+}
+
+std::chrono::microseconds parse_time_stamp(std::string_view time_stamp) {
+    if (auto fixed_width = parse_fixed_width_time_stamp(time_stamp)) {
+        return *fixed_width;
+    }
+
+    std::istringstream ss{std::string(time_stamp)};
     date::sys_time<std::chrono::microseconds> time_us;
     ss >> date::parse("%FT%T%Ez", time_us);
     // If parsing with timezone offset failed, try parsing with 'Z' format
     if (ss.fail()) {
         ss.clear();
-        ss.str(time_stamp);
+        ss.str(std::string(time_stamp));
         ss >> date::parse("%FT%TZ", time_us);
     }
-
-    auto epoch = time_us.time_since_epoch();
-    auto value = std::chrono::duration_cast<std::chrono::milliseconds>(epoch);
-    return value.count();
+    return time_us.time_since_epoch();
 }
 
 std::string adjust_time_ms(const std::string & time_stamp, uint64_t offset_ms) {
@@ -62,26 +165,9 @@ std::string adjust_time(const std::string & time_stamp, uint32_t offset) {
 }
 
 double time_difference_seconds(const std::string & timestamp1, const std::string & timestamp2) {
-    using namespace date;
     using namespace std::chrono;
     try {
-        std::istringstream ss1(timestamp1);
-        std::istringstream ss2(timestamp2);
-        sys_time<microseconds> time1, time2;
-        ss1 >> parse("%FT%T%Ez", time1);
-        ss2 >> parse("%FT%T%Ez", time2);
-        // If parsing with timezone offset failed, try parsing with 'Z' format
-        if (ss1.fail()) {
-            ss1.clear();
-            ss1.str(timestamp1);
-            ss1 >> parse("%FT%TZ", time1);
-        }
-        if (ss2.fail()) {
-            ss2.clear();
-            ss2.str(timestamp2);
-            ss2 >> parse("%FT%TZ", time2);
-        }
-        duration<double> diff = time1 - time2;
+        duration<double> diff = parse_time_stamp(timestamp1) - parse_time_stamp(timestamp2);
         return diff.count();
     } catch (const std::exception & e) {
         throw std::runtime_error(std::string("Failed to parse timestamps: ") + e.what());
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <chrono>
 #include <ctime>
 #include <string>
+#include <string_view>
 
 namespace dorado::utils {
 
@@ -11,6 +13,10 @@ std::string get_string_timestamp_from_unix_time(time_t time_stamp_ms);
 // Time stamp can be specified up to microseconds
 time_t get_unix_time_from_string_timestamp(const std::string& time_stamp);
 
+// Parses a time stamp in the same formats as get_unix_time_from_string_timestamp, giving the time
+// since the epoch.  A time stamp which can't be parsed gives 0.
+std::chrono::microseconds parse_time_stamp(std::string_view time_stamp);
+
 std::string adjust_time_ms(const std::string& time_stamp, uint64_t offset_ms);
 
 std::string adjust_time(const std::string& time_stamp, uint32_t offset);
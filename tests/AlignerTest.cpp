@@ -4,14 +4,17 @@
 #include "read_pipeline/AlignerNode.h"
 #include "read_pipeline/ClientInfo.h"
 #include "read_pipeline/HtsReader.h"
+#include "read_pipeline/HtsWriter.h"
 #include "utils/PostCondition.h"
 #include "utils/bam_utils.h"
+#include "utils/hts_file.h"
 #include "utils/sequence_utils.h"
 #include "utils/string_utils.h"
 
 #include <catch2/catch.hpp>
 #include <htslib/sam.h>
 
+#include <chrono>
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
@@ -608,3 +611,50 @@ TEST_CASE_METHOD(AlignerNodeTestFixture,
     }
     CHECK_THAT(bam_aux2Z(bam_aux_get(supplementary_rec, "SA")), Equals("read3,1,+,999M899S,0,0;"));
 }
+
+TEST_CASE("AlignerTest: Check read latency is recorded for aligned records", TEST_GROUP) {
+    fs::path aligner_test_dir = fs::path(get_aligner_data_dir());
+    auto ref = aligner_test_dir / "target.fq";
+    auto query = aligner_test_dir / "target.fq";
+    auto tmp_dir = TempDir(fs::temp_directory_path() / "aligner_latency_test");
+    fs::create_directories(tmp_dir.m_path);
+    const auto out_bam = tmp_dir.m_path / "out.bam";
+
+    auto options = dorado::alignment::dflt_options;
+    options.kmer_size = options.window_size = 15;
+    options.index_batch_size = 1'000'000'000ull;
+
+    dorado::utils::HtsFile hts_file(out_bam.string(), dorado::utils::HtsFile::OutputMode::BAM, 2,
+                                    false);
+    dorado::PipelineDescriptor pipeline_desc;
+    auto writer = pipeline_desc.add_node<dorado::HtsWriter>({}, hts_file, "");
+    auto index_file_access = std::make_shared<dorado::alignment::IndexFileAccess>();
+    auto aligner = pipeline_desc.add_node<dorado::AlignerNode>({writer}, index_file_access,
+                                                               ref.string(), "", options, 2);
+    auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
+
+    const auto& aligner_ref = dynamic_cast<dorado::AlignerNode&>(pipeline->get_node_ref(aligner));
+    dorado::SamHdrPtr header(sam_hdr_init());
+    dorado::utils::add_sq_hdr(header.get(), aligner_ref.get_sequence_records_for_header());
+    hts_file.set_and_write_header(header.get());
+
+    // The aligner builds new records, which must keep the time the read entered the pipeline.
+    dorado::HtsReader reader(query.string(), std::nullopt);
+    size_t num_reads = 0;
+    while (reader.read()) {
+        dorado::BamPtr record(bam_dup1(reader.record.get()));
+        dorado::utils::set_pipeline_entry_time(record.get(), std::chrono::steady_clock::now());
+        pipeline->push_message(std::move(record));
+        ++num_reads;
+    }
+    const auto stats = pipeline->terminate({});
+    hts_file.finalise([](size_t) { /* noop */ }, 2);
+
+    REQUIRE(num_reads == 1);
+    CHECK(stats.at("HtsWriter.read_latency_count") == double(num_reads));
+
+    // Make sure that it's the aligned record that was timed.
+    dorado::HtsReader out_reader(out_bam.string(), std::nullopt);
+    REQUIRE(out_reader.read());
+    CHECK((out_reader.record->core.flag & BAM_FUNMAP) == 0);
+}
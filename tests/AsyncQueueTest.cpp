@@ -8,14 +8,23 @@
 #include <atomic>
 #include <iostream>
 #include <numeric>
+#include <string>
 #include <thread>
+#include <vector>
 
 using dorado::utils::AsyncQueue;
 using dorado::utils::AsyncQueueStatus;
+using dorado::utils::AsyncQueueType;
+
+namespace {
+
+auto generate_queue_type() { return GENERATE(AsyncQueueType::Locked, AsyncQueueType::LockFree); }
+
+}  // namespace
 
 TEST_CASE(TEST_GROUP ": InputsMatchOutputs") {
     const int n = 10;
-    AsyncQueue<int> queue(n);
+    AsyncQueue<int> queue(n, generate_queue_type());
 
     for (int i = 0; i < n; ++i) {
         const auto status = queue.try_push(std::move(i));
@@ -30,14 +39,14 @@ TEST_CASE(TEST_GROUP ": InputsMatchOutputs") {
 }
 
 TEST_CASE(TEST_GROUP ": PushFailsIfTerminating") {
-    AsyncQueue<int> queue(1);
+    AsyncQueue<int> queue(1, generate_queue_type());
     queue.terminate();
     const auto status = queue.try_push(42);
     CHECK(status == AsyncQueueStatus::Terminate);
 }
 
 TEST_CASE(TEST_GROUP ": PopFailsIfTerminating") {
-    AsyncQueue<int> queue(1);
+    AsyncQueue<int> queue(1, generate_queue_type());
     queue.terminate();
     int val;
     const auto status = queue.try_pop(val);
@@ -45,7 +54,7 @@ TEST_CASE(TEST_GROUP ": PopFailsIfTerminating") {
 }
 
 TEST_CASE(TEST_GROUP ": PushPopSucceedAfterRestarting") {
-    AsyncQueue<int> queue(1);
+    AsyncQueue<int> queue(1, generate_queue_type());
     queue.terminate();
     queue.restart();
     const auto push_status = queue.try_push(42);
@@ -58,7 +67,7 @@ TEST_CASE(TEST_GROUP ": PushPopSucceedAfterRestarting") {
 // Spawned thread sits waiting for an item.
 // Main thread supplies that item.
 TEST_CASE(TEST_GROUP ": PopFromOtherThread") {
-    AsyncQueue<int> queue(1);
+    AsyncQueue<int> queue(1, generate_queue_type());
     std::atomic_bool thread_started{false};
     AsyncQueueStatus pop_status;
 
@@ -85,7 +94,7 @@ TEST_CASE(TEST_GROUP ": PopFromOtherThread") {
 // Spawned thread sits waiting for an item.
 // Main thread terminates wait.
 TEST_CASE(TEST_GROUP ": TerminateFromOtherThread") {
-    AsyncQueue<int> queue(1);
+    AsyncQueue<int> queue(1, generate_queue_type());
     std::atomic_bool thread_started{false};
     AsyncQueueStatus pop_status;
 
@@ -111,7 +120,7 @@ TEST_CASE(TEST_GROUP ": TerminateFromOtherThread") {
 
 TEST_CASE(TEST_GROUP ": process_and_pop_n") {
     const int n = 10;
-    AsyncQueue<int> queue(n);
+    AsyncQueue<int> queue(n, generate_queue_type());
     for (int i = 0; i < n; ++i) {
         const auto status = queue.try_push(std::move(i));
         REQUIRE(status == AsyncQueueStatus::Success);
@@ -134,4 +143,204 @@ TEST_CASE(TEST_GROUP ": process_and_pop_n") {
     std::iota(expected.begin(), expected.end(), 0);
     CHECK(popped_items == expected);
     CHECK(queue.size() == 0);
-}
\ No newline at end of file
+}
+
+TEST_CASE(TEST_GROUP ": PopsDrainQueueAfterTerminate") {
+    AsyncQueue<int> queue(5, generate_queue_type());
+    for (int i = 0; i < 3; ++i) {
+        REQUIRE(queue.try_push(std::move(i)) == AsyncQueueStatus::Success);
+    }
+    queue.terminate();
+
+    int val = -1;
+    for (int i = 0; i < 3; ++i) {
+        REQUIRE(queue.try_pop(val) == AsyncQueueStatus::Success);
+        CHECK(val == i);
+    }
+    CHECK(queue.try_pop(val) == AsyncQueueStatus::Terminate);
+    CHECK(queue.size() == 0);
+}
+
+TEST_CASE(TEST_GROUP ": PopTimesOutWhenEmpty") {
+    AsyncQueue<int> queue(1, generate_queue_type());
+    int val = -1;
+    const auto timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+    CHECK(queue.try_pop_until(val, timeout) == AsyncQueueStatus::Timeout);
+    CHECK(queue.process_and_pop_n_with_timeout([](int) {}, 10, timeout) ==
+          AsyncQueueStatus::Timeout);
+}
+
+// Pushes to a full queue block until an item is popped.
+TEST_CASE(TEST_GROUP ": PushBlocksWhenFull") {
+    AsyncQueue<int> queue(2, generate_queue_type());
+    REQUIRE(queue.try_push(0) == AsyncQueueStatus::Success);
+    REQUIRE(queue.try_push(1) == AsyncQueueStatus::Success);
+
+    std::atomic_bool pushed{false};
+    auto pushing_thread = std::thread([&]() {
+        queue.try_push(2);
+        pushed.store(true);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(!pushed.load());
+
+    int val = -1;
+    REQUIRE(queue.try_pop(val) == AsyncQueueStatus::Success);
+    pushing_thread.join();
+    CHECK(pushed.load());
+    CHECK(queue.size() == 2);
+}
+
+TEST_CASE(TEST_GROUP ": StatsCountPushesAndPops") {
+    AsyncQueue<int> queue(10, generate_queue_type());
+    for (int i = 0; i < 4; ++i) {
+        REQUIRE(queue.try_push(std::move(i)) == AsyncQueueStatus::Success);
+    }
+    int val = -1;
+    REQUIRE(queue.try_pop(val) == AsyncQueueStatus::Success);
+    REQUIRE(queue.process_and_pop_n([](int) {}, 2) == AsyncQueueStatus::Success);
+
+    const auto stats = queue.sample_stats();
+    CHECK(stats.at("pushes") == 4);
+    CHECK(stats.at("pops") == 3);
+    CHECK(stats.at("items") == 1);
+}
+
+TEST_CASE(TEST_GROUP ": PushNInputsMatchOutputs") {
+    const int n = 10;
+    AsyncQueue<int> queue(n, generate_queue_type());
+
+    std::vector<int> items(n);
+    std::iota(items.begin(), items.end(), 0);
+    const auto expected = items;
+    REQUIRE(queue.try_push_n(std::move(items)) == AsyncQueueStatus::Success);
+    CHECK(items.empty());
+    CHECK(queue.size() == n);
+
+    std::vector<int> popped_items;
+    REQUIRE(queue.process_and_pop_n([&](int popped) { popped_items.push_back(popped); }, n) ==
+            AsyncQueueStatus::Success);
+    CHECK(popped_items == expected);
+    CHECK(queue.sample_stats().at("pushes") == n);
+}
+
+// Pushing more items than the queue can hold blocks until they have all been popped.
+TEST_CASE(TEST_GROUP ": PushNLargerThanCapacity") {
+    const int n = 100;
+    AsyncQueue<int> queue(3, generate_queue_type());
+
+    std::vector<int> popped_items;
+    auto popping_thread = std::thread([&]() {
+        int val = -1;
+        while (queue.try_pop(val) == AsyncQueueStatus::Success) {
+            popped_items.push_back(val);
+        }
+    });
+
+    std::vector<int> items(n);
+    std::iota(items.begin(), items.end(), 0);
+    const auto expected = items;
+    const auto status = queue.try_push_n(std::move(items));
+    queue.terminate();
+    popping_thread.join();
+
+    CHECK(status == AsyncQueueStatus::Success);
+    CHECK(popped_items == expected);
+}
+
+TEST_CASE(TEST_GROUP ": PushNFailsIfTerminating") {
+    AsyncQueue<int> queue(5, generate_queue_type());
+    queue.terminate();
+    CHECK(queue.try_push_n({1, 2, 3}) == AsyncQueueStatus::Terminate);
+    CHECK(queue.size() == 0);
+}
+
+namespace {
+
+// Pushes num_items values from each of num_producers threads through a queue shared with
+// num_consumers popping threads, then terminates the queue.  Returns the sum of the values popped.
+int64_t run_producers_and_consumers(AsyncQueue<int>& queue,
+                                    int num_producers,
+                                    int num_consumers,
+                                    int num_items,
+                                    bool use_process_and_pop_n) {
+    std::atomic<int64_t> popped_sum{0};
+    std::vector<std::thread> consumers;
+    for (int i = 0; i < num_consumers; ++i) {
+        consumers.emplace_back([&] {
+            int64_t sum = 0;
+            if (use_process_and_pop_n) {
+                auto process_fn = [&sum](int val) { sum += val; };
+                while (queue.process_and_pop_n(process_fn, 16) == AsyncQueueStatus::Success) {
+                }
+            } else {
+                int val = 0;
+                while (queue.try_pop(val) == AsyncQueueStatus::Success) {
+                    sum += val;
+                }
+            }
+            popped_sum += sum;
+        });
+    }
+
+    std::vector<std::thread> producers;
+    for (int i = 0; i < num_producers; ++i) {
+        producers.emplace_back([&queue, num_items] {
+            for (int val = 1; val <= num_items; ++val) {
+                queue.try_push(int(val));
+            }
+        });
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    queue.terminate();
+    for (auto& consumer : consumers) {
+        consumer.join();
+    }
+    // Leave the queue usable for the next run.
+    queue.restart();
+    return popped_sum;
+}
+
+}  // namespace
+
+TEST_CASE(TEST_GROUP ": ManyProducersAndConsumers") {
+    const auto queue_type = generate_queue_type();
+    const int num_producers = GENERATE(1, 4);
+    const int num_consumers = GENERATE(1, 4);
+    const bool use_process_and_pop_n = GENERATE(false, true);
+    CAPTURE(queue_type == AsyncQueueType::LockFree, num_producers, num_consumers,
+            use_process_and_pop_n);
+
+    constexpr int kNumItems = 10000;
+    AsyncQueue<int> queue(8, queue_type);
+    const auto popped_sum = run_producers_and_consumers(queue, num_producers, num_consumers,
+                                                        kNumItems, use_process_and_pop_n);
+    CHECK(popped_sum == int64_t(num_producers) * kNumItems * (kNumItems + 1) / 2);
+
+    const auto stats = queue.sample_stats();
+    CHECK(stats.at("pushes") == double(num_producers) * kNumItems);
+    CHECK(stats.at("pops") == double(num_producers) * kNumItems);
+}
+
+TEST_CASE(TEST_GROUP ": Benchmark contention", "[.benchmark]") {
+    const int num_threads = GENERATE(1, 2, 4, 8, 16, 32, 64);
+    constexpr int kNumItems = 100000;
+    // Spread the same total amount of work across the producers.
+    const int items_per_producer = std::max(kNumItems / num_threads, 1);
+
+    AsyncQueue<int> locked_queue(1000, AsyncQueueType::Locked);
+    BENCHMARK("Locked, " + std::to_string(num_threads) + " producers/consumers") {
+        return run_producers_and_consumers(locked_queue, num_threads, num_threads,
+                                           items_per_producer, false);
+    };
+
+    AsyncQueue<int> lock_free_queue(1000, AsyncQueueType::LockFree);
+    BENCHMARK("LockFree, " + std::to_string(num_threads) + " producers/consumers") {
+        return run_producers_and_consumers(lock_free_queue, num_threads, num_threads,
+                                           items_per_producer, false);
+    };
+}
@@ -106,6 +106,6 @@ TEST_CASE("HtsReaderTest: fetch_read_ids API w/ SAM", TEST_GROUP) {
                                                       "60588a89-f191-414e-b444-ad0815b7d9c9"};
 
     auto read_set = dorado::fetch_read_ids(sam.string());
-    CHECK(read_set.find("d7500028-dfcc-4404-b636-13edae804c55") != read_set.end());
-    CHECK(read_set.find("60588a89-f191-414e-b444-ad0815b7d9c9") != read_set.end());
+    CHECK(read_set.contains("d7500028-dfcc-4404-b636-13edae804c55"));
+    CHECK(read_set.contains("60588a89-f191-414e-b444-ad0815b7d9c9"));
 }
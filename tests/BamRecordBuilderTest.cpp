@@ -0,0 +1,149 @@
+#include "utils/BamRecordBuilder.h"
+
+#include <catch2/catch.hpp>
+#include <htslib/sam.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#define TEST_GROUP "[bam_record_builder]"
+
+using dorado::BamPtr;
+using dorado::utils::BamRecordBuilder;
+
+namespace {
+
+// A basecalled read, with the tags written for a simplex read with moves and modbase calls.
+struct TestRead {
+    std::string read_id;
+    std::string seq;
+    std::string qstring;
+    std::vector<uint8_t> moves;
+    std::string mm;
+    std::vector<uint8_t> ml;
+};
+
+TestRead make_read(size_t len) {
+    std::minstd_rand rng(42);
+    TestRead read;
+    read.read_id = "0a1b2c3d-4e5f-6a7b-8c9d-0e1f2a3b4c5d";
+    for (size_t i = 0; i < len; ++i) {
+        read.seq += "ACGT"[rng() % 4];
+        read.qstring += char(33 + rng() % 50);
+    }
+    read.moves.push_back(6);
+    for (size_t i = 0; i < len; ++i) {
+        read.moves.push_back(1);
+        read.moves.insert(read.moves.end(), rng() % 3, 0);
+    }
+    read.mm = "C+m?";
+    for (size_t i = 0; i < len / 20; ++i) {
+        read.mm += "," + std::to_string(rng() % 5);
+        read.ml.push_back(uint8_t(rng()));
+    }
+    read.mm += ';';
+    return read;
+}
+
+// Builds the record as it was before BamRecordBuilder, appending each tag in turn.
+BamPtr append_tags(const TestRead& read) {
+    BamPtr record(bam_init1());
+    std::vector<uint8_t> qscore;
+    std::transform(read.qstring.begin(), read.qstring.end(), std::back_inserter(qscore),
+                   [](char c) { return (uint8_t)(c)-33; });
+    bam_set1(record.get(), read.read_id.length(), read.read_id.c_str(), 4, -1, -1, 0, 0, nullptr,
+             -1, -1, 0, read.seq.length(), read.seq.c_str(), (char*)qscore.data(), 0);
+
+    int qs = 14;
+    bam_aux_append(record.get(), "qs", 'i', sizeof(qs), (uint8_t*)&qs);
+    float du = 1.25f;
+    bam_aux_append(record.get(), "du", 'f', sizeof(du), (uint8_t*)&du);
+    int rn = -1;
+    bam_aux_append(record.get(), "rn", 'i', sizeof(rn), (uint8_t*)&rn);
+    const std::string rg = "xyz_test_model";
+    bam_aux_append(record.get(), "RG", 'Z', int(rg.length() + 1), (uint8_t*)rg.c_str());
+    auto moves = read.moves;
+    bam_aux_update_array(record.get(), "mv", 'c', int(moves.size()), moves.data());
+    int mn = int(read.seq.length());
+    bam_aux_append(record.get(), "MN", 'i', sizeof(mn), (uint8_t*)&mn);
+    bam_aux_append(record.get(), "MM", 'Z', int(read.mm.length() + 1), (uint8_t*)read.mm.c_str());
+    auto ml = read.ml;
+    bam_aux_update_array(record.get(), "ML", 'C', int(ml.size()), ml.data());
+    return record;
+}
+
+BamPtr build_tags(BamRecordBuilder& builder, const TestRead& read) {
+    builder.clear();
+    builder.add_int("qs", 14);
+    builder.add_float("du", 1.25f);
+    builder.add_int("rn", -1);
+    builder.add_string("RG", "xyz_test_model");
+    std::copy(read.moves.begin(), read.moves.end(),
+              builder.add_byte_array("mv", 'c', read.moves.size()));
+    builder.add_int("MN", int(read.seq.length()));
+    builder.add_string("MM", read.mm);
+    std::copy(read.ml.begin(), read.ml.end(), builder.add_byte_array("ML", 'C', read.ml.size()));
+    return builder.build_unmapped(read.read_id, read.seq, read.qstring);
+}
+
+void check_identical(const bam1_t* expected, const bam1_t* actual) {
+    CHECK(std::memcmp(&expected->core, &actual->core, sizeof(bam1_core_t)) == 0);
+    REQUIRE(expected->l_data == actual->l_data);
+    CHECK(std::memcmp(expected->data, actual->data, size_t(expected->l_data)) == 0);
+}
+
+}  // namespace
+
+TEST_CASE("BamRecordBuilder matches appending each tag", TEST_GROUP) {
+    BamRecordBuilder builder;
+
+    SECTION("With tags") {
+        // Odd lengths end the packed sequence half way through a byte.
+        const auto read = make_read(GENERATE(1, 2, 101));
+        const auto expected = append_tags(read);
+        check_identical(expected.get(), build_tags(builder, read).get());
+
+        // Reusing the builder gives the same record.
+        check_identical(expected.get(), build_tags(builder, read).get());
+    }
+
+    SECTION("Empty arrays") {
+        TestRead read = make_read(10);
+        read.ml.clear();
+        check_identical(append_tags(read).get(), build_tags(builder, read).get());
+    }
+
+    SECTION("No tags") {
+        const auto read = make_read(10);
+        BamPtr expected(bam_init1());
+        std::vector<uint8_t> qscore;
+        for (auto c : read.qstring) {
+            qscore.push_back(uint8_t(c - 33));
+        }
+        bam_set1(expected.get(), read.read_id.length(), read.read_id.c_str(), 4, -1, -1, 0, 0,
+                 nullptr, -1, -1, 0, read.seq.length(), read.seq.c_str(), (char*)qscore.data(), 0);
+
+        builder.add_int("qs", 14);
+        builder.clear();
+        check_identical(expected.get(),
+                        builder.build_unmapped(read.read_id, read.seq, read.qstring).get());
+    }
+
+    SECTION("Mismatched quality string") {
+        CHECK_THROWS(builder.build_unmapped("read", "ACGT", "###"));
+    }
+}
+
+TEST_CASE("Benchmark BAM record building", "[.benchmark]" TEST_GROUP) {
+    // A 20kb read, typical of the tags written for a modbase call with moves.
+    const auto read = make_read(20000);
+
+    BENCHMARK("Append each tag") { return append_tags(read); };
+
+    BamRecordBuilder builder;
+    BENCHMARK("BamRecordBuilder") { return build_tags(builder, read); };
+}
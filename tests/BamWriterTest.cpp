@@ -6,9 +6,14 @@
 #include "utils/stats.h"
 
 #include <catch2/catch.hpp>
+#include <htslib/bgzf.h>
 #include <htslib/sam.h>
 
+#include <cstdint>
 #include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
 
 #define TEST_GROUP "[bam_utils][hts_writer]"
 
@@ -31,7 +36,7 @@ protected:
     void generate_bam(HtsFile::OutputMode mode, int num_threads) {
         HtsReader reader(m_in_sam.string(), std::nullopt);
 
-        utils::HtsFile hts_file(m_out_bam.string(), mode, num_threads);
+        utils::HtsFile hts_file(m_out_bam.string(), mode, num_threads, true);
         hts_file.set_and_write_header(reader.header);
 
         PipelineDescriptor pipeline_desc;
@@ -44,7 +49,7 @@ protected:
         auto& writer_ref = dynamic_cast<HtsWriter&>(pipeline->get_node_ref(writer));
         stats = writer_ref.sample_stats();
 
-        hts_file.finalise([](size_t) { /* noop */ }, num_threads, true);
+        hts_file.finalise([](size_t) { /* noop */ }, num_threads);
     }
 
     stats::NamedStats stats;
@@ -88,7 +93,7 @@ TEST_CASE("HtsWriterTest: Read and write FASTQ with tag", TEST_GROUP) {
     HtsReader reader(input_fastq.string(), std::nullopt);
     {
         // Write with tags into temporary folder.
-        utils::HtsFile hts_file(out_fastq.string(), HtsFile::OutputMode::FASTQ, 2);
+        utils::HtsFile hts_file(out_fastq.string(), HtsFile::OutputMode::FASTQ, 2, false);
         HtsWriter writer(hts_file, "");
         reader.read();
         CHECK_THAT(bam_aux2Z(bam_aux_get(reader.record.get(), "RG")),
@@ -97,7 +102,7 @@ TEST_CASE("HtsWriterTest: Read and write FASTQ with tag", TEST_GROUP) {
         CHECK_THAT(bam_aux2Z(bam_aux_get(reader.record.get(), "st")),
                    Equals("2023-06-22T07:17:48.308+00:00"));
         writer.write(reader.record.get());
-        hts_file.finalise([](size_t) { /* noop */ }, 2, false);
+        hts_file.finalise([](size_t) { /* noop */ }, 2);
     }
 
     // Read temporary file to make sure tags were correctly set.
@@ -109,3 +114,141 @@ TEST_CASE("HtsWriterTest: Read and write FASTQ with tag", TEST_GROUP) {
     CHECK_THAT(bam_aux2Z(bam_aux_get(new_fastq_reader.record.get(), "st")),
                Equals("2023-06-22T07:17:48.308+00:00"));
 }
+
+TEST_CASE("HtsWriterTest: Sorted output doesn't depend on the sort buffer size", TEST_GROUP) {
+    auto input_sam = fs::path(get_data_dir("bam_reader")) / "small.sam";
+    auto tmp_dir = TempDir(fs::temp_directory_path() / "writer_sort_test");
+    std::filesystem::create_directories(tmp_dir.m_path);
+
+    auto write_sorted = [&](const fs::path& out_bam, size_t sort_buffer_size) {
+        HtsReader reader(input_sam.string(), std::nullopt);
+        utils::HtsFile hts_file(out_bam.string(), HtsFile::OutputMode::BAM, 2, true);
+        hts_file.set_sort_buffer_size(sort_buffer_size);
+        hts_file.set_and_write_header(reader.header);
+        while (reader.read()) {
+            REQUIRE(hts_file.write(reader.record.get()) >= 0);
+        }
+        hts_file.finalise([](size_t) { /* noop */ }, 2);
+    };
+
+    // A tiny buffer means that every record is spilled to its own run and merged back together.
+    const auto in_memory_bam = tmp_dir.m_path / "in_memory.bam";
+    const auto spilled_bam = tmp_dir.m_path / "spilled.bam";
+    write_sorted(in_memory_bam, HtsFile::DEFAULT_SORT_BUFFER_SIZE);
+    write_sorted(spilled_bam, 1);
+
+    CHECK(ReadFileIntoVector(in_memory_bam) == ReadFileIntoVector(spilled_bam));
+    CHECK(fs::exists(fs::path(spilled_bam.string() + ".bai")));
+    for (const auto& entry : fs::directory_iterator(tmp_dir.m_path)) {
+        CHECK(entry.path().extension() != ".tmp");
+    }
+
+    // Check that the records come out in coordinate order, with the unmapped reads at the end.
+    HtsReader sorted_reader(spilled_bam.string(), std::nullopt);
+    uint64_t last_key = 0;
+    size_t num_records = 0;
+    while (sorted_reader.read()) {
+        const auto& core = sorted_reader.record->core;
+        const uint64_t key = (static_cast<uint64_t>(core.tid) << 32) | core.pos;
+        CHECK(key >= last_key);
+        last_key = key;
+        ++num_records;
+    }
+    CHECK(num_records == 11);
+}
+
+namespace {
+
+// Sorts |unsorted_bam| into |out_bam| the way that HtsFile::finalise() used to: the offset of each
+// record is stored in a multimap keyed by its position, then each record is seeked to in turn.
+void sort_with_record_offsets(const fs::path& unsorted_bam, const fs::path& out_bam) {
+    HtsFilePtr in_file(hts_open(unsorted_bam.string().c_str(), "rb"));
+    REQUIRE(in_file);
+    SamHdrPtr in_header(sam_hdr_read(in_file.get()));
+    REQUIRE(in_header);
+
+    HtsFilePtr out_file(hts_open(out_bam.string().c_str(), "wb"));
+    REQUIRE(out_file);
+    SamHdrPtr out_header(sam_hdr_dup(in_header.get()));
+    sam_hdr_change_HD(out_header.get(), "SO", "coordinate");
+    REQUIRE(sam_hdr_write(out_file.get(), out_header.get()) >= 0);
+
+    BamPtr record(bam_init1());
+    std::multimap<uint64_t, int64_t> record_map;
+    auto pos = bgzf_tell(in_file->fp.bgzf);
+    while (sam_read1(in_file.get(), in_header.get(), record.get()) >= 0) {
+        const auto& core = record->core;
+        record_map.insert({(static_cast<uint64_t>(core.tid) << 32) | core.pos, pos});
+        pos = bgzf_tell(in_file->fp.bgzf);
+    }
+    for (const auto& [sorting_key, record_offset] : record_map) {
+        REQUIRE(bgzf_seek(in_file->fp.bgzf, record_offset, SEEK_SET) >= 0);
+        REQUIRE(sam_read1(in_file.get(), in_header.get(), record.get()) >= 0);
+        REQUIRE(sam_write1(out_file.get(), out_header.get(), record.get()) >= 0);
+    }
+    out_file.reset();
+    REQUIRE(sam_index_build(out_bam.string().c_str(), 0) >= 0);
+}
+
+}  // namespace
+
+TEST_CASE("HtsWriterTest: Sorted output matches sorting by record offsets", TEST_GROUP) {
+    const int num_threads = GENERATE(1, 4);
+    // The smaller buffer spills the records to several runs that are merged back together.
+    const size_t sort_buffer_size = GENERATE(HtsFile::DEFAULT_SORT_BUFFER_SIZE, size_t{1'000'000});
+    CAPTURE(num_threads, sort_buffer_size);
+
+    auto tmp_dir = TempDir(fs::temp_directory_path() / "writer_sort_order_test");
+    std::filesystem::create_directories(tmp_dir.m_path);
+    const auto unsorted_bam = tmp_dir.m_path / "unsorted.bam";
+    const auto expected_bam = tmp_dir.m_path / "expected.bam";
+    const auto sorted_bam = tmp_dir.m_path / "sorted.bam";
+
+    SamHdrPtr header(sam_hdr_init());
+    sam_hdr_add_line(header.get(), "HD", "VN", "1.6", NULL);
+    sam_hdr_add_line(header.get(), "SQ", "SN", "ref0", "LN", "100000", NULL);
+    sam_hdr_add_line(header.get(), "SQ", "SN", "ref1", "LN", "100000", NULL);
+
+    // Plenty of records share a position, so the order of ties is checked, and some are unmapped.
+    const std::string seq(50, 'A');
+    const std::string qual(50, 20);
+    const uint32_t cigar = bam_cigar_gen(50, BAM_CMATCH);
+    std::vector<BamPtr> records;
+    for (int i = 0; i < 20000; ++i) {
+        const std::string read_id = "read_" + std::to_string(i);
+        uint16_t flag = 0;
+        int32_t tid = i % 3 == 0 ? 1 : 0;
+        hts_pos_t pos = (i * 7919) % 500;
+        if (i % 7 == 0) {
+            flag = BAM_FUNMAP;
+            tid = -1;
+            pos = -1;
+        } else if (i % 11 == 0) {
+            // Unmapped, but placed next to its mate.
+            flag = BAM_FUNMAP;
+        }
+        const bool mapped = !(flag & BAM_FUNMAP);
+        BamPtr record(bam_init1());
+        bam_set1(record.get(), read_id.length(), read_id.c_str(), flag, tid, pos, mapped ? 60 : 0,
+                 mapped ? 1 : 0, mapped ? &cigar : nullptr, -1, -1, 0, seq.length(), seq.c_str(),
+                 qual.c_str(), 0);
+        records.push_back(std::move(record));
+    }
+
+    auto write_records = [&](const fs::path& out_bam, bool sort_bam) {
+        utils::HtsFile hts_file(out_bam.string(), HtsFile::OutputMode::BAM, num_threads, sort_bam);
+        hts_file.set_sort_buffer_size(sort_buffer_size);
+        hts_file.set_and_write_header(header.get());
+        for (const auto& record : records) {
+            REQUIRE(hts_file.write(record.get()) >= 0);
+        }
+        hts_file.finalise([](size_t) { /* noop */ }, num_threads);
+    };
+    write_records(unsorted_bam, false);
+    sort_with_record_offsets(unsorted_bam, expected_bam);
+    write_records(sorted_bam, true);
+
+    CHECK(ReadFileIntoVector(sorted_bam) == ReadFileIntoVector(expected_bam));
+    CHECK(ReadFileIntoVector(sorted_bam.string() + ".bai") ==
+          ReadFileIntoVector(expected_bam.string() + ".bai"));
+}
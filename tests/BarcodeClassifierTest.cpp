@@ -14,7 +14,9 @@
 
 #include <cstdint>
 #include <filesystem>
+#include <random>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #define TEST_GROUP "[barcode_demux]"
@@ -429,3 +431,56 @@ TEST_CASE(
             demux::BarcodeClassifier({}, kit_file.string(), std::nullopt),
             "Either custom kit must include kit arrangement or a kit name needs to be passed in.");
 }
+
+TEST_CASE("Benchmark barcode classification", "[.benchmark]" TEST_GROUP) {
+    // A synthetic set of 1kb reads, each with a barcode and its flanks at the front, and the
+    // reverse complement of them at the rear, with a few substitutions throughout.
+    const std::string kit_name = GENERATE("SQK-RBK114-96", "SQK-NBD114-96");
+    CAPTURE(kit_name);
+    const auto& kit_info = barcode_kits::get_kit_infos().at(kit_name);
+    const auto& barcodes = barcode_kits::get_barcodes();
+
+    std::minstd_rand rng(42);
+    auto random_bases = [&rng](size_t length) {
+        std::string bases;
+        for (size_t i = 0; i < length; ++i) {
+            bases += "ACGT"[rng() % 4];
+        }
+        return bases;
+    };
+    std::vector<std::string> reads;
+    for (int i = 0; i < 200; ++i) {
+        const auto& barcode_name = kit_info.barcodes[rng() % kit_info.barcodes.size()];
+        const auto front = kit_info.top_front_flank + barcodes.at(barcode_name) +
+                           kit_info.top_rear_flank;
+        auto read = random_bases(10) + front + random_bases(1000);
+        if (kit_info.double_ends) {
+            read += utils::reverse_complement(front) + random_bases(10);
+        }
+        for (size_t j = 0; j < read.length() / 50; ++j) {
+            read[rng() % read.length()] = "ACGT"[rng() % 4];
+        }
+        reads.push_back(std::move(read));
+    }
+
+    demux::BarcodeClassifier classifier({kit_name}, std::nullopt, std::nullopt);
+    const BarcodingInfo::FilterSet allowed_barcodes =
+            std::unordered_set<std::string>{"barcode01", "barcode02", "barcode03"};
+
+    BENCHMARK("All barcodes") {
+        size_t classified = 0;
+        for (const auto& read : reads) {
+            classified += classifier.barcode(read, false, std::nullopt).barcode_name !=
+                          "unclassified";
+        }
+        return classified;
+    };
+    BENCHMARK("Allowed barcodes") {
+        size_t classified = 0;
+        for (const auto& read : reads) {
+            classified += classifier.barcode(read, false, allowed_barcodes).barcode_name !=
+                          "unclassified";
+        }
+        return classified;
+    };
+}
@@ -24,11 +24,11 @@ namespace fs = std::filesystem;
 using namespace dorado;
 
 namespace {
-std::vector<BamPtr> create_bam_reader(const std::string& bc) {
+std::vector<BamPtr> create_bam_reader(const std::string& bc, const std::string& read_id) {
     ReadCommon read_common;
     read_common.seq = "AAAA";
     read_common.qstring = "!!!!";
-    read_common.read_id = bc;
+    read_common.read_id = read_id;
     auto records = read_common.extract_sam_lines(false, 0, false);
     for (auto& rec : records) {
         bam_aux_append(rec.get(), "BC", 'Z', int(bc.length() + 1), (uint8_t*)bc.c_str());
@@ -48,8 +48,8 @@ TEST_CASE("BarcodeDemuxerNode: check correct output files are created", TEST_GRO
         // the pipeline object is closed. This needs to be looked at.
         // TODO: Address open file issue on windows.
         dorado::PipelineDescriptor pipeline_desc;
-        auto demuxer =
-                pipeline_desc.add_node<BarcodeDemuxerNode>({}, tmp_dir.string(), 8, false, nullptr);
+        auto demuxer = pipeline_desc.add_node<BarcodeDemuxerNode>({}, tmp_dir.string(), 8, false,
+                                                                   nullptr, true);
 
         auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
 
@@ -60,7 +60,7 @@ TEST_CASE("BarcodeDemuxerNode: check correct output files are created", TEST_GRO
         demux_writer_ref.set_header(hdr.get());
 
         for (auto bc : {"bc01", "bc02", "bc03"}) {
-            auto records = create_bam_reader(bc);
+            auto records = create_bam_reader(bc, bc);
             for (auto& rec : records) {
                 pipeline->push_message(std::move(rec));
             }
@@ -68,7 +68,7 @@ TEST_CASE("BarcodeDemuxerNode: check correct output files are created", TEST_GRO
 
         pipeline->terminate(DefaultFlushOptions());
 
-        demux_writer_ref.finalise_hts_files([](size_t) { /* noop */ }, true);
+        demux_writer_ref.finalise_hts_files([](size_t) { /* noop */ });
 
         const std::unordered_set<std::string> expected_files = {
                 "bc01.bam", "bc01.bam.bai", "bc02.bam", "bc02.bam.bai", "bc03.bam", "bc03.bam.bai",
@@ -87,3 +87,54 @@ TEST_CASE("BarcodeDemuxerNode: check correct output files are created", TEST_GRO
 
     fs::remove_all(tmp_dir);
 }
+
+TEST_CASE("BarcodeDemuxerNode: sorted files share a memory budget", TEST_GROUP) {
+    auto tmp_dir = TempDir(fs::temp_directory_path() / "dorado_demuxer_budget");
+    const std::vector<std::string> barcodes = {"bc01", "bc02", "bc03"};
+    constexpr size_t reads_per_barcode = 5;
+
+    {
+        dorado::PipelineDescriptor pipeline_desc;
+        auto demuxer = pipeline_desc.add_node<BarcodeDemuxerNode>({}, tmp_dir.m_path.string(), 2,
+                                                                   false, nullptr, true);
+        auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
+
+        SamHdrPtr hdr(sam_hdr_init());
+        sam_hdr_add_line(hdr.get(), "SQ", "ID", "foo", "LN", "100", "SN", "ref", NULL);
+
+        auto& demux_writer_ref = dynamic_cast<BarcodeDemuxerNode&>(pipeline->get_node_ref(demuxer));
+        demux_writer_ref.set_header(hdr.get());
+        // Too small for even a single record, so every record has to be spilled to disk.
+        demux_writer_ref.set_sort_buffer_size(1);
+
+        // Interleave the barcodes so that the files take turns at holding the buffered records.
+        for (size_t i = 0; i < reads_per_barcode; ++i) {
+            for (const auto& bc : barcodes) {
+                for (auto& rec : create_bam_reader(bc, bc + "_" + std::to_string(i))) {
+                    pipeline->push_message(std::move(rec));
+                }
+            }
+        }
+
+        pipeline->terminate(DefaultFlushOptions());
+        demux_writer_ref.finalise_hts_files([](size_t) { /* noop */ });
+    }
+
+    for (const auto& entry : fs::directory_iterator(tmp_dir.m_path)) {
+        CHECK(entry.path().extension() != ".tmp");
+    }
+
+    // The records all have the same position, so they should come out in the order written.
+    for (const auto& bc : barcodes) {
+        HtsReader reader((tmp_dir.m_path / (bc + ".bam")).string(), std::nullopt);
+        std::vector<std::string> read_ids;
+        while (reader.read()) {
+            read_ids.emplace_back(bam_get_qname(reader.record.get()));
+        }
+        std::vector<std::string> expected_read_ids;
+        for (size_t i = 0; i < reads_per_barcode; ++i) {
+            expected_read_ids.push_back(bc + "_" + std::to_string(i));
+        }
+        CHECK(read_ids == expected_read_ids);
+    }
+}
@@ -4,6 +4,12 @@
 
 #include <catch2/catch.hpp>
 
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+
 #define CUT_TAG "[BedFile]"
 
 TEST_CASE(CUT_TAG ": test bedfile loading", CUT_TAG) {
@@ -22,3 +28,94 @@ TEST_CASE(CUT_TAG ": test bedfile loading", CUT_TAG) {
         REQUIRE(entries[i].strand == expected_dir[i]);
     }
 }
+
+namespace {
+
+// Write a BED file with |num_entries| randomly placed intervals on a single contig.
+std::filesystem::path write_synthetic_bed(const std::filesystem::path& dir, size_t num_entries) {
+    std::minstd_rand rng(42);
+    std::uniform_int_distribution<size_t> start_dist(0, 100'000'000);
+    std::uniform_int_distribution<size_t> length_dist(50, 5000);
+    const char strands[] = {'+', '-', '.'};
+
+    auto bed_path = dir / "synthetic.bed";
+    std::ofstream bed_stream(bed_path);
+    for (size_t i = 0; i < num_entries; ++i) {
+        const size_t start = start_dist(rng);
+        bed_stream << "chr1\t" << start << '\t' << start + length_dist(rng) << "\tinterval_" << i
+                   << "\t0\t" << strands[i % 3] << '\n';
+    }
+    return bed_path;
+}
+
+// The scan that was previously used to count hits in the aligner.
+size_t count_overlaps_linear(const dorado::alignment::BedFile::Entries& entries,
+                             size_t start,
+                             size_t end,
+                             char strand) {
+    size_t hits = 0;
+    for (const auto& interval : entries) {
+        if (!(interval.start >= end || interval.end <= start) &&
+            (interval.strand == strand || interval.strand == '.')) {
+            hits++;
+        }
+    }
+    return hits;
+}
+
+}  // namespace
+
+TEST_CASE(CUT_TAG ": overlapping entries match a linear scan", CUT_TAG) {
+    auto tmp_dir = TempDir(std::filesystem::temp_directory_path() / "bedfile_overlaps");
+    std::filesystem::create_directories(tmp_dir.m_path);
+    const size_t num_entries = GENERATE(0, 1, 2, 7, 100, 10000);
+    CAPTURE(num_entries);
+
+    dorado::alignment::BedFile bed;
+    REQUIRE(bed.load(write_synthetic_bed(tmp_dir.m_path, num_entries).string()));
+    const auto& entries = bed.entries("chr1");
+
+    std::minstd_rand rng(7);
+    std::uniform_int_distribution<size_t> start_dist(0, 101'000'000);
+    std::uniform_int_distribution<size_t> length_dist(0, 200'000);
+    for (int i = 0; i < 1000; ++i) {
+        const size_t start = start_dist(rng);
+        const size_t end = start + length_dist(rng);
+        const char strand = (i % 2) ? '+' : '-';
+        CAPTURE(start, end, strand);
+        CHECK(bed.num_overlapping_entries("chr1", start, end, strand) ==
+              count_overlaps_linear(entries, start, end, strand));
+    }
+    CHECK(bed.num_overlapping_entries("unknown", 0, 1'000'000'000, '+') == 0);
+}
+
+TEST_CASE(CUT_TAG ": overlap query benchmark", "[.benchmark]" CUT_TAG) {
+    auto tmp_dir = TempDir(std::filesystem::temp_directory_path() / "bedfile_benchmark");
+    std::filesystem::create_directories(tmp_dir.m_path);
+
+    dorado::alignment::BedFile bed;
+    REQUIRE(bed.load(write_synthetic_bed(tmp_dir.m_path, 200'000).string()));
+    const auto& entries = bed.entries("chr1");
+
+    // Typical read length alignments.
+    std::minstd_rand rng(7);
+    std::uniform_int_distribution<size_t> start_dist(0, 100'000'000);
+    std::vector<size_t> query_starts(1000);
+    std::generate(query_starts.begin(), query_starts.end(), [&] { return start_dist(rng); });
+
+    BENCHMARK("Linear scan") {
+        size_t hits = 0;
+        for (size_t start : query_starts) {
+            hits += count_overlaps_linear(entries, start, start + 20'000, '+');
+        }
+        return hits;
+    };
+
+    BENCHMARK("Interval index") {
+        size_t hits = 0;
+        for (size_t start : query_starts) {
+            hits += bed.num_overlapping_entries("chr1", start, start + 20'000, '+');
+        }
+        return hits;
+    };
+}
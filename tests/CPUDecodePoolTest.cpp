@@ -0,0 +1,106 @@
+#include "basecall/decode/CPUDecodePool.h"
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define TEST_GROUP "[CPUDecodePool]"
+
+using dorado::basecall::decode::CPUDecodePool;
+
+TEST_CASE("CPUDecodePool runs every task exactly once", TEST_GROUP) {
+    const size_t num_threads = GENERATE(1, 3, 8);
+    const size_t num_tasks = GENERATE(1, 7, 100);
+    CAPTURE(num_threads, num_tasks);
+
+    CPUDecodePool pool(num_threads);
+    REQUIRE(pool.num_threads() == num_threads);
+
+    std::vector<std::atomic<int>> counts(num_tasks);
+    pool.parallel_for(num_tasks, [&counts](size_t i) { ++counts[i]; });
+    for (const auto& count : counts) {
+        CHECK(count == 1);
+    }
+
+    auto stats = pool.sample_stats();
+    CHECK(stats.at("decode_pool_threads") == double(num_threads));
+    CHECK(stats.at("decode_pool_tasks_completed") == double(num_tasks));
+    CHECK(stats.at("decode_pool_queue_depth") == 0.0);
+    for (size_t i = 0; i < num_threads; ++i) {
+        const auto utilisation =
+                stats.at("decode_pool_thread_" + std::to_string(i) + "_utilisation");
+        CHECK(utilisation >= 0.0);
+        CHECK(utilisation <= 1.0);
+    }
+}
+
+TEST_CASE("CPUDecodePool handles concurrent submitters", TEST_GROUP) {
+    CPUDecodePool pool(4);
+
+    constexpr size_t kNumSubmitters = 6;
+    constexpr size_t kNumTasks = 50;
+    std::vector<std::vector<int>> results(kNumSubmitters, std::vector<int>(kNumTasks, 0));
+    std::vector<std::thread> submitters;
+    for (size_t s = 0; s < kNumSubmitters; ++s) {
+        submitters.emplace_back([&pool, &results, s] {
+            for (int repeat = 0; repeat < 10; ++repeat) {
+                pool.parallel_for(kNumTasks, [&results, s](size_t i) { ++results[s][i]; });
+            }
+        });
+    }
+    for (auto& submitter : submitters) {
+        submitter.join();
+    }
+
+    for (const auto& submitter_results : results) {
+        for (const int result : submitter_results) {
+            CHECK(result == 10);
+        }
+    }
+}
+
+TEST_CASE("CPUDecodePool balances uneven tasks", TEST_GROUP) {
+    CPUDecodePool pool(4);
+
+    // All of the slow tasks land on the first queue, so the other threads have to steal them.
+    std::atomic<int> num_completed{0};
+    pool.parallel_for(16, [&num_completed](size_t i) {
+        if (i % 4 == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        ++num_completed;
+    });
+    CHECK(num_completed == 16);
+}
+
+TEST_CASE("CPUDecodePool propagates task exceptions", TEST_GROUP) {
+    CPUDecodePool pool(2);
+
+    std::atomic<int> num_completed{0};
+    CHECK_THROWS_AS(pool.parallel_for(10,
+                                      [&num_completed](size_t i) {
+                                          if (i == 3) {
+                                              throw std::runtime_error("task failed");
+                                          }
+                                          ++num_completed;
+                                      }),
+                    std::runtime_error);
+    // The remaining tasks still ran before the exception was rethrown.
+    CHECK(num_completed == 9);
+
+    // And the pool is still usable.
+    pool.parallel_for(5, [&num_completed](size_t) { ++num_completed; });
+    CHECK(num_completed == 14);
+}
+
+TEST_CASE("CPUDecodePool shared instance is shared", TEST_GROUP) {
+    auto pool_a = CPUDecodePool::shared_instance();
+    auto pool_b = CPUDecodePool::shared_instance();
+    CHECK(pool_a == pool_b);
+    CHECK(pool_a->num_threads() >= 1);
+}
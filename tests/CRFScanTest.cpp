@@ -0,0 +1,127 @@
+#include "basecall/decode/crf_scan.h"
+
+#include <ATen/ATen.h>
+#include <catch2/catch.hpp>
+#include <torch/torch.h>
+
+#include <string>
+
+#define TEST_GROUP "[CRFScan]"
+
+namespace {
+
+// The original tensor based scans, which the optimised versions should match.
+at::Tensor reference_scan(const at::Tensor& Ms,
+                          const float fixed_stay_score,
+                          const at::Tensor& idx,
+                          const at::Tensor& v0) {
+    const int T = int(Ms.size(0));
+    const int N = int(Ms.size(1));
+    const int C = int(Ms.size(2));
+
+    at::Tensor alpha = Ms.new_full({T + 1, N, C}, -1E38);
+    alpha[0] = v0;
+
+    for (int t = 0; t < T; t++) {
+        auto scored_steps = at::add(alpha.index({t, at::indexing::Slice(), idx}), Ms[t]);
+        auto scored_stay =
+                at::add(alpha.index({t, at::indexing::Slice()}), fixed_stay_score).unsqueeze(-1);
+        auto scored_transitions = at::cat({scored_stay, scored_steps}, -1);
+
+        alpha[t + 1] = at::logsumexp(scored_transitions, -1);
+    }
+
+    return alpha;
+}
+
+at::Tensor reference_forward_scores(const at::Tensor& scores, const float fixed_stay_score) {
+    const int T = int(scores.size(0));
+    const int N = int(scores.size(1));
+    const int num_states = int(scores.size(2)) / 4;
+
+    const at::Tensor Ms = scores.reshape({T, N, -1, 4});
+    const auto v0 = Ms.new_full({{N, num_states}}, 0.0f);
+    const auto idx = at::arange(num_states).repeat_interleave(4).reshape({4, -1}).t().contiguous();
+
+    return reference_scan(Ms, fixed_stay_score, idx, v0);
+}
+
+at::Tensor reference_backward_scores(const at::Tensor& scores, const float fixed_stay_score) {
+    const int N = int(scores.size(1));
+    const int num_states = int(scores.size(2)) / 4;
+
+    const at::Tensor vT = scores.new_full({N, num_states}, 0.0f);
+
+    const auto idx = at::arange(num_states).repeat_interleave(4).reshape({4, -1}).t().contiguous();
+    auto idx_T = idx.flatten().argsort().reshape(idx.sizes());
+    const auto Ms_T = scores.index({at::indexing::Slice(), at::indexing::Slice(), idx_T});
+    idx_T = at::bitwise_right_shift(idx_T, 2);
+
+    return reference_scan(Ms_T.flip(0), fixed_stay_score, idx_T.to(at::kLong), vT).flip(0);
+}
+
+at::Tensor make_scores(int T, int N, int state_len) {
+    torch::manual_seed(42);
+    const int C = 1 << (2 * (state_len + 1));
+    return 2.f * torch::randn({T, N, C});
+}
+
+}  // namespace
+
+TEST_CASE("CRF scans match the reference implementation", TEST_GROUP) {
+    torch::InferenceMode inference_mode_guard;
+
+    const int state_len = GENERATE(1, 2, 3, 4, 5);
+    CAPTURE(state_len);
+    const float stay_score = 2.f;
+    const auto scores = make_scores(200, 3, state_len);
+
+    const auto fwd = dorado::basecall::decode::forward_scores(scores, stay_score);
+    const auto bwd = dorado::basecall::decode::backward_scores(scores, stay_score);
+    const auto expected_fwd = reference_forward_scores(scores, stay_score);
+    const auto expected_bwd = reference_backward_scores(scores, stay_score);
+
+    REQUIRE(fwd.sizes() == expected_fwd.sizes());
+    REQUIRE(bwd.sizes() == expected_bwd.sizes());
+    // Guides accumulate over the whole chunk, so allow for rounding differences between the
+    // elementwise exp/log implementations.
+    CHECK(torch::allclose(fwd, expected_fwd, 1e-5, 1e-3));
+    CHECK(torch::allclose(bwd, expected_bwd, 1e-5, 1e-3));
+
+    // The posteriors are what the beam search actually consumes.
+    const auto posts = at::softmax(fwd + bwd, -1);
+    const auto expected_posts = at::softmax(expected_fwd + expected_bwd, -1);
+    CHECK(torch::allclose(posts, expected_posts, 1e-3, 1e-5));
+}
+
+TEST_CASE("CRF scans handle non-contiguous scores", TEST_GROUP) {
+    torch::InferenceMode inference_mode_guard;
+
+    const float stay_score = 2.f;
+    // Scores as they're sliced by chunk in the CPU decoder.
+    const auto all_scores = make_scores(100, 5, 3);
+    const auto scores = all_scores.index({at::indexing::Slice(), at::indexing::Slice(1, 4)});
+    REQUIRE(!scores.is_contiguous());
+
+    CHECK(torch::allclose(dorado::basecall::decode::forward_scores(scores, stay_score),
+                          reference_forward_scores(scores, stay_score), 1e-5, 1e-3));
+    CHECK(torch::allclose(dorado::basecall::decode::backward_scores(scores, stay_score),
+                          reference_backward_scores(scores, stay_score), 1e-5, 1e-3));
+}
+
+TEST_CASE("Benchmark CRF scans", "[.benchmark]" TEST_GROUP) {
+    torch::InferenceMode inference_mode_guard;
+
+    const float stay_score = 2.f;
+    const int state_len = GENERATE(3, 4, 5);
+    const auto scores = make_scores(1000, 4, state_len);
+
+    BENCHMARK("Reference state_len " + std::to_string(state_len)) {
+        return reference_forward_scores(scores, stay_score).sum().item<float>() +
+               reference_backward_scores(scores, stay_score).sum().item<float>();
+    };
+    BENCHMARK("Optimised state_len " + std::to_string(state_len)) {
+        return dorado::basecall::decode::forward_scores(scores, stay_score).sum().item<float>() +
+               dorado::basecall::decode::backward_scores(scores, stay_score).sum().item<float>();
+    };
+}
@@ -130,7 +130,7 @@ TEST_CASE("4 subread split tagging", TEST_GROUP) {
     auto sink = pipeline_desc.add_node<MessageSinkToVector>({}, 3, messages);
     auto tag_node = pipeline_desc.add_node<dorado::SubreadTaggerNode>({sink}, 1, 1000);
     auto stereo_node = pipeline_desc.add_node<dorado::StereoDuplexEncoderNode>(
-            {tag_node}, read->read_common.model_stride);
+            {tag_node}, read->read_common.model_stride, 2);
     auto pairing_node = pipeline_desc.add_node<dorado::PairingNode>(
             {stereo_node},
             dorado::DuplexPairingParameters{dorado::ReadOrder::BY_CHANNEL,
@@ -16,7 +16,7 @@ TEST_CASE(TEST_GROUP "Test loading single-read Fast5 files") {
 }
 
 TEST_CASE(TEST_GROUP "Test loading single-read Fast5 file, empty read list") {
-    auto read_list = std::unordered_set<std::string>();
+    auto read_list = dorado::utils::ReadIdSet();
     CHECK(CountSinkReads(get_fast5_data_dir(), "cpu", 1, 0, read_list, {}) == 0);
 }
 
@@ -25,13 +25,13 @@ TEST_CASE(TEST_GROUP "Test loading single-read Fast5 file, no read list") {
 }
 
 TEST_CASE(TEST_GROUP "Test loading single-read Fast5 file, mismatched read list") {
-    auto read_list = std::unordered_set<std::string>{"read_1"};
+    auto read_list = dorado::utils::ReadIdSet{"read_1"};
     CHECK(CountSinkReads(get_fast5_data_dir(), "cpu", 1, 0, read_list, {}) == 0);
 }
 
 TEST_CASE(TEST_GROUP "Test loading single-read Fast5 file, matched read list") {
     // read present in Fast5 file
-    auto read_list = std::unordered_set<std::string>{"59097f00-0f1c-4fac-aea2-3c23d79b0a58"};
+    auto read_list = dorado::utils::ReadIdSet{"59097f00-0f1c-4fac-aea2-3c23d79b0a58"};
     CHECK(CountSinkReads(get_fast5_data_dir(), "cpu", 1, 0, read_list, {}) == 1);
 }
 
@@ -43,11 +43,11 @@ TEST_CASE(TEST_GROUP "Test calculating number of reads from fast5, read ids list
     }
 
     SECTION("fast5 file and read ids with 0 reads") {
-        auto read_list = std::unordered_set<std::string>();
+        auto read_list = dorado::utils::ReadIdSet();
         CHECK(dorado::DataLoader::get_num_reads(data_path, read_list, {}, false) == 0);
     }
     SECTION("fast5 file and read ids with 2 reads") {
-        auto read_list = std::unordered_set<std::string>();
+        auto read_list = dorado::utils::ReadIdSet();
         read_list.insert("1");
         read_list.insert("2");
         CHECK(dorado::DataLoader::get_num_reads(data_path, read_list, {}, false) == 1);
@@ -0,0 +1,118 @@
+#include "modbase/KmerIndex.h"
+#include "modbase/ModbaseEncoder.h"
+#include "utils/sequence_utils.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#define TEST_GROUP "[modbase_kmer_index]"
+
+using dorado::modbase::KmerIndex;
+
+namespace {
+
+std::string random_sequence(size_t len) {
+    std::minstd_rand rng(42);
+    std::uniform_int_distribution<int> base_dist(0, 3);
+    std::string seq;
+    for (size_t i = 0; i < len; ++i) {
+        seq += "ACGT"[base_dist(rng)];
+    }
+    return seq;
+}
+
+// The kmer index computed from scratch, with the first base most significant.
+uint64_t naive_kmer(const std::vector<int>& seq_ints, size_t pos, size_t kmer_len) {
+    uint64_t index = 0;
+    for (size_t i = 0; i < kmer_len; ++i) {
+        index = (index << 2) | uint64_t(seq_ints[pos + i]);
+    }
+    return index;
+}
+
+}  // namespace
+
+TEST_CASE("KmerIndex kmers match a direct calculation", TEST_GROUP) {
+    const auto seq_ints = dorado::utils::sequence_to_ints(random_sequence(100));
+    const KmerIndex kmers(seq_ints);
+    REQUIRE(kmers.size() == seq_ints.size());
+
+    const size_t kmer_len = GENERATE(1, 5, 9, 32);
+    CAPTURE(kmer_len);
+    for (size_t pos = 0; pos + kmer_len <= seq_ints.size(); ++pos) {
+        CAPTURE(pos);
+        CHECK(kmers.kmer(pos, kmer_len) == naive_kmer(seq_ints, pos, kmer_len));
+    }
+}
+
+TEST_CASE("KmerIndex one-hot encodings are zero padded", TEST_GROUP) {
+    const auto seq_ints = dorado::utils::sequence_to_ints("ACGT");
+    const KmerIndex kmers(seq_ints);
+
+    const auto* const one_hot = kmers.one_hot(-2);
+    const std::vector<uint32_t> expected{0, 0, 0x1, 0x100, 0x10000, 0x1000000, 0, 0};
+    CHECK(std::vector<uint32_t>(one_hot, one_hot + expected.size()) == expected);
+
+    // The full padding either side can be read.
+    CHECK(*kmers.one_hot(-int(KmerIndex::MAX_KMER_LEN)) == 0);
+    CHECK(*kmers.one_hot(int(seq_ints.size() + KmerIndex::MAX_KMER_LEN) - 1) == 0);
+}
+
+TEST_CASE("Benchmark modbase kmer lookup", "[.benchmark]" TEST_GROUP) {
+    // A 100kb read, with the kmer lengths of typical 9mer and 5mer models.
+    const auto seq_ints = dorado::utils::sequence_to_ints(random_sequence(100000));
+
+    BENCHMARK("Build kmer index") { return KmerIndex(seq_ints); };
+
+    const auto kmers = std::make_shared<const KmerIndex>(seq_ints);
+    for (const size_t kmer_len : {9, 5}) {
+        const std::string suffix = " " + std::to_string(kmer_len) + "mer";
+        std::vector<uint64_t> indices(seq_ints.size() - kmer_len);
+
+        BENCHMARK("Kmer indices from scratch" + suffix) {
+            for (size_t pos = 0; pos < indices.size(); ++pos) {
+                indices[pos] = naive_kmer(seq_ints, pos, kmer_len);
+            }
+            return indices.data();
+        };
+
+        BENCHMARK("Kmer indices from index" + suffix) {
+            for (size_t pos = 0; pos < indices.size(); ++pos) {
+                indices[pos] = kmers->kmer(pos, kmer_len);
+            }
+            return indices.data();
+        };
+    }
+
+    // Encode every CpG context, with block stride 6 and 200 sample chunks.
+    const size_t kBlockStride = 6;
+    std::vector<uint8_t> moves;
+    std::vector<size_t> context_hits;
+    for (size_t pos = 0; pos < seq_ints.size(); ++pos) {
+        moves.push_back(1);
+        moves.insert(moves.end(), pos % 3, 0);
+        if (pos + 1 < seq_ints.size() && seq_ints[pos] == 1 && seq_ints[pos + 1] == 2) {
+            context_hits.push_back(pos);
+        }
+    }
+    const auto seq_to_sig_map = dorado::utils::moves_to_map(
+            moves, kBlockStride, moves.size() * kBlockStride, std::nullopt);
+
+    for (const int bases_either_side : {4, 2}) {
+        dorado::modbase::ModBaseEncoder encoder(kBlockStride, 200, bases_either_side,
+                                                bases_either_side);
+        encoder.init(kmers, seq_to_sig_map);
+        std::vector<int8_t> buffer(context_hits.size() * encoder.encoded_size());
+        BENCHMARK("Encode CpG contexts " + std::to_string(2 * bases_either_side + 1) + "mer") {
+            for (size_t i = 0; i < context_hits.size(); ++i) {
+                encoder.get_context(context_hits[i], &buffer[i * encoder.encoded_size()]);
+            }
+            return buffer.data();
+        };
+    }
+}
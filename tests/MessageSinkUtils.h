@@ -58,8 +58,8 @@ inline size_t CountSinkReads(const std::filesystem::path& data_path,
                              const std::string& device,
                              size_t num_worker_threads,
                              size_t max_reads,
-                             std::optional<std::unordered_set<std::string>> read_list,
-                             std::unordered_set<std::string> read_ignore_list) {
+                             std::optional<dorado::utils::ReadIdSet> read_list,
+                             dorado::utils::ReadIdSet read_ignore_list) {
     dorado::PipelineDescriptor pipeline_desc;
     std::vector<dorado::Message> messages;
     pipeline_desc.add_node<MessageSinkToVector>({}, 100, messages);
@@ -4,8 +4,34 @@
 
 #include <catch2/catch.hpp>
 
+#include <random>
+#include <string>
+#include <vector>
+
 #define TEST_GROUP "[modbase_encoder]"
 
+namespace {
+
+struct SyntheticRead {
+    std::string seq;
+    std::vector<uint8_t> moves;
+};
+
+SyntheticRead make_synthetic_read(size_t seq_len, size_t block_stride) {
+    std::minstd_rand rng(42);
+    std::uniform_int_distribution<int> base_dist(0, 3);
+    std::uniform_int_distribution<int> stay_dist(0, 3);
+    SyntheticRead read;
+    for (size_t i = 0; i < seq_len; ++i) {
+        read.seq += "ACGT"[base_dist(rng)];
+        read.moves.push_back(1);
+        read.moves.insert(read.moves.end(), stay_dist(rng) + block_stride / 6, 0);
+    }
+    return read;
+}
+
+}  // namespace
+
 TEST_CASE("Encode sequence for modified basecalling", TEST_GROUP) {
     const size_t BLOCK_STRIDE = 2;
     const size_t SLICE_BLOCKS = 6;
@@ -91,3 +117,70 @@ TEST_CASE("Encode sequence for modified basecalling", TEST_GROUP) {
     // clang-format on    
     CHECK(expected_slice2 == slice2.data);
 }
+
+TEST_CASE("Encoding into a caller provided buffer matches", TEST_GROUP) {
+    const size_t kBlockStride = 2;
+    const auto read = make_synthetic_read(200, kBlockStride);
+    auto seq_ints = dorado::utils::sequence_to_ints(read.seq);
+    auto seq_to_sig_map = dorado::utils::moves_to_map(
+            read.moves, kBlockStride, read.moves.size() * kBlockStride, std::nullopt);
+
+    const int bases_before = GENERATE(1, 4);
+    CAPTURE(bases_before);
+    dorado::modbase::ModBaseEncoder encoder(kBlockStride, 24, bases_before, bases_before);
+    encoder.init(seq_ints, seq_to_sig_map);
+    const size_t encoded_size = encoder.encoded_size();
+    CHECK(encoded_size == size_t(2 * bases_before + 1) * 4 * 24);
+
+    // Write every context back to back, as the chunks of a read would be.
+    std::vector<int8_t> buffer(read.seq.size() * encoded_size, -1);
+    for (size_t pos = 0; pos < read.seq.size(); ++pos) {
+        const auto context = encoder.get_context(pos, &buffer[pos * encoded_size]);
+        CHECK(context.data.empty());
+    }
+    for (size_t pos = 0; pos < read.seq.size(); ++pos) {
+        CAPTURE(pos);
+        const auto expected = encoder.get_context(pos);
+        const std::vector<int8_t> actual(buffer.begin() + pos * encoded_size,
+                                         buffer.begin() + (pos + 1) * encoded_size);
+        CHECK(expected.data == actual);
+    }
+}
+
+TEST_CASE("Benchmark modbase chunk encoding", "[.benchmark]" TEST_GROUP) {
+    // A 50kb read with CpG contexts, encoded as for a 9mer model with 200 sample chunks.
+    const size_t kBlockStride = 6;
+    const auto read = make_synthetic_read(50000, kBlockStride);
+    auto seq_ints = dorado::utils::sequence_to_ints(read.seq);
+    auto seq_to_sig_map = dorado::utils::moves_to_map(
+            read.moves, kBlockStride, read.moves.size() * kBlockStride, std::nullopt);
+    std::vector<size_t> context_hits;
+    for (size_t pos = 0; pos + 1 < read.seq.size(); ++pos) {
+        if (read.seq[pos] == 'C' && read.seq[pos + 1] == 'G') {
+            context_hits.push_back(pos);
+        }
+    }
+
+    dorado::modbase::ModBaseEncoder encoder(kBlockStride, 200, 4, 4);
+    encoder.init(seq_ints, seq_to_sig_map);
+
+    BENCHMARK("Allocation per chunk") {
+        std::vector<std::vector<int8_t>> chunks;
+        chunks.reserve(context_hits.size());
+        for (auto context_hit : context_hits) {
+            chunks.push_back(encoder.get_context(context_hit).data);
+        }
+        return chunks;
+    };
+
+    // As ModBaseCallerNode does, reuse the buffer from one read to the next.
+    const size_t encoded_size = encoder.encoded_size();
+    std::vector<int8_t> buffer;
+    BENCHMARK("Reused buffer per read") {
+        buffer.resize(context_hits.size() * encoded_size);
+        for (size_t i = 0; i < context_hits.size(); ++i) {
+            encoder.get_context(context_hits[i], &buffer[i * encoded_size]);
+        }
+        return buffer.data();
+    };
+}
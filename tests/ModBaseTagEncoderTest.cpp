@@ -0,0 +1,112 @@
+#include "modbase/ModBaseTagEncoder.h"
+#include "utils/types.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#define TEST_GROUP "[modbase_tag_encoder]"
+
+using Catch::Matchers::Equals;
+using dorado::ModBaseInfo;
+using dorado::modbase::ModBaseTagEncoder;
+
+namespace {
+
+// A 5mC model, with calls on both the C and G of each strand.
+const std::vector<std::string> ALPHABET = {"A", "C", "m", "G", "T"};
+const std::string SEQ = "TCGACGGTCCGA";
+
+std::vector<uint8_t> probs_5mC() {
+    const std::vector<uint8_t> mod_probs = {0, 200, 0, 0, 30, 0, 220, 0, 0, 90, 0, 0};
+    std::vector<uint8_t> probs(SEQ.size() * ALPHABET.size(), 0);
+    for (size_t i = 0; i < SEQ.size(); ++i) {
+        probs[i * ALPHABET.size() + 2] = mod_probs[i];
+    }
+    return probs;
+}
+
+}  // namespace
+
+TEST_CASE("ModBaseTagEncoder simplex tags", TEST_GROUP) {
+    const auto probs = probs_5mC();
+
+    SECTION("No context") {
+        ModBaseTagEncoder encoder(ModBaseInfo(ALPHABET, "5mC", ""));
+        REQUIRE(encoder.encode(SEQ, probs, false, 0));
+        CHECK_THAT(encoder.mm(), Equals("C+m.,0,0,0,0;"));
+        CHECK(encoder.ml() == std::vector<uint8_t>{200, 30, 0, 90});
+
+        REQUIRE(encoder.encode(SEQ, probs, false, 100));
+        CHECK_THAT(encoder.mm(), Equals("C+m.,0;"));
+        CHECK(encoder.ml() == std::vector<uint8_t>{200});
+    }
+
+    SECTION("CpG context ignores the threshold") {
+        ModBaseTagEncoder encoder(ModBaseInfo(ALPHABET, "5mC", "_:XG:_:_"));
+        for (const uint8_t threshold : {0, 100}) {
+            REQUIRE(encoder.encode(SEQ, probs, false, threshold));
+            CHECK_THAT(encoder.mm(), Equals("C+m?,0,0,1;"));
+            CHECK(encoder.ml() == std::vector<uint8_t>{200, 30, 90});
+        }
+    }
+}
+
+TEST_CASE("ModBaseTagEncoder duplex tags", TEST_GROUP) {
+    const auto probs = probs_5mC();
+
+    SECTION("No context") {
+        ModBaseTagEncoder encoder(ModBaseInfo(ALPHABET, "5mC", ""));
+        REQUIRE(encoder.encode(SEQ, probs, true, 0));
+        CHECK_THAT(encoder.mm(), Equals("C+m.,0,0,0,0;G-m.,0,0,0,0;"));
+        CHECK(encoder.ml() == std::vector<uint8_t>{200, 30, 0, 90, 0, 0, 220, 0});
+
+        REQUIRE(encoder.encode(SEQ, probs, true, 100));
+        CHECK_THAT(encoder.mm(), Equals("C+m.,0;G-m.,2;"));
+        CHECK(encoder.ml() == std::vector<uint8_t>{200, 220});
+    }
+
+    SECTION("CpG context matches the complement strand") {
+        // The GG at positions 5-6 is only a CpG on the forward strand.
+        ModBaseTagEncoder encoder(ModBaseInfo(ALPHABET, "5mC", "_:XG:_:_"));
+        REQUIRE(encoder.encode(SEQ, probs, true, 100));
+        CHECK_THAT(encoder.mm(), Equals("C+m?,0,0,1;G-m?,0,0,1;"));
+        CHECK(encoder.ml() == std::vector<uint8_t>{200, 30, 90, 0, 0, 0});
+    }
+}
+
+TEST_CASE("ModBaseTagEncoder rejects invalid codes", TEST_GROUP) {
+    ModBaseTagEncoder encoder(ModBaseInfo({"A", "C", "mq", "G", "T"}, "5mC", ""));
+    CHECK_FALSE(encoder.encode(SEQ, probs_5mC(), false, 0));
+    CHECK(encoder.mm().empty());
+    CHECK(encoder.ml().empty());
+}
+
+TEST_CASE("ModBaseTagEncoder rejects invalid contexts", TEST_GROUP) {
+    CHECK_THROWS(ModBaseTagEncoder(ModBaseInfo(ALPHABET, "5mC", "_:CG:_:_")));
+}
+
+TEST_CASE("Benchmark modbase tag encoding", "[.benchmark]" TEST_GROUP) {
+    // A 100kb read called with a 5mC and 6mA model.
+    const std::vector<std::string> alphabet = {"A", "a", "C", "m", "G", "T"};
+    std::minstd_rand rng(42);
+    std::uniform_int_distribution<int> dist(0, 255);
+    std::string seq;
+    std::vector<uint8_t> probs;
+    for (size_t i = 0; i < 100000; ++i) {
+        seq += "ACGT"[dist(rng) & 3];
+        for (size_t j = 0; j < alphabet.size(); ++j) {
+            probs.push_back(uint8_t(dist(rng)));
+        }
+    }
+
+    for (const std::string context : {"", "_:XG:_:_"}) {
+        ModBaseTagEncoder encoder(ModBaseInfo(alphabet, "6mA 5mC", context));
+        const std::string suffix = context.empty() ? "" : " CpG";
+        BENCHMARK("Simplex tags" + suffix) { return encoder.encode(seq, probs, false, 128); };
+        BENCHMARK("Duplex tags" + suffix) { return encoder.encode(seq, probs, true, 128); };
+    }
+}
@@ -4,6 +4,12 @@
 
 #include <catch2/catch.hpp>
 
+#include <random>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #define TEST_GROUP "[modbase_motif_matcher]"
 
 using std::make_tuple;
@@ -46,3 +52,77 @@ TEST_CASE(TEST_GROUP ": test motifs", TEST_GROUP) {
     auto hits = matcher.get_motif_hits(SEQ);
     CHECK(hits == expected_results);
 }
+
+namespace {
+
+// The regex based matcher that MotifMatcher replaced, kept as a reference.
+std::vector<size_t> get_motif_hits_regex(const std::string& motif,
+                                         size_t motif_offset,
+                                         const std::string& seq) {
+    const std::unordered_map<char, std::string> iupac_codes = {
+            // clang-format off
+            {'A', "A"}, {'C', "C"}, {'G', "G"}, {'T', "T"}, {'U', "T"},
+            {'R', "[AG]"}, {'Y', "[CT]"}, {'S', "[GC]"}, {'W', "[AT]"}, {'K', "[GT]"},
+            {'M', "[AC]"}, {'B', "[CGT]"}, {'D', "[AGT]"}, {'H', "[ACT]"}, {'V', "[ACG]"},
+            {'N', "[ACGT]"},
+            // clang-format on
+    };
+    std::string motif_regex = "(";
+    for (auto base : motif) {
+        motif_regex += iupac_codes.at(base);
+    }
+    motif_regex += ")";
+
+    std::vector<size_t> context_hits;
+    std::regex regex(motif_regex);
+    auto pos = seq.cbegin();
+    std::smatch motif_match;
+    while (std::regex_search(pos, seq.cend(), motif_match, regex)) {
+        context_hits.push_back(std::distance(seq.cbegin(), pos) + motif_match.position(0) +
+                               motif_offset);
+        pos += motif_match.position(0) + 1;
+    }
+    return context_hits;
+}
+
+std::string random_sequence(size_t length, const std::string& alphabet, unsigned seed) {
+    std::minstd_rand rng(seed);
+    std::uniform_int_distribution<size_t> dist(0, alphabet.size() - 1);
+    std::string seq(length, 'A');
+    for (auto& base : seq) {
+        base = alphabet[dist(rng)];
+    }
+    return seq;
+}
+
+}  // namespace
+
+TEST_CASE(TEST_GROUP ": matches the regex implementation", TEST_GROUP) {
+    auto [motif, motif_offset] = GENERATE(table<std::string, size_t>({
+            make_tuple("CG", 0),
+            make_tuple("CHG", 0),
+            make_tuple("CHH", 0),
+            make_tuple("DRACH", 2),
+            make_tuple("GATC", 1),
+            make_tuple("A", 0),
+            make_tuple("NNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNNC", 40),
+            make_tuple(std::string(70, 'N') + "CG", 70),
+    }));
+    // Include some characters that shouldn't match anything.
+    const std::string alphabet = GENERATE(as<std::string>{}, "ACGT", "ACGTNacgtU");
+    const size_t seq_len = GENERATE(0, 1, 5, 31, 32, 33, 100, 4099);
+    CAPTURE(motif, motif_offset, alphabet, seq_len);
+
+    const auto seq = random_sequence(seq_len, alphabet, unsigned(seq_len));
+    dorado::modbase::MotifMatcher matcher(motif, motif_offset);
+    CHECK(matcher.get_motif_hits(seq) == get_motif_hits_regex(motif, motif_offset, seq));
+}
+
+TEST_CASE(TEST_GROUP ": motif search benchmark", "[.benchmark]" TEST_GROUP) {
+    const auto seq = random_sequence(100'000, "ACGT", 42);
+    for (const std::string motif : {"CG", "CHG", "DRACH"}) {
+        dorado::modbase::MotifMatcher matcher(motif, 0);
+        BENCHMARK("regex " + motif) { return get_motif_hits_regex(motif, 0, seq); };
+        BENCHMARK("MotifMatcher " + motif) { return matcher.get_motif_hits(seq); };
+    }
+}
@@ -1,7 +1,9 @@
 #include "MessageSinkUtils.h"
 #include "TestUtils.h"
 #include "api/runner_creation.h"
+#include "basecall/CPUCaller.h"
 #include "basecall/CRFModelConfig.h"
+#include "basecall/ModelRunner.h"
 #include "models/models.h"
 #include "read_pipeline/AdapterDetectorNode.h"
 #include "read_pipeline/BarcodeClassifierNode.h"
@@ -29,6 +31,8 @@
 #include <filesystem>
 #include <functional>
 #include <random>
+#include <thread>
+#include <vector>
 
 #ifndef _WIN32
 #include <unistd.h>
@@ -230,6 +234,65 @@ DEFINE_TEST(NodeSmokeTestRead, "BasecallerNode") {
                                            1000, "BasecallerNode", 0);
 }
 
+TEST_CASE("SmokeTest: CPU runners sharing a caller", "[SmokeTest]") {
+    const char model_name[] = "dna_r10.4.1_e8.2_400bps_fast@v4.2.0";
+    const auto model_dir = download_model(model_name);
+    auto model_config = dorado::basecall::load_crf_model_config(model_dir.m_path / model_name);
+
+    // Deeper than the default, so that several batches are queued up in the caller at once.
+    constexpr int pipeline_depth = 3;
+    constexpr int batch_size = 4;
+    constexpr int num_iterations = 3;
+    const int chunk_size = model_config.stride * 200;
+
+    using DecodedChunks = std::vector<dorado::basecall::decode::DecodedChunk>;
+    auto caller = std::make_shared<dorado::basecall::CPUCaller>(model_config, "cpu");
+    std::vector<std::unique_ptr<dorado::basecall::ModelRunner>> runners;
+    std::vector<DecodedChunks> expected;
+    for (int i = 0; i < pipeline_depth; ++i) {
+        auto& runner = runners.emplace_back(
+                std::make_unique<dorado::basecall::ModelRunner>(caller, chunk_size, batch_size));
+        for (int chunk_idx = 0; chunk_idx < batch_size; ++chunk_idx) {
+            auto chunk = at::randn({model_config.num_features, int64_t(runner->chunk_size())});
+            runner->accept_chunk(chunk_idx, chunk.to(caller->dtype()));
+        }
+        // Each runner asks for a different number of chunks, so mixed up results are caught.
+        // Calling them one at a time gives the results to expect.
+        expected.push_back(runner->call_chunks(batch_size - i));
+        REQUIRE(expected.back().size() == size_t(batch_size - i));
+    }
+
+    // Now call all of the runners at once, so that their batches are pipelined through the caller.
+    std::vector<std::vector<DecodedChunks>> results(pipeline_depth);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < pipeline_depth; ++i) {
+        threads.emplace_back([&, i] {
+            for (int iteration = 0; iteration < num_iterations; ++iteration) {
+                results[i].push_back(runners[i]->call_chunks(batch_size - i));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (int i = 0; i < pipeline_depth; ++i) {
+        CAPTURE(i);
+        REQUIRE(results[i].size() == size_t(num_iterations));
+        for (const auto& result : results[i]) {
+            REQUIRE(result.size() == expected[i].size());
+            for (size_t chunk_idx = 0; chunk_idx < result.size(); ++chunk_idx) {
+                CAPTURE(chunk_idx);
+                CHECK(result[chunk_idx].sequence == expected[i][chunk_idx].sequence);
+                CHECK(result[chunk_idx].qstring == expected[i][chunk_idx].qstring);
+                CHECK(result[chunk_idx].moves == expected[i][chunk_idx].moves);
+            }
+        }
+    }
+    CHECK(caller->sample_stats().at("batches_called") ==
+          double(pipeline_depth * (num_iterations + 1)));
+}
+
 DEFINE_TEST(NodeSmokeTestRead, "ModBaseCallerNode") {
     auto gpu = GENERATE(true, false);
     CAPTURE(gpu);
@@ -94,3 +94,46 @@ TEST_CASE("Split read pairing", TEST_GROUP) {
             });
     CHECK(num_pairs == 2);
 }
+
+TEST_CASE("Pairing across many channels with multiple threads", TEST_GROUP) {
+    // Reads from many channels are spread over the read cache shards, and a small cache depth
+    // forces pores to be evicted while other threads are still working on them.
+    const int num_channels = 100;
+    const int reads_per_channel = 5;
+    const size_t cache_depth = 10;
+
+    dorado::PipelineDescriptor pipeline_desc;
+    std::vector<dorado::Message> messages;
+    auto sink = pipeline_desc.add_node<MessageSinkToVector>({}, 100, messages);
+    auto pairing_node = pipeline_desc.add_node<dorado::PairingNode>(
+            {sink}, dorado::DuplexPairingParameters{dorado::ReadOrder::BY_CHANNEL, cache_depth},
+            4, 100);
+    auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
+
+    for (int i = 0; i < reads_per_channel; ++i) {
+        for (int channel = 0; channel < num_channels; ++channel) {
+            auto read = make_read(i * 20000, 100);
+            read->read_common.attributes.channel_number = channel;
+            read->read_common.read_id = std::to_string(channel) + "_" + std::to_string(i);
+            pipeline->push_message(std::move(read));
+        }
+    }
+
+    const auto& node = dynamic_cast<dorado::PairingNode&>(pipeline->get_node_ref(pairing_node));
+    pipeline->terminate({});
+    const auto stats = node.sample_stats();
+    pipeline.reset();
+
+    // Every read must come out exactly once, and none of them are long enough to pair.
+    auto num_reads =
+            std::count_if(messages.begin(), messages.end(), [](const dorado::Message& message) {
+                return std::holds_alternative<dorado::SimplexReadPtr>(message);
+            });
+    CHECK(num_reads == num_channels * reads_per_channel);
+    CHECK(messages.size() == size_t(num_reads));
+
+    CHECK(stats.at("cached_signal_mb") == 0);
+    CHECK(stats.at("cache_lock_acquisitions") >= num_channels * reads_per_channel);
+    CHECK(stats.count("cache_contended_locks") == 1);
+    CHECK(stats.count("cache_shard_0_contended_locks") == 1);
+}
@@ -0,0 +1,156 @@
+#include "utils/PairwiseOverlapper.h"
+
+#include "TestUtils.h"
+#include "utils/sequence_utils.h"
+#include "utils/types.h"
+
+#include <catch2/catch.hpp>
+#include <minimap.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define TEST_GROUP "[PairwiseOverlapper]"
+
+namespace {
+
+using Overlap = dorado::utils::PairwiseOverlapper::Overlap;
+
+struct CandidatePair {
+    std::string temp_seq;
+    std::string comp_seq;
+};
+
+// Build a set of duplex candidate pairs from the reads in the aligner test dataset. Each read is
+// paired with a truncated reverse complement of itself, which should overlap, and with the next
+// read in the file, which shouldn't.
+std::vector<CandidatePair> load_candidate_pairs() {
+    std::ifstream fastq(get_aligner_data_dir() / "dataset.fastq");
+    std::vector<std::string> seqs;
+    std::string line;
+    for (size_t line_num = 0; std::getline(fastq, line); ++line_num) {
+        if (line_num % 4 == 1) {
+            seqs.push_back(std::move(line));
+        }
+    }
+    REQUIRE(!seqs.empty());
+
+    std::vector<CandidatePair> pairs;
+    for (size_t i = 0; i < seqs.size(); ++i) {
+        const auto& seq = seqs[i];
+        auto seq_rc = dorado::utils::reverse_complement(seq);
+        seq_rc = seq_rc.substr(0, size_t(seq_rc.length() * 0.9f));
+        pairs.push_back({seq, std::move(seq_rc)});
+        pairs.push_back({seq, seqs[(i + 1) % seqs.size()]});
+    }
+    return pairs;
+}
+
+// The original per-pair overlap check, which sets up all of the minimap2 state from scratch.
+Overlap reference_overlap(const std::string& temp_seq, const std::string& comp_seq) {
+    mm_idxopt_t idx_opt;
+    mm_mapopt_t map_opt;
+    mm_set_opt(0, &idx_opt, &map_opt);
+    mm_set_opt("map-hifi", &idx_opt, &map_opt);
+
+    std::vector<const char*> seqs = {temp_seq.c_str()};
+    std::vector<const char*> names = {"temp"};
+    mm_idx_t* index = mm_idx_str(idx_opt.w, idx_opt.k, 0, idx_opt.bucket_bits, 1, seqs.data(),
+                                 names.data());
+    mm_mapopt_update(&map_opt, index);
+
+    dorado::MmTbufPtr tbuf(mm_tbuf_init());
+
+    int hits = 0;
+    mm_reg1_t* reg = mm_map(index, int(comp_seq.length()), comp_seq.c_str(), &hits, tbuf.get(),
+                            &map_opt, "comp");
+
+    mm_idx_destroy(index);
+
+    Overlap overlap{hits, 0, false, 0, 0, 0, 0};
+    if (hits > 0) {
+        auto best_map = std::max_element(
+                reg, reg + hits,
+                [](const mm_reg1_t& l, const mm_reg1_t& r) { return l.mapq < r.mapq; });
+        overlap.mapq = uint8_t(best_map->mapq);
+        overlap.rev = best_map->rev;
+        overlap.ref_start = best_map->rs;
+        overlap.ref_end = best_map->re;
+        overlap.query_start = best_map->qs;
+        overlap.query_end = best_map->qe;
+    }
+
+    for (int i = 0; i < hits; ++i) {
+        free(reg[i].p);
+    }
+    free(reg);
+
+    return overlap;
+}
+
+}  // namespace
+
+TEST_CASE("Overlaps match a from-scratch minimap2 mapping", TEST_GROUP) {
+    const auto pairs = load_candidate_pairs();
+
+    dorado::utils::PairwiseOverlapper overlapper;
+    size_t num_overlapping = 0;
+    for (const auto& [temp_seq, comp_seq] : pairs) {
+        CAPTURE(temp_seq.length(), comp_seq.length());
+        const auto expected = reference_overlap(temp_seq, comp_seq);
+        const auto overlap = overlapper.overlap(temp_seq, "temp", comp_seq, "comp");
+        REQUIRE(overlap.num_hits == expected.num_hits);
+        if (expected.num_hits == 0) {
+            continue;
+        }
+        ++num_overlapping;
+        CHECK(overlap.mapq == expected.mapq);
+        CHECK(overlap.rev == expected.rev);
+        CHECK(overlap.ref_start == expected.ref_start);
+        CHECK(overlap.ref_end == expected.ref_end);
+        CHECK(overlap.query_start == expected.query_start);
+        CHECK(overlap.query_end == expected.query_end);
+    }
+
+    // Make sure that the test actually exercised some overlaps.
+    CHECK(num_overlapping >= pairs.size() / 4);
+}
+
+TEST_CASE("Overlapping a read with its reverse complement", TEST_GROUP) {
+    const std::string seq =
+            ReadFileIntoString(std::filesystem::path(get_aligner_data_dir()) / "long_target.fa");
+    auto temp_seq = seq.substr(seq.find('\n') + 1);
+    temp_seq.erase(std::remove(temp_seq.begin(), temp_seq.end(), '\n'), temp_seq.end());
+    const auto comp_seq = dorado::utils::reverse_complement(temp_seq);
+
+    dorado::utils::PairwiseOverlapper overlapper;
+    const auto overlap = overlapper.overlap(temp_seq, "temp", comp_seq, "comp");
+    REQUIRE(overlap.num_hits > 0);
+    CHECK(overlap.rev);
+    CHECK(overlap.mapq >= 50);
+}
+
+TEST_CASE("Benchmark duplex candidate pair overlaps", "[.benchmark]" TEST_GROUP) {
+    const auto pairs = load_candidate_pairs();
+
+    BENCHMARK("From scratch") {
+        size_t num_hits = 0;
+        for (const auto& [temp_seq, comp_seq] : pairs) {
+            num_hits += reference_overlap(temp_seq, comp_seq).num_hits;
+        }
+        return num_hits;
+    };
+
+    dorado::utils::PairwiseOverlapper overlapper;
+    BENCHMARK("Reused PairwiseOverlapper") {
+        size_t num_hits = 0;
+        for (const auto& [temp_seq, comp_seq] : pairs) {
+            num_hits += overlapper.overlap(temp_seq, "temp", comp_seq, "comp").num_hits;
+        }
+        return num_hits;
+    };
+}
@@ -0,0 +1,144 @@
+#include "demux/PatternBank.h"
+
+#include <catch2/catch.hpp>
+#include <edlib.h>
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define TEST_GROUP "[pattern_bank]"
+
+using dorado::demux::PatternBank;
+
+namespace {
+
+const std::vector<std::pair<char, char>> N_EQUALITIES = {
+        {'N', 'A'}, {'N', 'T'}, {'N', 'C'}, {'N', 'G'}};
+
+// The result edlib gives when aligning a pattern against the text on its own.
+struct EdlibResult {
+    int edit_distance;
+    int start;
+    int end;
+};
+
+EdlibResult edlib_align(const std::string& pattern,
+                        const std::string& text,
+                        EdlibAlignMode mode,
+                        bool use_n) {
+    std::vector<EdlibEqualityPair> equalities;
+    if (use_n) {
+        for (const auto& [first, second] : N_EQUALITIES) {
+            equalities.push_back({first, second});
+        }
+    }
+    EdlibAlignConfig config = edlibDefaultAlignConfig();
+    config.mode = mode;
+    config.task = EDLIB_TASK_LOC;
+    config.additionalEqualities = equalities.data();
+    config.additionalEqualitiesLength = int(equalities.size());
+    auto result = edlibAlign(pattern.data(), int(pattern.length()), text.data(),
+                             int(text.length()), config);
+    REQUIRE(result.status == EDLIB_STATUS_OK);
+    // edlib doesn't give a start location when the text is empty.
+    EdlibResult edlib_result{result.editDistance,
+                             result.startLocations ? result.startLocations[0] : 0,
+                             result.endLocations ? result.endLocations[0] : -1};
+    edlibFreeAlignResult(result);
+    return edlib_result;
+}
+
+std::string random_sequence(std::minstd_rand& rng, size_t length, const char* alphabet) {
+    const size_t alphabet_size = std::char_traits<char>::length(alphabet);
+    std::string sequence;
+    for (size_t i = 0; i < length; ++i) {
+        sequence += alphabet[rng() % alphabet_size];
+    }
+    return sequence;
+}
+
+}  // namespace
+
+TEST_CASE("PatternBank simple matches", TEST_GROUP) {
+    const PatternBank bank({"ACGT", "GGGG", "TTACG"});
+    CHECK(bank.size() == 3);
+    CHECK(bank.pattern(1) == "GGGG");
+
+    CHECK(bank.global_distances("ACGT") == std::vector<int>{0, 3, 3});
+    CHECK(bank.global_distances("") == std::vector<int>{4, 4, 5});
+
+    const auto matches = bank.infix_matches("CCTTACGTCC");
+    CHECK(matches[0].edit_distance == 0);
+    CHECK(matches[0].start == 4);
+    CHECK(matches[0].end == 7);
+    CHECK(matches[2].edit_distance == 0);
+    CHECK(matches[2].start == 2);
+    CHECK(matches[2].end == 6);
+
+    // No match at all in an empty text.
+    const auto empty_matches = bank.infix_matches("");
+    CHECK(empty_matches[1].edit_distance == 4);
+    CHECK(empty_matches[1].start == 0);
+    CHECK(empty_matches[1].end == -1);
+
+    CHECK_THROWS(PatternBank({"ACGT", ""}));
+}
+
+TEST_CASE("PatternBank matches edlib", TEST_GROUP) {
+    std::minstd_rand rng(42);
+    const bool use_n = GENERATE(false, true);
+    // Long patterns span several 64 bit blocks, including patterns which fill them exactly.
+    const size_t max_length = GENERATE(40, 150);
+    CAPTURE(use_n, max_length);
+
+    for (int iteration = 0; iteration < 50; ++iteration) {
+        std::vector<std::string> patterns;
+        const size_t num_patterns = 1 + rng() % 9;
+        for (size_t i = 0; i < num_patterns; ++i) {
+            const size_t length = (i == 0 && max_length > 64) ? 128 : 1 + rng() % max_length;
+            patterns.push_back(random_sequence(rng, length, use_n ? "ACGTN" : "ACGT"));
+        }
+        auto text = random_sequence(rng, rng() % (max_length + 20), "ACGTX");
+        // Plant a noisy copy of the first pattern, so that there's a good match to find.
+        const size_t position = text.empty() ? 0 : rng() % text.length();
+        for (size_t i = 0; i < patterns[0].length() && position + i < text.length(); ++i) {
+            if (rng() % 8 != 0) {
+                text[position + i] = patterns[0][i];
+            }
+        }
+        CAPTURE(text);
+
+        const auto bank = use_n ? PatternBank(patterns, N_EQUALITIES) : PatternBank(patterns);
+        const auto global = bank.global_distances(text);
+        const auto infix = bank.infix_matches(text);
+        REQUIRE(global.size() == num_patterns);
+        REQUIRE(infix.size() == num_patterns);
+        for (size_t i = 0; i < num_patterns; ++i) {
+            const auto& pattern = patterns[i];
+            CAPTURE(pattern);
+            const auto expected_global = edlib_align(pattern, text, EDLIB_MODE_NW, use_n);
+            CHECK(global[i] == expected_global.edit_distance);
+
+            const auto expected_infix = edlib_align(pattern, text, EDLIB_MODE_HW, use_n);
+            CHECK(infix[i].edit_distance == expected_infix.edit_distance);
+            CHECK(infix[i].start == expected_infix.start);
+            CHECK(infix[i].end == expected_infix.end);
+        }
+    }
+}
+
+TEST_CASE("Benchmark PatternBank", "[.benchmark]" TEST_GROUP) {
+    // A 96 barcode kit, padded with its flank buffers, scored against a mask region.
+    std::minstd_rand rng(42);
+    std::vector<std::string> barcodes;
+    for (int i = 0; i < 96; ++i) {
+        barcodes.push_back(random_sequence(rng, 39, "ACGT"));
+    }
+    const auto mask = random_sequence(rng, 55, "ACGT");
+    const PatternBank bank(barcodes);
+
+    BENCHMARK("Global distances") { return bank.global_distances(mask); };
+    BENCHMARK("Infix matches") { return bank.infix_matches(mask); };
+}
@@ -1,9 +1,13 @@
 #include "MessageSinkUtils.h"
 #include "read_pipeline/NullNode.h"
+#include "read_pipeline/ReadFilterNode.h"
 #include "read_pipeline/ReadPipeline.h"
 
 #include <catch2/catch.hpp>
 
+#include <string>
+#include <vector>
+
 #define TEST_GROUP "[Pipeline]"
 
 using dorado::MessageSink;
@@ -12,6 +16,49 @@ using dorado::NullNode;
 using dorado::Pipeline;
 using dorado::PipelineDescriptor;
 
+namespace {
+
+// Makes a short read that passes ReadFilterNode's default filters.
+dorado::SimplexReadPtr make_read(const std::string& read_id) {
+    auto read = std::make_unique<dorado::SimplexRead>();
+    read->read_common.read_id = read_id;
+    read->read_common.seq = "ACGTACGT";
+    read->read_common.qstring = "////////";
+    return read;
+}
+
+// Node that does nothing but forward messages, either one at a time or in batches of up to
+// batch_size, so that the cost of the hand-off between nodes can be measured on its own.
+class ForwardingNode : public MessageSink {
+public:
+    explicit ForwardingNode(size_t batch_size) : MessageSink(1000, 1), m_batch_size(batch_size) {
+        start_input_processing(&ForwardingNode::input_thread_fn, this);
+    }
+    ~ForwardingNode() { stop_input_processing(); }
+    std::string get_name() const override { return "ForwardingNode"; }
+    void terminate(const dorado::FlushOptions&) override { stop_input_processing(); }
+    void restart() override { start_input_processing(&ForwardingNode::input_thread_fn, this); }
+
+private:
+    void input_thread_fn() {
+        if (m_batch_size == 1) {
+            dorado::Message message;
+            while (get_input_message(message)) {
+                send_message_to_sink(std::move(message));
+            }
+        } else {
+            std::vector<dorado::Message> messages;
+            while (get_input_messages(messages, m_batch_size)) {
+                send_messages_to_sink(std::move(messages));
+            }
+        }
+    }
+
+    const size_t m_batch_size;
+};
+
+}  // namespace
+
 TEST_CASE("Creation", TEST_GROUP) {
     {
         // Empty pipelines are not allowed.
@@ -187,4 +234,96 @@ TEST_CASE("TerminateRestart", TEST_GROUP) {
     pipeline->push_message(std::make_unique<dorado::SimplexRead>());
     pipeline.reset();
     CHECK(messages.size() == 2);
-}
\ No newline at end of file
+}
+
+// Test batches of messages make it through nodes that consume batches, in order.
+TEST_CASE("BatchedFlow", TEST_GROUP) {
+    PipelineDescriptor pipeline_desc;
+    std::vector<dorado::Message> messages;
+    auto sink = pipeline_desc.add_node<MessageSinkToVector>({}, 100, messages);
+    pipeline_desc.add_node<dorado::ReadFilterNode>({sink}, 0, 0,
+                                                   std::unordered_set<std::string>{}, 1);
+    auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
+    REQUIRE(pipeline != nullptr);
+
+    // More messages than the sink's queue can hold, so the batched push has to block.
+    const int kNumReads = 1000;
+    std::vector<dorado::Message> batch;
+    for (int i = 0; i < kNumReads; ++i) {
+        batch.push_back(make_read(std::to_string(i)));
+        if (batch.size() == 64) {
+            pipeline->push_messages(std::move(batch));
+            CHECK(batch.empty());
+        }
+    }
+    pipeline->push_messages(std::move(batch));
+    pipeline.reset();
+
+    auto reads = ConvertMessages<dorado::SimplexReadPtr>(std::move(messages));
+    REQUIRE(reads.size() == kNumReads);
+    for (int i = 0; i < kNumReads; ++i) {
+        CHECK(reads[i]->read_common.read_id == std::to_string(i));
+    }
+}
+
+// Test node timings are reported along with the node's own stats.
+TEST_CASE("NodeTimingStats", TEST_GROUP) {
+    PipelineDescriptor pipeline_desc;
+    std::vector<dorado::Message> messages;
+    auto sink = pipeline_desc.add_node<MessageSinkToVector>({}, 100, messages);
+    pipeline_desc.add_node<dorado::ReadFilterNode>({sink}, 0, 0,
+                                                   std::unordered_set<std::string>{}, 1);
+    auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
+    REQUIRE(pipeline != nullptr);
+
+    const int kNumReads = 10;
+    for (int i = 0; i < kNumReads; ++i) {
+        pipeline->push_message(make_read(std::to_string(i)));
+    }
+    const auto stats = pipeline->terminate(dorado::DefaultFlushOptions());
+    CHECK(messages.size() == kNumReads);
+
+    CHECK(stats.at("ReadFilterNode.processing_count") == kNumReads);
+    CHECK(stats.at("ReadFilterNode.input_wait_count") >= 1);
+    CHECK(stats.at("ReadFilterNode.input_wait_count") <= kNumReads);
+    CHECK(stats.at("ReadFilterNode.push_wait_count") >= 1);
+    for (const auto* prefix : {"input_wait", "processing", "push_wait"}) {
+        const std::string name = std::string("ReadFilterNode.") + prefix;
+        CHECK(stats.at(name + "_p50_ms") <= stats.at(name + "_p99_ms"));
+        CHECK(stats.at(name + "_p99_ms") <= stats.at(name + "_max_ms"));
+    }
+}
+
+// Compares the time taken to pass reads through a chain of forwarding nodes, terminated by a
+// NullNode, when messages are handed on one at a time and when they're handed on in batches.
+// The nodes are the same in both cases, so only the hand-off differs.
+TEST_CASE("Benchmark batched hand-off", TEST_GROUP "[.benchmark]") {
+    const int num_nodes = GENERATE(1, 5, 10);
+    const int kNumReads = 10000;
+    const size_t kBatchSize = 32;
+
+    auto run_chain = [num_nodes](size_t batch_size) {
+        PipelineDescriptor pipeline_desc;
+        auto sink = pipeline_desc.add_node<NullNode>({});
+        for (int i = 0; i < num_nodes; ++i) {
+            sink = pipeline_desc.add_node<ForwardingNode>({sink}, batch_size);
+        }
+        auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
+        std::vector<dorado::Message> batch;
+        for (int i = 0; i < kNumReads; ++i) {
+            if (batch_size == 1) {
+                pipeline->push_message(make_read("read"));
+                continue;
+            }
+            batch.push_back(make_read("read"));
+            if (batch.size() == batch_size) {
+                pipeline->push_messages(std::move(batch));
+            }
+        }
+        pipeline->push_messages(std::move(batch));
+        pipeline.reset();
+    };
+
+    BENCHMARK("Unbatched, " + std::to_string(num_nodes) + " nodes") { run_chain(1); };
+    BENCHMARK("Batched, " + std::to_string(num_nodes) + " nodes") { run_chain(kBatchSize); };
+}
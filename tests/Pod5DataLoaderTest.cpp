@@ -8,12 +8,12 @@
 #define TEST_GROUP "Pod5DataLoaderTest: "
 
 TEST_CASE(TEST_GROUP "Test loading single-read POD5 file from data dir, empty read list") {
-    auto read_list = std::unordered_set<std::string>();
+    auto read_list = dorado::utils::ReadIdSet();
     CHECK(CountSinkReads(get_pod5_data_dir(), "cpu", 1, 0, read_list, {}) == 0);
 }
 
 TEST_CASE(TEST_GROUP "Test loading single-read POD5 file from single file path, empty read list") {
-    auto read_list = std::unordered_set<std::string>();
+    auto read_list = dorado::utils::ReadIdSet();
     CHECK(CountSinkReads(get_single_pod5_file_path(), "cpu", 1, 0, read_list, {}) == 0);
 }
 
@@ -26,24 +26,24 @@ TEST_CASE(TEST_GROUP "Test loading single-read POD5 file from single file path,
 }
 
 TEST_CASE(TEST_GROUP "Test loading single-read POD5 file from data dir, mismatched read list") {
-    auto read_list = std::unordered_set<std::string>{"read_1"};
+    auto read_list = dorado::utils::ReadIdSet{"read_1"};
     CHECK(CountSinkReads(get_pod5_data_dir(), "cpu", 1, 0, read_list, {}) == 0);
 }
 
 TEST_CASE(TEST_GROUP
           "Test loading single-read POD5 file from single file path, mismatched read list") {
-    auto read_list = std::unordered_set<std::string>{"read_1"};
+    auto read_list = dorado::utils::ReadIdSet{"read_1"};
     CHECK(CountSinkReads(get_single_pod5_file_path(), "cpu", 1, 0, read_list, {}) == 0);
 }
 
 TEST_CASE(TEST_GROUP "Test loading single-read POD5 file from data dir, matched read list") {
-    auto read_list = std::unordered_set<std::string>{"002bd127-db82-436f-b828-28567c3d505d"};
+    auto read_list = dorado::utils::ReadIdSet{"002bd127-db82-436f-b828-28567c3d505d"};
     CHECK(CountSinkReads(get_pod5_data_dir(), "cpu", 1, 0, read_list, {}) == 1);
 }
 
 TEST_CASE(TEST_GROUP
           "Test loading single-read POD5 file from single file path, matched read list") {
-    auto read_list = std::unordered_set<std::string>{"002bd127-db82-436f-b828-28567c3d505d"};
+    auto read_list = dorado::utils::ReadIdSet{"002bd127-db82-436f-b828-28567c3d505d"};
     CHECK(CountSinkReads(get_single_pod5_file_path(), "cpu", 1, 0, read_list, {}) == 1);
 }
 
@@ -55,11 +55,11 @@ TEST_CASE(TEST_GROUP "Test calculating number of reads from pod5, read ids list.
     }
 
     SECTION("pod5 file and read ids with 0 reads") {
-        auto read_list = std::unordered_set<std::string>();
+        auto read_list = dorado::utils::ReadIdSet();
         CHECK(dorado::DataLoader::get_num_reads(data_path, read_list, {}, false) == 0);
     }
     SECTION("pod5 file and read ids with 2 reads") {
-        auto read_list = std::unordered_set<std::string>();
+        auto read_list = dorado::utils::ReadIdSet();
         read_list.insert("1");
         read_list.insert("2");
         CHECK(dorado::DataLoader::get_num_reads(data_path, read_list, {}, false) == 1);
@@ -101,11 +101,33 @@ TEST_CASE(TEST_GROUP "Load data sorted by channel id.") {
     }
 }
 
+TEST_CASE(TEST_GROUP "Load data sorted by channel id with multiple worker threads.") {
+    auto data_path = get_data_dir("multi_read_pod5");
+    const size_t num_reads = dorado::DataLoader::get_num_reads(data_path, std::nullopt, {}, true);
+
+    dorado::PipelineDescriptor pipeline_desc;
+    std::vector<dorado::Message> messages;
+    pipeline_desc.add_node<MessageSinkToVector>({}, 100, messages);
+    auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
+
+    dorado::DataLoader loader(*pipeline, "cpu", 4, 0, std::nullopt, {});
+    loader.load_reads(data_path, true, dorado::ReadOrder::BY_CHANNEL);
+    pipeline.reset();
+    auto reads = ConvertMessages<dorado::SimplexReadPtr>(std::move(messages));
+    CHECK(reads.size() == num_reads);
+
+    int start_channel_id = -1;
+    for (auto & i : reads) {
+        CHECK(i->read_common.attributes.channel_number >= start_channel_id);
+        start_channel_id = i->read_common.attributes.channel_number;
+    }
+}
+
 TEST_CASE(TEST_GROUP "Test loading POD5 file with read ignore list") {
     auto data_path = get_data_dir("multi_read_pod5");
 
     SECTION("read ignore list with 1 read") {
-        auto read_ignore_list = std::unordered_set<std::string>();
+        auto read_ignore_list = dorado::utils::ReadIdSet();
         read_ignore_list.insert("0007f755-bc82-432c-82be-76220b107ec5");  // read present in POD5
 
         CHECK(dorado::DataLoader::get_num_reads(data_path, std::nullopt, read_ignore_list, false) ==
@@ -114,9 +136,9 @@ TEST_CASE(TEST_GROUP "Test loading POD5 file with read ignore list") {
     }
 
     SECTION("same read in read_ids and ignore list") {
-        auto read_list = std::unordered_set<std::string>();
+        auto read_list = dorado::utils::ReadIdSet();
         read_list.insert("0007f755-bc82-432c-82be-76220b107ec5");  // read present in POD5
-        auto read_ignore_list = std::unordered_set<std::string>();
+        auto read_ignore_list = dorado::utils::ReadIdSet();
         read_ignore_list.insert("0007f755-bc82-432c-82be-76220b107ec5");  // read present in POD5
 
         CHECK(dorado::DataLoader::get_num_reads(data_path, read_list, read_ignore_list, false) ==
@@ -125,6 +147,19 @@ TEST_CASE(TEST_GROUP "Test loading POD5 file with read ignore list") {
     }
 }
 
+TEST_CASE(TEST_GROUP "Test loading POD5 files with multiple worker threads") {
+    auto data_path = get_data_dir("multi_read_pod5");
+    const size_t num_reads = dorado::DataLoader::get_num_reads(data_path, std::nullopt, {}, false);
+    REQUIRE(num_reads > 2);
+
+    SECTION("all reads") {
+        CHECK(CountSinkReads(data_path, "cpu", 4, 0, std::nullopt, {}) == num_reads);
+    }
+    SECTION("max reads") {
+        CHECK(CountSinkReads(data_path, "cpu", 4, 2, std::nullopt, {}) == 2);
+    }
+}
+
 TEST_CASE(TEST_GROUP "Test correct previous and next read ids when loaded by channel order.") {
     auto data_path = get_data_dir("single_channel_multi_read_pod5");
 
@@ -153,3 +188,38 @@ TEST_CASE(TEST_GROUP "Test correct previous and next read ids when loaded by cha
         next_read_id = (*i)->read_common.read_id;
     }
 }
+
+TEST_CASE(TEST_GROUP "Load data sorted by channel id opens each file once per channel group.") {
+    // More files than the loader keeps open at once.
+    const size_t num_files = 130;
+    auto tmp_dir = TempDir(std::filesystem::temp_directory_path() / "pod5_channel_order_test");
+    std::filesystem::create_directories(tmp_dir.m_path);
+    const auto source_file = get_data_dir("multi_read_pod5") / "filtered.pod5";
+    for (size_t i = 0; i < num_files; ++i) {
+        std::filesystem::copy_file(source_file,
+                                   tmp_dir.m_path / ("reads_" + std::to_string(i) + ".pod5"));
+    }
+    const size_t num_reads =
+            dorado::DataLoader::get_num_reads(tmp_dir.m_path, std::nullopt, {}, false);
+    REQUIRE(num_reads == num_files * 4);
+
+    dorado::PipelineDescriptor pipeline_desc;
+    std::vector<dorado::Message> messages;
+    pipeline_desc.add_node<MessageSinkToVector>({}, 100, messages);
+    auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
+
+    dorado::DataLoader loader(*pipeline, "cpu", 4, 0, std::nullopt, {});
+    loader.load_reads(tmp_dir.m_path, false, dorado::ReadOrder::BY_CHANNEL);
+    // The reads all fit in a single channel group, so each file is only opened once to load its
+    // reads, rather than once per channel.
+    CHECK(loader.sample_stats().at("pod5_files_opened") == num_files);
+    pipeline.reset();
+    auto reads = ConvertMessages<dorado::SimplexReadPtr>(std::move(messages));
+    CHECK(reads.size() == num_reads);
+
+    int start_channel_id = -1;
+    for (auto & i : reads) {
+        CHECK(i->read_common.attributes.channel_number >= start_channel_id);
+        start_channel_id = i->read_common.attributes.channel_number;
+    }
+}
@@ -0,0 +1,127 @@
+#include "utils/ReadIdSet.h"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#define TEST_GROUP "[read_id_set]"
+
+using dorado::utils::ReadIdSet;
+
+namespace {
+
+std::string random_read_id(std::mt19937_64& rng) {
+    const uint64_t hi = rng();
+    const uint64_t lo = rng();
+    char read_id[37];
+    std::snprintf(read_id, sizeof(read_id), "%08x-%04x-%04x-%04x-%012llx", uint32_t(hi >> 32),
+                  uint32_t(hi >> 16) & 0xffff, uint32_t(hi) & 0xffff, uint32_t(lo >> 48),
+                  (unsigned long long)(lo & 0xffffffffffffull));
+    return read_id;
+}
+
+}  // namespace
+
+TEST_CASE("ReadIdSet parses UUIDs", TEST_GROUP) {
+    const auto uuid = ReadIdSet::parse_uuid("002bd127-db82-436f-b828-28567c3d505d");
+    REQUIRE(uuid.has_value());
+    const ReadIdSet::Uuid expected{0x00, 0x2b, 0xd1, 0x27, 0xdb, 0x82, 0x43, 0x6f,
+                                   0xb8, 0x28, 0x28, 0x56, 0x7c, 0x3d, 0x50, 0x5d};
+    CHECK(*uuid == expected);
+
+    CHECK_FALSE(ReadIdSet::parse_uuid("").has_value());
+    CHECK_FALSE(ReadIdSet::parse_uuid("read_1").has_value());
+    // Uppercase digits, a missing separator, and the wrong length.
+    CHECK_FALSE(ReadIdSet::parse_uuid("002BD127-db82-436f-b828-28567c3d505d").has_value());
+    CHECK_FALSE(ReadIdSet::parse_uuid("002bd127-db82-436f-b82828567c3d505d0").has_value());
+    CHECK_FALSE(ReadIdSet::parse_uuid("002bd127-db82-436f-b828-28567c3d505").has_value());
+}
+
+TEST_CASE("ReadIdSet behaves as a set of strings", TEST_GROUP) {
+    ReadIdSet set{"002bd127-db82-436f-b828-28567c3d505d", "read_1"};
+    CHECK(set.size() == 2);
+    CHECK(set.count("002bd127-db82-436f-b828-28567c3d505d") == 1);
+    CHECK(set.contains(*ReadIdSet::parse_uuid("002bd127-db82-436f-b828-28567c3d505d")));
+    CHECK(set.contains("read_1"));
+    CHECK_FALSE(set.contains("read_2"));
+    CHECK_FALSE(set.contains("002BD127-DB82-436F-B828-28567C3D505D"));
+
+    CHECK_FALSE(set.insert("read_1"));
+    CHECK_FALSE(set.insert("002bd127-db82-436f-b828-28567c3d505d"));
+    CHECK(set.insert("00000000-0000-0000-0000-000000000000"));
+    CHECK(set.contains("00000000-0000-0000-0000-000000000000"));
+    CHECK(set.size() == 3);
+
+    // Compare against a set of strings while the table grows.
+    std::mt19937_64 rng(42);
+    std::unordered_set<std::string> expected{"002bd127-db82-436f-b828-28567c3d505d", "read_1",
+                                             "00000000-0000-0000-0000-000000000000"};
+    std::vector<std::string> read_ids;
+    for (int i = 0; i < 10000; ++i) {
+        read_ids.push_back(random_read_id(rng));
+    }
+    for (size_t i = 0; i < read_ids.size(); i += 2) {
+        CHECK(set.insert(read_ids[i]) == expected.insert(read_ids[i]).second);
+    }
+    CHECK(set.size() == expected.size());
+    for (const auto& read_id : read_ids) {
+        CHECK(set.contains(read_id) == (expected.count(read_id) != 0));
+    }
+
+    ReadIdSet other{"read_1", "read_2", read_ids[0], read_ids[1]};
+    CHECK(set.count_not_in(other) == set.size() - 2);
+    CHECK(other.count_not_in(set) == 2);
+    CHECK(ReadIdSet().count_not_in(set) == 0);
+    CHECK(ReadIdSet().empty());
+}
+
+TEST_CASE("Benchmark ReadIdSet", "[.benchmark]" TEST_GROUP) {
+    std::mt19937_64 rng(42);
+    std::vector<std::string> read_ids;
+    for (int i = 0; i < 1000000; ++i) {
+        read_ids.push_back(random_read_id(rng));
+    }
+
+    BENCHMARK("Insert into unordered_set<std::string>") {
+        std::unordered_set<std::string> set;
+        for (const auto& read_id : read_ids) {
+            set.insert(read_id);
+        }
+        return set.size();
+    };
+    BENCHMARK("Insert into ReadIdSet") {
+        ReadIdSet set;
+        for (const auto& read_id : read_ids) {
+            set.insert(read_id);
+        }
+        return set.size();
+    };
+
+    std::unordered_set<std::string> string_set(read_ids.begin(), read_ids.end());
+    ReadIdSet read_id_set;
+    for (const auto& read_id : read_ids) {
+        read_id_set.insert(read_id);
+    }
+    // Reads are looked up in a different order to the one they were added in.
+    auto lookups = read_ids;
+    std::shuffle(lookups.begin(), lookups.end(), rng);
+    BENCHMARK("Look up in unordered_set<std::string>") {
+        size_t found = 0;
+        for (const auto& read_id : lookups) {
+            found += string_set.count(read_id);
+        }
+        return found;
+    };
+    BENCHMARK("Look up in ReadIdSet") {
+        size_t found = 0;
+        for (const auto& read_id : lookups) {
+            found += read_id_set.count(read_id);
+        }
+        return found;
+    };
+}
@@ -0,0 +1,111 @@
+#include "read_pipeline/read_output_progress_stats.h"
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+
+#define TEST_GROUP "[read_pipeline][ReadOutputProgressStats]"
+
+using dorado::ReadOutputProgressStats;
+using namespace std::chrono_literals;
+
+namespace {
+
+dorado::stats::NamedStats reads_written(double count) {
+    return {{"HtsWriter.unique_simplex_reads_written", count}};
+}
+
+}  // namespace
+
+TEST_CASE("ReadOutputProgressStats: completed collector with duplicate read ids", TEST_GROUP) {
+    ReadOutputProgressStats progress_stats(
+            1h, 2, ReadOutputProgressStats::StatsCollectionMode::collector_per_input_file);
+    progress_stats.set_post_processing_percentage(0.5f);
+
+    // 10 reads were read from the file but only 8 were written, since 2 had duplicate ids.
+    progress_stats.update_stats(reads_written(8));
+    progress_stats.update_reads_per_file_estimate(10);
+    progress_stats.notify_stats_collector_completed(reads_written(8));
+
+    auto report = progress_stats.get_current_report();
+    CHECK(report.total_reads_processed == 10);
+    CHECK(report.interval_reads_processed == 10);
+    CHECK(report.total_reads_estimate == 20);
+    // Half of the reads have been written, and nothing has been post processed.
+    CHECK(report.estimated_percentage == 25);
+}
+
+TEST_CASE("ReadOutputProgressStats: overlapping collectors", TEST_GROUP) {
+    ReadOutputProgressStats progress_stats(
+            1h, 2, ReadOutputProgressStats::StatsCollectionMode::collector_per_input_file);
+    progress_stats.set_post_processing_percentage(0.5f);
+
+    std::size_t last_percentage = 0;
+    auto check_report = [&](std::size_t total_reads_processed, std::size_t total_reads_estimate) {
+        auto report = progress_stats.get_current_report();
+        CHECK(report.total_reads_processed == total_reads_processed);
+        CHECK(report.total_reads_estimate == total_reads_estimate);
+        CHECK(report.estimated_percentage >= last_percentage);
+        last_percentage = report.estimated_percentage;
+        return report;
+    };
+
+    // Both files are being aligned, and the combined count covers both collectors.
+    // With no file completed yet, the reads are assumed to be 3/4 of the way through a file.
+    progress_stats.update_stats(reads_written(6));
+    check_report(6, 16);
+
+    // File 0 completes with 10 reads while file 1 has written 4.
+    progress_stats.update_stats(reads_written(14));
+    progress_stats.update_reads_per_file_estimate(10);
+    progress_stats.notify_stats_collector_completed(reads_written(10));
+    auto report = check_report(14, 20);
+    CHECK(report.interval_reads_processed == 14);
+    CHECK(report.estimated_percentage == 35);
+
+    // File 0 is half way through post processing.
+    progress_stats.update_post_processing_progress(0, 50.f);
+    report = check_report(14, 20);
+    CHECK(report.estimated_percentage == 47);
+
+    // File 1 completes and starts post processing while file 0 is still being post processed.
+    progress_stats.update_stats(reads_written(10));
+    progress_stats.update_reads_per_file_estimate(10);
+    progress_stats.notify_stats_collector_completed(reads_written(10));
+    progress_stats.update_post_processing_progress(1, 20.f);
+    report = check_report(20, 20);
+    CHECK(report.estimated_percentage == 67);
+
+    // File 0 completing post processing mustn't reset the progress of file 1.
+    progress_stats.notify_post_processing_completed(0);
+    report = check_report(20, 20);
+    CHECK(report.estimated_percentage == 80);
+
+    progress_stats.update_post_processing_progress(1, 100.f);
+    progress_stats.notify_post_processing_completed(1);
+    report = check_report(20, 20);
+    CHECK(report.estimated_percentage == 100);
+}
+
+TEST_CASE("ReadOutputProgressStats: single collector", TEST_GROUP) {
+    ReadOutputProgressStats progress_stats(
+            1h, 2, ReadOutputProgressStats::StatsCollectionMode::single_collector);
+    progress_stats.set_post_processing_percentage(0.4f);
+
+    progress_stats.update_reads_per_file_estimate(10);
+    progress_stats.update_stats(reads_written(25));
+    auto report = progress_stats.get_current_report();
+    CHECK(report.total_reads_processed == 25);
+    // The second file already has more reads than the first, so is assumed to be 3/4 of the way
+    // through.
+    CHECK(report.total_reads_estimate == 30);
+
+    progress_stats.update_reads_per_file_estimate(20);
+    progress_stats.update_stats(reads_written(30));
+    progress_stats.notify_stats_collector_completed(reads_written(30));
+    progress_stats.update_post_processing_progress(50.f);
+    report = progress_stats.get_current_report();
+    CHECK(report.total_reads_processed == 30);
+    CHECK(report.total_reads_estimate == 30);
+    CHECK(report.estimated_percentage == 80);
+}
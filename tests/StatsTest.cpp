@@ -0,0 +1,80 @@
+#include "utils/stats.h"
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define TEST_GROUP "[utils][stats]"
+
+using dorado::stats::LatencyHistogram;
+using namespace std::chrono_literals;
+
+TEST_CASE("LatencyHistogram is empty by default", TEST_GROUP) {
+    LatencyHistogram histogram;
+    CHECK(histogram.count() == 0);
+    CHECK(histogram.percentile_ms(0.5) == 0.0);
+
+    dorado::stats::NamedStats stats;
+    histogram.add_to_stats(stats, "latency");
+    CHECK(stats.at("latency_count") == 0.0);
+    CHECK(stats.at("latency_mean_ms") == 0.0);
+    CHECK(stats.at("latency_p99_ms") == 0.0);
+}
+
+TEST_CASE("LatencyHistogram percentiles", TEST_GROUP) {
+    LatencyHistogram histogram;
+    // 1ms, 2ms, ..., 100ms.
+    for (int i = 1; i <= 100; ++i) {
+        histogram.record(std::chrono::milliseconds(i));
+    }
+    CHECK(histogram.count() == 100);
+
+    // Buckets are an eighth of a power of 2 wide, so percentiles round up by at most that much.
+    CHECK(histogram.percentile_ms(0.5) >= 50.0);
+    CHECK(histogram.percentile_ms(0.5) <= 50.0 * 1.125);
+    CHECK(histogram.percentile_ms(0.9) >= 90.0);
+    CHECK(histogram.percentile_ms(0.9) <= 90.0 * 1.125);
+    CHECK(histogram.percentile_ms(0.0) >= 1.0);
+    CHECK(histogram.percentile_ms(0.0) <= 1.125);
+    // The top bucket is clamped to the largest value recorded.
+    CHECK(histogram.percentile_ms(1.0) == Approx(100.0));
+
+    dorado::stats::NamedStats stats;
+    histogram.add_to_stats(stats, "latency");
+    CHECK(stats.at("latency_count") == 100.0);
+    CHECK(stats.at("latency_mean_ms") == Approx(50.5));
+    CHECK(stats.at("latency_max_ms") == Approx(100.0));
+    CHECK(stats.at("latency_p50_ms") == histogram.percentile_ms(0.5));
+}
+
+TEST_CASE("LatencyHistogram handles extreme values", TEST_GROUP) {
+    LatencyHistogram histogram;
+    histogram.record(0ns);
+    histogram.record(-5ns);
+    histogram.record(std::chrono::nanoseconds::max(), 2);
+    CHECK(histogram.count() == 4);
+    CHECK(histogram.percentile_ms(0.5) == 0.0);
+    CHECK(histogram.percentile_ms(1.0) == Approx(double(std::chrono::nanoseconds::max().count()) /
+                                                  1e6));
+}
+
+TEST_CASE("LatencyHistogram records from many threads", TEST_GROUP) {
+    LatencyHistogram histogram;
+    constexpr int kNumThreads = 8;
+    constexpr int kNumRecords = 10000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kNumThreads; ++t) {
+        threads.emplace_back([&histogram] {
+            for (int i = 0; i < kNumRecords; ++i) {
+                histogram.record(std::chrono::microseconds(i % 100));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CHECK(histogram.count() == kNumThreads * kNumRecords);
+    CHECK(histogram.percentile_ms(1.0) == Approx(0.099));
+}
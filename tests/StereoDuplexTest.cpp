@@ -63,7 +63,7 @@ TEST_CASE(TEST_GROUP "Encoder") {
     torch::load(stereo_raw_data, DataPath("stereo_raw_data.tensor").string());
     stereo_raw_data = stereo_raw_data.to(torch::kFloat16);
 
-    dorado::StereoDuplexEncoderNode stereo_node = dorado::StereoDuplexEncoderNode(5);
+    dorado::StereoDuplexEncoderNode stereo_node = dorado::StereoDuplexEncoderNode(5, 1);
 
     dorado::ReadPair read_pair;
     read_pair.template_read = template_read;
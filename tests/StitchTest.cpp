@@ -3,8 +3,13 @@
 #include "read_pipeline/ReadPipeline.h"
 #include "utils/math_utils.h"
 
+#include <ATen/ATen.h>
 #include <catch2/catch.hpp>
 
+#include <numeric>
+#include <random>
+#include <string>
+
 #define TEST_GROUP "[utils]"
 
 // clang-format off
@@ -80,3 +85,146 @@ TEST_CASE("Test stitch_chunks", TEST_GROUP) {
     REQUIRE(read_common.qstring == expected_qstring);
     REQUIRE(read_common.moves == expected_moves);
 }
+
+namespace {
+
+// The original implementation, which builds the outputs from per-chunk copies.
+void reference_stitch_chunks(
+        dorado::ReadCommon& read_common,
+        const std::vector<std::unique_ptr<dorado::utils::Chunk>>& called_chunks) {
+    int start_pos = 0;
+    int mid_point_front = 0;
+    std::vector<uint8_t> moves;
+    std::vector<std::string> sequences;
+    std::vector<std::string> qstrings;
+
+    for (int i = 0; i < int(called_chunks.size() - 1); i++) {
+        auto& current_chunk = called_chunks[i];
+        auto& next_chunk = called_chunks[i + 1];
+        int overlap_size = int((current_chunk->raw_chunk_size + current_chunk->input_offset) -
+                               (next_chunk->input_offset));
+        int overlap_down_sampled = overlap_size / read_common.model_stride;
+        int mid_point_rear = overlap_down_sampled / 2;
+
+        int current_chunk_bases_to_trim =
+                std::accumulate(std::prev(current_chunk->moves.end(), mid_point_rear),
+                                current_chunk->moves.end(), 0);
+
+        int current_chunk_seq_len = int(current_chunk->seq.size());
+        int end_pos = current_chunk_seq_len - current_chunk_bases_to_trim;
+        int trimmed_len = end_pos - start_pos;
+        sequences.push_back(current_chunk->seq.substr(start_pos, trimmed_len));
+        qstrings.push_back(current_chunk->qstring.substr(start_pos, trimmed_len));
+        moves.insert(moves.end(), std::next(current_chunk->moves.begin(), mid_point_front),
+                     std::prev(current_chunk->moves.end(), mid_point_rear));
+
+        mid_point_front = overlap_down_sampled - mid_point_rear;
+
+        start_pos = 0;
+        for (int j = 0; j < mid_point_front; j++) {
+            start_pos += (int)next_chunk->moves[j];
+        }
+    }
+
+    auto& last_chunk = called_chunks.back();
+    moves.insert(moves.end(), std::next(last_chunk->moves.begin(), mid_point_front),
+                 last_chunk->moves.end());
+
+    if (called_chunks.size() == 1) {
+        int last_index_in_moves_to_keep =
+                int(read_common.get_raw_data_samples() / read_common.model_stride);
+        moves = std::vector<uint8_t>(moves.begin(), moves.begin() + last_index_in_moves_to_keep);
+        int end = std::accumulate(moves.begin(), moves.end(), 0);
+        sequences.push_back(last_chunk->seq.substr(start_pos, end));
+        qstrings.push_back(last_chunk->qstring.substr(start_pos, end));
+    } else {
+        sequences.push_back(last_chunk->seq.substr(start_pos));
+        qstrings.push_back(last_chunk->qstring.substr(start_pos));
+    }
+
+    read_common.seq = std::accumulate(sequences.begin(), sequences.end(), std::string(""));
+    read_common.qstring = std::accumulate(qstrings.begin(), qstrings.end(), std::string(""));
+    read_common.moves = std::move(moves);
+
+    if (static_cast<int>(read_common.moves.size()) >
+        static_cast<int>(read_common.get_raw_data_samples() / read_common.model_stride)) {
+        if (read_common.moves.back() == 1) {
+            read_common.seq.pop_back();
+            read_common.qstring.pop_back();
+        }
+        read_common.moves.pop_back();
+    }
+}
+
+// Chunks the way BasecallerNode does for a read of |num_chunks| chunks, with random calls.
+std::vector<std::unique_ptr<dorado::utils::Chunk>> make_random_chunks(
+        dorado::ReadCommon& read_common,
+        size_t num_chunks) {
+    constexpr size_t kChunkSize = 10000;
+    constexpr size_t kOverlap = 500;
+    constexpr int kStride = 5;
+
+    // Leave a partial chunk and a partial stride at the end of the signal.
+    const size_t signal_len = (num_chunks - 1) * (kChunkSize - kOverlap) + kChunkSize / 2 + 3;
+    read_common.raw_data = at::zeros({int64_t(signal_len)}, at::kShort);
+    read_common.model_stride = kStride;
+
+    // As in BasecallerNode, the last chunk is aligned to the end of the signal, rounded up to a
+    // whole number of strides.
+    size_t last_chunk_offset = signal_len > kChunkSize ? signal_len - kChunkSize : 0;
+    last_chunk_offset += (kStride - last_chunk_offset % kStride) % kStride;
+
+    std::minstd_rand rng(static_cast<unsigned>(num_chunks));
+    std::vector<std::unique_ptr<dorado::utils::Chunk>> chunks;
+    for (size_t i = 0; i < num_chunks; ++i) {
+        const size_t offset =
+                i + 1 == num_chunks ? last_chunk_offset : i * (kChunkSize - kOverlap);
+        auto chunk = std::make_unique<dorado::utils::Chunk>(offset, kChunkSize);
+        chunk->moves.resize(kChunkSize / kStride);
+        for (auto& move : chunk->moves) {
+            move = rng() % 3 == 0;
+            if (move) {
+                chunk->seq.push_back("ACGT"[rng() % 4]);
+                chunk->qstring.push_back(char('!' + rng() % 40));
+            }
+        }
+        chunks.push_back(std::move(chunk));
+    }
+    return chunks;
+}
+
+}  // namespace
+
+TEST_CASE("Test stitch_chunks matches the original implementation", TEST_GROUP) {
+    const size_t num_chunks = GENERATE(1, 2, 3, 10, 57);
+    CAPTURE(num_chunks);
+
+    dorado::ReadCommon read_common;
+    const auto chunks = make_random_chunks(read_common, num_chunks);
+
+    dorado::ReadCommon expected = read_common;
+    reference_stitch_chunks(expected, chunks);
+    dorado::utils::stitch_chunks(read_common, chunks);
+
+    CHECK(read_common.seq == expected.seq);
+    CHECK(read_common.qstring == expected.qstring);
+    CHECK(read_common.moves == expected.moves);
+    CHECK(size_t(std::accumulate(read_common.moves.begin(), read_common.moves.end(), 0)) ==
+          read_common.seq.size());
+}
+
+TEST_CASE("Benchmark stitch_chunks", "[.benchmark]" TEST_GROUP) {
+    const size_t num_chunks = GENERATE(1, 10, 100, 1000);
+
+    dorado::ReadCommon read_common;
+    const auto chunks = make_random_chunks(read_common, num_chunks);
+
+    BENCHMARK("Original " + std::to_string(num_chunks) + " chunks") {
+        reference_stitch_chunks(read_common, chunks);
+        return read_common.seq.size();
+    };
+    BENCHMARK("stitch_chunks " + std::to_string(num_chunks) + " chunks") {
+        dorado::utils::stitch_chunks(read_common, chunks);
+        return read_common.seq.size();
+    };
+}
@@ -0,0 +1,226 @@
+#include "TestUtils.h"
+#include "summary/summary.h"
+#include "utils/hts_file.h"
+#include "utils/types.h"
+
+#include <catch2/catch.hpp>
+#include <htslib/sam.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define TEST_GROUP "[summary]"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const std::string READ_GROUP = "run0_model";
+const std::string EXP_START_TIME = "2023-09-12T09:00:00.000+00:00";
+constexpr std::chrono::seconds EXP_START_TIME_SINCE_EPOCH{1694509200};
+
+// More than a batch of records, so that the rows are formatted on several threads.
+constexpr int NUM_RECORDS = 2345;
+
+struct TestRecord {
+    std::string read_id;
+    uint16_t flag{BAM_FUNMAP};
+    int seqlen{0};
+    std::optional<std::string> read_group;
+    std::optional<std::chrono::milliseconds> start_offset;
+    std::optional<std::string> f5_filename;
+    std::string filename;
+    std::optional<std::string> barcode;
+    int channel{0};
+    int mux{0};
+    int mean_qscore{0};
+    int num_samples{0};
+    int trim_samples{0};
+    float duration{0};
+};
+
+std::vector<TestRecord> make_test_records() {
+    std::vector<TestRecord> records;
+    for (int i = 0; i < NUM_RECORDS; ++i) {
+        TestRecord record;
+        record.read_id = "read_" + std::to_string(i);
+        if (i % 100 == 7) {
+            record.flag |= BAM_FSECONDARY;
+        } else if (i % 100 == 8) {
+            record.flag |= BAM_FSUPPLEMENTARY;
+        }
+        record.seqlen = 10 + i % 50;
+        // Records without a read group, or without a start time.
+        if (i != 1234) {
+            record.read_group = READ_GROUP;
+            if (i != 1500) {
+                record.start_offset = std::chrono::milliseconds((i * 7919) % 3'600'000);
+            }
+        }
+        if (i % 7 == 0) {
+            record.f5_filename = "legacy.fast5";
+        }
+        record.filename = "file_" + std::to_string(i / 1000) + ".pod5";
+        if (i % 2 == 0) {
+            record.barcode = "barcode01";
+        }
+        record.channel = 1 + i % 512;
+        record.mux = 1 + i % 4;
+        record.mean_qscore = i % 40;
+        record.num_samples = 1000 + 3 * i;
+        record.trim_samples = i % 100;
+        record.duration = record.num_samples / 5000.f;
+        records.push_back(std::move(record));
+    }
+    return records;
+}
+
+std::string format_start_time(std::chrono::milliseconds offset) {
+    const auto minutes = std::chrono::duration_cast<std::chrono::minutes>(offset);
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(offset - minutes);
+    const auto milliseconds = offset - minutes - seconds;
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "2023-09-12T09:%02d:%02d.%03d+00:00",
+                  int(minutes.count()), int(seconds.count()), int(milliseconds.count()));
+    return buffer;
+}
+
+void append_string_tag(bam1_t* record, const char* tag, const std::string& value) {
+    bam_aux_append(record, tag, 'Z', int(value.length() + 1),
+                   reinterpret_cast<const uint8_t*>(value.c_str()));
+}
+
+void append_int_tag(bam1_t* record, const char* tag, int32_t value) {
+    bam_aux_append(record, tag, 'i', sizeof(value), reinterpret_cast<const uint8_t*>(&value));
+}
+
+void write_test_bam(const fs::path& filename, const std::vector<TestRecord>& records) {
+    dorado::utils::HtsFile hts_file(filename.string(), dorado::utils::HtsFile::OutputMode::BAM, 2,
+                                    false);
+    dorado::SamHdrPtr header(sam_hdr_init());
+    sam_hdr_add_line(header.get(), "RG", "ID", READ_GROUP.c_str(), "DT", EXP_START_TIME.c_str(),
+                     NULL);
+    hts_file.set_and_write_header(header.get());
+
+    for (const auto& test_record : records) {
+        const std::string seq(test_record.seqlen, 'A');
+        const std::string qual(test_record.seqlen, 20);
+        dorado::BamPtr record(bam_init1());
+        bam_set1(record.get(), test_record.read_id.length(), test_record.read_id.c_str(),
+                 test_record.flag, -1, -1, 0, 0, nullptr, -1, -1, 0, seq.length(), seq.c_str(),
+                 qual.c_str(), 0);
+        if (test_record.read_group) {
+            append_string_tag(record.get(), "RG", *test_record.read_group);
+        }
+        if (test_record.start_offset) {
+            append_string_tag(record.get(), "st", format_start_time(*test_record.start_offset));
+        }
+        if (test_record.f5_filename) {
+            append_string_tag(record.get(), "f5", *test_record.f5_filename);
+        }
+        append_string_tag(record.get(), "fn", test_record.filename);
+        if (test_record.barcode) {
+            append_string_tag(record.get(), "BC", *test_record.barcode);
+        }
+        append_int_tag(record.get(), "ch", test_record.channel);
+        append_int_tag(record.get(), "mx", test_record.mux);
+        append_int_tag(record.get(), "qs", test_record.mean_qscore);
+        append_int_tag(record.get(), "ns", test_record.num_samples);
+        append_int_tag(record.get(), "ts", test_record.trim_samples);
+        bam_aux_append(record.get(), "du", 'f', sizeof(test_record.duration),
+                       reinterpret_cast<const uint8_t*>(&test_record.duration));
+        hts_file.write(record.get());
+    }
+    hts_file.finalise([](size_t) { /* noop */ }, 2);
+}
+
+// Formats a row as the summary did before rows were formatted on worker threads, with the
+// general and barcoding fields that are used for an unaligned file.
+std::string format_expected_row(const TestRecord& record, char separator) {
+    using namespace std::chrono;
+    std::string run_id = "unknown";
+    if (record.read_group) {
+        run_id = record.read_group->substr(0, record.read_group->find("_"));
+    }
+    auto filename = record.f5_filename ? *record.f5_filename : record.filename;
+    auto barcode = record.barcode ? *record.barcode : "unclassified";
+
+    float sample_rate = record.num_samples / record.duration;
+    float template_duration = (record.num_samples - record.trim_samples) / sample_rate;
+    auto start_time = 0.0;
+    if (record.read_group) {
+        // A missing start time is parsed as the epoch.
+        microseconds read_start_time(0);
+        if (record.start_offset) {
+            read_start_time = EXP_START_TIME_SINCE_EPOCH + *record.start_offset;
+        }
+        start_time = duration<double>(read_start_time - EXP_START_TIME_SINCE_EPOCH).count();
+    }
+    auto template_start_time = start_time + (record.duration - template_duration);
+
+    std::ostringstream writer;
+    writer << filename << separator << record.read_id;
+    writer << separator << run_id << separator << record.channel << separator << record.mux
+           << separator << start_time << separator << record.duration << separator
+           << template_start_time << separator << template_duration << separator << record.seqlen
+           << separator << record.mean_qscore;
+    writer << separator << barcode;
+    writer << '\n';
+    return writer.str();
+}
+
+}  // namespace
+
+TEST_CASE("SummaryData: rows match the ostream formatting", TEST_GROUP) {
+    const char separator = GENERATE('\t', ',');
+    const int threads = GENERATE(1, 3, 8);
+    CAPTURE(separator, threads);
+
+    auto tmp_dir = TempDir(fs::temp_directory_path() / "summary_test");
+    fs::create_directories(tmp_dir.m_path);
+    const auto bam_file = tmp_dir.m_path / "reads.bam";
+
+    const auto records = make_test_records();
+    write_test_bam(bam_file, records);
+
+    std::string expected =
+            "filename,read_id,run_id,channel,mux,start_time,duration,template_start,"
+            "template_duration,sequence_length_template,mean_qscore_template,barcode\n";
+    std::replace(expected.begin(), expected.end(), ',', separator);
+    size_t num_expected_rows = 1;
+    for (const auto& record : records) {
+        // Only primary records have a row.
+        if (record.flag & (BAM_FSECONDARY | BAM_FSUPPLEMENTARY)) {
+            continue;
+        }
+        expected += format_expected_row(record, separator);
+        ++num_expected_rows;
+    }
+
+    dorado::SummaryData summary;
+    summary.set_separator(separator);
+    summary.set_threads(threads);
+    std::ostringstream output;
+    REQUIRE(summary.process_file(bam_file.string(), output));
+
+    // Compare row by row, so that a mismatch reports the row rather than the whole file.
+    std::istringstream expected_rows(expected);
+    std::istringstream output_rows(output.str());
+    std::string expected_row, output_row;
+    size_t num_rows = 0;
+    while (std::getline(expected_rows, expected_row)) {
+        CAPTURE(num_rows);
+        REQUIRE(std::getline(output_rows, output_row));
+        CHECK(output_row == expected_row);
+        ++num_rows;
+    }
+    CHECK_FALSE(std::getline(output_rows, output_row));
+    CHECK(num_rows == num_expected_rows);
+}
@@ -76,6 +76,52 @@ TEST_CASE(CUT_TAG ": convert_f32_to_f16", CUT_TAG) {
     }
 }
 
+TEST_CASE(CUT_TAG ": median_mad_counting", CUT_TAG) {
+    torch::manual_seed(42);
+
+    // Odd and even sizes, since the lower median is taken for an even number of elements.
+    const int num_elems = GENERATE(1, 2, 999, 1000);
+    auto in = torch::randint(-500, 3000, num_elems).to(torch::kI16);
+
+    const auto expected_median = in.median();
+    const auto expected_mad = torch::median(torch::abs(in - expected_median));
+    const auto [median, mad] = dorado::utils::median_mad_counting(in);
+
+    CHECK(median == expected_median.item<int>());
+    CHECK(mad == expected_mad.item<int>());
+}
+
+TEST_CASE(CUT_TAG ": convert_i16_to_f16", CUT_TAG) {
+    torch::manual_seed(42);
+    srand(42);
+
+    for (int i = 0; i < 10; ++i) {
+        const int num_elems = rand() % 100;
+        const auto elems_i16 = torch::randint(-500, 3000, {num_elems}).to(torch::kI16);
+        const float shift = 400.0f * rand() / RAND_MAX;
+        const float scale = 0.01f + 100.0f * rand() / RAND_MAX;
+        const float kRelTolerance = 0.0f;
+        const float kAbsTolerance = 0.0f;
+
+        const auto scaled_torch_f16 =
+                ((elems_i16.to(torch::kFloat) + shift) * scale).to(torch::kHalf);
+        auto scaled_f16 = torch::zeros({num_elems}, torch::kHalf);
+        dorado::utils::convert_i16_to_f16_scaled(scaled_f16.data_ptr<c10::Half>(),
+                                                 elems_i16.data_ptr<int16_t>(), num_elems, shift,
+                                                 scale);
+        CHECK(torch::allclose(scaled_torch_f16, scaled_f16, kRelTolerance, kAbsTolerance));
+
+        const auto normalised_torch_f16 =
+                ((elems_i16.to(torch::kFloat) - shift) / scale).to(torch::kHalf);
+        auto normalised_f16 = torch::zeros({num_elems}, torch::kHalf);
+        dorado::utils::convert_i16_to_f16_normalised(normalised_f16.data_ptr<c10::Half>(),
+                                                     elems_i16.data_ptr<int16_t>(), num_elems,
+                                                     shift, scale);
+        CHECK(torch::allclose(normalised_torch_f16, normalised_f16, kRelTolerance,
+                              kAbsTolerance));
+    }
+}
+
 TEST_CASE(CUT_TAG ": copy_tensor_elems", CUT_TAG) {
     torch::manual_seed(42);
     srand(42);
@@ -83,4 +83,31 @@ TEST_CASE(CUT_TAG ": adjust_time", CUT_TAG) {
     CAPTURE(timestamp);
     auto result_time_stamp = dorado::utils::adjust_time(timestamp, adjustment);
     CHECK(result_time_stamp == adjusted_timestamp);
-}
\ No newline at end of file
+}
+
+TEST_CASE(CUT_TAG ": parse_time_stamp", CUT_TAG) {
+    std::string timestamp;
+    microseconds expected;
+
+    std::tie(timestamp, expected) = GENERATE(table<std::string, microseconds>({
+            // clang-format off
+                make_tuple("1970-01-01T00:00:00Z",             microseconds(0s)),
+                make_tuple("1970-01-02T00:00:00.000101+00:00", microseconds(24h) + 101us),
+                make_tuple("1975-01-02T00:00:00.456123+00:00", microseconds(43848h) + 456123us),
+                make_tuple("1976-02-29T12:00:00.5Z",           microseconds(54012h) + 500ms),
+                make_tuple("1970-01-01T09:50:12+01:30",        microseconds(8h + 20min + 12s)),
+                make_tuple("1970-01-01T09:50:12.25-05:00",     microseconds(14h + 50min + 12s + 250ms)),
+                make_tuple("1969-12-31T23:59:59Z",             microseconds(-1s)),
+                make_tuple("not a time stamp",                 microseconds(0s)),
+            // clang-format on
+    }));
+    CAPTURE(timestamp);
+    CHECK(dorado::utils::parse_time_stamp(timestamp) == expected);
+}
+
+TEST_CASE(CUT_TAG ": time_difference_seconds", CUT_TAG) {
+    CHECK(dorado::utils::time_difference_seconds("1970-01-01T00:01:00.5Z",
+                                                 "1970-01-01T00:00:00+00:00") == 60.5);
+    CHECK(dorado::utils::time_difference_seconds("1970-01-01T01:00:00+01:00",
+                                                 "1970-01-01T00:00:01Z") == -1.0);
+}
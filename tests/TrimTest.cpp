@@ -4,11 +4,13 @@
 #include "demux/Trimmer.h"
 #include "read_pipeline/HtsReader.h"
 #include "read_pipeline/read_utils.h"
+#include "utils/bam_utils.h"
 
 #include <ATen/ATen.h>
 #include <catch2/catch.hpp>
 #include <htslib/sam.h>
 
+#include <chrono>
 #include <filesystem>
 #include <random>
 #include <string>
@@ -214,6 +216,21 @@ TEST_CASE("Test trim removes all alignment information", TEST_GROUP) {
     CHECK(trimmed_record->core.mpos == -1);
 }
 
+TEST_CASE("Test trim keeps the pipeline entry time", TEST_GROUP) {
+    const auto data_dir = fs::path(get_data_dir("trimmer"));
+    const auto bam_file = data_dir / "reverse_strand_record.bam";
+    HtsReader reader(bam_file.string(), std::nullopt);
+    reader.read();
+    auto &record = reader.record;
+    const auto entry_time = std::chrono::steady_clock::now();
+    utils::set_pipeline_entry_time(record.get(), entry_time);
+
+    Trimmer trimmer;
+    auto trimmed_record = trimmer.trim_sequence(std::move(record), {72, 647});
+
+    CHECK(utils::get_pipeline_entry_time(trimmed_record.get()) == entry_time);
+}
+
 std::string to_qstr(std::vector<int8_t> qscore) {
     std::string qstr;
     for (size_t i = 0; i < qscore.size(); ++i) {
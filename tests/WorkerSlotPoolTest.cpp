@@ -0,0 +1,189 @@
+#include "MessageSinkUtils.h"
+#include "read_pipeline/ReadFilterNode.h"
+#include "read_pipeline/ReadPipeline.h"
+#include "read_pipeline/WorkerSlotPool.h"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#define TEST_GROUP "[WorkerSlotPool]"
+
+using dorado::NodeWorkerSlots;
+using dorado::WorkerSlotPool;
+
+namespace {
+
+// Node whose input threads are never started, so whatever is pushed stays in its queue.
+class StalledNode : public dorado::MessageSink {
+public:
+    StalledNode(std::string name, size_t max_messages, int num_threads)
+            : MessageSink(max_messages, num_threads), m_name(std::move(name)) {}
+    std::string get_name() const override { return m_name; }
+    void terminate(const dorado::FlushOptions&) override { terminate_input_queue(); }
+    void restart() override {}
+
+private:
+    const std::string m_name;
+};
+
+// Node whose input threads each hold on to the message they pop until released, so that its
+// queue backs up.
+class BlockingNode : public dorado::MessageSink {
+public:
+    BlockingNode(std::string name, size_t max_messages, int num_threads)
+            : MessageSink(max_messages, num_threads), m_name(std::move(name)) {
+        start_input_processing(&BlockingNode::input_thread_fn, this);
+    }
+    ~BlockingNode() { terminate(dorado::DefaultFlushOptions()); }
+    std::string get_name() const override { return m_name; }
+    void terminate(const dorado::FlushOptions&) override {
+        {
+            std::lock_guard lock(m_mutex);
+            m_released = true;
+        }
+        m_cv.notify_all();
+        stop_input_processing();
+    }
+    void restart() override {}
+
+private:
+    void input_thread_fn() {
+        dorado::Message message;
+        while (get_input_message(message)) {
+            std::unique_lock lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_released; });
+        }
+    }
+
+    const std::string m_name;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_released{false};
+};
+
+}  // namespace
+
+TEST_CASE("NodeWorkerSlots limits concurrency", TEST_GROUP) {
+    const int num_slots = GENERATE(1, 2, 3);
+    CAPTURE(num_slots);
+    NodeWorkerSlots slots(num_slots);
+
+    std::atomic<int> num_active{0};
+    std::atomic<int> max_active{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 20; ++i) {
+                slots.acquire();
+                const int active = ++num_active;
+                int prev_max = max_active.load();
+                while (active > prev_max && !max_active.compare_exchange_weak(prev_max, active)) {
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                --num_active;
+                slots.release();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CHECK(max_active.load() <= num_slots);
+    CHECK(max_active.load() >= 1);
+}
+
+TEST_CASE("WorkerSlotPool favours the node with the fullest queue", TEST_GROUP) {
+    StalledNode busy_node("busy", 10, 4);
+    StalledNode idle_node("idle", 10, 4);
+    for (int i = 0; i < 10; ++i) {
+        busy_node.push_message(std::make_unique<dorado::SimplexRead>());
+    }
+    REQUIRE(busy_node.input_queue_occupancy() == Approx(1.0));
+    REQUIRE(idle_node.input_queue_occupancy() == Approx(0.0));
+
+    // Rebalance by hand rather than waiting on the controller thread.
+    WorkerSlotPool pool(5, std::chrono::hours(1));
+    pool.add_node(busy_node, 1);
+    pool.add_node(idle_node, 1);
+    for (int i = 0; i < 4; ++i) {
+        pool.rebalance();
+    }
+
+    const auto stats = pool.sample_stats();
+    CHECK(stats.at("max_active_threads") == 5.0);
+    // The busy node gets every slot except the idle node's minimum.
+    CHECK(stats.at("busy_slots") == 4.0);
+    CHECK(stats.at("idle_slots") == 1.0);
+    CHECK(stats.at("busy_occupancy") > stats.at("idle_occupancy"));
+
+    busy_node.terminate(dorado::DefaultFlushOptions());
+    idle_node.terminate(dorado::DefaultFlushOptions());
+}
+
+TEST_CASE("WorkerSlotPool adds input threads to a node whose queue is backing up", TEST_GROUP) {
+    const size_t kQueueSize = 10;
+    BlockingNode single_thread_node("single", kQueueSize, 1);
+    BlockingNode multi_thread_node("multi", kQueueSize, 2);
+    // Once the input threads have each popped a message, the rest fill the queue.
+    for (size_t i = 0; i < kQueueSize + 1; ++i) {
+        single_thread_node.push_message(std::make_unique<dorado::SimplexRead>());
+    }
+    for (size_t i = 0; i < kQueueSize + 2; ++i) {
+        multi_thread_node.push_message(std::make_unique<dorado::SimplexRead>());
+    }
+    REQUIRE(single_thread_node.input_queue_occupancy() == Approx(1.0));
+    REQUIRE(multi_thread_node.input_queue_occupancy() == Approx(1.0));
+
+    // Adding a node rebalances the slots.
+    WorkerSlotPool pool(8, std::chrono::hours(1));
+    pool.add_node(single_thread_node, 1);
+    pool.add_node(multi_thread_node, 1);
+
+    // The node that was created with several threads is given all of the other slots, along
+    // with the threads to use them.  The node with a single thread is left with it.
+    const auto stats = pool.sample_stats();
+    CHECK(stats.at("multi_slots") == 7.0);
+    CHECK(stats.at("multi_threads") == 7.0);
+    CHECK(multi_thread_node.num_input_threads() == 7);
+    CHECK(stats.at("single_threads") == 1.0);
+    CHECK(single_thread_node.num_input_threads() == 1);
+}
+
+TEST_CASE("WorkerSlotPool with a single slot still processes every read", TEST_GROUP) {
+    dorado::PipelineDescriptor pipeline_desc;
+    std::vector<dorado::Message> messages;
+    auto sink = pipeline_desc.add_node<MessageSinkToVector>({}, 100, messages);
+    pipeline_desc.add_node<dorado::ReadFilterNode>({sink}, 0, 0,
+                                                   std::unordered_set<std::string>{}, 4);
+    auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc), nullptr);
+    REQUIRE(pipeline != nullptr);
+
+    auto pool = std::make_unique<WorkerSlotPool>(1, std::chrono::milliseconds(1));
+    pool->add_nodes(*pipeline, {"ReadFilterNode"}, 1);
+    CHECK(pool->sample_stats().at("ReadFilterNode_slots") == 1.0);
+
+    const int kNumReads = 500;
+    for (int i = 0; i < kNumReads; ++i) {
+        auto read = std::make_unique<dorado::SimplexRead>();
+        read->read_common.read_id = std::to_string(i);
+        read->read_common.seq = "ACGTACGT";
+        read->read_common.qstring = "////////";
+        pipeline->push_message(std::move(read));
+    }
+    pipeline->terminate(dorado::DefaultFlushOptions());
+    pool.reset();
+    pipeline.reset();
+
+    auto reads = ConvertMessages<dorado::SimplexReadPtr>(std::move(messages));
+    CHECK(reads.size() == kNumReads);
+}